@@ -0,0 +1,186 @@
+#include "NArmyLayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "nglarmy.h"
+#include "nglassert.h"
+#include "nprofile.h"
+
+// Uniform like the soldiers seen from afar
+const glm::vec4 kPlaceholderColor(0.30f, 0.26f, 0.20f, 1.0f);
+
+NArmyLayer::NArmyLayer(NRenderDevice& device, NAssetService& assets, const NglTerrainGeometry& terrainGeometry,
+                       bool isAnimated, bool isBattle, double tickDuration)
+    : mDevice(device),
+      mAssets(assets),
+      mTerrainGeometry(terrainGeometry),
+      mSimulation(terrainGeometry, isAnimated, isBattle, tickDuration) {
+    mSoldier = assets.requestModel("soldier.glb", NAssetPriority::kNormal, kPlaceholderColor);
+
+    // Global textures must be set from the first frame, nothing samples these until the soldier is drawn
+    const float zeros[4] = {};
+    NTextureHandle placeholder = device.createTexture({NTextureFormat::kRgba32F, 1, 1, zeros, "Animation placeholder"});
+    device.setGlobalTexture(kNAnimationSlot, placeholder);
+    device.setGlobalTexture(kNSkinSlot, placeholder);
+}
+
+NArmyLayer::~NArmyLayer() {}
+
+void NArmyLayer::simulateTo(uint64_t tick) {
+    mSimulation.advanceTo(tick);
+}
+
+void NArmyLayer::update(float alpha, const glm::vec3& cameraPosition, const NOcclusionCuller* culler) {
+    const NArmySnapshot& snapshot = mSimulation.latestSnapshot();
+    {
+        NGL_PROFILE_SCOPE("Army interpolation");
+        nglInterpolateInstances(snapshot.previousInstances, snapshot.instances, alpha, mInstances);
+    }
+
+    const NMeshAsset* soldierMesh = mAssets.mesh(mSoldier);
+    if (soldierMesh != nullptr && mSoldierHeight == 0.0f) {
+        glm::vec3 extent = glm::max(glm::abs(soldierMesh->boundsMin), glm::abs(soldierMesh->boundsMax));
+        mSoldierRadius = std::hypot(extent.x, extent.z);
+        mSoldierHeight = soldierMesh->boundsMax.y * (1.0f + kMaxHeightScale) + kStepHeight;
+        mDevice.setGlobalTexture(kNAnimationSlot, soldierMesh->animationTexture);
+        mDevice.setGlobalTexture(kNSkinSlot, soldierMesh->skinTexture);
+    }
+
+    // Soldiers are small next to the distances between units, the distance to the unit's center on the ground is
+    // good enough to order them. The order of the frame before is kept as the starting point while no unit is gone.
+    const std::vector<NArmyUnit>& units = snapshot.units;
+    mUnitCount = static_cast<int>(units.size());
+    if (mUnitOrder.size() != units.size()) {
+        mUnitOrder.resize(units.size());
+        std::iota(mUnitOrder.begin(), mUnitOrder.end(), 0);
+    }
+    glm::vec2 cameraXz(cameraPosition.x, cameraPosition.z);
+    mUnitDistances.resize(units.size());
+    for (size_t i = 0; i < units.size(); i++) {
+        glm::vec2 offset = units[i].center - cameraXz;
+        mUnitDistances[i] = glm::dot(offset, offset);
+    }
+    std::sort(mUnitOrder.begin(), mUnitOrder.end(),
+              [&](int a, int b) { return mUnitDistances[a] < mUnitDistances[b]; });
+
+    mVisibleUnits.clear();
+    for (int i : mUnitOrder) {
+        const NArmyUnit& unit = units[i];
+        if (culler != nullptr) {
+            const float radius = unit.radius + mSoldierRadius;
+            glm::vec2 rectMin = unit.center - glm::vec2(radius);
+            glm::vec2 rectMax = unit.center + glm::vec2(radius);
+            float minY, maxY;
+            mTerrainGeometry.heightRange(rectMin, rectMax, minY, maxY);
+            if (culler->isOccluded(glm::vec3(rectMin.x, minY, rectMin.y),
+                                   glm::vec3(rectMax.x, maxY + mSoldierHeight, rectMax.y))) {
+                continue;
+            }
+        }
+        mVisibleUnits.push_back(unit);
+    }
+}
+
+void NArmyLayer::updateShadowCasters(const NFrameUniform& frameUniform) {
+    // The unit's box, the soldiers' own size included, in the cascade's light clip space: the center transformed and
+    // the half extent along each clip axis. Cascades span the whole scene along the light, only x and y are tested.
+    NGL_PROFILE_SCOPE("Shadow caster culling");
+    const std::vector<NArmyUnit>& units = mSimulation.latestSnapshot().units;
+    for (int cascade = 0; cascade < kNSoldierCascadeCount; cascade++) {
+        const glm::mat4& matrix = frameUniform.shadow_matrices[cascade];
+        std::vector<NArmyUnit>& casters = mShadowUnits[cascade];
+        casters.clear();
+        for (const NArmyUnit& unit : units) {
+            const float radius = unit.radius + mSoldierRadius;
+            const glm::vec3 center(unit.center.x, (unit.minHeight + unit.maxHeight + mSoldierHeight) * 0.5f,
+                                   unit.center.y);
+            const glm::vec3 halfExtent(radius, (unit.maxHeight + mSoldierHeight - unit.minHeight) * 0.5f, radius);
+            const glm::vec4 clipCenter = matrix * glm::vec4(center, 1.0f);
+            const float extentX = std::abs(matrix[0][0]) * halfExtent.x + std::abs(matrix[1][0]) * halfExtent.y +
+                                  std::abs(matrix[2][0]) * halfExtent.z;
+            const float extentY = std::abs(matrix[0][1]) * halfExtent.x + std::abs(matrix[1][1]) * halfExtent.y +
+                                  std::abs(matrix[2][1]) * halfExtent.z;
+            if (std::abs(clipCenter.x) - extentX <= 1.0f && std::abs(clipCenter.y) - extentY <= 1.0f) {
+                casters.push_back(unit);
+            }
+        }
+    }
+}
+
+int NArmyLayer::unitCount() const {
+    return mUnitCount;
+}
+
+int NArmyLayer::occludedUnitCount() const {
+    return mUnitCount - static_cast<int>(mVisibleUnits.size());
+}
+
+const std::vector<NInstance>& NArmyLayer::instances() const {
+    return mInstances;
+}
+
+uint32_t NArmyLayer::pickSoldier(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                                 float& distance) const {
+    if (mSoldierHeight == 0.0f) {
+        return kNInvalidIndex;
+    }
+    // Units are fit around their soldiers at both ticks of the snapshot by the simulation, and so around the
+    // interpolated soldiers, bounds as for occlusion culling
+    return nglPickSoldier(mInstances, mSimulation.latestSnapshot().units, mSoldierRadius, mSoldierHeight, origin,
+                          direction, maxDistance, distance);
+}
+
+void NArmyLayer::record(NCommandList& commandList, NPipelineHandle pipeline) const {
+    const NMeshAsset* mesh = mAssets.mesh(mSoldier);
+    if (mesh == nullptr) {
+        return;
+    }
+    NDraw draw = makeDraw(*mesh, pipeline, mesh->vertexBuffer);
+    draw.texture = mAssets.texture(mSoldier);
+    recordUnits(commandList, draw, mVisibleUnits);
+}
+
+void NArmyLayer::recordDepth(NCommandList& commandList, NPipelineHandle pipeline) const {
+    const NMeshAsset* mesh = mAssets.mesh(mSoldier);
+    if (mesh == nullptr) {
+        return;
+    }
+    recordUnits(commandList, makeDraw(*mesh, pipeline, mesh->positionBuffer), mVisibleUnits);
+}
+
+void NArmyLayer::recordShadow(NCommandList& commandList, NPipelineHandle shadowPipeline, uint32_t cascade) const {
+    const NMeshAsset* mesh = mAssets.mesh(mSoldier);
+    if (mesh == nullptr) {
+        return;
+    }
+    NGL_ASSERT(cascade < static_cast<uint32_t>(kNSoldierCascadeCount));
+    NDraw draw = makeDraw(*mesh, shadowPipeline, mesh->positionBuffer);
+    draw.cascade = cascade;
+    recordUnits(commandList, draw, mShadowUnits[cascade]);
+}
+
+NDraw NArmyLayer::makeDraw(const NMeshAsset& mesh, NPipelineHandle pipeline, NBufferHandle vertexBuffer) const {
+    NDraw draw;
+    draw.pipeline = pipeline;
+    draw.vertexBuffer = vertexBuffer;
+    draw.indexBuffer = mesh.indexBuffer;
+    draw.indexCount = mesh.indexCount;
+    draw.instanceCount = static_cast<uint32_t>(mInstances.size());
+    draw.firstInstance = 1;
+    return draw;
+}
+
+void NArmyLayer::recordUnits(NCommandList& commandList, const NDraw& armyDraw,
+                             const std::vector<NArmyUnit>& units) const {
+    NGL_PROFILE_SCOPE("Army");
+    commandList.beginScope("Army");
+    NDraw draw = armyDraw;
+    for (const NArmyUnit& unit : units) {
+        draw.instanceCount = unit.instanceCount;
+        draw.firstInstance = armyDraw.firstInstance + unit.firstInstance;
+        commandList.draw(draw);
+    }
+    commandList.endScope();
+}
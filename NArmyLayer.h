@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NArmySimulation.h"
+#include "NAssetService.h"
+#include "NCommandList.h"
+#include "NOcclusionCuller.h"
+#include "NRenderDevice.h"
+#include "NglTerrainGeometry.h"
+
+// Soldiers, drawn a unit at a time from front to back so that early depth testing rejects the hidden ones. Units hidden
+// behind the terrain are not drawn at all in the camera passes, and each shadow cascade draws only the units within its
+// light-space box. Soldiers are placed once per simulation tick on the CPU, on the simulation thread (see
+// NArmySimulation), and the vertex shaders read their NInstance records interpolated between ticks. The soldier model
+// streams in through the asset service, nothing is drawn until its mesh is there. Its animation and skin textures are
+// then set as the global kNAnimationSlot and kNSkinSlot textures.
+class NArmyLayer {
+public:
+    // Without isAnimated, soldiers are drawn as the static mesh, to compare the cost of skinning. With isBattle, the
+    // army fights itself rather than marching (see NArmySimulation). tickDuration is NSimulationClock::tickDuration().
+    NArmyLayer(NRenderDevice& device, NAssetService& assets, const NglTerrainGeometry& terrainGeometry,
+               bool isAnimated, bool isBattle, double tickDuration);
+    NArmyLayer(const NArmyLayer&) = delete;
+    NArmyLayer& operator=(const NArmyLayer&) = delete;
+    NArmyLayer(NArmyLayer&&) = delete;
+    NArmyLayer& operator=(NArmyLayer&&) = delete;
+    ~NArmyLayer();
+
+    // Takes the soldiers of simulation tick NSimulationClock::tick() and of the tick before, once simulated. The next
+    // tick is simulated meanwhile.
+    void simulateTo(uint64_t tick);
+    // Places the rendered soldiers between the latest two ticks by alpha, sorts the units by distance to the camera
+    // and drops the occluded ones. culler was updated for the same camera, nullptr disables occlusion culling.
+    void update(float alpha, const glm::vec3& cameraPosition, const NOcclusionCuller* culler);
+    // Picks the units that cast shadows in each soldier cascade, by their bounds in the cascade's light space. The
+    // occlusion culling does not apply, units hidden from the camera can cast shadows it sees. Call after update(),
+    // with the shadow matrices of NShadowCascades::update().
+    void updateShadowCasters(const NFrameUniform& frameUniform);
+    // Of the latest update(), units are wiped out in battles
+    int unitCount() const;
+    int occludedUnitCount() const;
+    // Of the latest update(), for NRenderDevice::uploadInstances()
+    const std::vector<NInstance>& instances() const;
+    // Soldier of instances() that the ray from origin along direction, unit length, meets first within maxDistance,
+    // and the distance to it. kNInvalidIndex for none, and until the soldier model is there. See nglPickSoldier().
+    uint32_t pickSoldier(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+    void record(NCommandList& commandList, NPipelineHandle pipeline) const;
+    // Depth only, pipeline uses NShader::kDepth
+    void recordDepth(NCommandList& commandList, NPipelineHandle pipeline) const;
+    // Depth only, into the given shadow cascade
+    void recordShadow(NCommandList& commandList, NPipelineHandle shadowPipeline, uint32_t cascade) const;
+
+private:
+    NDraw makeDraw(const NMeshAsset& mesh, NPipelineHandle pipeline, NBufferHandle vertexBuffer) const;
+    void recordUnits(NCommandList& commandList, const NDraw& armyDraw, const std::vector<NArmyUnit>& units) const;
+
+    NRenderDevice& mDevice;
+    const NAssetService& mAssets;
+    const NglTerrainGeometry& mTerrainGeometry;
+    NArmySimulation mSimulation;
+    NAssetHandle mSoldier;
+    float mSoldierRadius = 0.0f;  // around the vertical axis
+    float mSoldierHeight = 0.0f;
+    std::vector<int> mUnitOrder;  // into the latest snapshot's units, front to back
+    std::vector<float> mUnitDistances;
+    std::vector<NArmyUnit> mVisibleUnits;  // front to back
+    std::array<std::vector<NArmyUnit>, kNSoldierCascadeCount> mShadowUnits;  // per soldier cascade
+    int mUnitCount = 0;
+    std::vector<NInstance> mInstances;  // rendered
+};
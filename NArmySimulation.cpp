@@ -0,0 +1,95 @@
+#include "NArmySimulation.h"
+
+#include "nglassert.h"
+#include "nprofile.h"
+
+NArmySimulation::NArmySimulation(const NglTerrainGeometry& terrainGeometry, bool isAnimated, bool isBattle,
+                                 double tickDuration)
+    : mTerrainGeometry(terrainGeometry),
+      mIsAnimated(isAnimated),
+      mTickDuration(tickDuration),
+      mGrid(glm::vec2(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z),
+            glm::vec2(terrainGeometry.boundsMax().x, terrainGeometry.boundsMax().z), kSeparationRadius) {
+    if (isBattle) {
+        mBattle = std::make_unique<NBattle>(glm::vec2(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z),
+                                            glm::vec2(terrainGeometry.boundsMax().x, terrainGeometry.boundsMax().z));
+        nglDeployArmies(terrainGeometry, *mBattle);
+    }
+    mThread = std::thread(&NArmySimulation::simulateLoop, this);
+}
+
+NArmySimulation::~NArmySimulation() {
+    mIsStopping.store(true);
+    notify();
+    mThread.join();
+}
+
+void NArmySimulation::advanceTo(uint64_t tick) {
+    NGL_ASSERT(!mHasLatestTick || tick >= mLatestTick.load(std::memory_order_relaxed));
+    while (!mHasLatestTick || mLatestTick.load(std::memory_order_relaxed) < tick) {
+        uint64_t next = mHasLatestTick ? mLatestTick.load(std::memory_order_relaxed) + 1 : 0;
+        if (mSimulatedTickCount.load(std::memory_order_acquire) <= next) {
+            // The simulation takes longer than the frame
+            NGL_PROFILE_SCOPE("Wait for simulation");
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [&] { return mSimulatedTickCount.load(std::memory_order_acquire) > next; });
+        }
+        // Hands the snapshot of tick next - 1 back to the simulation thread
+        mLatestTick.store(next, std::memory_order_release);
+        mHasLatestTick = true;
+        notify();
+    }
+}
+
+const NArmySnapshot& NArmySimulation::latestSnapshot() const {
+    NGL_ASSERT(mHasLatestTick);
+    return mSnapshots[mLatestTick.load(std::memory_order_relaxed) % kSnapshotCount];
+}
+
+void NArmySimulation::simulateLoop() {
+    nProfileSetThreadName("Simulation");
+    for (uint64_t tick = 0;; tick++) {
+        // The renderer holds the latest tick, the snapshot of tick latest + 1 is free
+        auto isSnapshotFree = [&] { return tick <= mLatestTick.load(std::memory_order_acquire) + 1; };
+        if (!isSnapshotFree()) {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [&] { return mIsStopping.load() || isSnapshotFree(); });
+        }
+        if (mIsStopping.load()) {
+            return;
+        }
+        {
+            NGL_PROFILE_SCOPE("Army tick");
+            NArmySnapshot& snapshot = mSnapshots[tick % kSnapshotCount];
+            if (!mBattle) {
+                march(tick, snapshot);
+            } else {
+                if (tick > 0) {
+                    mBattle->tick(static_cast<float>(mTickDuration));
+                }
+                mBattle->writeSnapshot(mTerrainGeometry, mIsAnimated, snapshot);
+            }
+        }
+        mSimulatedTickCount.store(tick + 1, std::memory_order_release);
+        notify();
+    }
+}
+
+void NArmySimulation::march(uint64_t tick, NArmySnapshot& snapshot) {
+    const float time = static_cast<float>(tick * mTickDuration);
+    const uint32_t animation = mIsAnimated ? static_cast<uint32_t>(NAnimation::kWalk) : kNStaticPose;
+    nglUpdateInstances(time, mTerrainGeometry, animation, snapshot.instances);
+    nglSeparateSoldiers(mTerrainGeometry, mGrid, mGroundPositions, snapshot.instances);
+    // The snapshot of the tick before is the renderer's, only read on both sides
+    snapshot.previousInstances =
+            tick > 0 ? mSnapshots[(tick - 1) % kSnapshotCount].instances : snapshot.instances;
+    nglMarchingUnits(snapshot);
+}
+
+void NArmySimulation::notify() {
+    // Taking the mutex orders the notification after the waiter checked its condition, or before it waits
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+    }
+    mCondition.notify_all();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NBattle.h"
+#include "NSpatialGrid.h"
+#include "NglTerrainGeometry.h"
+#include "nglarmy.h"
+
+// The army simulated on its own thread, a tick ahead of rendering: while a frame interpolates between ticks N - 1 and
+// N, the thread simulates tick N + 1. Tick k places the soldiers at time k * tickDuration (see NSimulationClock), tick
+// 0 being the initial state. The army marches along its route, or fights itself in a battle (see NBattle).
+//
+// Snapshots of the soldiers go around a ring of kSnapshotCount, the renderer holding the latest one, which also has
+// the soldiers of the tick before, and the thread writing the next one. They change hands through two atomic tick
+// counters, the thread publishing the ticks it simulated and the renderer the latest tick it holds. The mutex only
+// parks a thread that has to wait for the other.
+class NArmySimulation {
+public:
+    // Without isAnimated, soldiers are in the static pose. With isBattle, the halves of the army fight each other from
+    // the middle of the route (see nglDeployArmies()).
+    NArmySimulation(const NglTerrainGeometry& terrainGeometry, bool isAnimated, bool isBattle, double tickDuration);
+    NArmySimulation(const NArmySimulation&) = delete;
+    NArmySimulation& operator=(const NArmySimulation&) = delete;
+    NArmySimulation(NArmySimulation&&) = delete;
+    NArmySimulation& operator=(NArmySimulation&&) = delete;
+    ~NArmySimulation();
+
+    // Makes tick the latest one held, after every tick before it, waiting for the thread where it is not done yet.
+    // The tick after it is simulated meanwhile.
+    void advanceTo(uint64_t tick);
+    // Of the latest tick held
+    const NArmySnapshot& latestSnapshot() const;
+
+private:
+    static constexpr uint64_t kSnapshotCount = 2;
+
+    void simulateLoop();
+    void march(uint64_t tick, NArmySnapshot& snapshot);
+    // Wakes the other thread if it waits
+    void notify();
+
+    const NglTerrainGeometry& mTerrainGeometry;
+    const bool mIsAnimated;
+    const double mTickDuration;
+
+    // Of the simulation thread
+    NSpatialGrid mGrid;
+    std::vector<glm::vec2> mGroundPositions;
+    std::unique_ptr<NBattle> mBattle;  // nullptr when marching
+
+    NArmySnapshot mSnapshots[kSnapshotCount];      // tick k in mSnapshots[k % kSnapshotCount]
+    std::atomic<uint64_t> mSimulatedTickCount{0};  // written by the simulation thread
+    std::atomic<uint64_t> mLatestTick{0};          // written by the renderer
+    bool mHasLatestTick = false;                   // of the renderer, false until tick 0 is held
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::atomic<bool> mIsStopping{false};
+    std::thread mThread;
+};
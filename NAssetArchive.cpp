@@ -0,0 +1,104 @@
+#include "NAssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if NGL_ZSTD_ENABLED
+#include <zstd.h>
+#endif
+
+#include "nglassert.h"
+#include "ngllog.h"
+
+static_assert(sizeof(NArchiveHeader) == 16, "NArchiveHeader is part of the file format");
+static_assert(sizeof(NArchiveEntry) == 40, "NArchiveEntry is part of the file format");
+
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t nArchiveHash(const std::string& path) {
+    size_t start = path.compare(0, 2, "./") == 0 || path.compare(0, 2, ".\\") == 0 ? 2 : 0;
+    uint64_t hash = kFnvOffsetBasis;
+    for (size_t i = start; i < path.size(); i++) {
+        char c = path[i] == '\\' ? '/' : path[i];
+        hash = (hash ^ static_cast<unsigned char>(c)) * kFnvPrime;
+    }
+    return hash;
+}
+
+NAssetArchive::NAssetArchive() {}
+
+NAssetArchive::~NAssetArchive() {}
+
+bool NAssetArchive::open(const std::string& path) {
+    // Loading reads most of it, soon
+    NMappedFile file;
+    if (!nTryMapFile(path, NFileAccess::kWillNeed, file)) {
+        return false;
+    }
+
+    NArchiveHeader header{};
+    bool isValid = file.size() >= sizeof(header);
+    if (isValid) {
+        memcpy(&header, file.data(), sizeof(header));
+        isValid = memcmp(header.magic, kNArchiveMagic, sizeof(kNArchiveMagic)) == 0 &&
+                  header.version == kNArchiveVersion &&
+                  header.entryCount <= (file.size() - sizeof(header)) / sizeof(NArchiveEntry);
+    }
+    // The index is 8-byte aligned in the page-aligned mapping
+    const NArchiveEntry* entries = isValid ? reinterpret_cast<const NArchiveEntry*>(file.data() + sizeof(header))
+                                           : nullptr;
+    for (uint32_t i = 0; isValid && i < header.entryCount; i++) {
+        const NArchiveEntry& entry = entries[i];
+        bool isKnownCompression =
+                entry.compression == NArchiveCompression::kNone || entry.compression == NArchiveCompression::kZstd;
+        isValid = entry.offset <= file.size() && entry.size <= file.size() - entry.offset && isKnownCompression &&
+                  (i == 0 || entries[i - 1].hash < entry.hash);
+    }
+    if (!isValid) {
+        NGL_LOGE("%s is not an asset archive", path.c_str());
+        return false;
+    }
+
+    mPath = path;
+    mFile = std::move(file);
+    mEntries = entries;
+    mEntryCount = header.entryCount;
+    NGL_LOGI("Asset archive %s opened, %u entries", path.c_str(), mEntryCount);
+    return true;
+}
+
+const NArchiveEntry* NAssetArchive::find(const std::string& path) const {
+    uint64_t hash = nArchiveHash(path);
+    const NArchiveEntry* end = mEntries + mEntryCount;
+    const NArchiveEntry* entry =
+            std::lower_bound(mEntries, end, hash, [](const NArchiveEntry& a, uint64_t b) { return a.hash < b; });
+    return entry != end && entry->hash == hash ? entry : nullptr;
+}
+
+const char* NAssetArchive::data(const NArchiveEntry& entry) const {
+    return mFile.data() + entry.offset;
+}
+
+bool NAssetArchive::decompress(const NArchiveEntry& entry, std::vector<char>& result) const {
+    switch (entry.compression) {
+        case NArchiveCompression::kNone:
+            result.assign(data(entry), data(entry) + entry.size);
+            return true;
+        case NArchiveCompression::kZstd: {
+#if NGL_ZSTD_ENABLED
+            result.resize(entry.uncompressedSize);
+            size_t size = ZSTD_decompress(result.data(), result.size(), data(entry), entry.size);
+            if (ZSTD_isError(size) || size != entry.uncompressedSize) {
+                NGL_LOGE("Corrupt entry %016llx in %s", static_cast<unsigned long long>(entry.hash), mPath.c_str());
+                return false;
+            }
+            return true;
+#else
+            NGL_LOGE("%s has compressed entries, build with NGL_ZSTD_ENABLED=1 to read them", mPath.c_str());
+            return false;
+#endif
+        }
+    }
+    return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nfile.h"
+
+// Packed asset archive, written by nwar-pack, so that loading opens a single file and reads it mostly front to back.
+// Little-endian like every platform the game runs on:
+//
+//   NArchiveHeader
+//   NArchiveEntry[entryCount]  sorted by hash
+//   entry data                 each entry at a multiple of kNArchiveAlignment, in packing order
+//
+// Files are looked up by nArchiveHash() of their path, the packer refuses paths whose hashes collide.
+
+#ifndef NGL_ZSTD_ENABLED
+#define NGL_ZSTD_ENABLED 0
+#endif
+
+constexpr char kNArchiveMagic[4] = {'N', 'P', 'A', 'K'};
+constexpr uint32_t kNArchiveVersion = 1;
+constexpr uint64_t kNArchiveAlignment = 4096;
+
+enum class NArchiveCompression : uint32_t {
+    kNone,
+    kZstd,  // needs a build with NGL_ZSTD_ENABLED
+};
+
+struct NArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct NArchiveEntry {
+    uint64_t hash;
+    uint64_t offset;  // from the start of the archive
+    uint64_t size;    // stored
+    uint64_t uncompressedSize;
+    NArchiveCompression compression;
+    uint32_t reserved;
+};
+
+// FNV-1a of the path, with '/' separators and without a leading "./"
+uint64_t nArchiveHash(const std::string& path);
+
+class NAssetArchive {
+public:
+    NAssetArchive();
+    NAssetArchive(const NAssetArchive&) = delete;
+    NAssetArchive& operator=(const NAssetArchive&) = delete;
+    NAssetArchive(NAssetArchive&&) = delete;
+    NAssetArchive& operator=(NAssetArchive&&) = delete;
+    ~NAssetArchive();
+
+    // Maps the archive. Returns false if it cannot be read or is not an archive.
+    bool open(const std::string& path);
+
+    // nullptr if the archive has no such file
+    const NArchiveEntry* find(const std::string& path) const;
+    // Stored bytes of the entry, compressed or not
+    const char* data(const NArchiveEntry& entry) const;
+    // Returns false if the entry is corrupt or this build cannot decompress it
+    bool decompress(const NArchiveEntry& entry, std::vector<char>& result) const;
+
+private:
+    std::string mPath;
+    NMappedFile mFile;
+    const NArchiveEntry* mEntries = nullptr;
+    uint32_t mEntryCount = 0;
+};
@@ -0,0 +1,321 @@
+#include "NAssetService.h"
+
+#include <algorithm>
+#include <limits>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include "nfile.h"
+#include "nglassert.h"
+#include "ngllog.h"
+#include "nprofile.h"
+
+// Decoding is CPU bound, the main thread and the I/O thread keep a core each
+constexpr unsigned kMaxDecodeThreadCount = 4;
+constexpr size_t kPageSize = 4096;
+
+static void touchPages(const NMappedFile& file);
+
+NAssetService::NAssetService(NRenderDevice& device, bool hasMipmaps) : mDevice(device), mHasMipmaps(hasMipmaps) {
+    for (NTextureFormat format :
+         {NTextureFormat::kBc1, NTextureFormat::kBc3, NTextureFormat::kBc5, NTextureFormat::kBc7}) {
+        if (mDevice.isTextureFormatSupported(format)) {
+            mSupportedFormats.push_back(format);
+        }
+    }
+    unsigned coreCount = std::thread::hardware_concurrency();
+    unsigned decodeThreadCount = std::clamp(coreCount > 2 ? coreCount - 2 : 1u, 1u, kMaxDecodeThreadCount);
+    mReadThread = std::thread(&NAssetService::readLoop, this);
+    for (unsigned i = 0; i < decodeThreadCount; i++) {
+        mDecodeThreads.emplace_back(&NAssetService::decodeLoop, this);
+    }
+    NGL_LOGI("Asset service started, decode threads: %u", decodeThreadCount);
+}
+
+NAssetService::~NAssetService() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mReadCondition.notify_all();
+    mDecodeCondition.notify_all();
+    mReadThread.join();
+    for (std::thread& thread : mDecodeThreads) {
+        thread.join();
+    }
+}
+
+NAssetHandle NAssetService::requestTexture(const std::string& path, NAssetPriority priority,
+                                           const glm::vec4& placeholderColor) {
+    return request(path, false, priority, placeholderColor);
+}
+
+NAssetHandle NAssetService::requestModel(const std::string& path, NAssetPriority priority,
+                                         const glm::vec4& placeholderColor) {
+    return request(path, true, priority, placeholderColor);
+}
+
+void NAssetService::update(double timeBudget) {
+    NGL_PROFILE_SCOPE("Asset upload");
+    double startTime = glfwGetTime();
+    do {
+        std::unique_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            job = popNext(mUploadQueue);
+        }
+        if (!job) {
+            break;
+        }
+        upload(*job);
+    } while (glfwGetTime() - startTime < timeBudget);
+}
+
+void NAssetService::finish() {
+    // Every pending asset has a job on its way to the upload queue
+    while (mPendingAssetCount > 0) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mUploadCondition.wait(lock, [this] { return !mUploadQueue.empty(); });
+        }
+        update(std::numeric_limits<double>::infinity());
+    }
+}
+
+bool NAssetService::isReady(NAssetHandle asset) const {
+    const Asset& entry = mAssets[asset.index];
+    return entry.isTextureReady && (!entry.isModel || entry.isMeshReady);
+}
+
+int NAssetService::pendingCount() const {
+    return mPendingAssetCount;
+}
+
+NTextureHandle NAssetService::texture(NAssetHandle asset) const {
+    return mAssets[asset.index].texture;
+}
+
+const NMeshAsset* NAssetService::mesh(NAssetHandle asset) const {
+    const Asset& entry = mAssets[asset.index];
+    return entry.isMeshReady ? &entry.mesh : nullptr;
+}
+
+NAssetHandle NAssetService::request(const std::string& path, bool isModel, NAssetPriority priority,
+                                    const glm::vec4& placeholderColor) {
+    NAssetHandle handle = {static_cast<uint32_t>(mAssets.size())};
+    Asset asset;
+    asset.path = path;
+    asset.isModel = isModel;
+    asset.requestTime = glfwGetTime();
+    asset.texture = placeholder(placeholderColor);
+    mAssets.push_back(std::move(asset));
+    mPendingAssetCount++;
+
+    auto job = std::make_unique<Job>();
+    job->asset = handle.index;
+    job->priority = priority;
+    job->sequence = mNextSequence++;
+    job->isModel = isModel;
+    job->path = path;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReadQueue.push_back(std::move(job));
+    }
+    mReadCondition.notify_one();
+    return handle;
+}
+
+NTextureHandle NAssetService::placeholder(const glm::vec4& color) {
+    // Shared by the assets of the same color
+    for (const auto& placeholder : mPlaceholders) {
+        if (placeholder.first == color) {
+            return placeholder.second;
+        }
+    }
+    glm::vec4 bytes = glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f);
+    unsigned char pixel[4] = {static_cast<unsigned char>(bytes.r), static_cast<unsigned char>(bytes.g),
+                              static_cast<unsigned char>(bytes.b), static_cast<unsigned char>(bytes.a)};
+    NTextureHandle texture = mDevice.createTexture({NTextureFormat::kRgba8, 1, 1, pixel, "Placeholder"});
+    mPlaceholders.push_back({color, texture});
+    return texture;
+}
+
+void NAssetService::upload(Job& job) {
+    Asset& asset = mAssets[job.asset];
+    if (job.isModel) {
+        const std::vector<NglVertex>& vertices = job.geometry->vertices();
+        const std::vector<uint32_t>& indices = job.geometry->indices();
+        NMeshAsset& mesh = asset.mesh;
+        mesh.vertexBuffer =
+                mDevice.createBuffer(NBufferUsage::kVertex, vertices.data(), vertices.size() * sizeof(NglVertex));
+        mesh.indexBuffer =
+                mDevice.createBuffer(NBufferUsage::kIndex, indices.data(), indices.size() * sizeof(uint32_t));
+        mesh.indexCount = static_cast<uint32_t>(indices.size());
+
+        // Positions only, for the depth-only passes
+        std::vector<glm::vec3> positions;
+        positions.reserve(vertices.size());
+        mesh.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        mesh.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+        for (const NglVertex& vertex : vertices) {
+            positions.push_back(vertex.position);
+            mesh.boundsMin = glm::min(mesh.boundsMin, vertex.position);
+            mesh.boundsMax = glm::max(mesh.boundsMax, vertex.position);
+        }
+        mesh.positionBuffer =
+                mDevice.createBuffer(NBufferUsage::kVertex, positions.data(), positions.size() * sizeof(glm::vec3));
+
+        const NAnimationTexture& animationTexture = job.geometry->animationTexture();
+        const NAnimationTexture& skinTexture = job.geometry->skinTexture();
+        mesh.animationTexture = mDevice.createTexture({NTextureFormat::kRgba32F, animationTexture.width,
+                                                       animationTexture.height, animationTexture.texels.data(),
+                                                       asset.path.c_str()});
+        mesh.skinTexture = mDevice.createTexture({NTextureFormat::kRgba32F, skinTexture.width, skinTexture.height,
+                                                  skinTexture.texels.data(), asset.path.c_str()});
+        mesh.boundsMin = glm::min(mesh.boundsMin, job.geometry->animatedBoundsMin());
+        mesh.boundsMax = glm::max(mesh.boundsMax, job.geometry->animatedBoundsMax());
+        asset.isMeshReady = true;
+    } else if (job.texture.levels != nullptr) {
+        const NTextureFile& texture = job.texture;
+        asset.texture = mDevice.createTexture({texture.format, texture.width, texture.height, texture.levels,
+                                               asset.path.c_str(), mHasMipmaps ? texture.levelCount : 1});
+        asset.isTextureReady = true;
+        NGL_LOGI("Asset %s texture compressed, %zu bytes, %zu as RGBA8", asset.path.c_str(), texture.size,
+                 nTextureLevelSize(NTextureFormat::kRgba8, texture.width, texture.height));
+    } else {
+        asset.texture = mDevice.createTexture({NTextureFormat::kRgba8, job.image.width, job.image.height,
+                                               job.image.pixels.data(), asset.path.c_str(), 1, mHasMipmaps});
+        asset.isTextureReady = true;
+    }
+
+    if (isReady({job.asset})) {
+        mPendingAssetCount--;
+        NGL_LOGI("Asset %s ready %0.3fs after its request", asset.path.c_str(), glfwGetTime() - asset.requestTime);
+    }
+}
+
+void NAssetService::readLoop() {
+    nProfileSetThreadName("Asset I/O");
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mReadCondition.wait(lock, [this] { return mIsStopping || !mReadQueue.empty(); });
+            if (mIsStopping) {
+                return;
+            }
+            job = popNext(mReadQueue);
+        }
+        {
+            // Touching every page blocks here on the disk rather than on a decode thread
+            NGL_PROFILE_SCOPE("Asset read");
+            bool hasTextureFile = readTextureFile(*job);
+            if (job->isModel || !hasTextureFile) {
+                job->file = nMapFile(job->path, NFileAccess::kWillNeed);
+                touchPages(job->file);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDecodeQueue.push_back(std::move(job));
+        }
+        mDecodeCondition.notify_one();
+    }
+}
+
+bool NAssetService::readTextureFile(Job& job) const {
+    const std::string path = nTextureFilePath(job.path);
+    if (!nTryMapFile(path, NFileAccess::kWillNeed, job.textureFile)) {
+        return false;
+    }
+    bool isLoadable = nParseTextureFile(job.textureFile.data(), job.textureFile.size(), path.c_str(), job.texture);
+    if (isLoadable && std::find(mSupportedFormats.begin(), mSupportedFormats.end(), job.texture.format) ==
+                              mSupportedFormats.end()) {
+        NGL_LOGI("%s left out, the device does not support its format", path.c_str());
+        isLoadable = false;
+    }
+    if (!isLoadable) {
+        job.textureFile = NMappedFile();
+        job.texture = NTextureFile();
+        return false;
+    }
+    touchPages(job.textureFile);
+    return true;
+}
+
+void NAssetService::decodeLoop() {
+    nProfileSetThreadName("Asset decode");
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mDecodeCondition.wait(lock, [this] { return mIsStopping || !mDecodeQueue.empty(); });
+            if (mIsStopping) {
+                return;
+            }
+            job = popNext(mDecodeQueue);
+        }
+        std::unique_ptr<Job> textureJob = decode(*job);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mUploadQueue.push_back(std::move(job));
+            if (textureJob) {
+                mDecodeQueue.push_back(std::move(textureJob));
+            }
+        }
+        mUploadCondition.notify_all();
+        mDecodeCondition.notify_one();
+    }
+}
+
+std::unique_ptr<NAssetService::Job> NAssetService::decode(Job& job) {
+    NGL_PROFILE_SCOPE("Asset decode");
+    if (!job.isModel) {
+        if (job.texture.levels != nullptr) {
+            // Uploaded as it is
+            job.geometry.reset();
+        } else if (job.geometry) {
+            const std::vector<unsigned char>& texture = job.geometry->texture();
+            job.image = nDecodeImage(texture.data(), static_cast<uint32_t>(texture.size()), job.path.c_str());
+            job.geometry.reset();
+        } else {
+            job.image = nDecodeImage(job.file.data(), static_cast<uint32_t>(job.file.size()), job.path.c_str());
+            job.file = NMappedFile();
+        }
+        return nullptr;
+    }
+
+    job.geometry = std::make_shared<NglSoldierGeometry>(job.file.data(), job.file.size(), job.path.c_str());
+    job.file = NMappedFile();
+    auto textureJob = std::make_unique<Job>();
+    textureJob->asset = job.asset;
+    textureJob->priority = job.priority;
+    textureJob->sequence = job.sequence;
+    textureJob->isModel = false;
+    textureJob->path = job.path;
+    textureJob->geometry = job.geometry;
+    textureJob->textureFile = std::move(job.textureFile);
+    textureJob->texture = job.texture;
+    job.texture = NTextureFile();
+    return textureJob;
+}
+
+std::unique_ptr<NAssetService::Job> NAssetService::popNext(std::vector<std::unique_ptr<Job>>& queue) {
+    if (queue.empty()) {
+        return nullptr;
+    }
+    auto it = std::min_element(queue.begin(), queue.end(), [](const auto& a, const auto& b) {
+        return a->priority != b->priority ? a->priority < b->priority : a->sequence < b->sequence;
+    });
+    std::unique_ptr<Job> job = std::move(*it);
+    queue.erase(it);
+    return job;
+}
+
+void touchPages(const NMappedFile& file) {
+    const volatile char* pages = file.data();
+    for (size_t offset = 0; offset < file.size(); offset += kPageSize) {
+        pages[offset];
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NRenderDevice.h"
+#include "NglSoldierGeometry.h"
+#include "nfile.h"
+#include "nimage.h"
+#include "nrender.h"
+#include "ntexfile.h"
+
+using NAssetHandle = NHandle<struct NAssetTag>;
+
+// Order in which pending assets are read, decoded and uploaded, requests of the same priority are served first come
+// first served
+enum class NAssetPriority {
+    kHigh,  // covers much of the screen, e.g. the terrain
+    kNormal,
+    kLow,
+};
+
+// GPU resources of a model, see NAssetService::mesh()
+struct NMeshAsset {
+    NBufferHandle vertexBuffer;    // NglVertex
+    NBufferHandle positionBuffer;  // glm::vec3, for the depth-only passes
+    NBufferHandle indexBuffer;
+    uint32_t indexCount = 0;
+    NTextureHandle animationTexture;  // kRgba32F, see nBakeAnimations()
+    NTextureHandle skinTexture;       // kRgba32F, see nBakeSkins()
+    // In the bind pose and in every animation frame
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+// Loads assets in the background so that the first frame does not wait for them. Files are mapped and paged in on an
+// I/O thread, decoded on a pool of worker threads, and their GPU resources are created on the main thread by update(),
+// within a time budget per frame. Until then a texture is a 1x1 placeholder of the requested color and a mesh is
+// missing.
+class NAssetService {
+public:
+    // With hasMipmaps, textures get their full mip chain: the levels of the texture file, or the device generates them
+    // from the image. Without, the largest level only.
+    NAssetService(NRenderDevice& device, bool hasMipmaps);
+    NAssetService(const NAssetService&) = delete;
+    NAssetService& operator=(const NAssetService&) = delete;
+    NAssetService(NAssetService&&) = delete;
+    NAssetService& operator=(NAssetService&&) = delete;
+    // Waits for the jobs in progress, pending requests are dropped
+    ~NAssetService();
+
+    // PNG or JPEG file, as a kRgba8 texture. The texture file next to it (see nTextureFilePath()) is loaded instead
+    // when there is one in a format the device supports, its blocks are uploaded as they are.
+    NAssetHandle requestTexture(const std::string& path, NAssetPriority priority, const glm::vec4& placeholderColor);
+    // .glb file like soldier.glb (see NglSoldierGeometry), a mesh and its embedded diffuse texture, or the texture
+    // file next to it like for requestTexture(). The mesh usually arrives first, texture() returns the placeholder
+    // until the texture follows.
+    NAssetHandle requestModel(const std::string& path, NAssetPriority priority, const glm::vec4& placeholderColor);
+
+    // Call once per frame on the main thread, before recording. Creates the GPU resources of decoded assets, highest
+    // priority first, until timeBudget seconds are spent. Does at least one upload if there is any, so loading always
+    // makes progress.
+    void update(double timeBudget);
+    // Blocks until every requested asset is ready, for runs that must render the same frames every time
+    void finish();
+
+    bool isReady(NAssetHandle asset) const;
+    // Assets requested but not ready yet
+    int pendingCount() const;
+    // The placeholder until the texture is ready
+    NTextureHandle texture(NAssetHandle asset) const;
+    // nullptr until the mesh is ready
+    const NMeshAsset* mesh(NAssetHandle asset) const;
+
+private:
+    // One asset on its way from file to GPU. A model's job is split in two once the model is decoded, one for the
+    // mesh and one for the embedded texture.
+    struct Job {
+        uint32_t asset;
+        NAssetPriority priority;
+        uint64_t sequence;       // request order
+        bool isModel;      // else a texture, from the file or embedded in geometry
+        std::string path;  // names the asset in the log
+        NMappedFile file;  // encoded, once read
+        NMappedFile textureFile;  // once read, if there is one to load in place of the image
+        NTextureFile texture;     // once read, points into textureFile
+        NImage image;             // once decoded, textures without a texture file
+        std::shared_ptr<const NglSoldierGeometry> geometry;  // once decoded, models
+    };
+
+    // Main thread only
+    struct Asset {
+        std::string path;
+        bool isModel;
+        double requestTime;
+        NTextureHandle texture;
+        bool isTextureReady = false;
+        NMeshAsset mesh;
+        bool isMeshReady = false;
+    };
+
+    NAssetHandle request(const std::string& path, bool isModel, NAssetPriority priority,
+                         const glm::vec4& placeholderColor);
+    NTextureHandle placeholder(const glm::vec4& color);
+    void upload(Job& job);
+    void readLoop();
+    // Returns false if there is no texture file the device can take
+    bool readTextureFile(Job& job) const;
+    void decodeLoop();
+    // Returns the job of a model's texture, which still has to be decoded
+    std::unique_ptr<Job> decode(Job& job);
+    // Highest priority, then oldest
+    static std::unique_ptr<Job> popNext(std::vector<std::unique_ptr<Job>>& queue);
+
+    NRenderDevice& mDevice;
+    bool mHasMipmaps;
+    std::vector<NTextureFormat> mSupportedFormats;  // block compressed, read by the I/O thread
+    std::deque<Asset> mAssets;  // indexed by handle, elements stay put
+    std::vector<std::pair<glm::vec4, NTextureHandle>> mPlaceholders;
+    uint64_t mNextSequence = 0;
+    int mPendingAssetCount = 0;
+
+    // Guards the queues and mIsStopping
+    std::mutex mMutex;
+    std::condition_variable mReadCondition;
+    std::condition_variable mDecodeCondition;
+    std::condition_variable mUploadCondition;
+    std::vector<std::unique_ptr<Job>> mReadQueue;
+    std::vector<std::unique_ptr<Job>> mDecodeQueue;
+    std::vector<std::unique_ptr<Job>> mUploadQueue;
+    bool mIsStopping = false;
+
+    std::thread mReadThread;
+    std::vector<std::thread> mDecodeThreads;
+};
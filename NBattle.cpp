@@ -0,0 +1,460 @@
+#include "NBattle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include "nglassert.h"
+#include "nparallel.h"
+#include "nprofile.h"
+
+using glm::vec2;
+
+// Soldiers strike the enemies within reach and see those within sight
+constexpr float kReach = 0.06f;
+constexpr float kSightRadius = 1.0f;
+// Of the grids that find the nearest enemy in sight. Cells of kReach would have a query visit hundreds of them when no
+// enemy is in sight.
+constexpr float kSightCellSize = kSightRadius / 4.0f;
+// Ground speeds, per second
+constexpr float kMarchSpeed = 0.05f;
+constexpr float kAdvanceSpeed = 0.15f;
+constexpr float kRoutSpeed = 0.3f;
+// Soldiers moved less than this per second stand, such as those waiting behind the ones in front of them
+constexpr float kIdleSpeed = 0.02f;
+// Health, out of 1, that each enemy within reach takes per second
+constexpr float kDamage = 0.1f;
+// Morale, out of 1, recovered per second out of combat, and lost per health lost and per second and enemy within
+// reach beyond the soldier and its friends within reach. Routing soldiers rally at kRallyMorale.
+constexpr float kMoraleRecovery = 0.1f;
+constexpr float kDamageMoraleLoss = 0.5f;
+constexpr float kOutnumberedMoraleLoss = 0.2f;
+constexpr float kRallyMorale = 0.5f;
+// Of two steps of the walk, and of a strike
+constexpr float kAnimationPeriod = 1.0f;
+// Below this many soldiers per part, waking the pool's threads costs more than the passes
+constexpr size_t kMinSoldiersPerPart = 4096;
+
+static void resolveDamage(float duration, size_t begin, size_t end, const float* __restrict attackerCounts,
+                          const float* __restrict friendCounts, float* __restrict health, float* __restrict morale,
+                          float* __restrict routing);
+static void resolveMovement(float duration, size_t begin, size_t end, const float* __restrict routing,
+                            const float* __restrict enemyCounts, const float* __restrict enemyX,
+                            const float* __restrict enemyZ, const float* __restrict pushX,
+                            const float* __restrict pushZ, const float* __restrict marchX,
+                            const float* __restrict marchZ, float* __restrict x, float* __restrict z,
+                            float* __restrict previousX, float* __restrict previousZ, float* __restrict headingX,
+                            float* __restrict headingZ, float* __restrict phase, uint32_t* __restrict animation);
+static vec2 separationPush(const vec2& offset, float distanceSquared, float tieDirection);
+static float fract(float value);
+
+NBattle::NBattle(const vec2& boundsMin, const vec2& boundsMax)
+    : mGrid(boundsMin, boundsMax, kReach),
+      mSightGrids{{boundsMin, boundsMax, kSightCellSize}, {boundsMin, boundsMax, kSightCellSize}} {}
+
+NBattle::~NBattle() {}
+
+void NBattle::copyStateFrom(const NBattle& battle) {
+    // The rest is scratch, written by every tick before it is read
+    mSoldiers = battle.mSoldiers;
+    std::copy(std::begin(battle.mSideEnds), std::end(battle.mSideEnds), mSideEnds);
+    std::copy(std::begin(battle.mCasualtyCounts), std::end(battle.mCasualtyCounts), mCasualtyCounts);
+    mLatestDuration = battle.mLatestDuration;
+}
+
+void NBattle::addSoldier(int side, uint32_t unit, const NInstance& instance) {
+    NGL_ASSERT(side == 0 || side == 1);
+    NGL_ASSERT(side == 1 || mSideEnds[1] == mSideEnds[0]);
+    NGL_ASSERT(mLatestDuration == 0.0f);
+    Soldiers& soldiers = mSoldiers;
+    const size_t i = soldiers.x.size();
+    soldiers.resize(i + 1);
+    soldiers.x[i] = soldiers.previousX[i] = instance.position.x;
+    soldiers.z[i] = soldiers.previousZ[i] = instance.position.z;
+    soldiers.headingX[i] = soldiers.marchX[i] = instance.heading.x;
+    soldiers.headingZ[i] = soldiers.marchZ[i] = instance.heading.y;
+    soldiers.health[i] = 1.0f;
+    soldiers.morale[i] = 1.0f;
+    soldiers.routing[i] = 0.0f;
+    soldiers.phase[i] = instance.phase;
+    soldiers.heightScale[i] = instance.heightScale;
+    soldiers.animation[i] = static_cast<uint32_t>(NAnimation::kWalk);
+    soldiers.unit[i] = unit;
+    if (side == 0) {
+        mSideEnds[0]++;
+    }
+    mSideEnds[1]++;
+}
+
+void NBattle::tick(float duration) {
+    NGL_ASSERT(duration > 0.0f);
+    mLatestDuration = duration;
+    const size_t count = mSoldiers.x.size();
+    if (count == 0) {
+        return;
+    }
+    const int partCount = nPartCount(count, kMinSoldiersPerPart);
+    {
+        NGL_PROFILE_SCOPE("Battle contacts");
+        findContacts(partCount);
+    }
+    {
+        NGL_PROFILE_SCOPE("Battle resolve");
+        resolve(duration, partCount);
+    }
+    {
+        NGL_PROFILE_SCOPE("Battle casualties");
+        removeDead(partCount);
+    }
+}
+
+void NBattle::writeSnapshot(const NglTerrainGeometry& terrainGeometry, bool isAnimated, NArmySnapshot& snapshot) const {
+    const Soldiers& soldiers = mSoldiers;
+    const size_t count = soldiers.x.size();
+    snapshot.instances.resize(count);
+    snapshot.previousInstances.resize(count);
+    snapshot.units.clear();
+    for (size_t i = 0; i < count; i++) {
+        const float x = soldiers.x[i];
+        const float z = soldiers.z[i];
+        NInstance& instance = snapshot.instances[i];
+        instance.position = glm::vec3(x, terrainGeometry.height(x, z), z);
+        instance.heightScale = soldiers.heightScale[i];
+        instance.heading = vec2(soldiers.headingX[i], soldiers.headingZ[i]);
+        instance.phase = soldiers.phase[i];
+        instance.animation = isAnimated ? soldiers.animation[i] : kNStaticPose;
+
+        const float previousX = soldiers.previousX[i];
+        const float previousZ = soldiers.previousZ[i];
+        NInstance& previous = snapshot.previousInstances[i];
+        previous = instance;
+        previous.position = glm::vec3(previousX, terrainGeometry.height(previousX, previousZ), previousZ);
+        previous.phase = fract(instance.phase - mLatestDuration / kAnimationPeriod);
+
+        if (i == 0 || soldiers.unit[i] != soldiers.unit[i - 1]) {
+            snapshot.units.push_back({static_cast<uint32_t>(i), 0, vec2(0.0f), 0.0f, instance.position.y,
+                                      instance.position.y});
+        }
+        NArmyUnit& unit = snapshot.units.back();
+        unit.instanceCount++;
+        unit.center += vec2(x, z);
+        unit.minHeight = std::min({unit.minHeight, instance.position.y, previous.position.y});
+        unit.maxHeight = std::max({unit.maxHeight, instance.position.y, previous.position.y});
+    }
+
+    // Around the soldiers at both ticks, and so wherever they are rendered between them
+    for (NArmyUnit& unit : snapshot.units) {
+        unit.center /= static_cast<float>(unit.instanceCount);
+        float radiusSquared = 0.0f;
+        for (size_t i = unit.firstInstance; i < unit.firstInstance + unit.instanceCount; i++) {
+            vec2 offset = vec2(soldiers.x[i], soldiers.z[i]) - unit.center;
+            vec2 previousOffset = vec2(soldiers.previousX[i], soldiers.previousZ[i]) - unit.center;
+            radiusSquared =
+                    std::max({radiusSquared, glm::dot(offset, offset), glm::dot(previousOffset, previousOffset)});
+        }
+        unit.radius = std::sqrt(radiusSquared);
+    }
+}
+
+size_t NBattle::soldierCount(int side) const {
+    return side == 0 ? mSideEnds[0] : mSideEnds[1] - mSideEnds[0];
+}
+
+size_t NBattle::casualtyCount(int side) const {
+    return mCasualtyCounts[side];
+}
+
+void NBattle::findContacts(int partCount) {
+    const Soldiers& soldiers = mSoldiers;
+    const size_t count = soldiers.x.size();
+    const size_t sideBegins[2] = {0, mSideEnds[0]};
+    mPositions.resize(count);
+    mSidePositions[0].resize(soldierCount(0));
+    mSidePositions[1].resize(soldierCount(1));
+    nRunParts(partCount, [&](int part) {
+        auto [begin, end] = nPartRange(count, part, partCount);
+        for (size_t i = begin; i < end; i++) {
+            const int side = i < mSideEnds[0] ? 0 : 1;
+            mPositions[i] = mSidePositions[side][i - sideBegins[side]] = vec2(soldiers.x[i], soldiers.z[i]);
+        }
+    });
+    // The three grids at once, each rebuilt on as many threads as it uses
+    nRunParts(3, [&](int grid) {
+        if (grid < 2) {
+            mSightGrids[grid].rebuild(mSidePositions[grid]);
+        } else {
+            mGrid.rebuild(mPositions);
+        }
+    });
+
+    mUnitStarts.clear();
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || i == mSideEnds[0] || soldiers.unit[i] != soldiers.unit[i - 1]) {
+            mUnitStarts.push_back(i);
+        }
+    }
+    mUnitStarts.push_back(count);
+
+    mEnemyCounts.resize(count);
+    mAttackerCounts.resize(count);
+    mFriendCounts.resize(count);
+    mEnemyX.resize(count);
+    mEnemyZ.resize(count);
+    mPushX.resize(count);
+    mPushZ.resize(count);
+    // Parts of whole units, which are about the same size
+    const size_t unitCount = mUnitStarts.size() - 1;
+    nRunParts(partCount, [&](int part) {
+        auto [firstUnit, lastUnit] = nPartRange(unitCount, part, partCount);
+        std::vector<uint32_t> found;
+        for (size_t unit = firstUnit; unit < lastUnit; unit++) {
+            const size_t unitBegin = mUnitStarts[unit];
+            const size_t unitEnd = mUnitStarts[unit + 1];
+            const int side = unitBegin < mSideEnds[0] ? 0 : 1;
+            const int enemySide = 1 - side;
+            const std::vector<vec2>& enemies = mSidePositions[enemySide];
+
+            // Soldiers look for the nearest enemy in sight only when one is in sight of the unit's bounding circle,
+            // which spares the units far from the enemy a query per soldier
+            vec2 boundsMin = mPositions[unitBegin];
+            vec2 boundsMax = boundsMin;
+            for (size_t i = unitBegin; i < unitEnd; i++) {
+                boundsMin = glm::min(boundsMin, mPositions[i]);
+                boundsMax = glm::max(boundsMax, mPositions[i]);
+            }
+            const vec2 unitCenter = (boundsMin + boundsMax) * 0.5f;
+            mSightGrids[enemySide].queryNearest(unitCenter, 1, kSightRadius + glm::length(boundsMax - unitCenter),
+                                                found);
+            const bool isEnemyInSight = !found.empty();
+
+            for (size_t i = unitBegin; i < unitEnd; i++) {
+                const vec2 position = mPositions[i];
+                vec2 push(0.0f);
+
+                // Enemies within reach strike, unless routing. The soldier faces the nearest of them, or the nearest
+                // in sight when none is within reach. Friends within reach, the soldier itself left out, count against
+                // being outnumbered. Soldiers in the same place part along x, enemies with side 0 to the left.
+                found.clear();
+                mGrid.queryRadius(position, kReach, found);
+                float enemyCount = 0.0f;
+                float attackerCount = 0.0f;
+                float friendCount = 0.0f;
+                float nearestDistanceSquared = std::numeric_limits<float>::infinity();
+                vec2 nearestOffset(0.0f);
+                for (uint32_t other : found) {
+                    if (other == i) {
+                        continue;
+                    }
+                    const vec2 offset = mPositions[other] - position;
+                    const float distanceSquared = glm::dot(offset, offset);
+                    if ((other < mSideEnds[0] ? 0 : 1) == side) {
+                        push += separationPush(-offset, distanceSquared, other > i ? -1.0f : 1.0f);
+                        friendCount += 1.0f;
+                        continue;
+                    }
+                    enemyCount += 1.0f;
+                    attackerCount += 1.0f - soldiers.routing[other];
+                    if (distanceSquared < nearestDistanceSquared) {
+                        nearestDistanceSquared = distanceSquared;
+                        nearestOffset = offset;
+                    }
+                    push += separationPush(-offset, distanceSquared, side == 0 ? -1.0f : 1.0f);
+                }
+                if (enemyCount == 0.0f && isEnemyInSight) {
+                    mSightGrids[enemySide].queryNearest(position, 1, kSightRadius, found);
+                    if (!found.empty()) {
+                        nearestOffset = enemies[found[0]] - position;
+                        nearestDistanceSquared = glm::dot(nearestOffset, nearestOffset);
+                    }
+                }
+                const bool hasEnemy =
+                        nearestDistanceSquared > 0.0f && nearestDistanceSquared <= kSightRadius * kSightRadius;
+                const vec2 enemyDirection = hasEnemy ? nearestOffset / std::sqrt(nearestDistanceSquared) : vec2(0.0f);
+                mEnemyCounts[i] = enemyCount;
+                mAttackerCounts[i] = attackerCount;
+                mFriendCounts[i] = friendCount;
+                mEnemyX[i] = enemyDirection.x;
+                mEnemyZ[i] = enemyDirection.y;
+                mPushX[i] = push.x;
+                mPushZ[i] = push.y;
+            }
+        }
+    });
+}
+
+void NBattle::resolve(float duration, int partCount) {
+    Soldiers& soldiers = mSoldiers;
+    const size_t count = soldiers.x.size();
+    const size_t side0End = mSideEnds[0];
+    // Per part, the survivors of side 0 then those of side 1
+    mPartSurvivorCounts.assign(partCount * 2, 0);
+    nRunParts(partCount, [&](int part) {
+        auto [begin, end] = nPartRange(count, part, partCount);
+        resolveDamage(duration, begin, end, mAttackerCounts.data(), mFriendCounts.data(), soldiers.health.data(),
+                      soldiers.morale.data(), soldiers.routing.data());
+        resolveMovement(duration, begin, end, soldiers.routing.data(), mEnemyCounts.data(), mEnemyX.data(),
+                        mEnemyZ.data(), mPushX.data(), mPushZ.data(), soldiers.marchX.data(), soldiers.marchZ.data(),
+                        soldiers.x.data(), soldiers.z.data(), soldiers.previousX.data(), soldiers.previousZ.data(),
+                        soldiers.headingX.data(), soldiers.headingZ.data(), soldiers.phase.data(),
+                        soldiers.animation.data());
+
+        // For removeDead()
+        const float* health = soldiers.health.data();
+        size_t side0SurvivorCount = 0;
+        size_t side1SurvivorCount = 0;
+        for (size_t i = begin; i < end; i++) {
+            size_t isAlive = health[i] > 0.0f ? 1 : 0;
+            side0SurvivorCount += i < side0End ? isAlive : 0;
+            side1SurvivorCount += i < side0End ? 0 : isAlive;
+        }
+        mPartSurvivorCounts[part * 2] = side0SurvivorCount;
+        mPartSurvivorCounts[part * 2 + 1] = side1SurvivorCount;
+    });
+}
+
+void NBattle::removeDead(int partCount) {
+    const size_t count = mSoldiers.x.size();
+    // Each part's survivors go after those of the parts before it, which keeps their order
+    std::vector<size_t> partStarts(partCount);
+    size_t sideSurvivorCounts[2] = {};
+    for (int part = 0; part < partCount; part++) {
+        partStarts[part] = sideSurvivorCounts[0] + sideSurvivorCounts[1];
+        sideSurvivorCounts[0] += mPartSurvivorCounts[part * 2];
+        sideSurvivorCounts[1] += mPartSurvivorCounts[part * 2 + 1];
+    }
+    const size_t survivorCount = sideSurvivorCounts[0] + sideSurvivorCounts[1];
+    if (survivorCount == count) {
+        return;
+    }
+    mCasualtyCounts[0] += soldierCount(0) - sideSurvivorCounts[0];
+    mCasualtyCounts[1] += soldierCount(1) - sideSurvivorCounts[1];
+    mSideEnds[0] = sideSurvivorCounts[0];
+    mSideEnds[1] = survivorCount;
+
+    const Soldiers& from = mSoldiers;
+    Soldiers& to = mSurvivors;
+    to.resize(survivorCount);
+    // Survivors are copied in runs, an array at a time. A soldier at a time, across all of the arrays, was six times
+    // slower.
+    nRunParts(partCount, [&](int part) {
+        auto [begin, end] = nPartRange(count, part, partCount);
+        size_t k = partStarts[part];
+        for (size_t i = begin; i < end;) {
+            if (from.health[i] <= 0.0f) {
+                i++;
+                continue;
+            }
+            size_t runEnd = i + 1;
+            while (runEnd < end && from.health[runEnd] > 0.0f) {
+                runEnd++;
+            }
+            to.copyRange(from, i, runEnd, k);
+            k += runEnd - i;
+            i = runEnd;
+        }
+    });
+    std::swap(mSoldiers, mSurvivors);
+}
+
+void NBattle::Soldiers::resize(size_t count) {
+    for (std::vector<float>* values : {&x, &z, &previousX, &previousZ, &headingX, &headingZ, &marchX, &marchZ,
+                                       &health, &morale, &routing, &phase, &heightScale}) {
+        values->resize(count);
+    }
+    animation.resize(count);
+    unit.resize(count);
+}
+
+void NBattle::Soldiers::copyRange(const Soldiers& from, size_t begin, size_t end, size_t destination) {
+    for (std::vector<float> Soldiers::*values :
+         {&Soldiers::x, &Soldiers::z, &Soldiers::previousX, &Soldiers::previousZ, &Soldiers::headingX,
+          &Soldiers::headingZ, &Soldiers::marchX, &Soldiers::marchZ, &Soldiers::health, &Soldiers::morale,
+          &Soldiers::routing, &Soldiers::phase, &Soldiers::heightScale}) {
+        std::copy((from.*values).begin() + begin, (from.*values).begin() + end, (this->*values).begin() + destination);
+    }
+    std::copy(from.animation.begin() + begin, from.animation.begin() + end, animation.begin() + destination);
+    std::copy(from.unit.begin() + begin, from.unit.begin() + end, unit.begin() + destination);
+}
+
+// The resolve passes are loops without branches over soldiers begin to end, vectorized by the compiler. The arrays
+// are __restrict, none overlaps another, which spares the compiler from checking that they do not before each loop
+// and from giving up when there are too many of them to check.
+
+// Damage taken from the enemies within reach, and morale
+void resolveDamage(float duration, size_t begin, size_t end, const float* __restrict attackerCounts,
+                   const float* __restrict friendCounts, float* __restrict health, float* __restrict morale,
+                   float* __restrict routing) {
+    for (size_t i = begin; i < end; i++) {
+        float attackerCount = attackerCounts[i];
+        float wasRouting = routing[i];
+        float damage = attackerCount * (kDamage * duration);
+        float outnumbering = std::max(attackerCount - friendCounts[i] - 1.0f, 0.0f);
+        float recovery = attackerCount > 0.0f ? 0.0f : kMoraleRecovery * duration;
+        float newMorale = morale[i] + recovery - damage * kDamageMoraleLoss -
+                          outnumbering * (kOutnumberedMoraleLoss * duration);
+        newMorale = std::min(std::max(newMorale, 0.0f), 1.0f);
+        health[i] -= damage;
+        morale[i] = newMorale;
+        routing[i] = newMorale <= 0.0f ? 1.0f : (newMorale >= kRallyMorale ? 0.0f : wasRouting);
+    }
+}
+
+// Routing soldiers flee the nearest enemy in sight, or run on when they see none. The others stand and strike when an
+// enemy is within reach, advance on the nearest one in sight, or march on. Conditions are 0 or 1 factors and the
+// selects are between values computed either way, so that nothing the compiler might branch around is left.
+void resolveMovement(float duration, size_t begin, size_t end, const float* __restrict routing,
+                     const float* __restrict enemyCounts, const float* __restrict enemyX,
+                     const float* __restrict enemyZ, const float* __restrict pushX, const float* __restrict pushZ,
+                     const float* __restrict marchX, const float* __restrict marchZ, float* __restrict x,
+                     float* __restrict z, float* __restrict previousX, float* __restrict previousZ,
+                     float* __restrict headingX, float* __restrict headingZ, float* __restrict phase,
+                     uint32_t* __restrict animation) {
+    const float phaseStep = duration / kAnimationPeriod;
+    const float idleDistanceSquared = (kIdleSpeed * duration) * (kIdleSpeed * duration);
+    for (size_t i = begin; i < end; i++) {
+        float isRouting = routing[i];
+        float hasEnemy = enemyX[i] * enemyX[i] + enemyZ[i] * enemyZ[i] > 0.0f ? 1.0f : 0.0f;
+        float isEngaged = (enemyCounts[i] > 0.0f ? 1.0f : 0.0f) * (1.0f - isRouting);
+        float towardsEnemy = hasEnemy * (1.0f - 2.0f * isRouting);
+        float withoutEnemy = 1.0f - hasEnemy;
+        float directionX =
+                towardsEnemy * enemyX[i] + withoutEnemy * (isRouting * headingX[i] + (1.0f - isRouting) * marchX[i]);
+        float directionZ =
+                towardsEnemy * enemyZ[i] + withoutEnemy * (isRouting * headingZ[i] + (1.0f - isRouting) * marchZ[i]);
+        float speed = isRouting * kRoutSpeed +
+                      (1.0f - isRouting) * (1.0f - isEngaged) * (hasEnemy * kAdvanceSpeed + withoutEnemy * kMarchSpeed);
+        float moveX = directionX * (speed * duration) + pushX[i];
+        float moveZ = directionZ * (speed * duration) + pushZ[i];
+        previousX[i] = x[i];
+        previousZ[i] = z[i];
+        x[i] += moveX;
+        z[i] += moveZ;
+        headingX[i] = directionX;
+        headingZ[i] = directionZ;
+        // Phases are positive, truncating wraps them
+        float nextPhase = phase[i] + phaseStep;
+        phase[i] = nextPhase - static_cast<float>(static_cast<int>(nextPhase));
+        uint32_t moving = moveX * moveX + moveZ * moveZ < idleDistanceSquared
+                                  ? static_cast<uint32_t>(NAnimation::kIdle)
+                                  : static_cast<uint32_t>(NAnimation::kWalk);
+        uint32_t engagedMask = isEngaged > 0.0f ? ~0u : 0u;
+        animation[i] = (static_cast<uint32_t>(NAnimation::kAttack) & engagedMask) | (moving & ~engagedMask);
+    }
+}
+
+// Half of the overlap of two soldiers closer than kSeparationRadius, away from the other one. offset is from the
+// other one, those in the same place part along x in tieDirection.
+vec2 separationPush(const vec2& offset, float distanceSquared, float tieDirection) {
+    if (distanceSquared >= kSeparationRadius * kSeparationRadius) {
+        return vec2(0.0f);
+    }
+    float distance = std::sqrt(distanceSquared);
+    vec2 direction = distance > 0.0f ? offset / distance : vec2(tieDirection, 0.0f);
+    return direction * ((kSeparationRadius - distance) * 0.5f);
+}
+
+// Like GLSL's, also for negative values
+float fract(float value) {
+    return value - std::floor(value);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NSpatialGrid.h"
+#include "NglTerrainGeometry.h"
+#include "nglarmy.h"
+#include "nrender.h"
+
+// Two sides fighting on the ground (x, z). Each tick, soldiers find the enemies and friends within reach through a
+// spatial grid of all soldiers and the nearest enemy in sight through a coarser grid per side, then damage, morale and
+// movement are resolved for every soldier at once and the dead are dropped. Soldiers are kept as a structure of arrays,
+// an array per attribute, so that the resolve passes are branch-free loops over contiguous floats which the compiler
+// vectorizes. Every pass is split over threads.
+//
+// A soldier strikes the enemies within reach and stands, advances on the nearest enemy in sight otherwise, and marches
+// on when it sees none. Morale falls with the damage taken and with being outnumbered, and recovers out of combat. A
+// soldier whose morale is gone flees from the nearest enemy until it has rallied. The dead are removed by compacting
+// the arrays, which keeps the soldiers of a unit next to each other, in the order they were added.
+class NBattle {
+public:
+    // Soldiers are expected within the bounds, those outside are slower to find
+    NBattle(const glm::vec2& boundsMin, const glm::vec2& boundsMax);
+    NBattle(const NBattle&) = delete;
+    NBattle& operator=(const NBattle&) = delete;
+    NBattle(NBattle&&) = delete;
+    NBattle& operator=(NBattle&&) = delete;
+    ~NBattle();
+
+    // A soldier of side 0 or 1, where instance stands and facing the way it marches. Soldiers of side 0 are all added
+    // before those of side 1, those of a unit one after the other, and no soldier is added once the battle ticked.
+    void addSoldier(int side, uint32_t unit, const NInstance& instance);
+    void tick(float duration);
+    // Takes the soldiers and casualties of battle, over the same bounds, as they are after its latest tick. Lets the
+    // same tick be run again and again, as benchmarks do.
+    void copyStateFrom(const NBattle& battle);
+    // Soldiers of the latest tick on the terrain, and the same soldiers at the tick before. Without isAnimated, they
+    // are drawn in the static pose.
+    void writeSnapshot(const NglTerrainGeometry& terrainGeometry, bool isAnimated, NArmySnapshot& snapshot) const;
+
+    size_t soldierCount(int side) const;
+    // Since the battle began
+    size_t casualtyCount(int side) const;
+
+private:
+    // A value per soldier in each array, the soldiers of side 0 first
+    struct Soldiers {
+        std::vector<float> x, z;
+        std::vector<float> previousX, previousZ;  // at the tick before
+        std::vector<float> headingX, headingZ;    // unit length
+        std::vector<float> marchX, marchZ;        // direction marched in with no enemy in sight, unit length
+        std::vector<float> health;                // dead at 0
+        std::vector<float> morale;                // routs at 0
+        std::vector<float> routing;               // 1 while routing, 0 otherwise
+        std::vector<float> phase;                 // of the animation
+        std::vector<float> heightScale;
+        std::vector<uint32_t> animation;          // NAnimation
+        std::vector<uint32_t> unit;
+
+        void resize(size_t count);
+        // Soldiers [begin, end) of from to this from destination on
+        void copyRange(const Soldiers& from, size_t begin, size_t end, size_t destination);
+    };
+
+    void findContacts(int partCount);
+    void resolve(float duration, int partCount);
+    void removeDead(int partCount);
+
+    Soldiers mSoldiers;
+    Soldiers mSurvivors;  // compacted into, then swapped with mSoldiers
+    size_t mSideEnds[2] = {};
+    size_t mCasualtyCounts[2] = {};
+    float mLatestDuration = 0.0f;  // of the latest tick
+
+    // Scratch of tick(), per soldier
+    std::vector<float> mEnemyCounts;     // enemies within reach
+    std::vector<float> mAttackerCounts;  // enemies within reach that are not routing
+    std::vector<float> mFriendCounts;    // friends within reach
+    std::vector<float> mEnemyX, mEnemyZ;  // towards the nearest enemy in sight, unit length, 0 for none
+    std::vector<float> mPushX, mPushZ;    // apart from the soldiers closer than kSeparationRadius
+    std::vector<glm::vec2> mPositions;
+    std::vector<glm::vec2> mSidePositions[2];
+    NSpatialGrid mGrid;           // of mPositions
+    NSpatialGrid mSightGrids[2];  // of each side's positions
+    std::vector<size_t> mUnitStarts;  // soldier count last
+    std::vector<size_t> mPartSurvivorCounts;
+};
@@ -0,0 +1,134 @@
+#include "NBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <numeric>
+
+#include "ngllog.h"
+
+static void writeSummary(FILE* file, const std::vector<double>& values);
+static double percentile(const std::vector<double>& sortedValues, double p);
+
+NBenchmark::NBenchmark(const char* label) : mLabel(label) {
+    mCpuFrameTimes.name = "cpuFrameTime";
+    mFrameTimes.name = "frameTime";
+    mGpuFrameTimes.name = "gpuFrameTime";
+}
+
+NBenchmark::~NBenchmark() {}
+
+void NBenchmark::onFrame(double time, double cpuFrameTime) {
+    if (mStartTime < 0) {
+        mStartTime = time;
+    } else {
+        mFrameTimes.values.push_back(time - mPreviousFrameTime);
+    }
+    mPreviousFrameTime = time;
+    mCpuFrameTimes.values.push_back(cpuFrameTime);
+}
+
+void NBenchmark::onPassStats(const std::vector<NPassStats>& passStats) {
+    // Devices keep reporting the latest frame they have results for until a newer one is available
+    if (mStartTime < 0 || passStats.empty() || passStats.front().startTime < mStartTime ||
+        passStats.front().startTime <= mLastGpuFrameStartTime) {
+        return;
+    }
+    mLastGpuFrameStartTime = passStats.front().startTime;
+
+    // Scopes of different passes may have the same name
+    std::string passName;
+    double gpuFrameTime = 0;
+    for (const NPassStats& stats : passStats) {
+        std::string name = stats.isScope ? passName + " / " + stats.name : stats.name;
+        if (!stats.isScope) {
+            passName = stats.name;
+            gpuFrameTime += stats.gpuTime;
+        }
+        auto it = std::find_if(mPassTimes.begin(), mPassTimes.end(),
+                               [&](const Series& series) { return series.name == name; });
+        if (it == mPassTimes.end()) {
+            it = mPassTimes.insert(mPassTimes.end(), Series{name, {}});
+        }
+        it->values.push_back(stats.gpuTime);
+    }
+    mGpuFrameTimes.values.push_back(gpuFrameTime);
+}
+
+int NBenchmark::frameCount() const {
+    return static_cast<int>(mCpuFrameTimes.values.size());
+}
+
+const std::vector<double>& NBenchmark::cpuFrameTimes() const {
+    return mCpuFrameTimes.values;
+}
+
+const std::vector<double>& NBenchmark::gpuFrameTimes() const {
+    return mGpuFrameTimes.values;
+}
+
+bool NBenchmark::writeJson(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+        return false;
+    }
+
+    // Times in milliseconds. Names are pass names and literals, none needs escaping.
+    fprintf(file, "{\n  \"device\": \"%s\",\n  \"frameCount\": %d,\n", mLabel, frameCount());
+    fprintf(file, "  \"summary\": {\n");
+    const Series* frameSeries[] = {&mCpuFrameTimes, &mFrameTimes, &mGpuFrameTimes};
+    for (const Series* series : frameSeries) {
+        fprintf(file, "    \"%s\": ", series->name.c_str());
+        writeSummary(file, series->values);
+        fprintf(file, ",\n");
+    }
+    fprintf(file, "    \"passes\": {");
+    for (size_t i = 0; i < mPassTimes.size(); i++) {
+        fprintf(file, "%s\n      \"%s\": ", i == 0 ? "" : ",", mPassTimes[i].name.c_str());
+        writeSummary(file, mPassTimes[i].values);
+    }
+    fprintf(file, "\n    }\n  },\n  \"frames\": {\n");
+    for (size_t i = 0; i < std::size(frameSeries); i++) {
+        fprintf(file, "    \"%s\": [", frameSeries[i]->name.c_str());
+        const std::vector<double>& values = frameSeries[i]->values;
+        for (size_t j = 0; j < values.size(); j++) {
+            fprintf(file, "%s%0.4f", j == 0 ? "" : ", ", values[j] * 1000.0);
+        }
+        fprintf(file, "]%s\n", i + 1 < std::size(frameSeries) ? "," : "");
+    }
+    fprintf(file, "  }\n}\n");
+    bool isWritten = ferror(file) == 0;
+    fclose(file);
+
+    std::vector<double> cpuFrameTimes = mCpuFrameTimes.values;
+    std::sort(cpuFrameTimes.begin(), cpuFrameTimes.end());
+    NGL_LOGI("%s benchmark: %d frames, CPU frame time p50 %0.3fms, p99 %0.3fms, written to %s", mLabel, frameCount(),
+             percentile(cpuFrameTimes, 50.0) * 1000.0, percentile(cpuFrameTimes, 99.0) * 1000.0, path.c_str());
+    return isWritten;
+}
+
+void writeSummary(FILE* file, const std::vector<double>& values) {
+    std::vector<double> sortedValues = values;
+    std::sort(sortedValues.begin(), sortedValues.end());
+    double mean = sortedValues.empty() ? 0.0
+                                       : std::accumulate(sortedValues.begin(), sortedValues.end(), 0.0) /
+                                                 static_cast<double>(sortedValues.size());
+    fprintf(file,
+            "{\"count\": %zu, \"mean\": %0.4f, \"min\": %0.4f, \"p50\": %0.4f, \"p90\": %0.4f, \"p95\": %0.4f, "
+            "\"p99\": %0.4f, \"max\": %0.4f}",
+            sortedValues.size(), mean * 1000.0, percentile(sortedValues, 0.0) * 1000.0,
+            percentile(sortedValues, 50.0) * 1000.0, percentile(sortedValues, 90.0) * 1000.0,
+            percentile(sortedValues, 95.0) * 1000.0, percentile(sortedValues, 99.0) * 1000.0,
+            percentile(sortedValues, 100.0) * 1000.0);
+}
+
+double percentile(const std::vector<double>& sortedValues, double p) {
+    // Nearest rank
+    if (sortedValues.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sortedValues.size())));
+    return sortedValues[std::clamp<size_t>(rank, 1, sortedValues.size()) - 1];
+}
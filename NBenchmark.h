@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "nrender.h"
+
+// Records the frames of a benchmark run and writes them as JSON: per-frame CPU frame time (as in NFrameStats), time
+// between frames, GPU frame time (the sum of the pass times) and GPU time of each pass and scope, along with their
+// mean and percentiles. GPU times arrive a few frames late, those of the last frames of a run are missing.
+class NBenchmark {
+public:
+    NBenchmark(const char* label);
+    NBenchmark(const NBenchmark&) = delete;
+    NBenchmark& operator=(const NBenchmark&) = delete;
+    NBenchmark(NBenchmark&&) = delete;
+    NBenchmark& operator=(NBenchmark&&) = delete;
+    ~NBenchmark();
+
+    // Call for every measured frame, GPU times of frames started before the first one are ignored
+    void onFrame(double time, double cpuFrameTime);
+    // Call once per frame with NRenderDevice::passStats()
+    void onPassStats(const std::vector<NPassStats>& passStats);
+
+    int frameCount() const;
+    // Seconds, in frame order
+    const std::vector<double>& cpuFrameTimes() const;
+    const std::vector<double>& gpuFrameTimes() const;
+    // Returns false if the file cannot be written
+    bool writeJson(const std::string& path) const;
+
+private:
+    struct Series {
+        std::string name;
+        std::vector<double> values;  // seconds
+    };
+
+    const char* const mLabel;
+    double mStartTime = -1;
+    double mPreviousFrameTime = -1;
+    double mLastGpuFrameStartTime = -1;
+    Series mCpuFrameTimes;
+    Series mFrameTimes;
+    Series mGpuFrameTimes;
+    std::vector<Series> mPassTimes;  // in the order passes were first seen
+};
@@ -1,8 +1,9 @@
-#include "NvkCamera.h"
+#include "NCamera.h"
 
 #include <algorithm>
 
-#include "nvkvk.h"
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
 
 constexpr float kAcceleration = 8.0f;
 constexpr float kDeceleration = 6.0f;
@@ -10,12 +11,12 @@ constexpr float kFasterFactor = 8.0f;
 constexpr float kMaxSpeed = 1.0f;
 constexpr float kRotationFactor = 2.0f;
 
-NvkCamera::NvkCamera(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up)
+NCamera::NCamera(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up)
     : mOriginalPosition(position), mOriginalTarget(target), mOriginalUp(up) {
     reset();
 }
 
-bool NvkCamera::onKeyEvent(int key, int /*scancode*/, int action, int mods) {
+bool NCamera::onKeyEvent(int key, int /*scancode*/, int action, int mods) {
     bool handled = false;
     bool pressed = action != GLFW_RELEASE;
     if (key == GLFW_KEY_W) {
@@ -50,7 +51,7 @@ bool NvkCamera::onKeyEvent(int key, int /*scancode*/, int action, int mods) {
     return handled;
 }
 
-bool NvkCamera::onMouseButtonEvent(GLFWwindow* window, int button, int action, int /*mods*/) {
+bool NCamera::onMouseButtonEvent(GLFWwindow* window, int button, int action, int /*mods*/) {
     bool handled = false;
     if (button == GLFW_MOUSE_BUTTON_LEFT) {
         mRotationActive = action == GLFW_PRESS;
@@ -66,7 +67,7 @@ bool NvkCamera::onMouseButtonEvent(GLFWwindow* window, int button, int action, i
     return handled;
 }
 
-bool NvkCamera::onMouseMotionEvent(GLFWwindow* window, double x, double y) {
+bool NCamera::onMouseMotionEvent(GLFWwindow* window, double x, double y) {
     bool handled = false;
     if (mRotationActive) {
         glm::vec2 mousePosition = glm::vec2(x, y);
@@ -84,9 +85,8 @@ bool NvkCamera::onMouseMotionEvent(GLFWwindow* window, double x, double y) {
     return handled;
 }
 
-void NvkCamera::onNextFrame(double time) {
-    float timeDeltaSeconds = static_cast<float>(time - mPreviousFrameTime);
-    mPreviousFrameTime = time;
+void NCamera::onTick(float tickDuration) {
+    mPreviousPosition = mPosition;
 
     const glm::mat4 orientation = glm::mat4_cast(mLookAtOrientation);
     const glm::vec3 forward = -glm::vec3(orientation[0][2], orientation[1][2], orientation[2][2]);
@@ -119,32 +119,55 @@ void NvkCamera::onNextFrame(double time) {
 
     if (direction == glm::vec3(0)) {
         // decelerate naturally according to the damping value
-        mVelocity -= mVelocity * std::min(kDeceleration * timeDeltaSeconds, 1.0f);
+        mVelocity -= mVelocity * std::min(kDeceleration * tickDuration, 1.0f);
     } else {
         // acceleration
-        mVelocity += direction * kAcceleration * timeDeltaSeconds;
+        mVelocity += direction * kAcceleration * tickDuration;
         const float maxSpeed = mMoveOrder.faster ? kMaxSpeed * kFasterFactor : kMaxSpeed;
         if (glm::length(mVelocity) > maxSpeed) {
             mVelocity = glm::normalize(mVelocity) * maxSpeed;
         }
     }
 
-    mPosition += mVelocity * timeDeltaSeconds;
+    mPosition += mVelocity * tickDuration;
 }
 
-glm::mat4 NvkCamera::getModelViewMatrix() const {
-    const glm::mat4 t = glm::translate(glm::mat4(1.0f), -mPosition);
+void NCamera::interpolate(float alpha) {
+    mRenderPosition = glm::mix(mPreviousPosition, mPosition, alpha);
+}
+
+void NCamera::setLookAt(const glm::vec3& position, const glm::vec3& target) {
+    mPosition = position;
+    mPreviousPosition = position;
+    mRenderPosition = position;
+    mLookAtOrientation = glm::lookAt(position, target, mOriginalUp);
+    mVelocity = glm::vec3(0.0f);
+}
+
+glm::mat4 NCamera::getModelViewMatrix() const {
+    const glm::mat4 t = glm::translate(glm::mat4(1.0f), -mRenderPosition);
     const glm::mat4 r = glm::mat4_cast(mLookAtOrientation);
     return r * t;
 }
 
-void NvkCamera::reset() {
+glm::vec3 NCamera::getPosition() const {
+    return mRenderPosition;
+}
+
+glm::vec3 NCamera::getTarget() const {
+    const glm::mat4 orientation = glm::mat4_cast(mLookAtOrientation);
+    return mRenderPosition - glm::vec3(orientation[0][2], orientation[1][2], orientation[2][2]);
+}
+
+void NCamera::reset() {
     mPosition = mOriginalPosition;
+    mPreviousPosition = mOriginalPosition;
+    mRenderPosition = mOriginalPosition;
     mLookAtOrientation = glm::lookAt(mOriginalPosition, mOriginalTarget, mOriginalUp);
     mVelocity = glm::vec3(0.0f);
 }
 
-void NvkCamera::resetUp() {
+void NCamera::resetUp() {
     glm::mat4 orientation = glm::mat4_cast(mLookAtOrientation);
     glm::vec3 dir = -glm::vec3(orientation[0][2], orientation[1][2], orientation[2][2]);
     mLookAtOrientation = glm::lookAt(mPosition, mPosition + dir, mOriginalUp);
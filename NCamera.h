@@ -5,16 +5,25 @@
 
 struct GLFWwindow;
 
-class NglCamera {
+class NCamera {
 public:
-    NglCamera(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up);
+    NCamera(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up);
 
     bool onKeyEvent(int key, int scancode, int action, int mods);
     bool onMouseButtonEvent(GLFWwindow* window, int button, int action, int mods);
     bool onMouseMotionEvent(GLFWwindow* window, double x, double y);
-    void onNextFrame(double time);
-
+    // Moves the camera by a simulation tick of the given duration
+    void onTick(float tickDuration);
+    // Places the rendered camera between where it was before the latest tick and after it (see NSimulationClock)
+    void interpolate(float alpha);
+    // Moves the camera along a scripted path, keeps the original up vector
+    void setLookAt(const glm::vec3& position, const glm::vec3& target);
+
+    // Of the rendered camera
     glm::mat4 getModelViewMatrix() const;
+    glm::vec3 getPosition() const;
+    // A point straight ahead, for recording camera paths
+    glm::vec3 getTarget() const;
 
 private:
     void reset();
@@ -25,6 +34,8 @@ private:
     const glm::vec3 mOriginalUp;
 
     glm::vec3 mPosition;
+    glm::vec3 mPreviousPosition;  // before the latest tick
+    glm::vec3 mRenderPosition;
     glm::quat mLookAtOrientation;
     glm::vec3 mVelocity;
 
@@ -41,6 +52,4 @@ private:
     bool mRotationActive = false;
     glm::vec2 mMousePositionAtRotationStart;
     glm::quat mLookAtOrientationAtRotationStart;
-
-    double mPreviousFrameTime = 0;
 };
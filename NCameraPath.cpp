@@ -0,0 +1,107 @@
+#include "NCameraPath.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "nglassert.h"
+#include "ngllog.h"
+
+// Little-endian like every platform the game runs on, keys are written as they are laid out in memory
+constexpr char kMagic[4] = {'N', 'C', 'A', 'M'};
+constexpr uint32_t kVersion = 1;
+
+struct NCameraPathHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t keyCount;
+    uint32_t reserved;
+};
+
+NCameraPath::NCameraPath() {}
+
+NCameraPath::~NCameraPath() {}
+
+void NCameraPath::addKey(double time, const glm::vec3& position, const glm::vec3& target) {
+    NGL_ASSERT(mKeys.empty() || time > mKeys.back().time);
+    mKeys.push_back({time, position, target});
+}
+
+bool NCameraPath::isEmpty() const {
+    return mKeys.empty();
+}
+
+double NCameraPath::duration() const {
+    return mKeys.empty() ? 0.0 : mKeys.back().time;
+}
+
+void NCameraPath::sample(double time, glm::vec3& position, glm::vec3& target) const {
+    NGL_ASSERT(!mKeys.empty());
+    auto next = std::upper_bound(mKeys.begin(), mKeys.end(), time,
+                                 [](double value, const Key& key) { return value < key.time; });
+    if (next == mKeys.begin() || next == mKeys.end()) {
+        const Key& key = next == mKeys.begin() ? mKeys.front() : mKeys.back();
+        position = key.position;
+        target = key.target;
+        return;
+    }
+    const Key& previous = *(next - 1);
+    float t = static_cast<float>((time - previous.time) / (next->time - previous.time));
+    position = glm::mix(previous.position, next->position, t);
+    target = glm::mix(previous.target, next->target, t);
+}
+
+bool NCameraPath::save(const std::string& path) const {
+    static_assert(sizeof(Key) == 32, "Key is part of the file format");
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+        return false;
+    }
+    NCameraPathHeader header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.keyCount = static_cast<uint32_t>(mKeys.size());
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(mKeys.data(), sizeof(Key), mKeys.size(), file);
+    bool isWritten = ferror(file) == 0;
+    fclose(file);
+    NGL_LOGI("Camera path written to %s, %zu keys", path.c_str(), mKeys.size());
+    return isWritten;
+}
+
+bool NCameraPath::load(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        NGL_LOGE("Cannot read %s", path.c_str());
+        return false;
+    }
+    NCameraPathHeader header{};
+    std::vector<Key> keys;
+    bool isRead = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                  header.version == kVersion;
+    if (isRead) {
+        // The count comes from the file, a damaged one could ask for gigabytes: no more keys than the rest holds
+        const long keysBegin = ftell(file);
+        isRead = keysBegin >= 0 && fseek(file, 0, SEEK_END) == 0;
+        const long fileSize = isRead ? ftell(file) : -1;
+        isRead = isRead && fileSize >= keysBegin && fseek(file, keysBegin, SEEK_SET) == 0 &&
+                 header.keyCount <= static_cast<unsigned long>(fileSize - keysBegin) / sizeof(Key);
+    }
+    if (isRead) {
+        keys.resize(header.keyCount);
+        isRead = fread(keys.data(), sizeof(Key), keys.size(), file) == keys.size();
+    }
+    fclose(file);
+    for (size_t i = 1; isRead && i < keys.size(); i++) {
+        isRead = keys[i].time > keys[i - 1].time;
+    }
+    if (!isRead) {
+        NGL_LOGE("%s is not a camera path", path.c_str());
+        return false;
+    }
+    mKeys = std::move(keys);
+    return true;
+}
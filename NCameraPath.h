@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Camera positions and targets over time, for scripted flights, recordings and benchmark runs. Keys are interpolated
+// linearly.
+class NCameraPath {
+public:
+    NCameraPath();
+    ~NCameraPath();
+
+    // Times must increase from one key to the next
+    void addKey(double time, const glm::vec3& position, const glm::vec3& target);
+
+    bool isEmpty() const;
+    // Time of the last key
+    double duration() const;
+    // Times outside of the path are clamped to it. The path must have at least one key.
+    void sample(double time, glm::vec3& position, glm::vec3& target) const;
+
+    // Binary file: a header, then 32 bytes per key. Returns false if the file cannot be written.
+    bool save(const std::string& path) const;
+    // Replaces the keys. Returns false, leaving the keys alone, if the file cannot be read or is not a camera path.
+    bool load(const std::string& path);
+
+private:
+    struct Key {
+        double time;
+        glm::vec3 position;
+        glm::vec3 target;
+    };
+
+    std::vector<Key> mKeys;
+};
@@ -0,0 +1,42 @@
+#include "NCommandList.h"
+
+#include "nglassert.h"
+
+NCommandList::NCommandList() {}
+
+NCommandList::~NCommandList() {}
+
+void NCommandList::reset() {
+    // Keeps the capacity, steady-state frames do not allocate
+    mDraws.clear();
+    mScopes.clear();
+    NGL_ASSERT(!mIsInScope);
+}
+
+void NCommandList::draw(const NDraw& draw) {
+    NGL_ASSERT(draw.pipeline.isValid());
+    NGL_ASSERT(draw.vertexBuffer.isValid());
+    NGL_ASSERT(draw.indexBuffer.isValid());
+    mDraws.push_back(draw);
+}
+
+void NCommandList::beginScope(const char* name) {
+    NGL_ASSERT(!mIsInScope);
+    uint32_t drawCount = static_cast<uint32_t>(mDraws.size());
+    mScopes.push_back({name, drawCount, drawCount});
+    mIsInScope = true;
+}
+
+void NCommandList::endScope() {
+    NGL_ASSERT(mIsInScope);
+    mScopes.back().endDraw = static_cast<uint32_t>(mDraws.size());
+    mIsInScope = false;
+}
+
+const std::vector<NDraw>& NCommandList::draws() const {
+    return mDraws;
+}
+
+const std::vector<NCommandScope>& NCommandList::scopes() const {
+    return mScopes;
+}
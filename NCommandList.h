@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "nrender.h"
+
+// Draws of one pass, recorded by the scene and replayed by a backend. Plain data: the backend walks it in a single
+// loop, so submitting a draw costs no virtual call. Scopes name ranges of draws whose GPU time is measured on their
+// own, they do not nest.
+class NCommandList {
+public:
+    NCommandList();
+    NCommandList(const NCommandList&) = delete;
+    NCommandList& operator=(const NCommandList&) = delete;
+    NCommandList(NCommandList&&) = delete;
+    NCommandList& operator=(NCommandList&&) = delete;
+    ~NCommandList();
+
+    void reset();
+    void draw(const NDraw& draw);
+    // name must outlive the frame, e.g. a string literal
+    void beginScope(const char* name);
+    void endScope();
+
+    const std::vector<NDraw>& draws() const;
+    const std::vector<NCommandScope>& scopes() const;
+
+private:
+    std::vector<NDraw> mDraws;
+    std::vector<NCommandScope> mScopes;  // in draw order
+    bool mIsInScope = false;
+};
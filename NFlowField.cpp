@@ -0,0 +1,216 @@
+#include "NFlowField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "nglassert.h"
+#include "nparallel.h"
+
+// Ground rising by as much as it runs takes this many times longer to cross than flat ground, on top of the flat time
+constexpr float kSlopeCost = 10.0f;
+// Below this many cells per strip, waking the pool's threads costs more than the sweeps
+constexpr size_t kMinCellsPerStrip = 65536;
+// Sweeps end when no cell's travel time goes down by more than this fraction of the time to cross it
+constexpr float kConvergence = 1e-4f;
+constexpr float kUnreached = std::numeric_limits<float>::infinity();
+
+static float solveEikonal(float a, float b, float cost);
+static glm::vec2 groundBoundsMin(const NglTerrainGeometry& terrainGeometry);
+static float cellSizeOf(const NglTerrainGeometry& terrainGeometry, int resolution);
+static glm::ivec2 cellOf(const glm::vec2& position, const glm::vec2& boundsMin, float cellSize, int resolution);
+
+NFlowField::NFlowField(const NglTerrainGeometry& terrainGeometry, int resolution, const glm::vec2& destination)
+    : mResolution(resolution),
+      mDestination(destination),
+      mBoundsMin(groundBoundsMin(terrainGeometry)),
+      mCellSize(cellSizeOf(terrainGeometry, resolution)) {
+    NGL_ASSERT(resolution > 1);
+    computeCosts(terrainGeometry);
+    integrate();
+}
+
+NFlowField::~NFlowField() {}
+
+glm::vec2 NFlowField::direction(const glm::vec2& position) const {
+    // Down the travel times, central differences, one sided on the edges of the grid
+    const size_t n = mResolution;
+    glm::ivec2 cell = cellCoordinates(position);
+    int left = std::max(cell.x - 1, 0);
+    int right = std::min(cell.x + 1, mResolution - 1);
+    int before = std::max(cell.y - 1, 0);
+    int after = std::min(cell.y + 1, mResolution - 1);
+    glm::vec2 gradient((mTimes[cell.y * n + right] - mTimes[cell.y * n + left]) / (right - left),
+                       (mTimes[after * n + cell.x] - mTimes[before * n + cell.x]) / (after - before));
+    float length = glm::length(gradient);
+    return length > 0.0f ? -gradient / length : glm::vec2(0.0f);
+}
+
+float NFlowField::travelTime(const glm::vec2& position) const {
+    glm::ivec2 cell = cellCoordinates(position);
+    return mTimes[static_cast<size_t>(cell.y) * mResolution + cell.x];
+}
+
+int NFlowField::resolution() const {
+    return mResolution;
+}
+
+const glm::vec2& NFlowField::destination() const {
+    return mDestination;
+}
+
+void NFlowField::computeCosts(const NglTerrainGeometry& terrainGeometry) {
+    const size_t n = mResolution;
+    const int partCount = nPartCount(n * n, kMinCellsPerStrip);
+    std::vector<float> heights(n * n);
+    nRunParts(partCount, [&](int part) {
+        auto [beginRow, endRow] = nPartRange(n, part, partCount);
+        for (size_t j = beginRow; j < endRow; j++) {
+            for (size_t i = 0; i < n; i++) {
+                glm::vec2 center = mBoundsMin + (glm::vec2(i, j) + 0.5f) * mCellSize;
+                heights[j * n + i] = terrainGeometry.height(center.x, center.y);
+            }
+        }
+    });
+
+    // The slope is the length of the height gradient, central differences, one sided on the edges of the grid
+    mCosts.resize(n * n);
+    nRunParts(partCount, [&](int part) {
+        auto [beginRow, endRow] = nPartRange(n, part, partCount);
+        for (size_t j = beginRow; j < endRow; j++) {
+            size_t before = j > 0 ? j - 1 : j;
+            size_t after = j + 1 < n ? j + 1 : j;
+            for (size_t i = 0; i < n; i++) {
+                size_t left = i > 0 ? i - 1 : i;
+                size_t right = i + 1 < n ? i + 1 : i;
+                float dx = (heights[j * n + right] - heights[j * n + left]) / ((right - left) * mCellSize);
+                float dz = (heights[after * n + i] - heights[before * n + i]) / ((after - before) * mCellSize);
+                mCosts[j * n + i] = (1.0f + kSlopeCost * std::sqrt(dx * dx + dz * dz)) * mCellSize;
+            }
+        }
+    });
+}
+
+void NFlowField::integrate() {
+    const size_t n = mResolution;
+    mTimes.assign(n * n, kUnreached);
+    glm::ivec2 destinationCell = cellCoordinates(mDestination);
+    mTimes[destinationCell.y * n + destinationCell.x] = 0.0f;
+
+    // Each strip of rows is swept on its own thread against the rows on either side of it as they were at the start
+    // of the pass, rows outside of the grid being unreached. A strip is swept again as long as its cells or these rows
+    // change, so passes only visit the strips the wavefront is crossing.
+    const int stripCount = nPartCount(n * n, kMinCellsPerStrip);
+    const std::vector<float> unreachedRow(n, kUnreached);
+    std::vector<float> boundaryRows(stripCount * 2 * n, kUnreached);
+    std::vector<uint8_t> hasChanged(stripCount, 1);
+    std::vector<uint8_t> isActive(stripCount, 0);
+    for (;;) {
+        bool isConverged = true;
+        for (int strip = 0; strip < stripCount; strip++) {
+            auto [beginRow, endRow] = nPartRange(n, strip, stripCount);
+            const float* rows[2] = {beginRow > 0 ? &mTimes[(beginRow - 1) * n] : unreachedRow.data(),
+                                    endRow < n ? &mTimes[endRow * n] : unreachedRow.data()};
+            bool hasBoundaryChanged = false;
+            for (int side = 0; side < 2; side++) {
+                float* boundaryRow = &boundaryRows[(strip * 2 + side) * n];
+                if (memcmp(boundaryRow, rows[side], n * sizeof(float)) != 0) {
+                    memcpy(boundaryRow, rows[side], n * sizeof(float));
+                    hasBoundaryChanged = true;
+                }
+            }
+            isActive[strip] = hasChanged[strip] || hasBoundaryChanged;
+            isConverged = isConverged && !isActive[strip];
+        }
+        if (isConverged) {
+            break;
+        }
+        nRunParts(stripCount, [&](int strip) {
+            auto [beginRow, endRow] = nPartRange(n, strip, stripCount);
+            hasChanged[strip] = isActive[strip] && sweep(beginRow, endRow, &boundaryRows[strip * 2 * n],
+                                                         &boundaryRows[(strip * 2 + 1) * n]);
+        });
+    }
+}
+
+// Returns whether a travel time went down by more than kConvergence
+bool NFlowField::sweep(size_t beginRow, size_t endRow, const float* rowBefore, const float* rowAfter) {
+    const size_t n = mResolution;
+    const size_t rowCount = endRow - beginRow;
+    bool hasChanged = false;
+    for (int order = 0; order < 4; order++) {
+        const bool isRowReversed = (order & 1) != 0;
+        const bool isColumnReversed = (order & 2) != 0;
+        for (size_t r = 0; r < rowCount; r++) {
+            size_t j = isRowReversed ? endRow - 1 - r : beginRow + r;
+            float* times = &mTimes[j * n];
+            const float* costs = &mCosts[j * n];
+            const float* before = j > beginRow ? times - n : rowBefore;
+            const float* after = j + 1 < endRow ? times + n : rowAfter;
+            for (size_t c = 0; c < n; c++) {
+                size_t i = isColumnReversed ? n - 1 - c : c;
+                float a = std::min(i > 0 ? times[i - 1] : kUnreached, i + 1 < n ? times[i + 1] : kUnreached);
+                float b = std::min(before[i], after[i]);
+                float time = solveEikonal(a, b, costs[i]);
+                if (time < times[i]) {
+                    hasChanged = hasChanged || time < times[i] - kConvergence * costs[i];
+                    times[i] = time;
+                }
+            }
+        }
+    }
+    return hasChanged;
+}
+
+glm::ivec2 NFlowField::cellCoordinates(const glm::vec2& position) const {
+    return cellOf(position, mBoundsMin, mCellSize, mResolution);
+}
+
+NFlowFieldCache::NFlowFieldCache(const NglTerrainGeometry& terrainGeometry, int resolution)
+    : mTerrainGeometry(terrainGeometry), mResolution(resolution) {}
+
+NFlowFieldCache::~NFlowFieldCache() {}
+
+const NFlowField& NFlowFieldCache::field(const glm::vec2& destination) {
+    glm::ivec2 cell = cellOf(destination, groundBoundsMin(mTerrainGeometry), cellSizeOf(mTerrainGeometry, mResolution),
+                             mResolution);
+    std::unique_ptr<NFlowField>& field = mFields[static_cast<uint32_t>(cell.y * mResolution + cell.x)];
+    if (!field) {
+        field = std::make_unique<NFlowField>(mTerrainGeometry, mResolution, destination);
+    }
+    return *field;
+}
+
+// Travel time of a cell from its neighbors' a along one axis and b along the other, the smaller of the two on each
+// side: the upwind (Godunov) discretization of |grad T| = cost / cell size
+float solveEikonal(float a, float b, float cost) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    if (a == kUnreached) {
+        return kUnreached;
+    }
+    // From one side only when the other is too far behind to be on the wavefront
+    if (b - a >= cost) {
+        return a + cost;
+    }
+    return 0.5f * (a + b + std::sqrt(2.0f * cost * cost - (b - a) * (b - a)));
+}
+
+glm::vec2 groundBoundsMin(const NglTerrainGeometry& terrainGeometry) {
+    return glm::vec2(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z);
+}
+
+// Square cells over the longer side of the terrain
+float cellSizeOf(const NglTerrainGeometry& terrainGeometry, int resolution) {
+    glm::vec3 extent = terrainGeometry.boundsMax() - terrainGeometry.boundsMin();
+    return std::max(extent.x, extent.z) / resolution;
+}
+
+// Positions outside of the grid are in its nearest edge cell
+glm::ivec2 cellOf(const glm::vec2& position, const glm::vec2& boundsMin, float cellSize, int resolution) {
+    int x = static_cast<int>(std::floor((position.x - boundsMin.x) / cellSize));
+    int z = static_cast<int>(std::floor((position.y - boundsMin.y) / cellSize));
+    return glm::ivec2(std::clamp(x, 0, resolution - 1), std::clamp(z, 0, resolution - 1));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NglTerrainGeometry.h"
+
+// The quickest ways to a destination over the terrain, for everyone heading there: the travel time from every cell of
+// a square grid over the terrain, steeper ground being slower to cross. Built once per destination, after which the
+// way from anywhere is a lookup in the cells around it.
+//
+// Travel times solve the eikonal equation |grad T| = cost with fast sweeps, Gauss-Seidel passes over the grid in the
+// four diagonal orders. Unlike Dijkstra over the cell graph, the ways are not bent to the grid's 8 directions, and
+// the grid splits into strips of rows swept on their own threads.
+class NFlowField {
+public:
+    // resolution cells along each side of the terrain
+    NFlowField(const NglTerrainGeometry& terrainGeometry, int resolution, const glm::vec2& destination);
+    NFlowField(const NFlowField&) = delete;
+    NFlowField& operator=(const NFlowField&) = delete;
+    NFlowField(NFlowField&&) = delete;
+    NFlowField& operator=(NFlowField&&) = delete;
+    ~NFlowField();
+
+    // Ground direction (x, z) of the quickest way to the destination from position, zero in the destination's cell
+    glm::vec2 direction(const glm::vec2& position) const;
+    // Travel time from position to the destination, as the distance it would be over flat ground
+    float travelTime(const glm::vec2& position) const;
+
+    int resolution() const;
+    const glm::vec2& destination() const;
+
+private:
+    void computeCosts(const NglTerrainGeometry& terrainGeometry);
+    void integrate();
+    bool sweep(size_t beginRow, size_t endRow, const float* rowBefore, const float* rowAfter);
+    glm::ivec2 cellCoordinates(const glm::vec2& position) const;
+
+    int mResolution;
+    glm::vec2 mDestination;
+    glm::vec2 mBoundsMin;
+    float mCellSize;
+    std::vector<float> mCosts;  // per cell, of crossing it, cell size times 1 over flat ground
+    std::vector<float> mTimes;  // per cell, rows along x from the lowest z
+};
+
+// Flow fields built on first use per destination. Destinations in the same cell share a field. Not thread safe.
+class NFlowFieldCache {
+public:
+    NFlowFieldCache(const NglTerrainGeometry& terrainGeometry, int resolution);
+    NFlowFieldCache(const NFlowFieldCache&) = delete;
+    NFlowFieldCache& operator=(const NFlowFieldCache&) = delete;
+    NFlowFieldCache(NFlowFieldCache&&) = delete;
+    NFlowFieldCache& operator=(NFlowFieldCache&&) = delete;
+    ~NFlowFieldCache();
+
+    const NFlowField& field(const glm::vec2& destination);
+
+private:
+    const NglTerrainGeometry& mTerrainGeometry;
+    int mResolution;
+    std::unordered_map<uint32_t, std::unique_ptr<NFlowField>> mFields;  // by destination cell
+};
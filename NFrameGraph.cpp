@@ -0,0 +1,365 @@
+#include "NFrameGraph.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "nglassert.h"
+#include "ngllog.h"
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment);
+static double toMiB(uint64_t size);
+
+NFrameGraph::NFrameGraph() {
+    Resource backbuffer;
+    backbuffer.name = "Backbuffer";
+    backbuffer.kind = Kind::kBackbuffer;
+    backbuffer.desc.format = NTextureFormat::kRgba8;
+    backbuffer.texture = kNBackbuffer;
+    mResources.push_back(backbuffer);
+}
+
+NFrameGraph::~NFrameGraph() {}
+
+NGraphResource NFrameGraph::backbuffer() const {
+    return {0};
+}
+
+NGraphResource NFrameGraph::createTexture(const char* name, const NGraphTextureDesc& desc) {
+    NGL_ASSERT(!mIsCompiled);
+    Resource resource;
+    resource.name = name;
+    resource.kind = Kind::kTransient;
+    resource.desc = desc;
+    mResources.push_back(resource);
+    return {static_cast<uint32_t>(mResources.size() - 1)};
+}
+
+NGraphResource NFrameGraph::importTexture(const char* name, NTextureHandle texture, glm::ivec2 size,
+                                          NResourceState state) {
+    NGL_ASSERT(!mIsCompiled);
+    Resource resource;
+    resource.name = name;
+    resource.kind = Kind::kImported;
+    resource.desc.size = size;
+    resource.importedState = state;
+    resource.texture = texture;
+    mResources.push_back(resource);
+    return {static_cast<uint32_t>(mResources.size() - 1)};
+}
+
+NGraphPass NFrameGraph::addPass(const NPassDesc& desc, std::vector<NPassAccess> accesses, RecordFunction record) {
+    NGL_ASSERT(!mIsCompiled);
+    Pass pass;
+    pass.desc = desc;
+    pass.accesses = std::move(accesses);
+    pass.record = std::move(record);
+    mPasses.push_back(std::move(pass));
+    return {static_cast<uint32_t>(mPasses.size() - 1)};
+}
+
+void NFrameGraph::setPassEnabled(NGraphPass pass, bool isEnabled) {
+    if (mPasses[pass.index].isEnabled != isEnabled) {
+        mPasses[pass.index].isEnabled = isEnabled;
+        mAreBarriersDirty = true;
+    }
+}
+
+NTextureHandle NFrameGraph::texture(NGraphResource resource) const {
+    return mResources[resource.index].texture;
+}
+
+void NFrameGraph::execute(NRenderDevice& device) {
+    if (!mIsCompiled || device.backbufferSize() != mBackbufferSize) {
+        compile(device);
+    } else if (mAreBarriersDirty) {
+        // Lifetimes and placement assume every live pass may run, only the state transitions change
+        computeTargetsAndBarriers();
+    }
+
+    for (const Pass& pass : mPasses) {
+        if (!isExecuted(pass)) {
+            continue;
+        }
+        mCommandList.reset();
+        pass.record(mCommandList);
+        device.executePass(pass.desc, pass.targets, pass.barriers, mCommandList);
+    }
+    device.executeBarriers(mFinalBarriers);
+}
+
+void NFrameGraph::compile(NRenderDevice& device) {
+    if (mIsCompiled) {
+        // The transient textures of the previous compilation may still be in use
+        device.waitIdle();
+        for (Resource& resource : mResources) {
+            if (resource.kind == Kind::kTransient && resource.texture.isValid()) {
+                device.destroyTexture(resource.texture);
+                resource.texture = NTextureHandle();
+            }
+        }
+    }
+    mBackbufferSize = device.backbufferSize();
+
+    cullPasses();
+    computeLifetimes();
+    placeTransientTextures(device);
+    computeTargetsAndBarriers();
+
+    mIsCompiled = true;
+}
+
+void NFrameGraph::cullPasses() {
+    // Reference counting from the outputs backwards: a pass is live if something live reads one of its writes.
+    // Backbuffer and imported textures count as read after the frame.
+    for (Resource& resource : mResources) {
+        resource.referenceCount = resource.kind == Kind::kTransient ? 0 : 1;
+    }
+    for (Pass& pass : mPasses) {
+        pass.isCulled = false;
+        pass.referenceCount = 0;
+        for (const NPassAccess& access : pass.accesses) {
+            if (isRead(pass, access)) {
+                mResources[access.resource.index].referenceCount++;
+            }
+            if (isWrite(access)) {
+                pass.referenceCount++;
+            }
+        }
+    }
+
+    std::vector<uint32_t> unreferenced;
+    for (uint32_t i = 0; i < mResources.size(); i++) {
+        if (mResources[i].referenceCount == 0) {
+            unreferenced.push_back(i);
+        }
+    }
+    for (Pass& pass : mPasses) {
+        if (pass.referenceCount == 0) {
+            pass.isCulled = true;
+        }
+    }
+    while (!unreferenced.empty()) {
+        uint32_t resourceIndex = unreferenced.back();
+        unreferenced.pop_back();
+        for (Pass& pass : mPasses) {
+            if (pass.isCulled) {
+                continue;
+            }
+            for (const NPassAccess& access : pass.accesses) {
+                if (access.resource.index != resourceIndex || !isWrite(access)) {
+                    continue;
+                }
+                if (--pass.referenceCount > 0) {
+                    continue;
+                }
+                pass.isCulled = true;
+                for (const NPassAccess& readAccess : pass.accesses) {
+                    if (isRead(pass, readAccess) && --mResources[readAccess.resource.index].referenceCount == 0) {
+                        unreferenced.push_back(readAccess.resource.index);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    for (const Pass& pass : mPasses) {
+        if (pass.isCulled) {
+            NGL_LOGI("Frame graph: pass %s culled", pass.desc.name);
+        }
+    }
+}
+
+void NFrameGraph::computeLifetimes() {
+    for (Resource& resource : mResources) {
+        resource.firstPass = -1;
+        resource.lastPass = -1;
+    }
+    for (size_t i = 0; i < mPasses.size(); i++) {
+        if (mPasses[i].isCulled) {
+            continue;
+        }
+        for (const NPassAccess& access : mPasses[i].accesses) {
+            Resource& resource = mResources[access.resource.index];
+            if (resource.firstPass < 0) {
+                resource.firstPass = static_cast<int>(i);
+            }
+            resource.lastPass = static_cast<int>(i);
+        }
+    }
+}
+
+void NFrameGraph::placeTransientTextures(NRenderDevice& device) {
+    std::vector<Resource*> transients;
+    NMemoryRequirements heapRequirements;
+    uint64_t unaliasedSize = 0;
+    for (Resource& resource : mResources) {
+        if (resource.kind != Kind::kTransient || resource.firstPass < 0) {
+            continue;
+        }
+        glm::ivec2 size = sizeOf(resource);
+        resource.memoryRequirements =
+                device.getRenderTargetMemoryRequirements({resource.desc.format, size.x, size.y, resource.name.c_str()});
+        heapRequirements.alignment = std::max(heapRequirements.alignment, resource.memoryRequirements.alignment);
+        heapRequirements.typeBits &= resource.memoryRequirements.typeBits;
+        unaliasedSize += alignUp(resource.memoryRequirements.size, resource.memoryRequirements.alignment);
+        transients.push_back(&resource);
+    }
+    NGL_VERIFY(transients.empty() || heapRequirements.typeBits != 0);
+
+    // Greedy placement, largest first: each texture goes to the lowest offset that does not collide with an already
+    // placed texture whose lifetime overlaps its own
+    std::sort(transients.begin(), transients.end(), [](const Resource* a, const Resource* b) {
+        return a->memoryRequirements.size > b->memoryRequirements.size;
+    });
+    std::vector<const Resource*> placed;
+    for (Resource* resource : transients) {
+        const NMemoryRequirements& requirements = resource->memoryRequirements;
+        std::vector<const Resource*> conflicts;
+        for (const Resource* other : placed) {
+            if (other->firstPass <= resource->lastPass && resource->firstPass <= other->lastPass) {
+                conflicts.push_back(other);
+            }
+        }
+        std::sort(conflicts.begin(), conflicts.end(),
+                  [](const Resource* a, const Resource* b) { return a->offset < b->offset; });
+        uint64_t offset = 0;
+        for (const Resource* other : conflicts) {
+            if (offset + requirements.size <= other->offset) {
+                break;
+            }
+            offset = std::max(offset, alignUp(other->offset + other->memoryRequirements.size, requirements.alignment));
+        }
+        resource->offset = offset;
+        heapRequirements.size = std::max(heapRequirements.size, offset + requirements.size);
+        placed.push_back(resource);
+    }
+
+    device.allocateTransientMemory(heapRequirements);
+    for (Resource* resource : transients) {
+        glm::ivec2 size = sizeOf(*resource);
+        resource->texture = device.createTransientRenderTarget(
+                {resource->desc.format, size.x, size.y, resource->name.c_str()}, resource->offset);
+        NGL_LOGI("Frame graph: %s %dx%d, passes %d..%d, offset %llu, size %llu", resource->name.c_str(), size.x,
+                 size.y, resource->firstPass, resource->lastPass, static_cast<unsigned long long>(resource->offset),
+                 static_cast<unsigned long long>(resource->memoryRequirements.size));
+    }
+    NGL_LOGI("Frame graph: transient memory %.2f MiB with aliasing, %.2f MiB without (%zu textures)",
+             toMiB(heapRequirements.size), toMiB(unaliasedSize), transients.size());
+}
+
+void NFrameGraph::computeTargetsAndBarriers() {
+    mAreBarriersDirty = false;
+    std::vector<NResourceState> states(mResources.size());
+    for (size_t i = 0; i < mResources.size(); i++) {
+        states[i] = mResources[i].kind == Kind::kImported ? mResources[i].importedState : NResourceState::kUndefined;
+    }
+
+    for (size_t passIndex = 0; passIndex < mPasses.size(); passIndex++) {
+        Pass& pass = mPasses[passIndex];
+        pass.targets = NPassTargets();
+        pass.barriers.clear();
+        if (!isExecuted(pass)) {
+            continue;
+        }
+
+        for (const NPassAccess& access : pass.accesses) {
+            const Resource& resource = mResources[access.resource.index];
+            NResourceState& state = states[access.resource.index];
+
+            bool isAttachment = access.state == NResourceState::kColorAttachment ||
+                                access.state == NResourceState::kDepthAttachment ||
+                                access.state == NResourceState::kDepthRead;
+            if (isAttachment) {
+                bool isColor = access.state == NResourceState::kColorAttachment;
+                NLoadOp loadOp = isColor ? pass.desc.colorLoadOp : pass.desc.depthLoadOp;
+                if (access.state == NResourceState::kDepthRead) {
+                    loadOp = NLoadOp::kLoad;
+                }
+                if (loadOp == NLoadOp::kLoad && state == NResourceState::kUndefined) {
+                    loadOp = NLoadOp::kDontCare;
+                }
+                bool store = resource.kind != Kind::kTransient || isReadLater(access.resource, passIndex);
+                if (isColor) {
+                    NGL_ASSERT(!pass.targets.color.isValid());
+                    pass.targets.color = resource.texture;
+                    pass.targets.colorLoadOp = loadOp;
+                    pass.targets.storeColor = store;
+                } else {
+                    NGL_ASSERT(!pass.targets.depth.isValid());
+                    pass.targets.depth = resource.texture;
+                    pass.targets.depthLoadOp = loadOp;
+                    pass.targets.storeDepth = store;
+                    pass.targets.isDepthReadOnly = access.state == NResourceState::kDepthRead;
+                }
+                pass.targets.size = sizeOf(resource);
+            }
+
+            // Read after read in the same state needs no barrier, everything else does: layout changes, and
+            // writes that must be visible to or ordered with later accesses
+            if (state != access.state || isWrite(access)) {
+                pass.barriers.push_back({resource.texture, state, access.state});
+            }
+            state = access.state;
+        }
+    }
+
+    mFinalBarriers.clear();
+    for (size_t i = 0; i < mResources.size(); i++) {
+        const Resource& resource = mResources[i];
+        if (resource.kind == Kind::kBackbuffer) {
+            mFinalBarriers.push_back({resource.texture, states[i], NResourceState::kPresent});
+        } else if (resource.kind == Kind::kImported && states[i] != resource.importedState) {
+            mFinalBarriers.push_back({resource.texture, states[i], resource.importedState});
+        }
+    }
+}
+
+glm::ivec2 NFrameGraph::sizeOf(const Resource& resource) const {
+    return resource.desc.size == glm::ivec2(0, 0) ? mBackbufferSize : resource.desc.size;
+}
+
+bool NFrameGraph::isReadLater(NGraphResource resource, size_t passIndex) const {
+    for (size_t i = passIndex + 1; i < mPasses.size(); i++) {
+        if (!isExecuted(mPasses[i])) {
+            continue;
+        }
+        for (const NPassAccess& access : mPasses[i].accesses) {
+            if (access.resource == resource && isRead(mPasses[i], access)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool NFrameGraph::isExecuted(const Pass& pass) const {
+    return !pass.isCulled && pass.isEnabled;
+}
+
+bool NFrameGraph::isRead(const Pass& pass, const NPassAccess& access) {
+    switch (access.state) {
+        case NResourceState::kShaderRead:
+        case NResourceState::kDepthRead:
+            return true;
+        case NResourceState::kColorAttachment:
+            return pass.desc.colorLoadOp == NLoadOp::kLoad;
+        case NResourceState::kDepthAttachment:
+            return pass.desc.depthLoadOp == NLoadOp::kLoad;
+        default:
+            return false;
+    }
+}
+
+bool NFrameGraph::isWrite(const NPassAccess& access) {
+    return access.state == NResourceState::kColorAttachment || access.state == NResourceState::kDepthAttachment ||
+           access.state == NResourceState::kTransferDst;
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+double toMiB(uint64_t size) {
+    return size / (1024.0 * 1024.0);
+}
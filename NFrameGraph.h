@@ -0,0 +1,112 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "NCommandList.h"
+#include "NRenderDevice.h"
+
+using NGraphResource = NHandle<struct NGraphResourceTag>;
+using NGraphPass = NHandle<struct NGraphPassTag>;
+
+struct NGraphTextureDesc {
+    NTextureFormat format;
+    glm::ivec2 size = glm::ivec2(0, 0);  // zero means backbuffer size
+};
+
+struct NPassAccess {
+    NGraphResource resource;
+    NResourceState state;
+};
+
+// Render graph. Passes declare the textures they read and write. Compiling the graph culls passes whose results are
+// never used, derives load/store ops and the minimal set of barriers between passes, and places transient textures in
+// one block of memory where textures with disjoint lifetimes alias. The graph is built once; it compiles on the first
+// execution and again whenever the backbuffer size changes. Passes can be switched off between frames, e.g. to keep
+// the contents of a cached texture, which only recomputes the barriers.
+class NFrameGraph {
+public:
+    using RecordFunction = std::function<void(NCommandList& commandList)>;
+
+    NFrameGraph();
+    NFrameGraph(const NFrameGraph&) = delete;
+    NFrameGraph& operator=(const NFrameGraph&) = delete;
+    NFrameGraph(NFrameGraph&&) = delete;
+    NFrameGraph& operator=(NFrameGraph&&) = delete;
+    ~NFrameGraph();
+
+    // Presented at the end of the frame, never culled
+    NGraphResource backbuffer() const;
+    // Exists only within a frame, contents are undefined at the first access
+    NGraphResource createTexture(const char* name, const NGraphTextureDesc& desc);
+    // Owned by the caller and kept across frames; state is the one the texture is in between frames
+    NGraphResource importTexture(const char* name, NTextureHandle texture, glm::ivec2 size, NResourceState state);
+
+    // Passes run in the order they are added
+    NGraphPass addPass(const NPassDesc& desc, std::vector<NPassAccess> accesses, RecordFunction record);
+    void setPassEnabled(NGraphPass pass, bool isEnabled);
+
+    // Device texture behind a resource, valid while passes are recorded
+    NTextureHandle texture(NGraphResource resource) const;
+
+    // Call between NRenderDevice::beginFrame() and endFrame()
+    void execute(NRenderDevice& device);
+
+private:
+    enum class Kind {
+        kBackbuffer,
+        kTransient,
+        kImported,
+    };
+
+    struct Resource {
+        std::string name;
+        Kind kind;
+        NGraphTextureDesc desc;
+        NResourceState importedState = NResourceState::kUndefined;
+        NTextureHandle texture;
+
+        // Compilation results
+        int referenceCount = 0;
+        int firstPass = -1;
+        int lastPass = -1;
+        NMemoryRequirements memoryRequirements;
+        uint64_t offset = 0;
+    };
+
+    struct Pass {
+        NPassDesc desc;
+        std::vector<NPassAccess> accesses;
+        RecordFunction record;
+
+        bool isEnabled = true;
+
+        // Compilation results
+        int referenceCount = 0;
+        bool isCulled = false;
+        NPassTargets targets;
+        std::vector<NBarrier> barriers;
+    };
+
+    void compile(NRenderDevice& device);
+    void cullPasses();
+    void computeLifetimes();
+    void placeTransientTextures(NRenderDevice& device);
+    void computeTargetsAndBarriers();
+    glm::ivec2 sizeOf(const Resource& resource) const;
+    bool isReadLater(NGraphResource resource, size_t passIndex) const;
+    bool isExecuted(const Pass& pass) const;
+
+    static bool isRead(const Pass& pass, const NPassAccess& access);
+    static bool isWrite(const NPassAccess& access);
+
+    std::vector<Resource> mResources;
+    std::vector<Pass> mPasses;
+    std::vector<NBarrier> mFinalBarriers;
+    NCommandList mCommandList;
+
+    bool mIsCompiled = false;
+    bool mAreBarriersDirty = false;
+    glm::ivec2 mBackbufferSize = glm::ivec2(0, 0);
+};
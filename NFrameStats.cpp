@@ -0,0 +1,78 @@
+#include "NFrameStats.h"
+
+#include <algorithm>
+
+#include "ngllog.h"
+
+constexpr double kReportInterval = 2.0;
+
+NFrameStats::NFrameStats(const char* label) : mLabel(label) {}
+
+NFrameStats::~NFrameStats() {}
+
+void NFrameStats::onFrame(double time, double cpuFrameTime) {
+    if (mWindowStartTime < 0) {
+        mWindowStartTime = time;
+    }
+
+    mFrameCount++;
+    mCpuFrameTimeSum += cpuFrameTime;
+    mCpuFrameTimeMax = std::max(mCpuFrameTimeMax, cpuFrameTime);
+
+    double window = time - mWindowStartTime;
+    if (window >= kReportInterval) {
+        int fps = static_cast<int>(mFrameCount / window);
+        NGL_LOGI("%s FPS: %d, CPU frame time: avg %0.3fms, max %0.3fms", mLabel, fps,
+                 mCpuFrameTimeSum / mFrameCount * 1000.0, mCpuFrameTimeMax * 1000.0);
+        for (PassTimes& passTimes : mPassTimes) {
+            if (passTimes.count > 0) {
+                double gpuTime = passTimes.gpuTimeSum / passTimes.count * 1000.0;
+                double overdraw = passTimes.overdrawSum / passTimes.count;
+                if (overdraw >= 0) {
+                    NGL_LOGI("%s   %s GPU time: avg %0.3fms, overdraw: avg %0.2f", mLabel, passTimes.name.c_str(),
+                             gpuTime, overdraw);
+                } else {
+                    NGL_LOGI("%s   %s GPU time: avg %0.3fms", mLabel, passTimes.name.c_str(), gpuTime);
+                }
+            }
+            passTimes.gpuTimeSum = 0;
+            passTimes.overdrawSum = 0;
+            passTimes.count = 0;
+        }
+        if (mCulledFrameCount > 0) {
+            NGL_LOGI("%s   Occluded units: avg %0.1f of %d", mLabel,
+                     mOccludedCountSum / static_cast<double>(mCulledFrameCount), mTestedCount);
+        }
+        mCulledFrameCount = 0;
+        mOccludedCountSum = 0;
+        mWindowStartTime = time;
+        mFrameCount = 0;
+        mCpuFrameTimeSum = 0;
+        mCpuFrameTimeMax = 0;
+    }
+}
+
+void NFrameStats::onPassStats(const std::vector<NPassStats>& passStats) {
+    // Scopes of different passes may have the same name
+    std::string passName;
+    for (const NPassStats& stats : passStats) {
+        std::string name = stats.isScope ? passName + " / " + stats.name : stats.name;
+        if (!stats.isScope) {
+            passName = stats.name;
+        }
+        auto it = std::find_if(mPassTimes.begin(), mPassTimes.end(),
+                               [&](const PassTimes& passTimes) { return passTimes.name == name; });
+        if (it == mPassTimes.end()) {
+            it = mPassTimes.insert(mPassTimes.end(), {name});
+        }
+        it->gpuTimeSum += stats.gpuTime;
+        it->overdrawSum += stats.overdraw;
+        it->count++;
+    }
+}
+
+void NFrameStats::onOcclusionCulling(int occludedCount, int testedCount) {
+    mCulledFrameCount++;
+    mOccludedCountSum += occludedCount;
+    mTestedCount = testedCount;
+}
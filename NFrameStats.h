@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "nrender.h"
+
+// Accumulates per-frame CPU cost and logs FPS and CPU frame time every couple of seconds. CPU frame time is the time
+// the main thread spends on a frame excluding waits on the GPU and the display (swap, present, in-flight fences).
+// GPU time and overdraw of each render pass, and GPU time of the scopes of its command list, are logged along with it
+// when the device can measure them, and so is the number of units hidden by occlusion culling.
+class NFrameStats {
+public:
+    NFrameStats(const char* label);
+    NFrameStats(const NFrameStats&) = delete;
+    NFrameStats& operator=(const NFrameStats&) = delete;
+    NFrameStats(NFrameStats&&) = delete;
+    NFrameStats& operator=(NFrameStats&&) = delete;
+    ~NFrameStats();
+
+    void onFrame(double time, double cpuFrameTime);
+    // Call once per frame with NRenderDevice::passStats()
+    void onPassStats(const std::vector<NPassStats>& passStats);
+    // Call once per frame with culling enabled
+    void onOcclusionCulling(int occludedCount, int testedCount);
+
+private:
+    struct PassTimes {
+        std::string name;
+        double gpuTimeSum = 0;
+        double overdrawSum = 0;
+        int count = 0;
+    };
+
+    const char* const mLabel;
+    double mWindowStartTime = -1;
+    int mFrameCount = 0;
+    double mCpuFrameTimeSum = 0;
+    double mCpuFrameTimeMax = 0;
+    std::vector<PassTimes> mPassTimes;  // in the order passes were first seen
+    int mCulledFrameCount = 0;
+    int mOccludedCountSum = 0;
+    int mTestedCount = 0;
+};
@@ -0,0 +1,353 @@
+#include "NHeightField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "nglassert.h"
+#include "nparallel.h"
+
+// Rays under the ground by less than this are grazing it, and not stopped, so that points on the ground can be seen
+constexpr float kGrazingDepth = 1e-5f;
+// How far past the start of a step, in cells along the ray, the node it is in is looked up. Keeps a ray that is on
+// the edge of a node out of the node it just left.
+constexpr double kNodeLookAhead = 1e-6;
+// Below this many vertices per part, waking the pool's threads costs more than the loops
+constexpr size_t kMinVerticesPerPart = 65536;
+constexpr size_t kMinSightLinesPerPart = 1024;
+
+static int nodeOf(double position, int nodeSize, int levelSize);
+static double exitOf(double origin, double direction, int node, int nodeSize);
+static bool firstBelow(float beginDepth, float endDepth, double begin, double end, double& t);
+
+NHeightField::NHeightField(const NglTerrainGeometry& terrainGeometry, int resolution)
+    : mResolution(resolution),
+      mBoundsMin(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z) {
+    NGL_ASSERT(resolution > 1);
+    // Square cells over the longer side of the terrain, the vertices on its far edges kept on the terrain
+    const glm::vec3 extent = terrainGeometry.boundsMax() - terrainGeometry.boundsMin();
+    mVertexSpacing = std::max(extent.x, extent.z) / (resolution - 1);
+    const glm::vec2 boundsMax(terrainGeometry.boundsMax().x, terrainGeometry.boundsMax().z);
+    const size_t n = resolution;
+    mHeights.resize(n * n);
+    const int partCount = nPartCount(n * n, kMinVerticesPerPart);
+    nRunParts(partCount, [&](int part) {
+        auto [beginRow, endRow] = nPartRange(n, part, partCount);
+        for (size_t j = beginRow; j < endRow; j++) {
+            for (size_t i = 0; i < n; i++) {
+                glm::vec2 position = glm::min(vertexPosition(glm::ivec2(i, j)), boundsMax);
+                mHeights[j * n + i] = terrainGeometry.height(position.x, position.y);
+            }
+        }
+    });
+    buildPyramid();
+}
+
+NHeightField::~NHeightField() {}
+
+bool NHeightField::intersectSegment(const glm::vec3& from, const glm::vec3& to, float& fraction) const {
+    glm::vec3 origin((from.x - mBoundsMin.x) / mVertexSpacing, from.y, (from.z - mBoundsMin.y) / mVertexSpacing);
+    glm::vec3 direction((to.x - from.x) / mVertexSpacing, to.y - from.y, (to.z - from.z) / mVertexSpacing);
+    double t;
+    if (!intersectGrid(origin, direction, 0.0, 1.0, t)) {
+        return false;
+    }
+    fraction = static_cast<float>(t);
+    return true;
+}
+
+bool NHeightField::intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                                glm::vec3& hit) const {
+    const glm::vec3 unitDirection = glm::normalize(direction);
+    glm::vec3 gridOrigin((origin.x - mBoundsMin.x) / mVertexSpacing, origin.y,
+                         (origin.z - mBoundsMin.y) / mVertexSpacing);
+    glm::vec3 gridDirection(unitDirection.x / mVertexSpacing, unitDirection.y, unitDirection.z / mVertexSpacing);
+    double t;
+    if (!intersectGrid(gridOrigin, gridDirection, 0.0, maxDistance, t)) {
+        return false;
+    }
+    hit = origin + unitDirection * static_cast<float>(t);
+    return true;
+}
+
+bool NHeightField::isVisible(const glm::vec3& from, const glm::vec3& to) const {
+    float fraction;
+    return !intersectSegment(from, to, fraction);
+}
+
+void NHeightField::testSightLines(const std::vector<NSightLine>& lines, std::vector<uint8_t>& areVisible) const {
+    areVisible.resize(lines.size());
+    const int partCount = nPartCount(lines.size(), kMinSightLinesPerPart);
+    nRunParts(partCount, [&](int part) {
+        auto [begin, end] = nPartRange(lines.size(), part, partCount);
+        for (size_t i = begin; i < end; i++) {
+            areVisible[i] = isVisible(lines[i].from, lines[i].to) ? 1 : 0;
+        }
+    });
+}
+
+void NHeightField::computeViewsheds(const std::vector<glm::vec2>& observers, float eyeHeight, float targetHeight,
+                                    float radius, std::vector<NViewshed>& viewsheds) const {
+    viewsheds.resize(observers.size());
+    const int partCount = nPartCount(observers.size(), 1);
+    nRunParts(partCount, [&](int part) {
+        auto [begin, end] = nPartRange(observers.size(), part, partCount);
+        for (size_t i = begin; i < end; i++) {
+            computeViewshed(observers[i], eyeHeight, targetHeight, radius, viewsheds[i]);
+        }
+    });
+}
+
+float NHeightField::height(const glm::vec2& position) const {
+    const float last = static_cast<float>(mResolution - 1);
+    glm::vec2 grid = glm::clamp((position - mBoundsMin) / mVertexSpacing, glm::vec2(0.0f), glm::vec2(last));
+    int i = std::min(static_cast<int>(grid.x), mResolution - 2);
+    int j = std::min(static_cast<int>(grid.y), mResolution - 2);
+    float u = grid.x - i;
+    float v = grid.y - j;
+    const float* row = &mHeights[static_cast<size_t>(j) * mResolution + i];
+    const float* nextRow = row + mResolution;
+    return (row[0] * (1.0f - u) + row[1] * u) * (1.0f - v) + (nextRow[0] * (1.0f - u) + nextRow[1] * u) * v;
+}
+
+int NHeightField::resolution() const {
+    return mResolution;
+}
+
+glm::vec2 NHeightField::vertexPosition(const glm::ivec2& vertex) const {
+    return mBoundsMin + glm::vec2(vertex) * mVertexSpacing;
+}
+
+void NHeightField::buildPyramid() {
+    const size_t n = mResolution;
+    int size = mResolution - 1;
+    mPyramid.emplace_back(static_cast<size_t>(size) * size);
+    mLevelSizes.push_back(size);
+    std::vector<float>& cells = mPyramid.back();
+    int partCount = nPartCount(cells.size(), kMinVerticesPerPart);
+    nRunParts(partCount, [&](int part) {
+        auto [beginRow, endRow] = nPartRange(size, part, partCount);
+        for (size_t j = beginRow; j < endRow; j++) {
+            const float* row = &mHeights[j * n];
+            const float* nextRow = row + n;
+            for (int i = 0; i < size; i++) {
+                cells[j * size + i] = std::max(std::max(row[i], row[i + 1]), std::max(nextRow[i], nextRow[i + 1]));
+            }
+        }
+    });
+
+    // Nodes on the far edges of a level with an odd size cover one or two nodes below rather than four
+    while (size > 1) {
+        const std::vector<float>& below = mPyramid.back();
+        const int belowSize = size;
+        size = (size + 1) / 2;
+        std::vector<float> level(static_cast<size_t>(size) * size);
+        partCount = nPartCount(level.size() * 4, kMinVerticesPerPart);
+        nRunParts(partCount, [&](int part) {
+            auto [beginRow, endRow] = nPartRange(size, part, partCount);
+            for (size_t j = beginRow; j < endRow; j++) {
+                size_t j0 = j * 2;
+                size_t j1 = std::min<size_t>(j0 + 1, belowSize - 1);
+                for (int i = 0; i < size; i++) {
+                    int i0 = i * 2;
+                    int i1 = std::min(i0 + 1, belowSize - 1);
+                    level[j * size + i] = std::max(std::max(below[j0 * belowSize + i0], below[j0 * belowSize + i1]),
+                                                   std::max(below[j1 * belowSize + i0], below[j1 * belowSize + i1]));
+                }
+            }
+        });
+        mPyramid.push_back(std::move(level));
+        mLevelSizes.push_back(size);
+    }
+}
+
+bool NHeightField::intersectGrid(const glm::vec3& origin, const glm::vec3& direction, double begin, double end,
+                                 double& t) const {
+    // Clipped to the height field, (x, z) from 0 to the last vertex
+    const double last = mResolution - 1;
+    const double rayOrigin[2] = {origin.x, origin.z};
+    const double rayDirection[2] = {direction.x, direction.z};
+    for (int axis = 0; axis < 2; axis++) {
+        if (rayDirection[axis] == 0.0) {
+            if (rayOrigin[axis] < 0.0 || rayOrigin[axis] > last) {
+                return false;
+            }
+            continue;
+        }
+        double t0 = -rayOrigin[axis] / rayDirection[axis];
+        double t1 = (last - rayOrigin[axis]) / rayDirection[axis];
+        begin = std::max(begin, std::min(t0, t1));
+        end = std::min(end, std::max(t0, t1));
+    }
+    if (begin > end) {
+        return false;
+    }
+
+    // Positions are doubles, which keep the steps exact to well under a cell on the largest grids
+    const double lookAhead = kNodeLookAhead / std::max({std::abs(rayDirection[0]), std::abs(rayDirection[1]), 1e-30});
+    const int topLevel = static_cast<int>(mPyramid.size()) - 1;
+    int level = topLevel;
+    double stepBegin = begin;
+    while (stepBegin < end) {
+        const int nodeSize = 1 << level;
+        const int levelSize = mLevelSizes[level];
+        const double ahead = std::min(stepBegin + lookAhead, end);
+        const int i = nodeOf(rayOrigin[0] + rayDirection[0] * ahead, nodeSize, levelSize);
+        const int j = nodeOf(rayOrigin[1] + rayDirection[1] * ahead, nodeSize, levelSize);
+        const double stepEnd = std::min({end, exitOf(rayOrigin[0], rayDirection[0], i, nodeSize),
+                                         exitOf(rayOrigin[1], rayDirection[1], j, nodeSize)});
+        // The ray is straight, its lowest point over the node at one end of the step
+        const double lowest = origin.y + std::min(direction.y * stepBegin, direction.y * stepEnd);
+        if (lowest + kGrazingDepth >= mPyramid[level][static_cast<size_t>(j) * levelSize + i]) {
+            stepBegin = std::max(stepEnd, ahead);
+            level = std::min(level + 1, topLevel);
+        } else if (level > 0) {
+            level--;
+        } else {
+            if (intersectCell(i, j, origin, direction, stepBegin, std::max(stepEnd, stepBegin), t)) {
+                return true;
+            }
+            stepBegin = std::max(stepEnd, ahead);
+        }
+    }
+    return false;
+}
+
+bool NHeightField::intersectCell(int i, int j, const glm::vec3& origin, const glm::vec3& direction, double begin,
+                                 double end, double& t) const {
+    // Split along the diagonal from (i + 1, j) to (i, j + 1), the ray crossing it at most once. In cell coordinates
+    // (u, v) from 0 to 1, the near triangle is u + v <= 1.
+    const float* row = &mHeights[static_cast<size_t>(j) * mResolution + i];
+    const float h00 = row[0];
+    const float h10 = row[1];
+    const float h01 = row[mResolution];
+    const float h11 = row[mResolution + 1];
+    const double u0 = origin.x - i;
+    const double v0 = origin.z - j;
+    double bounds[3] = {begin, end, end};
+    const double diagonalSpeed = static_cast<double>(direction.x) + direction.z;
+    if (diagonalSpeed != 0.0) {
+        double crossing = (1.0 - u0 - v0) / diagonalSpeed;
+        if (crossing > begin && crossing < end) {
+            bounds[1] = crossing;
+        }
+    }
+    // Depth of the ray under the ground, positive below it, plus the grazing depth
+    auto depth = [&](double s, bool isNear) {
+        float u = static_cast<float>(u0 + direction.x * s);
+        float v = static_cast<float>(v0 + direction.z * s);
+        float ground = isNear ? h00 + (h10 - h00) * u + (h01 - h00) * v
+                              : h11 + (h01 - h11) * (1.0f - u) + (h10 - h11) * (1.0f - v);
+        return ground - static_cast<float>(origin.y + direction.y * s) - kGrazingDepth;
+    };
+    for (int part = 0; part < 2; part++) {
+        const double partBegin = bounds[part];
+        const double partEnd = bounds[part + 1];
+        if (part == 1 && partBegin >= partEnd) {
+            break;
+        }
+        const double middle = (partBegin + partEnd) * 0.5;
+        const bool isNear = u0 + direction.x * middle + v0 + direction.z * middle <= 1.0;
+        if (firstBelow(depth(partBegin, isNear), depth(partEnd, isNear), partBegin, partEnd, t)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void NHeightField::computeViewshed(const glm::vec2& observer, float eyeHeight, float targetHeight, float radius,
+                                   NViewshed& viewshed) const {
+    const int last = mResolution - 1;
+    const glm::vec2 origin = glm::clamp((observer - mBoundsMin) / mVertexSpacing, glm::vec2(0.0f),
+                                        glm::vec2(static_cast<float>(last)));
+    const glm::ivec2 center = glm::clamp(glm::ivec2(glm::round(origin)), glm::ivec2(0), glm::ivec2(last));
+    const float gridRadius = radius / mVertexSpacing;
+    const int reach = static_cast<int>(std::ceil(gridRadius));
+    viewshed.firstVertex = glm::max(center - reach, glm::ivec2(0));
+    const glm::ivec2 lastVertex = glm::min(center + reach, glm::ivec2(last));
+    viewshed.size = lastVertex - viewshed.firstVertex + 1;
+    viewshed.isVisible.assign(static_cast<size_t>(viewshed.size.x) * viewshed.size.y, 0);
+    auto markVisible = [&](int i, int j) {
+        viewshed.isVisible[static_cast<size_t>(j - viewshed.firstVertex.y) * viewshed.size.x +
+                           (i - viewshed.firstVertex.x)] = 1;
+    };
+    markVisible(center.x, center.y);
+    if (reach == 0) {
+        return;
+    }
+    const float eye = height(observer) + eyeHeight;
+
+    // A ray from the observer to each vertex on the edge of the square around its nearest vertex, stepping a vertex
+    // at a time along its major axis. The ground along the ray is interpolated between the two vertices on either
+    // side of it on the minor axis, and a vertex is tested by the nearest of the two. Distances along a ray are the
+    // same multiple of those along its major axis, so slopes along it are compared per distance along that axis.
+    auto sweep = [&](int targetMajor, int targetMinor, bool isAlongX) {
+        const float originMajor = isAlongX ? origin.x : origin.y;
+        const float originMinor = isAlongX ? origin.y : origin.x;
+        const float minorStep = (targetMinor - originMinor) / std::abs(targetMajor - originMajor);
+        const int majorStep = targetMajor > originMajor ? 1 : -1;
+        const float stepLength2 = 1.0f + minorStep * minorStep;
+        const int firstMajor = majorStep > 0 ? static_cast<int>(std::floor(originMajor)) + 1
+                                             : static_cast<int>(std::ceil(originMajor)) - 1;
+        float steepest = -std::numeric_limits<float>::infinity();
+        for (int major = firstMajor; (targetMajor - major) * majorStep >= 0; major += majorStep) {
+            const float distance = std::abs(major - originMajor);
+            const float minor = originMinor + minorStep * distance;
+            if (major < 0 || major > last || minor < 0.0f || minor > last ||
+                distance * distance * stepLength2 > gridRadius * gridRadius) {
+                break;
+            }
+            const int minor0 = std::min(static_cast<int>(minor), last - 1);
+            const float weight = minor - minor0;
+            const size_t index0 = isAlongX ? static_cast<size_t>(minor0) * mResolution + major
+                                           : static_cast<size_t>(major) * mResolution + minor0;
+            const size_t index1 = index0 + (isAlongX ? mResolution : 1);
+            const int nearestMinor = weight < 0.5f ? minor0 : minor0 + 1;
+            const float nearestHeight = weight < 0.5f ? mHeights[index0] : mHeights[index1];
+            if ((nearestHeight + targetHeight - eye) / distance >= steepest) {
+                if (isAlongX) {
+                    markVisible(major, nearestMinor);
+                } else {
+                    markVisible(nearestMinor, major);
+                }
+            }
+            const float ground = mHeights[index0] + (mHeights[index1] - mHeights[index0]) * weight;
+            steepest = std::max(steepest, (ground - eye) / distance);
+        }
+    };
+    for (int offset = -reach; offset <= reach; offset++) {
+        sweep(center.x + reach, center.y + offset, true);
+        sweep(center.x - reach, center.y + offset, true);
+        sweep(center.y + reach, center.x + offset, false);
+        sweep(center.y - reach, center.x + offset, false);
+    }
+}
+
+// Node along one axis that the ray is in at position, the nodes on the edges of the level extending past them
+int nodeOf(double position, int nodeSize, int levelSize) {
+    return std::clamp(static_cast<int>(std::floor(position / nodeSize)), 0, levelSize - 1);
+}
+
+// Where the ray leaves node along one axis, infinite if it never does
+double exitOf(double origin, double direction, int node, int nodeSize) {
+    if (direction > 0.0) {
+        return ((node + 1.0) * nodeSize - origin) / direction;
+    }
+    if (direction < 0.0) {
+        return (static_cast<double>(node) * nodeSize - origin) / direction;
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+// First t from begin to end where the depth, linear from beginDepth to endDepth, is positive
+bool firstBelow(float beginDepth, float endDepth, double begin, double end, double& t) {
+    if (beginDepth > 0.0f) {
+        t = begin;
+        return true;
+    }
+    if (endDepth > 0.0f) {
+        t = begin + (end - begin) * (beginDepth / (beginDepth - endDepth));
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NglTerrainGeometry.h"
+
+// Segment between two points above the ground, from the eye to what it looks at
+struct NSightLine {
+    glm::vec3 from;
+    glm::vec3 to;
+};
+
+// Vertices of the height field seen from an observer, over the square of vertices around it within the radius
+struct NViewshed {
+    glm::ivec2 firstVertex;  // of the square, clipped to the height field
+    glm::ivec2 size;         // of the square, in vertices
+    std::vector<uint8_t> isVisible;  // 1 for a vertex in sight, rows along x from the lowest z
+};
+
+// Ray queries against the terrain: whether a point can be seen from another, where a ray meets the ground, and what
+// observers see around them. The terrain is resampled on a square grid of vertices, two triangles per cell.
+//
+// Rays walk a maximum-height pyramid over the cells, each level keeping the highest height of 2x2 nodes of the level
+// below. Where the ray stays above a node's highest point it skips the whole node and climbs a level, where it does
+// not it descends, and only the cells it may meet are tested against their triangles. Over open ground a ray crosses
+// a few large nodes rather than every cell on its way.
+//
+// Viewsheds sweep rays from the observer to every vertex on the edge of its square, keeping the steepest slope to the
+// ground along each ray: a vertex is in sight when the slope to it is no lower. Each ray visits the vertices it crosses
+// once, which costs a couple of steps per vertex of the square rather than a ray per vertex. Vertices are tested by the
+// ground between the rays rather than by their own triangles, they differ from isVisible() on the edges of what is
+// hidden, about 1% of them.
+class NHeightField {
+public:
+    // resolution vertices along each side of the terrain, heights sampled from its surface
+    NHeightField(const NglTerrainGeometry& terrainGeometry, int resolution);
+    NHeightField(const NHeightField&) = delete;
+    NHeightField& operator=(const NHeightField&) = delete;
+    NHeightField(NHeightField&&) = delete;
+    NHeightField& operator=(NHeightField&&) = delete;
+    ~NHeightField();
+
+    // First point of the segment from `from` to `to` below the ground, as a fraction of the way from `from`. False if
+    // there is none. Grazing the ground does not count, nor does the ground outside of the height field.
+    bool intersectSegment(const glm::vec3& from, const glm::vec3& to, float& fraction) const;
+    // Where the ray from origin along direction meets the ground within maxDistance, false if it does not
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, glm::vec3& hit) const;
+    // Whether to can be seen from from, no ground in the way
+    bool isVisible(const glm::vec3& from, const glm::vec3& to) const;
+    // isVisible() of every line, 1 for visible, on several threads for large batches
+    void testSightLines(const std::vector<NSightLine>& lines, std::vector<uint8_t>& areVisible) const;
+    // Viewshed of each observer, an eye eyeHeight above the ground at (x, z), of the ground within radius raised by
+    // targetHeight. Observers are split over threads.
+    void computeViewsheds(const std::vector<glm::vec2>& observers, float eyeHeight, float targetHeight, float radius,
+                          std::vector<NViewshed>& viewsheds) const;
+
+    // Bilinear between the vertices, clamped to the edges of the height field
+    float height(const glm::vec2& position) const;
+    int resolution() const;
+    // Ground position of a vertex
+    glm::vec2 vertexPosition(const glm::ivec2& vertex) const;
+
+private:
+    void buildPyramid();
+    // Of the ray origin + t direction in grid space, vertices 1 apart, for t from begin to end
+    bool intersectGrid(const glm::vec3& origin, const glm::vec3& direction, double begin, double end,
+                       double& t) const;
+    bool intersectCell(int i, int j, const glm::vec3& origin, const glm::vec3& direction, double begin, double end,
+                       double& t) const;
+    void computeViewshed(const glm::vec2& observer, float eyeHeight, float targetHeight, float radius,
+                         NViewshed& viewshed) const;
+
+    int mResolution;
+    glm::vec2 mBoundsMin;
+    float mVertexSpacing;
+    std::vector<float> mHeights;  // per vertex, rows along x from the lowest z
+    // Level 0 has the highest of the four heights of each cell, each level above the highest of 2x2 nodes below,
+    // down to a single node
+    std::vector<std::vector<float>> mPyramid;
+    std::vector<int> mLevelSizes;  // nodes along each side of each level
+};
@@ -0,0 +1,151 @@
+#include "NOcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using glm::vec2;
+using glm::vec3;
+using glm::vec4;
+
+// Power-of-two sizes, so every pyramid level halves both dimensions down to 1x1
+constexpr int kWidth = 256;
+constexpr int kHeight = 128;
+
+static float edge(const vec2& a, const vec2& b, const vec2& p);
+
+NOcclusionCuller::NOcclusionCuller(const NglTerrainGeometry& terrainGeometry)
+    : mTerrainGeometry(terrainGeometry), mClipPositions(terrainGeometry.vertices().size()) {
+    for (int width = kWidth, height = kHeight; width > 0 || height > 0; width /= 2, height /= 2) {
+        mPyramid.emplace_back(std::max(width, 1) * std::max(height, 1));
+    }
+}
+
+NOcclusionCuller::~NOcclusionCuller() {}
+
+void NOcclusionCuller::update(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+    mViewProjectionMatrix = projectionMatrix * viewMatrix;
+    mNearPlane = projectionMatrix[3][2] / (projectionMatrix[2][2] - 1.0f);
+    rasterizeTerrain();
+    buildPyramid();
+}
+
+bool NOcclusionCuller::isOccluded(const vec3& boxMin, const vec3& boxMax) const {
+    vec2 ndcMin(std::numeric_limits<float>::max());
+    vec2 ndcMax(-std::numeric_limits<float>::max());
+    float nearestDepth = std::numeric_limits<float>::max();
+    for (int i = 0; i < 8; i++) {
+        vec3 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z);
+        vec4 clip = mViewProjectionMatrix * vec4(corner, 1.0f);
+        if (clip.w < mNearPlane) {
+            return false;
+        }
+        vec3 ndc = vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, vec2(ndc));
+        ndcMax = glm::max(ndcMax, vec2(ndc));
+        nearestDepth = std::min(nearestDepth, ndc.z);
+    }
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) {
+        // Outside of the view, the GPU clips it
+        return false;
+    }
+
+    // The terrain was sampled at texel centers only, one more texel around the box covers what fell between them
+    int x0 = std::clamp(static_cast<int>(std::floor((ndcMin.x * 0.5f + 0.5f) * kWidth)) - 1, 0, kWidth - 1);
+    int x1 = std::clamp(static_cast<int>(std::floor((ndcMax.x * 0.5f + 0.5f) * kWidth)) + 1, 0, kWidth - 1);
+    int y0 = std::clamp(static_cast<int>(std::floor((ndcMin.y * 0.5f + 0.5f) * kHeight)) - 1, 0, kHeight - 1);
+    int y1 = std::clamp(static_cast<int>(std::floor((ndcMax.y * 0.5f + 0.5f) * kHeight)) + 1, 0, kHeight - 1);
+
+    // Coarsest level where the rectangle covers at most 2x2 texels
+    int level = 0;
+    while ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1) {
+        level++;
+    }
+    const std::vector<float>& depths = mPyramid[level];
+    int levelWidth = std::max(kWidth >> level, 1);
+    float farthestDepth = -1.0f;
+    for (int y = y0 >> level; y <= y1 >> level; y++) {
+        for (int x = x0 >> level; x <= x1 >> level; x++) {
+            farthestDepth = std::max(farthestDepth, depths[y * levelWidth + x]);
+        }
+    }
+    return nearestDepth > farthestDepth;
+}
+
+void NOcclusionCuller::rasterizeTerrain() {
+    const std::vector<NglVertex>& vertices = mTerrainGeometry.vertices();
+    for (size_t i = 0; i < vertices.size(); i++) {
+        mClipPositions[i] = mViewProjectionMatrix * vec4(vertices[i].position, 1.0f);
+    }
+
+    std::vector<float>& depths = mPyramid[0];
+    std::fill(depths.begin(), depths.end(), 1.0f);
+    const std::vector<uint32_t>& indices = mTerrainGeometry.indices();
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const vec4& clip0 = mClipPositions[indices[i]];
+        const vec4& clip1 = mClipPositions[indices[i + 1]];
+        const vec4& clip2 = mClipPositions[indices[i + 2]];
+        if (clip0.w < mNearPlane || clip1.w < mNearPlane || clip2.w < mNearPlane) {
+            continue;
+        }
+
+        const vec2 scale(kWidth * 0.5f, kHeight * 0.5f);
+        vec2 screen0 = (vec2(clip0) / clip0.w + 1.0f) * scale;
+        vec2 screen1 = (vec2(clip1) / clip1.w + 1.0f) * scale;
+        vec2 screen2 = (vec2(clip2) / clip2.w + 1.0f) * scale;
+        float area = edge(screen0, screen1, screen2);
+        if (area == 0.0f) {
+            continue;
+        }
+
+        int minX = std::max(static_cast<int>(std::floor(std::min({screen0.x, screen1.x, screen2.x}))), 0);
+        int maxX = std::min(static_cast<int>(std::ceil(std::max({screen0.x, screen1.x, screen2.x}))), kWidth - 1);
+        int minY = std::max(static_cast<int>(std::floor(std::min({screen0.y, screen1.y, screen2.y}))), 0);
+        int maxY = std::min(static_cast<int>(std::ceil(std::max({screen0.y, screen1.y, screen2.y}))), kHeight - 1);
+        // NDC depth is linear in screen space
+        float depth0 = clip0.z / clip0.w;
+        float depth1 = clip1.z / clip1.w;
+        float depth2 = clip2.z / clip2.w;
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                // Dividing by the signed area rasterizes both windings
+                vec2 p(x + 0.5f, y + 0.5f);
+                float weight0 = edge(screen1, screen2, p) / area;
+                float weight1 = edge(screen2, screen0, p) / area;
+                float weight2 = 1.0f - weight0 - weight1;
+                if (weight0 < 0.0f || weight1 < 0.0f || weight2 < 0.0f) {
+                    continue;
+                }
+                float depth = weight0 * depth0 + weight1 * depth1 + weight2 * depth2;
+                float& texel = depths[y * kWidth + x];
+                texel = std::min(texel, depth);
+            }
+        }
+    }
+}
+
+void NOcclusionCuller::buildPyramid() {
+    for (size_t level = 1; level < mPyramid.size(); level++) {
+        const std::vector<float>& src = mPyramid[level - 1];
+        std::vector<float>& dst = mPyramid[level];
+        int srcWidth = std::max(kWidth >> (level - 1), 1);
+        int srcHeight = std::max(kHeight >> (level - 1), 1);
+        int width = std::max(kWidth >> level, 1);
+        int height = std::max(kHeight >> level, 1);
+        for (int y = 0; y < height; y++) {
+            int srcY0 = y * 2;
+            int srcY1 = std::min(y * 2 + 1, srcHeight - 1);
+            for (int x = 0; x < width; x++) {
+                int srcX0 = x * 2;
+                int srcX1 = std::min(x * 2 + 1, srcWidth - 1);
+                dst[y * width + x] = std::max({src[srcY0 * srcWidth + srcX0], src[srcY0 * srcWidth + srcX1],
+                                               src[srcY1 * srcWidth + srcX0], src[srcY1 * srcWidth + srcX1]});
+            }
+        }
+    }
+}
+
+// Twice the signed area of the triangle a, b, p
+float edge(const vec2& a, const vec2& b, const vec2& p) {
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
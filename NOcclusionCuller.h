@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NglTerrainGeometry.h"
+
+// Tells which boxes are hidden behind the terrain. The terrain is rasterized on the CPU into a low resolution depth
+// buffer every frame, and a hierarchical-Z pyramid is built from it: each level keeps the farthest depth of 2x2 texels
+// of the level below, so a box is tested against a few texels of the level its screen rectangle fits in.
+// Conservative: boxes crossing the near plane, and terrain triangles crossing it, never occlude anything.
+class NOcclusionCuller {
+public:
+    NOcclusionCuller(const NglTerrainGeometry& terrainGeometry);
+    NOcclusionCuller(const NOcclusionCuller&) = delete;
+    NOcclusionCuller& operator=(const NOcclusionCuller&) = delete;
+    NOcclusionCuller(NOcclusionCuller&&) = delete;
+    NOcclusionCuller& operator=(NOcclusionCuller&&) = delete;
+    ~NOcclusionCuller();
+
+    // Rasterizes the terrain as seen through a GL perspective projection
+    void update(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+
+    // World-space box, must be called after update()
+    bool isOccluded(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+private:
+    void rasterizeTerrain();
+    void buildPyramid();
+
+    const NglTerrainGeometry& mTerrainGeometry;
+    glm::mat4 mViewProjectionMatrix = glm::mat4(1.0f);
+    float mNearPlane = 0.0f;
+    std::vector<glm::vec4> mClipPositions;     // of the terrain vertices
+    std::vector<std::vector<float>> mPyramid;  // NDC depths, level 0 has kWidth x kHeight texels
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "NCommandList.h"
+#include "nrender.h"
+
+struct GLFWwindow;
+
+// Backend-neutral render device, implemented by ngldevice.cpp and nvkdevice.cpp. Resources are created up front and
+// referenced by handle. A frame is a sequence of passes driven by NFrameGraph; each pass is one virtual call that
+// replays a whole command list.
+class NRenderDevice {
+public:
+    NRenderDevice() = default;
+    NRenderDevice(const NRenderDevice&) = delete;
+    NRenderDevice& operator=(const NRenderDevice&) = delete;
+    NRenderDevice(NRenderDevice&&) = delete;
+    NRenderDevice& operator=(NRenderDevice&&) = delete;
+    virtual ~NRenderDevice() = default;
+
+    virtual const char* name() const = 0;
+    virtual GLFWwindow* window() const = 0;
+    virtual glm::ivec2 backbufferSize() const = 0;
+
+    virtual NBufferHandle createBuffer(NBufferUsage usage, const void* data, size_t size) = 0;
+    virtual NTextureHandle createTexture(const NTextureDesc& desc) = 0;
+    // Whether createTexture() takes the format, block compressed formats depend on the GPU
+    virtual bool isTextureFormatSupported(NTextureFormat format) const = 0;
+    virtual NPipelineHandle createPipeline(const NPipelineDesc& desc) = 0;
+
+    // Render targets. Transient ones live in a single device-wide block of memory at offsets chosen by the frame
+    // graph, targets whose lifetimes do not overlap may share memory. Calling allocateTransientMemory() again
+    // replaces the block, all transient targets must have been destroyed by then.
+    virtual NMemoryRequirements getRenderTargetMemoryRequirements(const NRenderTargetDesc& desc) = 0;
+    virtual void allocateTransientMemory(const NMemoryRequirements& requirements) = 0;
+    virtual NTextureHandle createTransientRenderTarget(const NRenderTargetDesc& desc, uint64_t offset) = 0;
+    // Persistent targets start in NResourceState::kShaderRead
+    virtual NTextureHandle createRenderTarget(const NRenderTargetDesc& desc) = 0;
+    virtual void destroyTexture(NTextureHandle texture) = 0;
+
+    // Texture visible to every draw, slot is one of the kN*Slot constants. All slots must be set before the first
+    // frame.
+    virtual void setGlobalTexture(uint32_t slot, NTextureHandle texture) = 0;
+
+    // The projection in frameUniform follows OpenGL clip space conventions, backends convert it as needed. Returns
+    // false if the frame has to be skipped, e.g. because the swapchain was recreated.
+    virtual bool beginFrame(const NFrameUniform& frameUniform) = 0;
+    // Records of this frame's instances, at most kNMaxInstanceCount. Called after beginFrame() and before the first
+    // pass.
+    virtual void uploadInstances(const std::vector<NInstance>& instances) = 0;
+    // barriers are recorded before the pass starts
+    virtual void executePass(const NPassDesc& pass, const NPassTargets& targets, const std::vector<NBarrier>& barriers,
+                             const NCommandList& commandList) = 0;
+    virtual void executeBarriers(const std::vector<NBarrier>& barriers) = 0;
+    virtual void endFrame() = 0;
+
+    // Time the last frame spent blocked on the GPU or the display
+    virtual double frameWaitTime() const = 0;
+    // Passes of the latest frame whose GPU results are available, which lags a few frames behind. Empty if the GPU
+    // cannot measure time.
+    virtual const std::vector<NPassStats>& passStats() const = 0;
+
+    virtual void waitIdle() = 0;
+};
@@ -0,0 +1,161 @@
+#include "NShadowCascades.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <glm/ext.hpp>
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+constexpr int kShadowMapSize = 2048;
+constexpr int kTerrainCascade = kNSoldierCascadeCount;
+// Soldiers farther from the camera cast no shadows
+constexpr float kShadowDistance = 8.0f;
+// 0 splits the shadow distance uniformly, 1 logarithmically
+constexpr float kSplitLambda = 0.75f;
+// Soldiers stand on the terrain and walk a bit past its edges
+constexpr float kSceneMargin = 0.5f;
+
+static const char* const kShadowMapNames[] = {"Shadow map 0", "Shadow map 1", "Shadow map 2", "Terrain shadow map"};
+static const char* const kPassNames[] = {"Shadow cascade 0", "Shadow cascade 1", "Shadow cascade 2", "Terrain shadow"};
+static_assert(std::size(kPassNames) == kNShadowCascadeCount);
+
+static mat4 lightProjection(const mat4& lightView, const vec3& boxMin, const vec3& boxMax);
+static void sliceBoundingSphere(const mat4& inverseViewMatrix, const mat4& projectionMatrix, float sliceNear,
+                                float sliceFar, vec3& center, float& radius);
+
+NShadowCascades::NShadowCascades(NRenderDevice& device, const NglTerrainGeometry& terrainGeometry,
+                                 NPipelineHandle pipeline)
+    : mPipeline(pipeline),
+      mSceneMin(terrainGeometry.boundsMin() - vec3(kSceneMargin)),
+      mSceneMax(terrainGeometry.boundsMax() + vec3(kSceneMargin)) {
+    for (int i = 0; i < kNShadowCascadeCount; i++) {
+        mShadowMaps[i] =
+                device.createRenderTarget({NTextureFormat::kDepth, kShadowMapSize, kShadowMapSize, kShadowMapNames[i]});
+        device.setGlobalTexture(kNShadowCascadeSlot + i, mShadowMaps[i]);
+    }
+}
+
+NShadowCascades::~NShadowCascades() {}
+
+std::vector<NPassAccess> NShadowCascades::addPasses(NFrameGraph& frameGraph, const NTerrainLayer& terrainLayer,
+                                                    const NArmyLayer& armyLayer) {
+    std::vector<NPassAccess> reads;
+    for (int i = 0; i < kNShadowCascadeCount; i++) {
+        NGraphResource shadowMap = frameGraph.importTexture(kShadowMapNames[i], mShadowMaps[i],
+                                                            glm::ivec2(kShadowMapSize), NResourceState::kShaderRead);
+
+        NPassDesc pass;
+        pass.name = kPassNames[i];
+        uint32_t cascade = static_cast<uint32_t>(i);
+        NGraphPass graphPass = frameGraph.addPass(
+                pass, {{shadowMap, NResourceState::kDepthAttachment}}, [&, cascade](NCommandList& commandList) {
+                    if (cascade == kTerrainCascade) {
+                        terrainLayer.recordShadow(commandList, mPipeline, cascade);
+                    } else {
+                        armyLayer.recordShadow(commandList, mPipeline, cascade);
+                    }
+                });
+        if (i == kTerrainCascade) {
+            mTerrainPass = graphPass;
+        }
+        reads.push_back({shadowMap, NResourceState::kShaderRead});
+    }
+    return reads;
+}
+
+void NShadowCascades::update(NFrameGraph& frameGraph, const mat4& viewMatrix, const mat4& projectionMatrix,
+                             const vec3& lightVector, NFrameUniform& frameUniform) {
+    vec3 up = std::abs(lightVector.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+    mat4 lightView = glm::lookAt(vec3(0.0f), -lightVector, up);
+    vec3 sceneMin, sceneMax;
+    sceneBounds(lightView, sceneMin, sceneMax);
+
+    // Near and far planes of a GL perspective projection, soldier cascades end at the shadow distance
+    float nearPlane = projectionMatrix[3][2] / (projectionMatrix[2][2] - 1.0f);
+    float farPlane = std::min(kShadowDistance, projectionMatrix[3][2] / (projectionMatrix[2][2] + 1.0f));
+
+    mat4 inverseViewMatrix = glm::inverse(viewMatrix);
+    float sliceNear = nearPlane;
+    for (int i = 0; i < kNSoldierCascadeCount; i++) {
+        float fraction = static_cast<float>(i + 1) / kNSoldierCascadeCount;
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * fraction;
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, fraction);
+        float sliceFar = glm::mix(uniformSplit, logSplit, kSplitLambda);
+
+        vec3 center;
+        float radius;
+        sliceBoundingSphere(inverseViewMatrix, projectionMatrix, sliceNear, sliceFar, center, radius);
+
+        // Move the cascade in whole texels
+        float texelSize = 2.0f * radius / kShadowMapSize;
+        vec3 lightCenter = vec3(lightView * vec4(center, 1.0f));
+        lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+        vec3 boxMin(lightCenter.x - radius, lightCenter.y - radius, sceneMin.z);
+        vec3 boxMax(lightCenter.x + radius, lightCenter.y + radius, sceneMax.z);
+        frameUniform.shadow_matrices[i] = lightProjection(lightView, boxMin, boxMax);
+        frameUniform.cascade_splits[i] = sliceFar;
+        sliceNear = sliceFar;
+    }
+
+    if (lightVector != mTerrainLightVector) {
+        mTerrainLightVector = lightVector;
+        mTerrainMatrix = lightProjection(lightView, sceneMin, sceneMax);
+        mIsTerrainCascadeDirty = true;
+    }
+    frameUniform.shadow_matrices[kTerrainCascade] = mTerrainMatrix;
+    frameGraph.setPassEnabled(mTerrainPass, mIsTerrainCascadeDirty);
+}
+
+void NShadowCascades::onFrameRendered() {
+    mIsTerrainCascadeDirty = false;
+}
+
+void NShadowCascades::invalidateTerrainCascade() {
+    mIsTerrainCascadeDirty = true;
+}
+
+void NShadowCascades::sceneBounds(const mat4& lightView, vec3& boxMin, vec3& boxMax) const {
+    boxMin = vec3(std::numeric_limits<float>::max());
+    boxMax = vec3(-std::numeric_limits<float>::max());
+    for (int i = 0; i < 8; i++) {
+        vec3 corner((i & 1) ? mSceneMax.x : mSceneMin.x, (i & 2) ? mSceneMax.y : mSceneMin.y,
+                    (i & 4) ? mSceneMax.z : mSceneMin.z);
+        vec3 lightCorner = vec3(lightView * vec4(corner, 1.0f));
+        boxMin = glm::min(boxMin, lightCorner);
+        boxMax = glm::max(boxMax, lightCorner);
+    }
+}
+
+mat4 lightProjection(const mat4& lightView, const vec3& boxMin, const vec3& boxMax) {
+    // The light looks down -z
+    return glm::ortho(boxMin.x, boxMax.x, boxMin.y, boxMax.y, -boxMax.z, -boxMin.z) * lightView;
+}
+
+void sliceBoundingSphere(const mat4& inverseViewMatrix, const mat4& projectionMatrix, float sliceNear,
+                         float sliceFar, vec3& center, float& radius) {
+    vec3 corners[8];
+    for (int i = 0; i < 8; i++) {
+        float depth = (i & 4) ? sliceFar : sliceNear;
+        float x = ((i & 1) ? 1.0f : -1.0f) * depth / projectionMatrix[0][0];
+        float y = ((i & 2) ? 1.0f : -1.0f) * depth / projectionMatrix[1][1];
+        corners[i] = vec3(inverseViewMatrix * vec4(x, y, -depth, 1.0f));
+    }
+
+    center = vec3(0.0f);
+    for (const vec3& corner : corners) {
+        center += corner / 8.0f;
+    }
+    radius = 0.0f;
+    for (const vec3& corner : corners) {
+        radius = std::max(radius, glm::length(corner - center));
+    }
+    // The sphere only depends on the slice, not on where the camera looks. Rounding keeps float noise from changing
+    // the texel size from frame to frame.
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+}
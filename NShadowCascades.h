@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NArmyLayer.h"
+#include "NFrameGraph.h"
+#include "NRenderDevice.h"
+#include "NTerrainLayer.h"
+#include "NglTerrainGeometry.h"
+
+// Shadows of the directional light. Soldiers move every frame and are rendered into kNSoldierCascadeCount cascades
+// that split the camera frustum up to a fixed shadow distance. The terrain does not move and is rendered into one
+// more cascade covering all of it, which is only rendered again when the light changes or the terrain is invalidated.
+// Soldier cascades are fit to the bounding sphere of their frustum slice and snapped to shadow map texels, so their
+// shadows do not shimmer when the camera moves or turns.
+class NShadowCascades {
+public:
+    // pipeline uses NShader::kShadow
+    NShadowCascades(NRenderDevice& device, const NglTerrainGeometry& terrainGeometry, NPipelineHandle pipeline);
+    NShadowCascades(const NShadowCascades&) = delete;
+    NShadowCascades& operator=(const NShadowCascades&) = delete;
+    NShadowCascades(NShadowCascades&&) = delete;
+    NShadowCascades& operator=(NShadowCascades&&) = delete;
+    ~NShadowCascades();
+
+    // Adds a pass per cascade. Returns the accesses of a pass that samples the shadow maps.
+    std::vector<NPassAccess> addPasses(NFrameGraph& frameGraph, const NTerrainLayer& terrainLayer,
+                                       const NArmyLayer& armyLayer);
+
+    // Fits the cascades to the camera and fills the shadow part of frameUniform. projectionMatrix is a perspective
+    // projection, lightVector points towards the light.
+    void update(NFrameGraph& frameGraph, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix,
+                const glm::vec3& lightVector, NFrameUniform& frameUniform);
+    // Call after a frame was rendered with the state of the latest update()
+    void onFrameRendered();
+
+    // Renders the terrain cascade again in the next frame
+    void invalidateTerrainCascade();
+
+private:
+    // Light-space box around everything that casts or receives shadows
+    void sceneBounds(const glm::mat4& lightView, glm::vec3& boxMin, glm::vec3& boxMax) const;
+
+    const NPipelineHandle mPipeline;
+    glm::vec3 mSceneMin;
+    glm::vec3 mSceneMax;
+    std::array<NTextureHandle, kNShadowCascadeCount> mShadowMaps;
+
+    NGraphPass mTerrainPass;
+    glm::mat4 mTerrainMatrix = glm::mat4(1.0f);
+    glm::vec3 mTerrainLightVector = glm::vec3(0.0f);
+    bool mIsTerrainCascadeDirty = true;
+};
@@ -0,0 +1,47 @@
+#include "NSimulationClock.h"
+
+#include <algorithm>
+
+#include "nglassert.h"
+
+NSimulationClock::NSimulationClock(double tickRate, int maxTicksPerFrame)
+    : mTickDuration(1.0 / tickRate), mMaxAccumulatedTime(maxTicksPerFrame / tickRate) {
+    NGL_ASSERT(tickRate > 0 && maxTicksPerFrame > 0);
+}
+
+NSimulationClock::~NSimulationClock() {}
+
+void NSimulationClock::advance(double elapsedTime) {
+    mAccumulatedTime = std::min(mAccumulatedTime + std::max(elapsedTime, 0.0), mMaxAccumulatedTime);
+}
+
+bool NSimulationClock::nextTick(double& tickTime) {
+    if (mAccumulatedTime < mTickDuration) {
+        return false;
+    }
+    mAccumulatedTime -= mTickDuration;
+    mTickCount++;
+    // Counted rather than summed, so that tick times do not drift however long the run
+    tickTime = time();
+    return true;
+}
+
+double NSimulationClock::tickDuration() const {
+    return mTickDuration;
+}
+
+uint64_t NSimulationClock::tick() const {
+    return mTickCount;
+}
+
+double NSimulationClock::time() const {
+    return mTickCount * mTickDuration;
+}
+
+float NSimulationClock::alpha() const {
+    return static_cast<float>(std::min(mAccumulatedTime / mTickDuration, 1.0));
+}
+
+double NSimulationClock::renderTime() const {
+    return time() - (1.0 - alpha()) * mTickDuration;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+// Simulation time in fixed ticks, decoupled from the frame rate. Each frame advances the clock by the time it covers,
+// then runs the ticks that became due, and renders between the states of the latest two ticks. What the simulation
+// computes then depends on the tick rate only, not on the frame rate, and runs that are not bound to real time, such
+// as playback, can advance by any step.
+//
+//   clock.advance(elapsedTime);
+//   double tickTime;
+//   while (clock.nextTick(tickTime)) {
+//       // Simulate up to tickTime
+//   }
+//   // Render the state interpolated between the latest two ticks by clock.alpha()
+class NSimulationClock {
+public:
+    // After a stall, frames catch up on at most maxTicksPerFrame ticks and the rest of the time is dropped, the
+    // simulation slowing down rather than taking ever longer frames
+    NSimulationClock(double tickRate, int maxTicksPerFrame);
+    NSimulationClock(const NSimulationClock&) = delete;
+    NSimulationClock& operator=(const NSimulationClock&) = delete;
+    NSimulationClock(NSimulationClock&&) = delete;
+    NSimulationClock& operator=(NSimulationClock&&) = delete;
+    ~NSimulationClock();
+
+    void advance(double elapsedTime);
+    // Runs the next due tick, false when none is due. tickTime is the time it simulates up to.
+    bool nextTick(double& tickTime);
+
+    double tickDuration() const;
+    // Index of the latest tick, 0 before the first: tick 0 is the initial state
+    uint64_t tick() const;
+    // Of the latest tick, tick() * tickDuration()
+    double time() const;
+    // Fraction of a tick the frame is past the latest tick, from 0 to 1. Rendered states are interpolated from the
+    // tick before the latest to the latest one by alpha, trailing the clock by up to a tick.
+    float alpha() const;
+    // Time of the interpolated states
+    double renderTime() const;
+
+private:
+    const double mTickDuration;
+    const double mMaxAccumulatedTime;
+    uint64_t mTickCount = 0;
+    double mAccumulatedTime = 0;  // not simulated yet
+};
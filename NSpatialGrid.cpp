@@ -0,0 +1,175 @@
+#include "NSpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nglassert.h"
+#include "nparallel.h"
+
+// Below this many points per thread, waking the pool's threads costs more than the sort
+constexpr size_t kMinPointsPerThread = 16384;
+
+NSpatialGrid::NSpatialGrid(const glm::vec2& boundsMin, const glm::vec2& boundsMax, float cellSize)
+    : mBoundsMin(boundsMin), mCellSize(cellSize), mInverseCellSize(1.0f / cellSize) {
+    NGL_ASSERT(cellSize > 0.0f && boundsMax.x > boundsMin.x && boundsMax.y > boundsMin.y);
+    mCellCount = glm::ivec2(std::max(static_cast<int>(std::ceil((boundsMax.x - boundsMin.x) / cellSize)), 1),
+                            std::max(static_cast<int>(std::ceil((boundsMax.y - boundsMin.y) / cellSize)), 1));
+    mCellStarts.assign(static_cast<size_t>(mCellCount.x) * mCellCount.y + 1, 0);
+}
+
+NSpatialGrid::~NSpatialGrid() {}
+
+void NSpatialGrid::rebuild(const std::vector<glm::vec2>& points) {
+    NGL_ASSERT(points.size() < UINT32_MAX);
+    const size_t pointCount = points.size();
+    const size_t cellCount = mCellStarts.size() - 1;
+    const int threadCount = nPartCount(pointCount, kMinPointsPerThread);
+    mPointCells.resize(pointCount);
+    mPoints.resize(pointCount);
+    mPointIndices.resize(pointCount);
+    mThreadCounts.assign(cellCount * threadCount, 0);
+    mRangeStarts.resize(threadCount);
+
+    // Points of each cell, counted by each thread over its share of the points
+    nRunParts(threadCount, [&](int thread) {
+        uint32_t* counts = &mThreadCounts[cellCount * thread];
+        auto [begin, end] = nPartRange(pointCount, thread, threadCount);
+        for (size_t i = begin; i < end; i++) {
+            uint32_t cell = cellIndex(points[i]);
+            mPointCells[i] = cell;
+            counts[cell]++;
+        }
+    });
+
+    // Prefix sums over the cells, then over the threads within a cell, so that each thread writes its points of a
+    // cell after those of the threads before it and points stay in their original order within a cell. Each thread
+    // sums a range of cells, the ranges are then offset by the totals of the ranges before them.
+    nRunParts(threadCount, [&](int thread) {
+        auto [begin, end] = nPartRange(cellCount, thread, threadCount);
+        uint32_t total = 0;
+        for (size_t cell = begin; cell < end; cell++) {
+            for (int t = 0; t < threadCount; t++) {
+                total += mThreadCounts[cellCount * t + cell];
+            }
+        }
+        mRangeStarts[thread] = total;
+    });
+    uint32_t rangeStart = 0;
+    for (uint32_t& start : mRangeStarts) {
+        std::swap(start, rangeStart);
+        rangeStart += start;
+    }
+    nRunParts(threadCount, [&](int thread) {
+        auto [begin, end] = nPartRange(cellCount, thread, threadCount);
+        uint32_t offset = mRangeStarts[thread];
+        for (size_t cell = begin; cell < end; cell++) {
+            mCellStarts[cell] = offset;
+            for (int t = 0; t < threadCount; t++) {
+                uint32_t& count = mThreadCounts[cellCount * t + cell];
+                uint32_t start = offset;
+                offset += count;
+                count = start;
+            }
+        }
+    });
+    mCellStarts[cellCount] = static_cast<uint32_t>(pointCount);
+
+    nRunParts(threadCount, [&](int thread) {
+        uint32_t* starts = &mThreadCounts[cellCount * thread];
+        auto [begin, end] = nPartRange(pointCount, thread, threadCount);
+        for (size_t i = begin; i < end; i++) {
+            uint32_t position = starts[mPointCells[i]]++;
+            mPoints[position] = points[i];
+            mPointIndices[position] = static_cast<uint32_t>(i);
+        }
+    });
+}
+
+void NSpatialGrid::queryRadius(const glm::vec2& center, float radius, std::vector<uint32_t>& result) const {
+    glm::ivec2 minCell = cellCoordinates(glm::vec2(center.x - radius, center.y - radius));
+    glm::ivec2 maxCell = cellCoordinates(glm::vec2(center.x + radius, center.y + radius));
+    float radiusSquared = radius * radius;
+    for (int y = minCell.y; y <= maxCell.y; y++) {
+        // The cells of a row are one contiguous range of points
+        size_t rowCell = static_cast<size_t>(y) * mCellCount.x;
+        uint32_t end = mCellStarts[rowCell + maxCell.x + 1];
+        for (uint32_t i = mCellStarts[rowCell + minCell.x]; i < end; i++) {
+            glm::vec2 offset = mPoints[i] - center;
+            if (glm::dot(offset, offset) <= radiusSquared) {
+                result.push_back(mPointIndices[i]);
+            }
+        }
+    }
+}
+
+void NSpatialGrid::queryNearest(const glm::vec2& center, int k, float maxRadius, std::vector<uint32_t>& result) const {
+    result.clear();
+    if (k <= 0) {
+        return;
+    }
+    // Max-heap of the nearest points so far, by squared distance
+    std::vector<std::pair<float, uint32_t>> nearest;
+    nearest.reserve(k);
+    const float maxRadiusSquared = maxRadius * maxRadius;
+
+    // Cells in rings around the center's cell, a ring further out than the farthest of k points found ends the
+    // search. Points of ring r > 0 are at least r - 1 cells and the distance to the edge of the center's cell away.
+    glm::ivec2 home = cellCoordinates(center);
+    glm::vec2 inCell = (center - mBoundsMin) * mInverseCellSize - glm::vec2(home);
+    float edgeDistance =
+            std::max(std::min({inCell.x, 1.0f - inCell.x, inCell.y, 1.0f - inCell.y}), 0.0f) * mCellSize;
+    int ringCount = std::max(mCellCount.x, mCellCount.y);
+    for (int ring = 0; ring < ringCount; ring++) {
+        float ringDistance = ring == 0 ? 0.0f : edgeDistance + (ring - 1) * mCellSize;
+        if (ringDistance > maxRadius ||
+            (static_cast<int>(nearest.size()) == k && ringDistance * ringDistance > nearest.front().first)) {
+            break;
+        }
+        for (int y = std::max(home.y - ring, 0); y <= std::min(home.y + ring, mCellCount.y - 1); y++) {
+            // The top and bottom rows of the ring are whole, the rows between have their two ends
+            bool isEdgeRow = y == home.y - ring || y == home.y + ring;
+            int step = isEdgeRow || ring == 0 ? 1 : 2 * ring;
+            for (int x = home.x - ring; x <= home.x + ring; x += step) {
+                if (x < 0 || x >= mCellCount.x) {
+                    continue;
+                }
+                size_t cell = static_cast<size_t>(y) * mCellCount.x + x;
+                for (uint32_t i = mCellStarts[cell]; i < mCellStarts[cell + 1]; i++) {
+                    glm::vec2 offset = mPoints[i] - center;
+                    float distanceSquared = glm::dot(offset, offset);
+                    if (distanceSquared > maxRadiusSquared) {
+                        continue;
+                    }
+                    if (static_cast<int>(nearest.size()) < k) {
+                        nearest.push_back({distanceSquared, mPointIndices[i]});
+                        std::push_heap(nearest.begin(), nearest.end());
+                    } else if (distanceSquared < nearest.front().first) {
+                        std::pop_heap(nearest.begin(), nearest.end());
+                        nearest.back() = {distanceSquared, mPointIndices[i]};
+                        std::push_heap(nearest.begin(), nearest.end());
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort_heap(nearest.begin(), nearest.end());
+    for (const auto& point : nearest) {
+        result.push_back(point.second);
+    }
+}
+
+float NSpatialGrid::cellSize() const {
+    return mCellSize;
+}
+
+glm::ivec2 NSpatialGrid::cellCoordinates(const glm::vec2& point) const {
+    return glm::ivec2(
+            std::clamp(static_cast<int>(std::floor((point.x - mBoundsMin.x) * mInverseCellSize)), 0, mCellCount.x - 1),
+            std::clamp(static_cast<int>(std::floor((point.y - mBoundsMin.y) * mInverseCellSize)), 0, mCellCount.y - 1));
+}
+
+uint32_t NSpatialGrid::cellIndex(const glm::vec2& point) const {
+    glm::ivec2 coordinates = cellCoordinates(point);
+    return static_cast<uint32_t>(coordinates.y * mCellCount.x + coordinates.x);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Points on the ground (x, z) bucketed into a uniform grid of square cells, for neighbor queries such as soldiers
+// keeping apart. Rebuilt from scratch whenever the points move: a counting sort by cell, on several threads for large
+// point counts, leaves the points of each cell next to each other so that a query reads a few contiguous ranges.
+// Points outside of the bounds go to the nearest edge cell, queries still find them.
+class NSpatialGrid {
+public:
+    // Queries are fastest with cellSize about the largest query radius, they then visit 3x3 cells
+    NSpatialGrid(const glm::vec2& boundsMin, const glm::vec2& boundsMax, float cellSize);
+    NSpatialGrid(const NSpatialGrid&) = delete;
+    NSpatialGrid& operator=(const NSpatialGrid&) = delete;
+    NSpatialGrid(NSpatialGrid&&) = delete;
+    NSpatialGrid& operator=(NSpatialGrid&&) = delete;
+    ~NSpatialGrid();
+
+    // Queries return indices into points
+    void rebuild(const std::vector<glm::vec2>& points);
+
+    // Points within radius of center, appended to result in no particular order
+    void queryRadius(const glm::vec2& center, float radius, std::vector<uint32_t>& result) const;
+    // The k points nearest to center within maxRadius, nearest first, in place of the contents of result
+    void queryNearest(const glm::vec2& center, int k, float maxRadius, std::vector<uint32_t>& result) const;
+
+    float cellSize() const;
+
+private:
+    glm::ivec2 cellCoordinates(const glm::vec2& point) const;
+    uint32_t cellIndex(const glm::vec2& point) const;
+
+    glm::vec2 mBoundsMin;
+    float mCellSize;
+    float mInverseCellSize;
+    glm::ivec2 mCellCount;
+    std::vector<uint32_t> mCellStarts;    // cell count + 1, the points of cell c are from mCellStarts[c] on
+    std::vector<glm::vec2> mPoints;       // by cell
+    std::vector<uint32_t> mPointIndices;  // by cell, into the rebuild()'s points
+    // Scratch of rebuild()
+    std::vector<uint32_t> mPointCells;    // of each rebuild() point
+    std::vector<uint32_t> mThreadCounts;  // per thread and cell, then where the thread writes the cell's points
+    std::vector<uint32_t> mRangeStarts;   // per thread, of its range of cells
+};
@@ -0,0 +1,61 @@
+#include "NTerrainLayer.h"
+
+#include "nprofile.h"
+
+// Close to terrain-texture.png, no pop when it arrives
+const glm::vec4 kPlaceholderColor(0.0f, 0.7f, 0.0f, 1.0f);
+
+NTerrainLayer::NTerrainLayer(NRenderDevice& device, NAssetService& assets, const NglTerrainGeometry& terrainGeometry)
+    : mAssets(assets) {
+    const std::vector<NglVertex>& vertices = terrainGeometry.vertices();
+    const std::vector<uint32_t>& indices = terrainGeometry.indices();
+
+    mVertexBuffer = device.createBuffer(NBufferUsage::kVertex, vertices.data(), vertices.size() * sizeof(NglVertex));
+    mIndexBuffer = device.createBuffer(NBufferUsage::kIndex, indices.data(), indices.size() * sizeof(uint32_t));
+    mIndexCount = static_cast<uint32_t>(indices.size());
+
+    // Positions only, for the depth-only passes
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices.size());
+    for (const NglVertex& vertex : vertices) {
+        positions.push_back(vertex.position);
+    }
+    mPositionBuffer =
+            device.createBuffer(NBufferUsage::kVertex, positions.data(), positions.size() * sizeof(glm::vec3));
+
+    // Texture, the terrain covers much of the screen
+    mTexture = assets.requestTexture("terrain-texture.png", NAssetPriority::kHigh, kPlaceholderColor);
+}
+
+NTerrainLayer::~NTerrainLayer() {}
+
+void NTerrainLayer::record(NCommandList& commandList, NPipelineHandle pipeline) const {
+    NGL_PROFILE_SCOPE("Terrain");
+    NDraw draw = makeDraw(pipeline, mVertexBuffer);
+    draw.texture = mAssets.texture(mTexture);
+    commandList.beginScope("Terrain");
+    commandList.draw(draw);
+    commandList.endScope();
+}
+
+void NTerrainLayer::recordDepth(NCommandList& commandList, NPipelineHandle pipeline) const {
+    NGL_PROFILE_SCOPE("Terrain");
+    commandList.beginScope("Terrain");
+    commandList.draw(makeDraw(pipeline, mPositionBuffer));
+    commandList.endScope();
+}
+
+void NTerrainLayer::recordShadow(NCommandList& commandList, NPipelineHandle shadowPipeline, uint32_t cascade) const {
+    NDraw draw = makeDraw(shadowPipeline, mPositionBuffer);
+    draw.cascade = cascade;
+    commandList.draw(draw);
+}
+
+NDraw NTerrainLayer::makeDraw(NPipelineHandle pipeline, NBufferHandle vertexBuffer) const {
+    NDraw draw;
+    draw.pipeline = pipeline;
+    draw.vertexBuffer = vertexBuffer;
+    draw.indexBuffer = mIndexBuffer;
+    draw.indexCount = mIndexCount;
+    return draw;
+}
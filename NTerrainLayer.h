@@ -0,0 +1,33 @@
+#pragma once
+
+#include "NAssetService.h"
+#include "NCommandList.h"
+#include "NRenderDevice.h"
+#include "NglTerrainGeometry.h"
+
+class NTerrainLayer {
+public:
+    // The texture streams in through assets, a plain color stands in until then
+    NTerrainLayer(NRenderDevice& device, NAssetService& assets, const NglTerrainGeometry& terrainGeometry);
+    NTerrainLayer(const NTerrainLayer&) = delete;
+    NTerrainLayer& operator=(const NTerrainLayer&) = delete;
+    NTerrainLayer(NTerrainLayer&&) = delete;
+    NTerrainLayer& operator=(NTerrainLayer&&) = delete;
+    ~NTerrainLayer();
+
+    void record(NCommandList& commandList, NPipelineHandle pipeline) const;
+    // Depth only, pipeline uses NShader::kDepth
+    void recordDepth(NCommandList& commandList, NPipelineHandle pipeline) const;
+    // Depth only, into the given shadow cascade
+    void recordShadow(NCommandList& commandList, NPipelineHandle shadowPipeline, uint32_t cascade) const;
+
+private:
+    NDraw makeDraw(NPipelineHandle pipeline, NBufferHandle vertexBuffer) const;
+
+    const NAssetService& mAssets;
+    NBufferHandle mVertexBuffer;
+    NBufferHandle mPositionBuffer;
+    NBufferHandle mIndexBuffer;
+    NAssetHandle mTexture;
+    uint32_t mIndexCount;
+};
@@ -6,8 +6,8 @@
 class NglBicubicInterpolation {
 public:
     // samples are row-major, samples[y * 4 + x] = f(x, y)
-    class NglBicubicInterpolation();
-    class NglBicubicInterpolation(int column, int row, float samples[16]);
+    NglBicubicInterpolation();
+    NglBicubicInterpolation(int column, int row, float samples[16]);
     ~NglBicubicInterpolation() = default;
 
     float interpolate(float normalizedX, float normalizedY);
@@ -3,11 +3,14 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "nfile.h"
 #include "nglassert.h"
 #include "ngllog.h"
 
 NglDisplacementMap::NglDisplacementMap(const char* path) {
-    mData = stbi_load(path, &mWidth, &mDepth, nullptr, STBI_grey);
+    NMappedFile file = nMapFile(path, NFileAccess::kSequential);
+    mData = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()), static_cast<int>(file.size()),
+                                  &mWidth, &mDepth, nullptr, STBI_grey);
     NGL_ASSERT(mData);
     NGL_ASSERT(mWidth > 0);
     NGL_ASSERT(mDepth > 0);
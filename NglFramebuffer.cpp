@@ -0,0 +1,23 @@
+#include "NglFramebuffer.h"
+
+#include "nglassert.h"
+#include "nglerr.h"
+
+static GLuint create() {
+    GLuint name;
+    glCreateFramebuffers(1, &name);
+    NGL_CHECK_ERRORS;
+    NGL_ASSERT(name);
+    return name;
+}
+
+NglFramebuffer::NglFramebuffer() : mName(create()) {}
+
+NglFramebuffer::~NglFramebuffer() {
+    glDeleteFramebuffers(1, &mName);
+    NGL_CHECK_ERRORS;
+}
+
+NglFramebuffer::operator GLuint() const {
+    return mName;
+}
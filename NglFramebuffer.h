@@ -0,0 +1,18 @@
+#pragma once
+
+#include "nglgl.h"
+
+class NglFramebuffer {
+public:
+    NglFramebuffer();
+    NglFramebuffer(const NglFramebuffer&) = delete;
+    NglFramebuffer& operator=(const NglFramebuffer&) = delete;
+    NglFramebuffer(NglFramebuffer&&) = delete;
+    NglFramebuffer& operator=(NglFramebuffer&&) = delete;
+    ~NglFramebuffer();
+
+    operator GLuint() const;
+
+private:
+    const GLuint mName;
+};
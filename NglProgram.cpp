@@ -1,5 +1,6 @@
 #include "NglProgram.h"
 
+#include <utility>
 #include <vector>
 
 #include "nglassert.h"
@@ -48,16 +49,23 @@ NglProgram::Builder& NglProgram::Builder::setFragmentShader(const char* shaderCo
     return *this;
 }
 
+NglProgram::Builder& NglProgram::Builder::addDefine(const char* name) {
+    NGL_ASSERT(name);
+    mDefines += "#define ";
+    mDefines += name;
+    mDefines += "\n";
+    return *this;
+}
+
 NglProgram NglProgram::Builder::build() {
     NGL_ASSERT(!mVertexShaderCode.empty());
     NGL_ASSERT(!mFragmentShaderCode.empty());
 
-    GLuint vertexShader = generateShader(GL_VERTEX_SHADER, mVertexShaderCode.c_str(), "mVertexShaderCode");
-    GLuint geometryShader =
-            !mGeometryShaderCode.empty()
-                    ? generateShader(GL_GEOMETRY_SHADER, mGeometryShaderCode.c_str(), "mGeometryShaderCode")
-                    : 0;
-    GLuint fragmentShader = generateShader(GL_FRAGMENT_SHADER, mFragmentShaderCode.c_str(), "mFragmentShaderCode");
+    GLuint vertexShader = generateShader(GL_VERTEX_SHADER, mVertexShaderCode, "mVertexShaderCode");
+    GLuint geometryShader = !mGeometryShaderCode.empty()
+                                    ? generateShader(GL_GEOMETRY_SHADER, mGeometryShaderCode, "mGeometryShaderCode")
+                                    : 0;
+    GLuint fragmentShader = generateShader(GL_FRAGMENT_SHADER, mFragmentShaderCode, "mFragmentShaderCode");
 
     GLuint program = glCreateProgram();
     NGL_CHECK_ERRORS;
@@ -92,10 +100,18 @@ NglProgram NglProgram::Builder::build() {
     return NglProgram(program);
 }
 
-GLuint NglProgram::Builder::generateShader(GLenum shaderType, const char* shaderCode, const char* label) {
+GLuint NglProgram::Builder::generateShader(GLenum shaderType, const std::string& shaderCode,
+                                          const char* label) const {
+    // #version has to come first
+    std::string code = shaderCode;
+    size_t versionStart = code.find("#version");
+    NGL_ASSERT(versionStart != std::string::npos);
+    code.insert(code.find('\n', versionStart) + 1, mDefines);
+    const char* codeData = code.c_str();
+
     GLuint shader = glCreateShader(shaderType);
     NGL_CHECK_ERRORS;
-    glShaderSource(shader, 1, &shaderCode, nullptr);
+    glShaderSource(shader, 1, &codeData, nullptr);
     NGL_CHECK_ERRORS;
     glCompileShader(shader);
     NGL_CHECK_ERRORS;
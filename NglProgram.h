@@ -19,15 +19,18 @@ public:
         Builder& setVertexShader(const char* shaderCode);
         Builder& setGeometryShader(const char* shaderCode);
         Builder& setFragmentShader(const char* shaderCode);
+        // Defined in all stages, right after the #version line
+        Builder& addDefine(const char* name);
 
         NglProgram build();
 
     private:
-        static GLuint generateShader(GLenum shaderType, const char* shaderCode, const char* label);
+        GLuint generateShader(GLenum shaderType, const std::string& shaderCode, const char* label) const;
 
         std::string mVertexShaderCode;
         std::string mGeometryShaderCode;
         std::string mFragmentShaderCode;
+        std::string mDefines;
     };
 
 private:
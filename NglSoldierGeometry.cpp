@@ -0,0 +1,410 @@
+#include "NglSoldierGeometry.h"
+
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <assimp/Importer.hpp>
+#include <cctype>
+#include <cmath>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "nfile.h"
+#include "nglassert.h"
+#include "nglassimp.h"
+#include "ngllog.h"
+
+constexpr float kModelScale = 0.01f;
+constexpr unsigned int kImportFlags =
+        aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices;
+
+// In NAnimation order, a model's animation is the clip whose name it contains
+const char* const kAnimationNames[] = {"walk", "idle", "attack"};
+static_assert(sizeof(kAnimationNames) / sizeof(kAnimationNames[0]) == static_cast<size_t>(NAnimation::kCount),
+              "Every clip needs a name");
+
+// Rig of a model without a skin, made for the blocky soldier.glb: rigid arms and legs, and a torso that carries the
+// head. Proportions are fractions of the model's height and half width. The soldier faces +z, its left is +x.
+constexpr int kHipsJoint = 0;
+constexpr int kTorsoJoint = 1;
+constexpr int kLeftLegJoint = 2;
+constexpr int kRightLegJoint = 3;
+constexpr int kLeftArmJoint = 4;
+constexpr int kRightArmJoint = 5;
+constexpr int kRigJointCount = 6;
+constexpr float kHipHeight = 0.355f;  // top of the legs
+constexpr float kHipBlend = 0.1f;     // above and below kHipHeight, the legs blend into the torso
+constexpr float kShoulderHeight = 0.72f;
+constexpr float kLegX = 0.33f;
+constexpr float kArmX = 0.62f;  // arms are further out, the legs and the torso within
+constexpr float kShoulderX = 0.82f;
+constexpr int kSineKeyCount = 8;
+
+static bool importSkin(const aiScene* scene, const glm::mat4& meshTransform, size_t vertexCount,
+                       NSkeleton& skeleton, std::vector<NVertexSkin>& skins, std::vector<NAnimationClip>& clips);
+static void addJoints(const aiNode* node, int parent, const std::map<std::string, const aiBone*>& bones,
+                      const glm::mat4& meshTransform, NSkeleton& skeleton, std::map<std::string, int>& jointIndices);
+static NAnimationClip importClip(const aiAnimation* animation, const char* name,
+                                 const std::map<std::string, int>& jointIndices);
+static void rig(const std::vector<NglVertex>& vertices, NSkeleton& skeleton, std::vector<NVertexSkin>& skins,
+                std::vector<NAnimationClip>& clips);
+static void addRigJoint(NSkeleton& skeleton, const char* name, int parent, const glm::vec3& pivot);
+static NJointTrack sineTrack(int joint, const glm::vec3& axis, float amplitude, float phaseOffset);
+static NJointTrack keyedTrack(int joint, const glm::vec3& axis, const std::vector<std::pair<float, float>>& angles);
+
+NglSoldierGeometry::NglSoldierGeometry() {
+    // GLTF model
+    const char* path = "soldier.glb";
+    NMappedFile file = nMapFile(path, NFileAccess::kSequential);
+    import(file.data(), file.size(), path);
+}
+
+NglSoldierGeometry::NglSoldierGeometry(const void* data, size_t size, const char* label) {
+    import(data, size, label);
+}
+
+NglSoldierGeometry::~NglSoldierGeometry() {}
+
+const std::vector<NglVertex>& NglSoldierGeometry::vertices() const {
+    return mVertices;
+}
+
+const std::vector<uint32_t>& NglSoldierGeometry::indices() const {
+    return mIndices;
+}
+
+const std::vector<unsigned char>& NglSoldierGeometry::texture() const {
+    return mTexture;
+}
+
+const NAnimationTexture& NglSoldierGeometry::animationTexture() const {
+    return mAnimationTexture;
+}
+
+const NAnimationTexture& NglSoldierGeometry::skinTexture() const {
+    return mSkinTexture;
+}
+
+const glm::vec3& NglSoldierGeometry::animatedBoundsMin() const {
+    return mAnimatedBoundsMin;
+}
+
+const glm::vec3& NglSoldierGeometry::animatedBoundsMax() const {
+    return mAnimatedBoundsMax;
+}
+
+void NglSoldierGeometry::import(const void* data, size_t size, const char* label) {
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFileFromMemory(data, size, kImportFlags, "glb");
+    if (scene) {
+        NGL_LOGI("%s loaded", label);
+    } else {
+        NGL_LOGE("Error loading %s: %s", label, importer.GetErrorString());
+        abort();
+    }
+    load(scene);
+}
+
+void NglSoldierGeometry::load(const aiScene* scene) {
+    float bottom = 0;
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+        const aiMesh* mesh = scene->mMeshes[m];
+        NGL_ASSERT(mesh->HasTextureCoords(0));
+        for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
+            NglVertex vertex;
+            vertex.position = ai2glm(mesh->mVertices[v]) * kModelScale;
+            vertex.normal = ai2glm(mesh->mNormals[v]);
+            vertex.uv = ai2glmvec2(mesh->mTextureCoords[0][v]);
+            mVertices.push_back(vertex);
+            bottom = std::min(bottom, vertex.position.y);
+        }
+        for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+            const aiFace& face = mesh->mFaces[f];
+            NGL_ASSERT(face.mNumIndices == 3);
+            mIndices.push_back(face.mIndices[0]);
+            mIndices.push_back(face.mIndices[1]);
+            mIndices.push_back(face.mIndices[2]);
+        }
+    }
+
+    // Rebase to y = 0
+    for (NglVertex& vertex : mVertices) {
+        vertex.position.y -= bottom;
+    }
+
+    // Skin and clips, in the model space of the vertices above
+    NSkeleton skeleton;
+    std::vector<NVertexSkin> skins;
+    std::vector<NAnimationClip> clips;
+    glm::mat4 meshTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -bottom, 0.0f)) *
+                              glm::scale(glm::mat4(1.0f), glm::vec3(kModelScale));
+    if (!importSkin(scene, meshTransform, mVertices.size(), skeleton, skins, clips)) {
+        NGL_LOGI("Soldier has no skin, rigged with %d joints", kRigJointCount);
+        rig(mVertices, skeleton, skins, clips);
+    }
+    bake(skeleton, skins, clips);
+
+    // Soldier texture
+    NGL_ASSERT(scene->mNumMaterials > 0);
+    const aiMaterial* material = scene->mMaterials[0];
+    NGL_LOGI("Soldier material: %s", material->GetName().C_Str());
+    NGL_ASSERT(material->GetName().length > 0);
+    NGL_LOGI("Soldier diffuse texture count: %u", material->GetTextureCount(aiTextureType_DIFFUSE));
+    aiString texturePath;
+    NGL_ASSERT(material->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS);
+    NGL_LOGI("Soldier diffuse texture 0, path: %s", texturePath.C_Str());
+    const aiTexture* aiTexture = scene->GetEmbeddedTexture(texturePath.C_Str());
+    NGL_ASSERT(aiTexture);
+    NGL_LOGI("Soldier diffuse texture 0, width: %u, height: %u", aiTexture->mWidth, aiTexture->mHeight);
+    NGL_ASSERT(aiTexture->pcData);
+    NGL_ASSERT(aiTexture->mHeight == 0);
+    NGL_ASSERT(aiTexture->mWidth > 0);
+    const unsigned char* textureData = reinterpret_cast<const unsigned char*>(aiTexture->pcData);
+    mTexture.assign(textureData, textureData + aiTexture->mWidth);
+}
+
+void NglSoldierGeometry::bake(const NSkeleton& skeleton, const std::vector<NVertexSkin>& skins,
+                              const std::vector<NAnimationClip>& clips) {
+    mAnimationTexture = nBakeAnimations(skeleton, clips);
+    mSkinTexture = nBakeSkins(skins);
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(mVertices.size());
+    for (const NglVertex& vertex : mVertices) {
+        positions.push_back(vertex.position);
+    }
+    nAnimatedBounds(skeleton, clips, positions, skins, mAnimatedBoundsMin, mAnimatedBoundsMax);
+    NGL_LOGI("Soldier animations baked, %zu joints, %zu clips of %u frames, %dx%d texels", skeleton.joints.size(),
+             clips.size(), kNAnimationFrameCount, mAnimationTexture.width, mAnimationTexture.height);
+}
+
+bool importSkin(const aiScene* scene, const glm::mat4& meshTransform, size_t vertexCount, NSkeleton& skeleton,
+                std::vector<NVertexSkin>& skins, std::vector<NAnimationClip>& clips) {
+    // A joint may move the vertices of several meshes, with the same bind pose
+    std::map<std::string, const aiBone*> bones;
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+        const aiMesh* mesh = scene->mMeshes[m];
+        for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+            bones[mesh->mBones[b]->mName.C_Str()] = mesh->mBones[b];
+        }
+    }
+    if (bones.empty()) {
+        return false;
+    }
+    std::map<std::string, int> jointIndices;
+    addJoints(scene->mRootNode, -1, bones, meshTransform, skeleton, jointIndices);
+
+    // The largest influences of each vertex, vertices no bone moves follow the first joint
+    std::vector<std::vector<std::pair<float, int>>> influences(vertexCount);
+    size_t vertexBase = 0;
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+        const aiMesh* mesh = scene->mMeshes[m];
+        for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+            const aiBone* bone = mesh->mBones[b];
+            int joint = jointIndices.at(bone->mName.C_Str());
+            for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+                const aiVertexWeight& weight = bone->mWeights[w];
+                influences[vertexBase + weight.mVertexId].push_back({weight.mWeight, joint});
+            }
+        }
+        vertexBase += mesh->mNumVertices;
+    }
+    skins.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        std::vector<std::pair<float, int>>& vertexInfluences = influences[v];
+        std::sort(vertexInfluences.rbegin(), vertexInfluences.rend());
+        int count = std::min(static_cast<int>(vertexInfluences.size()), kNJointInfluenceCount);
+        float total = 0.0f;
+        for (int k = 0; k < count; k++) {
+            total += vertexInfluences[k].first;
+        }
+        for (int k = 0; k < count && total > 0.0f; k++) {
+            skins[v].joints[k] = vertexInfluences[k].second;
+            skins[v].weights[k] = vertexInfluences[k].first / total;
+        }
+    }
+
+    clips.resize(static_cast<size_t>(NAnimation::kCount));
+    for (size_t i = 0; i < clips.size(); i++) {
+        clips[i].name = kAnimationNames[i];
+        for (unsigned int a = 0; a < scene->mNumAnimations && clips[i].tracks.empty(); a++) {
+            std::string name = scene->mAnimations[a]->mName.C_Str();
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (name.find(kAnimationNames[i]) != std::string::npos) {
+                clips[i] = importClip(scene->mAnimations[a], kAnimationNames[i], jointIndices);
+                NGL_LOGI("Soldier animation %s is the %s clip", scene->mAnimations[a]->mName.C_Str(),
+                         kAnimationNames[i]);
+            }
+        }
+        if (clips[i].tracks.empty()) {
+            NGL_LOGI("Soldier has no %s animation, the clip holds the rest pose", kAnimationNames[i]);
+        }
+    }
+    NGL_LOGI("Soldier skin imported, %zu joints", skeleton.joints.size());
+    return true;
+}
+
+void addJoints(const aiNode* node, int parent, const std::map<std::string, const aiBone*>& bones,
+               const glm::mat4& meshTransform, NSkeleton& skeleton, std::map<std::string, int>& jointIndices) {
+    // Depth first, so parents come first. Nodes between joints are taken to be identity.
+    auto bone = bones.find(node->mName.C_Str());
+    if (bone != bones.end()) {
+        if (skeleton.joints.empty()) {
+            // Every root is taken to hang from the same node
+            glm::mat4 parentTransform(1.0f);
+            for (const aiNode* ancestor = node->mParent; ancestor != nullptr; ancestor = ancestor->mParent) {
+                parentTransform = ai2glm(ancestor->mTransformation) * parentTransform;
+            }
+            skeleton.rootTransform = meshTransform * parentTransform;
+        }
+        NJoint joint;
+        joint.name = bone->first;
+        joint.parent = parent;
+        aiVector3D scaling, position;
+        aiQuaternion rotation;
+        node->mTransformation.Decompose(scaling, rotation, position);
+        joint.restPose.translation = ai2glm(position);
+        joint.restPose.rotation = ai2glm(rotation);
+        joint.restPose.scale = ai2glm(scaling);
+        // The offset matrix takes the mesh as imported, the vertices were scaled and rebased since
+        joint.inverseBind = ai2glm(bone->second->mOffsetMatrix) * glm::inverse(meshTransform);
+        parent = static_cast<int>(skeleton.joints.size());
+        jointIndices[joint.name] = parent;
+        skeleton.joints.push_back(joint);
+    }
+    for (unsigned int c = 0; c < node->mNumChildren; c++) {
+        addJoints(node->mChildren[c], parent, bones, meshTransform, skeleton, jointIndices);
+    }
+}
+
+NAnimationClip importClip(const aiAnimation* animation, const char* name,
+                          const std::map<std::string, int>& jointIndices) {
+    // Key times in ticks, to fractions of the clip
+    double duration = animation->mDuration > 0.0 ? animation->mDuration : 1.0;
+    auto phase = [duration](double time) { return static_cast<float>(std::clamp(time / duration, 0.0, 1.0)); };
+
+    NAnimationClip clip;
+    clip.name = name;
+    for (unsigned int c = 0; c < animation->mNumChannels; c++) {
+        const aiNodeAnim* channel = animation->mChannels[c];
+        auto joint = jointIndices.find(channel->mNodeName.C_Str());
+        if (joint == jointIndices.end()) {
+            continue;
+        }
+        NJointTrack track;
+        track.joint = joint->second;
+        for (unsigned int k = 0; k < channel->mNumPositionKeys; k++) {
+            track.translations.times.push_back(phase(channel->mPositionKeys[k].mTime));
+            track.translations.values.push_back(ai2glm(channel->mPositionKeys[k].mValue));
+        }
+        for (unsigned int k = 0; k < channel->mNumRotationKeys; k++) {
+            track.rotations.times.push_back(phase(channel->mRotationKeys[k].mTime));
+            track.rotations.values.push_back(ai2glm(channel->mRotationKeys[k].mValue));
+        }
+        for (unsigned int k = 0; k < channel->mNumScalingKeys; k++) {
+            track.scales.times.push_back(phase(channel->mScalingKeys[k].mTime));
+            track.scales.values.push_back(ai2glm(channel->mScalingKeys[k].mValue));
+        }
+        clip.tracks.push_back(track);
+    }
+    return clip;
+}
+
+void rig(const std::vector<NglVertex>& vertices, NSkeleton& skeleton, std::vector<NVertexSkin>& skins,
+         std::vector<NAnimationClip>& clips) {
+    float height = 0.0f;
+    float halfWidth = 0.0f;
+    for (const NglVertex& vertex : vertices) {
+        height = std::max(height, vertex.position.y);
+        halfWidth = std::max(halfWidth, std::abs(vertex.position.x));
+    }
+    float hipY = kHipHeight * height;
+    float shoulderY = kShoulderHeight * height;
+    addRigJoint(skeleton, "hips", -1, glm::vec3(0.0f, hipY, 0.0f));
+    addRigJoint(skeleton, "torso", kHipsJoint, glm::vec3(0.0f, hipY, 0.0f));
+    addRigJoint(skeleton, "left leg", kHipsJoint, glm::vec3(kLegX * halfWidth, hipY, 0.0f));
+    addRigJoint(skeleton, "right leg", kHipsJoint, glm::vec3(-kLegX * halfWidth, hipY, 0.0f));
+    addRigJoint(skeleton, "left arm", kTorsoJoint, glm::vec3(kShoulderX * halfWidth, shoulderY, 0.0f));
+    addRigJoint(skeleton, "right arm", kTorsoJoint, glm::vec3(-kShoulderX * halfWidth, shoulderY, 0.0f));
+
+    skins.resize(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++) {
+        glm::vec3 position = vertices[v].position;
+        bool isLeft = position.x > 0.0f;
+        NVertexSkin& skin = skins[v];
+        if (std::abs(position.x) > kArmX * halfWidth) {
+            skin.joints[0] = isLeft ? kLeftArmJoint : kRightArmJoint;
+            continue;
+        }
+        int leg = isLeft ? kLeftLegJoint : kRightLegJoint;
+        float torsoWeight = glm::smoothstep(hipY - kHipBlend * height, hipY + kHipBlend * height, position.y);
+        bool isTorso = torsoWeight >= 0.5f;
+        skin.joints[0] = isTorso ? kTorsoJoint : leg;
+        skin.joints[1] = isTorso ? leg : kTorsoJoint;
+        skin.weights[0] = std::max(torsoWeight, 1.0f - torsoWeight);
+        skin.weights[1] = 1.0f - skin.weights[0];
+    }
+
+    // Angles in radians. Legs and arms swing around x, forward for negative angles.
+    const glm::vec3 xAxis(1.0f, 0.0f, 0.0f);
+    const glm::vec3 yAxis(0.0f, 1.0f, 0.0f);
+    const glm::vec3 zAxis(0.0f, 0.0f, 1.0f);
+    clips.resize(static_cast<size_t>(NAnimation::kCount));
+    for (size_t i = 0; i < clips.size(); i++) {
+        clips[i].name = kAnimationNames[i];
+    }
+    // Two steps, each arm swinging against the leg on its side. The hips sway like the whole body did before there
+    // were animations.
+    clips[static_cast<size_t>(NAnimation::kWalk)].tracks = {
+            sineTrack(kHipsJoint, zAxis, 0.03f, 0.0f),
+            sineTrack(kLeftLegJoint, xAxis, 0.45f, 0.0f),
+            sineTrack(kRightLegJoint, xAxis, 0.45f, 0.5f),
+            sineTrack(kLeftArmJoint, xAxis, 0.35f, 0.5f),
+            sineTrack(kRightArmJoint, xAxis, 0.35f, 0.0f),
+    };
+    // Breathing
+    clips[static_cast<size_t>(NAnimation::kIdle)].tracks = {
+            sineTrack(kTorsoJoint, xAxis, 0.03f, 0.0f),
+            sineTrack(kLeftArmJoint, zAxis, 0.04f, 0.0f),
+            sineTrack(kRightArmJoint, zAxis, -0.04f, 0.0f),
+    };
+    // The right arm is raised and strikes down in front, with the torso turning into the blow. The raised arm stays
+    // below the top of the head.
+    clips[static_cast<size_t>(NAnimation::kAttack)].tracks = {
+            keyedTrack(kTorsoJoint, yAxis, {{0.0f, 0.0f}, {0.3f, 0.25f}, {0.5f, -0.3f}, {0.8f, -0.1f}}),
+            keyedTrack(kRightArmJoint, xAxis, {{0.0f, 0.0f}, {0.3f, -2.0f}, {0.5f, -0.6f}, {0.8f, -0.2f}}),
+    };
+}
+
+void addRigJoint(NSkeleton& skeleton, const char* name, int parent, const glm::vec3& pivot) {
+    // Joints are not rotated in the bind pose, a joint's space is model space moved to its pivot
+    glm::vec3 parentPivot = parent < 0 ? glm::vec3(0.0f) : -glm::vec3(skeleton.joints[parent].inverseBind[3]);
+    NJoint joint;
+    joint.name = name;
+    joint.parent = parent;
+    joint.restPose.translation = pivot - parentPivot;
+    joint.inverseBind = glm::translate(glm::mat4(1.0f), -pivot);
+    skeleton.joints.push_back(joint);
+}
+
+NJointTrack sineTrack(int joint, const glm::vec3& axis, float amplitude, float phaseOffset) {
+    std::vector<std::pair<float, float>> angles;
+    for (int k = 0; k < kSineKeyCount; k++) {
+        float phase = static_cast<float>(k) / kSineKeyCount;
+        angles.push_back({phase, amplitude * std::sin((phase + phaseOffset) * glm::two_pi<float>())});
+    }
+    return keyedTrack(joint, axis, angles);
+}
+
+NJointTrack keyedTrack(int joint, const glm::vec3& axis, const std::vector<std::pair<float, float>>& angles) {
+    NJointTrack track;
+    track.joint = joint;
+    for (const auto& angle : angles) {
+        track.rotations.times.push_back(angle.first);
+        track.rotations.values.push_back(glm::angleAxis(angle.second, axis));
+    }
+    return track;
+}
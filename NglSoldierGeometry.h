@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NglVertex.h"
+#include "nanim.h"
+
+struct aiScene;
+
+class NglSoldierGeometry {
+public:
+    // Reads soldier.glb
+    NglSoldierGeometry();
+    // From the contents of a .glb file, label names it in the log. Safe to call on any thread.
+    NglSoldierGeometry(const void* data, size_t size, const char* label);
+    NglSoldierGeometry(const NglSoldierGeometry&) = delete;
+    NglSoldierGeometry& operator=(const NglSoldierGeometry&) = delete;
+    NglSoldierGeometry(NglSoldierGeometry&&) = delete;
+    NglSoldierGeometry& operator=(NglSoldierGeometry&&) = delete;
+    ~NglSoldierGeometry();
+
+    const std::vector<NglVertex>& vertices() const;
+    const std::vector<uint32_t>& indices() const;
+
+    // Encoded (PNG/JPEG) diffuse texture embedded in the model
+    const std::vector<unsigned char>& texture() const;
+
+    // The model's skin and its walk, idle and attack clips baked for the vertex shaders, see nanim.h. A model without
+    // a skin, like soldier.glb, is rigged here with clips authored in code.
+    const NAnimationTexture& animationTexture() const;
+    const NAnimationTexture& skinTexture() const;
+    // Of the vertices in every baked frame
+    const glm::vec3& animatedBoundsMin() const;
+    const glm::vec3& animatedBoundsMax() const;
+
+private:
+    void import(const void* data, size_t size, const char* label);
+    void load(const aiScene* scene);
+    void bake(const NSkeleton& skeleton, const std::vector<NVertexSkin>& skins,
+              const std::vector<NAnimationClip>& clips);
+
+    std::vector<NglVertex> mVertices;
+    std::vector<uint32_t> mIndices;
+    std::vector<unsigned char> mTexture;
+    NAnimationTexture mAnimationTexture;
+    NAnimationTexture mSkinTexture;
+    glm::vec3 mAnimatedBoundsMin = glm::vec3(0.0f);
+    glm::vec3 mAnimatedBoundsMax = glm::vec3(0.0f);
+};
@@ -1,8 +1,13 @@
 #include "NglSoundGenerator.h"
 
+#include "nfile.h"
+
 NglSoundGenerator::NglSoundGenerator() {
     mSoloud.init();
-    mSound.load("sound.mp3");
+    // Decoded whole by loadMem(), the mapping is not needed afterwards
+    NMappedFile file = nMapFile("sound.mp3", NFileAccess::kSequential);
+    mSound.loadMem(reinterpret_cast<const unsigned char*>(file.data()), static_cast<unsigned int>(file.size()), false,
+                   false);
     int soundHandle = mSoloud.play(mSound, 0.15f);
     mSoloud.setLooping(soundHandle, true);
 }
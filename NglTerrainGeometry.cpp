@@ -1,6 +1,7 @@
 #include "NglTerrainGeometry.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "NglBicubicInterpolation.h"
 #include "NglDisplacementMap.h"
@@ -115,6 +116,50 @@ int NglTerrainGeometry::depth() const {
     return kGranularity + 1;
 }
 
+vec3 NglTerrainGeometry::boundsMin() const {
+    return vec3(kMinX, kMinY, kMinZ);
+}
+
+vec3 NglTerrainGeometry::boundsMax() const {
+    return vec3(kMaxX, kMaxY, kMaxZ);
+}
+
+void NglTerrainGeometry::heightRange(const vec2& rectMin, const vec2& rectMax, float& minY, float& maxY) const {
+    bool isInside = rectMin.x >= kMinX && rectMax.x <= kMaxX && rectMin.y >= kMinZ && rectMax.y <= kMaxZ;
+    minY = isInside ? kMaxY : 0.0f;
+    maxY = isInside ? kMinY : 0.0f;
+    // Heights are interpolated linearly between the vertices, so the vertices of the covered cells bound them
+    int minI = std::clamp(static_cast<int>(std::floor((rectMin.x - kMinX) / (kMaxX - kMinX) * kGranularity)), 0,
+                          kGranularity);
+    int maxI = std::clamp(static_cast<int>(std::ceil((rectMax.x - kMinX) / (kMaxX - kMinX) * kGranularity)), 0,
+                          kGranularity);
+    int minJ = std::clamp(static_cast<int>(std::floor((rectMin.y - kMinZ) / (kMaxZ - kMinZ) * kGranularity)), 0,
+                          kGranularity);
+    int maxJ = std::clamp(static_cast<int>(std::ceil((rectMax.y - kMinZ) / (kMaxZ - kMinZ) * kGranularity)), 0,
+                          kGranularity);
+    for (int j = minJ; j <= maxJ; j++) {
+        for (int i = minI; i <= maxI; i++) {
+            minY = std::min(minY, mHeights[index(i, j)]);
+            maxY = std::max(maxY, mHeights[index(i, j)]);
+        }
+    }
+}
+
+float NglTerrainGeometry::height(float x, float z) const {
+    if (x < kMinX || x > kMaxX || z < kMinZ || z > kMaxZ) {
+        return 0.0f;
+    }
+    float u = (x - kMinX) / (kMaxX - kMinX) * kGranularity;
+    float v = (z - kMinZ) / (kMaxZ - kMinZ) * kGranularity;
+    int i = std::min(static_cast<int>(u), kGranularity - 1);
+    int j = std::min(static_cast<int>(v), kGranularity - 1);
+    float s = u - i;
+    float t = v - j;
+    float y0 = glm::mix(mHeights[index(i, j)], mHeights[index(i + 1, j)], s);
+    float y1 = glm::mix(mHeights[index(i, j + 1)], mHeights[index(i + 1, j + 1)], s);
+    return glm::mix(y0, y1, t);
+}
+
 const std::vector<NglVertex>& NglTerrainGeometry::vertices() const {
     return mVertices;
 }
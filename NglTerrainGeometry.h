@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <glm/glm.hpp>
 
 #include "NglVertex.h"
 
@@ -15,6 +16,14 @@ public:
 
     int width() const;
     int depth() const;
+    // World-space box containing the terrain
+    glm::vec3 boundsMin() const;
+    glm::vec3 boundsMax() const;
+    // Lowest and highest terrain heights over the ground rectangle (x, z) from rectMin to rectMax, 0 outside of the
+    // terrain
+    void heightRange(const glm::vec2& rectMin, const glm::vec2& rectMax, float& minY, float& maxY) const;
+    // Terrain height at (x, z), bilinear between the vertices, 0 outside of the terrain
+    float height(float x, float z) const;
 
     const std::vector<NglVertex>& vertices() const;
     const std::vector<uint32_t>& indices() const;
@@ -1,11 +1,13 @@
 #include "NglTexture.h"
 
-#include <stb_image.h>
+#include <algorithm>
 
 #include "nglassert.h"
 #include "nglerr.h"
 #include "ngllog.h"
 
+static void setSampling(GLuint name, int levelCount);
+
 static GLuint create() {
     GLuint name;
     glCreateTextures(GL_TEXTURE_2D, 1, &name);
@@ -25,41 +27,81 @@ NglTexture::operator GLuint() const {
     return mName;
 }
 
-void NglTexture::load(const char* path) const {
-    int width;
-    int height;
-    void* pixels = stbi_load(path, &width, &height, nullptr, STBI_rgb);
-    load(pixels, width, height, path);
-}
+void NglTexture::load(GLenum internalFormat, int width, int height, int levelCount, GLenum format, GLenum type,
+                      const void* pixels, const char* label) const {
+    NGL_ASSERT(pixels);
+    NGL_ASSERT(levelCount >= 1);
 
-void NglTexture::load(const void* data, uint32_t length, const char* label) const {
-    int width;
-    int height;
-    void* pixels =
-            stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(data), length, &width, &height, nullptr, STBI_rgb);
-    load(pixels, width, height, label);
+    setSampling(mName, levelCount);
+    glTextureStorage2D(mName, levelCount, internalFormat, width, height);
+    NGL_CHECK_ERRORS;
+    glTextureSubImage2D(mName, 0, 0, 0, width, height, format, type, pixels);
+    NGL_CHECK_ERRORS;
+    if (levelCount > 1) {
+        glGenerateTextureMipmap(mName);
+        NGL_CHECK_ERRORS;
+    }
+
+    NGL_LOGI("Texture %s loaded, width: %d, height: %d, levels: %d", label, width, height, levelCount);
 }
 
-void NglTexture::load(void* pixels, int width, int height, const char* label) const {
-    NGL_ASSERT(pixels);
+void NglTexture::loadBlocks(GLenum internalFormat, int blockSize, int width, int height, int levelCount,
+                            const void* data, const char* label) const {
+    NGL_ASSERT(data);
+    NGL_ASSERT(levelCount >= 1);
+
+    setSampling(mName, levelCount);
+    glTextureStorage2D(mName, levelCount, internalFormat, width, height);
+    NGL_CHECK_ERRORS;
+    const char* levelData = static_cast<const char*>(data);
+    size_t totalSize = 0;
+    for (int level = 0; level < levelCount; level++) {
+        int levelWidth = std::max(width >> level, 1);
+        int levelHeight = std::max(height >> level, 1);
+        GLsizei size = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize;
+        glCompressedTextureSubImage2D(mName, level, 0, 0, levelWidth, levelHeight, internalFormat, size, levelData);
+        NGL_CHECK_ERRORS;
+        levelData += size;
+        totalSize += size;
+    }
 
+    NGL_LOGI("Texture %s loaded, width: %d, height: %d, levels: %d, %zu bytes", label, width, height, levelCount,
+             totalSize);
+}
+
+void NglTexture::allocate(GLenum internalFormat, int width, int height, const char* label) const {
     glTextureParameteri(mName, GL_TEXTURE_MAX_LEVEL, 0);
     NGL_CHECK_ERRORS;
-    glTextureParameteri(mName, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(mName, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     NGL_CHECK_ERRORS;
-    glTextureParameteri(mName, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(mName, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     NGL_CHECK_ERRORS;
-    glTextureStorage2D(mName, 1, GL_RGB8, width, height);
+    glTextureStorage2D(mName, 1, internalFormat, width, height);
     NGL_CHECK_ERRORS;
-    glTextureSubImage2D(mName, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glObjectLabel(GL_TEXTURE, mName, -1, label);
     NGL_CHECK_ERRORS;
 
-    stbi_image_free(pixels);
-
-    NGL_LOGI("Texture %s loaded, width: %d, height: %d", label, width, height);
+    NGL_LOGI("Render target %s allocated, width: %d, height: %d", label, width, height);
 }
 
 void NglTexture::bind(GLuint unit) const {
     glBindTextureUnit(unit, mName);
     NGL_CHECK_ERRORS;
 }
+
+void setSampling(GLuint name, int levelCount) {
+    // Trilinear, and anisotropic for surfaces seen at grazing angles like the terrain, when there are levels
+    glTextureParameteri(name, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    NGL_CHECK_ERRORS;
+    glTextureParameteri(name, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    NGL_CHECK_ERRORS;
+    glTextureParameteri(name, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    NGL_CHECK_ERRORS;
+    if (levelCount > 1) {
+        GLfloat maxAnisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+        NGL_CHECK_ERRORS;
+        glTextureParameterf(name, GL_TEXTURE_MAX_ANISOTROPY, maxAnisotropy);
+        NGL_CHECK_ERRORS;
+    }
+}
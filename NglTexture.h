@@ -13,13 +13,18 @@ public:
 
     operator GLuint() const;
 
-    void load(const char* path) const;
-    void load(const void* data, uint32_t length, const char* label) const;
+    // Allocates levelCount levels, fills the first with tightly packed pixels and generates the others from it
+    void load(GLenum internalFormat, int width, int height, int levelCount, GLenum format, GLenum type,
+              const void* pixels, const char* label) const;
+    // Allocates levelCount levels and fills them with block compressed data, the levels one after the other. blockSize
+    // is the size of a 4x4 block of internalFormat in bytes.
+    void loadBlocks(GLenum internalFormat, int blockSize, int width, int height, int levelCount, const void* data,
+                    const char* label) const;
+    // Allocates a single level without contents, for render targets
+    void allocate(GLenum internalFormat, int width, int height, const char* label) const;
 
     void bind(GLuint unit) const;
 
 private:
-    void load(void* pixels, int width, int height, const char* label) const;
-
     const GLuint mName;
 };
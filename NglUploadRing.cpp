@@ -0,0 +1,78 @@
+#include "NglUploadRing.h"
+
+#include "nglassert.h"
+#include "nglerr.h"
+#include "ngllog.h"
+
+constexpr GLbitfield kMapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+static size_t alignUp(size_t value, size_t alignment);
+static char* map(const NglBuffer& buffer, size_t size);
+
+NglUploadRing::NglUploadRing(size_t frameSize)
+    : mFrameSize(alignUp(frameSize, kMaxAlignment)), mData(map(mBuffer, mFrameSize * kFrameCount)) {
+    NGL_LOGI("Upload ring created, %u frames of %zu bytes", kFrameCount, mFrameSize);
+}
+
+NglUploadRing::~NglUploadRing() {
+    for (GLsync fence : mFences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            NGL_CHECK_ERRORS;
+        }
+    }
+    glUnmapNamedBuffer(mBuffer);
+    NGL_CHECK_ERRORS;
+}
+
+NglUploadRing::operator GLuint() const {
+    return mBuffer;
+}
+
+double NglUploadRing::beginFrame() {
+    mOffset = 0;
+    GLsync& fence = mFences[mFrame];
+    if (fence == nullptr) {
+        return 0;
+    }
+    double waitStartTime = glfwGetTime();
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+    NGL_CHECK_ERRORS;
+    NGL_VERIFY(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED);
+    double waitTime = glfwGetTime() - waitStartTime;
+    glDeleteSync(fence);
+    NGL_CHECK_ERRORS;
+    fence = nullptr;
+    return waitTime;
+}
+
+NglUploadAllocation NglUploadRing::allocate(size_t size, size_t alignment) {
+    NGL_ASSERT(alignment > 0 && alignment <= kMaxAlignment && (alignment & (alignment - 1)) == 0);
+    size_t offset = alignUp(mOffset, alignment);
+    if (size > mFrameSize || offset > mFrameSize - size) {
+        NGL_ABORT("Upload ring frame full, %zu bytes of %zu used, %zu more requested", mOffset, mFrameSize, size);
+    }
+    mOffset = offset + size;
+    size_t ringOffset = mFrame * mFrameSize + offset;
+    return {mData + ringOffset, static_cast<GLintptr>(ringOffset)};
+}
+
+void NglUploadRing::endFrame() {
+    NGL_ASSERT(mFences[mFrame] == nullptr);
+    mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    NGL_CHECK_ERRORS;
+    mFrame = (mFrame + 1) % kFrameCount;
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+char* map(const NglBuffer& buffer, size_t size) {
+    glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(size), nullptr, kMapFlags);
+    NGL_CHECK_ERRORS;
+    void* data = glMapNamedBufferRange(buffer, 0, static_cast<GLsizeiptr>(size), kMapFlags);
+    NGL_CHECK_ERRORS;
+    NGL_ASSERT(data);
+    return static_cast<char*>(data);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "NglBuffer.h"
+#include "nglgl.h"
+
+// Where allocate() put the data: data is written by the CPU, offset is what the GPU reads it from in the ring's buffer
+struct NglUploadAllocation {
+    void* data;
+    GLintptr offset;
+};
+
+// Data the CPU writes every frame, such as uniforms and per-draw data, in a buffer that stays mapped for the ring's
+// lifetime. The buffer is split in kFrameCount slots used round robin, each frame bump allocates from its own slot.
+// A slot is reused once the GPU is done with the frame that last wrote it, so writes never touch memory the GPU is
+// still reading and the driver has no reason to stall or copy, as it may for glBufferSubData().
+class NglUploadRing {
+public:
+    static constexpr uint32_t kFrameCount = 3;
+    // Any alignment GL asks for, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT is at most 256
+    static constexpr size_t kMaxAlignment = 256;
+
+    explicit NglUploadRing(size_t frameSize);
+    NglUploadRing(const NglUploadRing&) = delete;
+    NglUploadRing& operator=(const NglUploadRing&) = delete;
+    NglUploadRing(NglUploadRing&&) = delete;
+    NglUploadRing& operator=(NglUploadRing&&) = delete;
+    ~NglUploadRing();
+
+    operator GLuint() const;
+
+    // Waits until the GPU is done with the next slot, returns the time spent waiting in seconds
+    double beginFrame();
+    // Coherent memory in the current slot, no flush needed. Aborts when the slot is full.
+    NglUploadAllocation allocate(size_t size, size_t alignment);
+    // The slot is released once the GPU has executed the commands issued so far
+    void endFrame();
+
+private:
+    const NglBuffer mBuffer;
+    const size_t mFrameSize;
+    char* const mData;
+    std::array<GLsync, kFrameCount> mFences{};
+    uint32_t mFrame = 0;
+    size_t mOffset = 0;  // in the current slot
+};
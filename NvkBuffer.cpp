@@ -0,0 +1,17 @@
+#include "NvkBuffer.h"
+
+NvkBuffer::NvkBuffer(const NvkContext& context, const void* data, VkDeviceSize size, VkBufferUsageFlags usage)
+    : mContext(context) {
+    mContext.createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mBuffer,
+                          mMemory);
+    mContext.uploadBuffer(data, size, mBuffer);
+}
+
+NvkBuffer::~NvkBuffer() {
+    vkDestroyBuffer(mContext.device(), mBuffer, nullptr);
+    vkFreeMemory(mContext.device(), mMemory, nullptr);
+}
+
+NvkBuffer::operator VkBuffer() const {
+    return mBuffer;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "NvkContext.h"
+
+// Device-local buffer initialized once through a staging copy
+class NvkBuffer {
+public:
+    NvkBuffer(const NvkContext& context, const void* data, VkDeviceSize size, VkBufferUsageFlags usage);
+    NvkBuffer(const NvkBuffer&) = delete;
+    NvkBuffer& operator=(const NvkBuffer&) = delete;
+    NvkBuffer(NvkBuffer&&) = delete;
+    NvkBuffer& operator=(NvkBuffer&&) = delete;
+    ~NvkBuffer();
+
+    operator VkBuffer() const;
+
+private:
+    const NvkContext& mContext;
+    VkBuffer mBuffer;
+    VkDeviceMemory mMemory;
+};
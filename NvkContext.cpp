@@ -0,0 +1,345 @@
+#include "NvkContext.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "nglassert.h"
+#include "ngllog.h"
+#include "nvkerr.h"
+#include "nvkstate.h"
+#include "nvkutil.h"
+
+NvkContext::NvkContext(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue graphicsQueue,
+                       VkCommandPool commandPool)
+    : mPhysicalDevice(physicalDevice), mDevice(device), mGraphicsQueue(graphicsQueue), mCommandPool(commandPool) {}
+
+NvkContext::~NvkContext() {}
+
+VkPhysicalDevice NvkContext::physicalDevice() const {
+    return mPhysicalDevice;
+}
+
+VkDevice NvkContext::device() const {
+    return mDevice;
+}
+
+uint32_t NvkContext::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags propertyFlags) const {
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) &&
+            (memoryProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags) {
+            return i;
+        }
+    }
+    NGL_ABORT("No memory type for typeFilter: %xu", typeFilter);
+}
+
+void NvkContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryPropertyFlags,
+                              VkBuffer& buffer, VkDeviceMemory& bufferMemory) const {
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = usage;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    NVK_CHECK(vkCreateBuffer(mDevice, &bufferCreateInfo, nullptr, &buffer));
+    NGL_LOGI("Created buffer: %p", reinterpret_cast<void*>(buffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(mDevice, buffer, &memoryRequirements);
+    NGL_LOGI("Memory requirements for buffer %p:", reinterpret_cast<void*>(buffer));
+    nvkDumpMemoryRequirements(memoryRequirements, "  ");
+
+    uint32_t memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, memoryPropertyFlags);
+    NGL_LOGI("Required memory type: %u", memoryTypeIndex);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memoryRequirements.size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    NVK_CHECK(vkAllocateMemory(mDevice, &allocInfo, nullptr, &bufferMemory));
+    NGL_LOGI("Allocated memory: %p", reinterpret_cast<void*>(bufferMemory));
+
+    NVK_CHECK(vkBindBufferMemory(mDevice, buffer, bufferMemory, 0));
+}
+
+void NvkContext::uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer) const {
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer,
+                 stagingBufferMemory);
+
+    void* mappedData;
+    NVK_CHECK(vkMapMemory(mDevice, stagingBufferMemory, 0, size, 0, &mappedData));
+    memcpy(mappedData, data, static_cast<size_t>(size));
+    vkUnmapMemory(mDevice, stagingBufferMemory);
+
+    copyBuffer(stagingBuffer, dstBuffer, size);
+
+    vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
+    vkFreeMemory(mDevice, stagingBufferMemory, nullptr);
+}
+
+void NvkContext::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const {
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = 0;  // Optional
+    copyRegion.dstOffset = 0;  // Optional
+    copyRegion.size = size;
+    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+    endSingleTimeCommands(commandBuffer);
+}
+
+void NvkContext::createImage(uint32_t width, uint32_t height, uint32_t levelCount, VkFormat format,
+                             VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memoryPropertyFlags,
+                             VkImage& image, VkDeviceMemory& imageMemory) const {
+    image = createImage(width, height, levelCount, format, tiling, usage);
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(mDevice, image, &memoryRequirements);
+    NGL_LOGI("Memory requirements for image %p:", reinterpret_cast<void*>(image));
+    nvkDumpMemoryRequirements(memoryRequirements, "  ");
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memoryRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, memoryPropertyFlags);
+
+    NVK_CHECK(vkAllocateMemory(mDevice, &allocInfo, nullptr, &imageMemory));
+    NGL_LOGI("Created image memory: %p", reinterpret_cast<void*>(imageMemory));
+
+    NVK_CHECK(vkBindImageMemory(mDevice, image, imageMemory, 0));
+}
+
+VkImage NvkContext::createImage(uint32_t width, uint32_t height, uint32_t levelCount, VkFormat format,
+                                VkImageTiling tiling, VkImageUsageFlags usage) const {
+    VkImageCreateInfo imageCreateInfo{};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.extent.width = width;
+    imageCreateInfo.extent.height = height;
+    imageCreateInfo.extent.depth = 1;
+    imageCreateInfo.mipLevels = levelCount;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.format = format;
+    imageCreateInfo.tiling = tiling;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.usage = usage;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.flags = 0;  // Optional
+    VkImage image;
+    NVK_CHECK(vkCreateImage(mDevice, &imageCreateInfo, nullptr, &image));
+    NGL_LOGI("Created image: %p", reinterpret_cast<void*>(image));
+    return image;
+}
+
+VkImageView NvkContext::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) const {
+    VkImageViewCreateInfo viewCreateInfo{};
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.image = image;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = format;
+    viewCreateInfo.subresourceRange.aspectMask = aspectFlags;
+    viewCreateInfo.subresourceRange.baseMipLevel = 0;
+    viewCreateInfo.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    viewCreateInfo.subresourceRange.layerCount = 1;
+    VkImageView result;
+    NVK_CHECK(vkCreateImageView(mDevice, &viewCreateInfo, nullptr, &result));
+    return result;
+}
+
+void NvkContext::uploadImage(const void* pixels, VkDeviceSize size, VkImage image, VkFormat format, uint32_t width,
+                             uint32_t height, uint32_t levelCount) const {
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer,
+                 stagingBufferMemory);
+
+    void* data;
+    NVK_CHECK(vkMapMemory(mDevice, stagingBufferMemory, 0, size, 0, &data));
+    memcpy(data, pixels, static_cast<size_t>(size));
+    vkUnmapMemory(mDevice, stagingBufferMemory);
+
+    transitionImageLayout(image, format, NResourceState::kUndefined, NResourceState::kTransferDst);
+    copyBufferToImage(stagingBuffer, image, format, width, height, levelCount);
+    transitionImageLayout(image, format, NResourceState::kTransferDst, NResourceState::kShaderRead);
+
+    vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
+    vkFreeMemory(mDevice, stagingBufferMemory, nullptr);
+}
+
+void NvkContext::generateLevels(VkImage image, uint32_t width, uint32_t height, uint32_t levelCount) const {
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    // The levels past the first have no contents yet, their layout is discarded
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.subresourceRange.baseMipLevel = 1;
+    barrier.subresourceRange.levelCount = levelCount - 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &barrier);
+
+    barrier.subresourceRange.levelCount = 1;
+    for (uint32_t level = 1; level < levelCount; level++) {
+        // The previous level becomes the source, the first one comes from kShaderRead
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.srcAccessMask = level == 1 ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout =
+                level == 1 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer,
+                             level == 1 ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkImageBlit blit{};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+        blit.srcOffsets[1] = {static_cast<int32_t>(std::max(width >> (level - 1), 1u)),
+                              static_cast<int32_t>(std::max(height >> (level - 1), 1u)), 1};
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        blit.dstOffsets[1] = {static_cast<int32_t>(std::max(width >> level, 1u)),
+                              static_cast<int32_t>(std::max(height >> level, 1u)), 1};
+        vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+    }
+    barrier.subresourceRange.baseMipLevel = levelCount - 1;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &barrier);
+
+    endSingleTimeCommands(commandBuffer);
+}
+
+void NvkContext::transitionImageLayout(VkImage image, VkFormat format, NResourceState before,
+                                       NResourceState after) const {
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    VkImageMemoryBarrier barrier = nvkImageBarrier(image, format, before, after);
+    vkCmdPipelineBarrier(commandBuffer, nvkResourceState(before).stage, nvkResourceState(after).stage, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+
+    endSingleTimeCommands(commandBuffer);
+}
+
+void NvkContext::copyBufferToImage(VkBuffer buffer, VkImage image, VkFormat format, uint32_t width, uint32_t height,
+                                   uint32_t levelCount) const {
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    std::vector<VkBufferImageCopy> regions(levelCount);
+    VkDeviceSize offset = 0;
+    for (uint32_t level = 0; level < levelCount; level++) {
+        uint32_t levelWidth = std::max(width >> level, 1u);
+        uint32_t levelHeight = std::max(height >> level, 1u);
+        VkBufferImageCopy& region = regions[level];
+        region.bufferOffset = offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {levelWidth, levelHeight, 1};
+        offset += nvkImageLevelSize(format, levelWidth, levelHeight);
+    }
+    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levelCount,
+                           regions.data());
+
+    endSingleTimeCommands(commandBuffer);
+}
+
+VkShaderModule NvkContext::createShaderModule(const char* code, size_t size) const {
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = size;
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(code);
+    VkShaderModule result;
+    NVK_CHECK(vkCreateShaderModule(mDevice, &createInfo, nullptr, &result));
+    return result;
+}
+
+VkDescriptorSet NvkContext::allocateImageDescriptorSet(VkDescriptorPool pool, VkDescriptorSetLayout layout,
+                                                       VkImageView view, VkSampler sampler) const {
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    VkDescriptorSet result;
+    NVK_CHECK(vkAllocateDescriptorSets(mDevice, &allocInfo, &result));
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = view;
+    imageInfo.sampler = sampler;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = result;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+
+    return result;
+}
+
+VkCommandBuffer NvkContext::beginSingleTimeCommands() const {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = mCommandPool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    NVK_CHECK(vkAllocateCommandBuffers(mDevice, &allocInfo, &commandBuffer));
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    NVK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+    return commandBuffer;
+}
+
+void NvkContext::endSingleTimeCommands(VkCommandBuffer commandBuffer) const {
+    NVK_CHECK(vkEndCommandBuffer(commandBuffer));
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    NVK_CHECK(vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+    NVK_CHECK(vkQueueWaitIdle(mGraphicsQueue));
+
+    vkFreeCommandBuffers(mDevice, mCommandPool, 1, &commandBuffer);
+}
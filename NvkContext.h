@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "nrender.h"
+#include "nvkvk.h"
+
+// Device-level helpers shared by the Vulkan layers: memory type lookup, buffer/image creation and one-shot uploads
+// through the graphics queue.
+class NvkContext {
+public:
+    NvkContext(VkPhysicalDevice physicalDevice, VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool);
+    NvkContext(const NvkContext&) = delete;
+    NvkContext& operator=(const NvkContext&) = delete;
+    NvkContext(NvkContext&&) = delete;
+    NvkContext& operator=(NvkContext&&) = delete;
+    ~NvkContext();
+
+    VkPhysicalDevice physicalDevice() const;
+    VkDevice device() const;
+
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags propertyFlags) const;
+
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryPropertyFlags,
+                      VkBuffer& buffer, VkDeviceMemory& bufferMemory) const;
+    void uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer) const;
+    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const;
+
+    void createImage(uint32_t width, uint32_t height, uint32_t levelCount, VkFormat format, VkImageTiling tiling,
+                     VkImageUsageFlags usage, VkMemoryPropertyFlags memoryPropertyFlags, VkImage& image,
+                     VkDeviceMemory& imageMemory) const;
+    // Without memory, bound by the caller
+    VkImage createImage(uint32_t width, uint32_t height, uint32_t levelCount, VkFormat format, VkImageTiling tiling,
+                        VkImageUsageFlags usage) const;
+    // Of every level
+    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) const;
+    // pixels has the levels one after the other, see nvkImageLevelSize()
+    void uploadImage(const void* pixels, VkDeviceSize size, VkImage image, VkFormat format, uint32_t width,
+                     uint32_t height, uint32_t levelCount) const;
+    // Blits each level from the previous one, in kShaderRead like the first level is
+    void generateLevels(VkImage image, uint32_t width, uint32_t height, uint32_t levelCount) const;
+    void transitionImageLayout(VkImage image, VkFormat format, NResourceState before, NResourceState after) const;
+    void copyBufferToImage(VkBuffer buffer, VkImage image, VkFormat format, uint32_t width, uint32_t height,
+                           uint32_t levelCount) const;
+
+    // SPIR-V, code is 4-byte aligned
+    VkShaderModule createShaderModule(const char* code, size_t size) const;
+
+    // Allocates a set with a single combined image sampler at binding 0
+    VkDescriptorSet allocateImageDescriptorSet(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkImageView view,
+                                               VkSampler sampler) const;
+
+    VkCommandBuffer beginSingleTimeCommands() const;
+    void endSingleTimeCommands(VkCommandBuffer commandBuffer) const;
+
+private:
+    const VkPhysicalDevice mPhysicalDevice;
+    const VkDevice mDevice;
+    const VkQueue mGraphicsQueue;
+    const VkCommandPool mCommandPool;
+};
@@ -0,0 +1,59 @@
+#include "NvkTexture.h"
+
+#include "ngllog.h"
+#include "nvkerr.h"
+#include "nvkstate.h"
+
+NvkTexture::NvkTexture(const NvkContext& context, const void* pixels, VkDeviceSize size, uint32_t width,
+                       uint32_t height, uint32_t levelCount, bool generatesLevels, VkFormat format, const char* label)
+    : mContext(context), mFormat(format) {
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (generatesLevels) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    mContext.createImage(width, height, levelCount, format, VK_IMAGE_TILING_OPTIMAL, usage,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mImage, mMemory);
+    mContext.uploadImage(pixels, size, mImage, format, width, height, generatesLevels ? 1 : levelCount);
+    if (generatesLevels) {
+        mContext.generateLevels(mImage, width, height, levelCount);
+    }
+    mView = mContext.createImageView(mImage, format, VK_IMAGE_ASPECT_COLOR_BIT);
+    NGL_LOGI("Texture %s loaded, width: %u, height: %u, levels: %u, %llu bytes", label, width, height, levelCount,
+             static_cast<unsigned long long>(size));
+}
+
+NvkTexture::NvkTexture(const NvkContext& context, uint32_t width, uint32_t height, VkFormat format,
+                       VkImageUsageFlags usage, VkDeviceMemory memory, VkDeviceSize offset, const char* label)
+    : mContext(context), mFormat(format) {
+    if (memory == VK_NULL_HANDLE) {
+        mContext.createImage(width, height, 1, format, VK_IMAGE_TILING_OPTIMAL, usage,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mImage, mMemory);
+    } else {
+        mImage = mContext.createImage(width, height, 1, format, VK_IMAGE_TILING_OPTIMAL, usage);
+        NVK_CHECK(vkBindImageMemory(mContext.device(), mImage, memory, offset));
+    }
+    // Views of depth formats are sampled and attached through the depth aspect only
+    mView = mContext.createImageView(mImage, format,
+                                     nvkIsDepthFormat(format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT);
+    NGL_LOGI("Render target %s created, width: %u, height: %u", label, width, height);
+}
+
+NvkTexture::~NvkTexture() {
+    vkDestroyImageView(mContext.device(), mView, nullptr);
+    vkDestroyImage(mContext.device(), mImage, nullptr);
+    if (mMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(mContext.device(), mMemory, nullptr);
+    }
+}
+
+VkImage NvkTexture::image() const {
+    return mImage;
+}
+
+VkImageView NvkTexture::view() const {
+    return mView;
+}
+
+VkFormat NvkTexture::format() const {
+    return mFormat;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "NvkContext.h"
+
+// Device-local 2D image with its view, either sampled texture contents or a render target
+class NvkTexture {
+public:
+    // pixels are tightly packed rows of the given format, or blocks for block compressed formats, followed by the
+    // smaller levels if levelCount is more than 1. With generatesLevels, pixels has the first level only and the
+    // others are blitted from it, the format must support linear blits.
+    NvkTexture(const NvkContext& context, const void* pixels, VkDeviceSize size, uint32_t width, uint32_t height,
+               uint32_t levelCount, bool generatesLevels, VkFormat format, const char* label);
+    // Render target without contents, placed at offset in memory or in memory of its own if memory is VK_NULL_HANDLE
+    NvkTexture(const NvkContext& context, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage,
+               VkDeviceMemory memory, VkDeviceSize offset, const char* label);
+    NvkTexture(const NvkTexture&) = delete;
+    NvkTexture& operator=(const NvkTexture&) = delete;
+    NvkTexture(NvkTexture&&) = delete;
+    NvkTexture& operator=(NvkTexture&&) = delete;
+    ~NvkTexture();
+
+    VkImage image() const;
+    VkImageView view() const;
+    VkFormat format() const;
+
+private:
+    const NvkContext& mContext;
+    const VkFormat mFormat;
+    VkImage mImage;
+    VkDeviceMemory mMemory = VK_NULL_HANDLE;  // owned
+    VkImageView mView;
+};
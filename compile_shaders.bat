@@ -2,5 +2,7 @@ IF NOT EXIST "out\" MKDIR "out"
 
 glslc -fshader-stage=vertex vertex.glsl -o out\vertex.spv || exit /b %errorlevel%
 glslc -fshader-stage=fragment fragment.glsl -o out\fragment.spv || exit /b %errorlevel%
+glslc -fshader-stage=vertex -DSHADOW_PASS vertex.glsl -o out\shadow_vertex.spv || exit /b %errorlevel%
+glslc -fshader-stage=vertex -DDEPTH_PASS vertex.glsl -o out\depth_vertex.spv || exit /b %errorlevel%
 
 ECHO Compiling shaders... DONE
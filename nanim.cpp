@@ -0,0 +1,135 @@
+#include "nanim.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "nglassert.h"
+
+template <typename T>
+static T sampleKeys(const NKeys<T>& keys, float phase);
+static glm::vec3 interpolate(const glm::vec3& a, const glm::vec3& b, float t);
+static glm::quat interpolate(const glm::quat& a, const glm::quat& b, float t);
+
+std::vector<NJointPose> nSampleClip(const NSkeleton& skeleton, const NAnimationClip& clip, float phase) {
+    std::vector<NJointPose> poses;
+    poses.reserve(skeleton.joints.size());
+    for (const NJoint& joint : skeleton.joints) {
+        poses.push_back(joint.restPose);
+    }
+    for (const NJointTrack& track : clip.tracks) {
+        NGL_ASSERT(track.joint >= 0 && track.joint < static_cast<int>(poses.size()));
+        NJointPose& pose = poses[track.joint];
+        if (!track.translations.times.empty()) {
+            pose.translation = sampleKeys(track.translations, phase);
+        }
+        if (!track.rotations.times.empty()) {
+            pose.rotation = sampleKeys(track.rotations, phase);
+        }
+        if (!track.scales.times.empty()) {
+            pose.scale = sampleKeys(track.scales, phase);
+        }
+    }
+    return poses;
+}
+
+std::vector<glm::mat4> nSkinningMatrices(const NSkeleton& skeleton, const std::vector<NJointPose>& poses) {
+    NGL_ASSERT(poses.size() == skeleton.joints.size());
+    std::vector<glm::mat4> globals(poses.size());
+    std::vector<glm::mat4> matrices(poses.size());
+    for (size_t j = 0; j < poses.size(); j++) {
+        const NJoint& joint = skeleton.joints[j];
+        const NJointPose& pose = poses[j];
+        NGL_ASSERT(joint.parent < static_cast<int>(j));
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), pose.translation) * glm::mat4_cast(pose.rotation) *
+                          glm::scale(glm::mat4(1.0f), pose.scale);
+        globals[j] = (joint.parent < 0 ? skeleton.rootTransform : globals[joint.parent]) * local;
+        matrices[j] = globals[j] * joint.inverseBind;
+    }
+    return matrices;
+}
+
+NAnimationTexture nBakeAnimations(const NSkeleton& skeleton, const std::vector<NAnimationClip>& clips) {
+    NGL_ASSERT(!skeleton.joints.empty());
+    NGL_ASSERT(clips.size() == static_cast<size_t>(NAnimation::kCount));
+    NAnimationTexture texture;
+    texture.width = static_cast<int>(skeleton.joints.size()) * 3;
+    texture.height = static_cast<int>(clips.size() * kNAnimationFrameCount);
+    texture.texels.reserve(static_cast<size_t>(texture.width) * texture.height * 4);
+    for (const NAnimationClip& clip : clips) {
+        for (uint32_t frame = 0; frame < kNAnimationFrameCount; frame++) {
+            float phase = static_cast<float>(frame) / kNAnimationFrameCount;
+            for (const glm::mat4& matrix : nSkinningMatrices(skeleton, nSampleClip(skeleton, clip, phase))) {
+                // The last row of an affine matrix is always (0, 0, 0, 1)
+                for (int row = 0; row < 3; row++) {
+                    for (int column = 0; column < 4; column++) {
+                        texture.texels.push_back(matrix[column][row]);
+                    }
+                }
+            }
+        }
+    }
+    return texture;
+}
+
+NAnimationTexture nBakeSkins(const std::vector<NVertexSkin>& skins) {
+    size_t texelCount = skins.size() * 2;
+    NAnimationTexture texture;
+    texture.width = kNSkinTextureWidth;
+    texture.height = static_cast<int>(std::max<size_t>((texelCount + kNSkinTextureWidth - 1) / kNSkinTextureWidth, 1));
+    texture.texels.assign(static_cast<size_t>(texture.width) * texture.height * 4, 0.0f);
+    for (size_t i = 0; i < skins.size(); i++) {
+        float* texels = &texture.texels[i * 8];
+        for (int k = 0; k < kNJointInfluenceCount; k++) {
+            texels[k] = static_cast<float>(skins[i].joints[k]);
+            texels[4 + k] = skins[i].weights[k];
+        }
+    }
+    return texture;
+}
+
+void nAnimatedBounds(const NSkeleton& skeleton, const std::vector<NAnimationClip>& clips,
+                     const std::vector<glm::vec3>& positions, const std::vector<NVertexSkin>& skins,
+                     glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    NGL_ASSERT(positions.size() == skins.size());
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (const NAnimationClip& clip : clips) {
+        for (uint32_t frame = 0; frame < kNAnimationFrameCount; frame++) {
+            float phase = static_cast<float>(frame) / kNAnimationFrameCount;
+            std::vector<glm::mat4> matrices = nSkinningMatrices(skeleton, nSampleClip(skeleton, clip, phase));
+            for (size_t v = 0; v < positions.size(); v++) {
+                glm::vec3 position(0.0f);
+                for (int k = 0; k < kNJointInfluenceCount && skins[v].weights[k] > 0.0f; k++) {
+                    position += skins[v].weights[k] *
+                                glm::vec3(matrices[skins[v].joints[k]] * glm::vec4(positions[v], 1.0f));
+                }
+                boundsMin = glm::min(boundsMin, position);
+                boundsMax = glm::max(boundsMax, position);
+            }
+        }
+    }
+}
+
+template <typename T>
+T sampleKeys(const NKeys<T>& keys, float phase) {
+    NGL_ASSERT(!keys.times.empty() && keys.times.size() == keys.values.size());
+    // Between the last key at or before phase and the one after it, wrapping around the end of the clip
+    size_t next = std::upper_bound(keys.times.begin(), keys.times.end(), phase) - keys.times.begin();
+    size_t previous = next == 0 ? keys.times.size() - 1 : next - 1;
+    if (next == keys.times.size()) {
+        next = 0;
+    }
+    float start = keys.times[previous];
+    float span = keys.times[next] - start + (next <= previous ? 1.0f : 0.0f);
+    float offset = phase - start + (phase < start ? 1.0f : 0.0f);
+    float t = span > 0.0f ? std::min(offset / span, 1.0f) : 0.0f;
+    return interpolate(keys.values[previous], keys.values[next], t);
+}
+
+glm::vec3 interpolate(const glm::vec3& a, const glm::vec3& b, float t) {
+    return glm::mix(a, b, t);
+}
+
+glm::quat interpolate(const glm::quat& a, const glm::quat& b, float t) {
+    return glm::slerp(a, b, t);
+}
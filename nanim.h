@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/ext.hpp>
+#include <glm/glm.hpp>
+
+#include "nrender.h"
+
+// Skeletal animation baked into textures for crowds. Every soldier plays one of a few looping clips, so rather than
+// skinning matrices per instance, the vertex shaders fetch them from the frame of the clip the instance is at in an
+// animation texture (nBakeAnimations()), and the joints and weights of each vertex from a skin texture
+// (nBakeSkins()). Both are kRgba32F and fetched without filtering.
+
+constexpr int kNJointInfluenceCount = 4;  // per vertex
+constexpr int kNSkinTextureWidth = 1024;  // must match skin_texture_width in the vertex shaders, even
+
+// Transform of a joint relative to its parent
+struct NJointPose {
+    glm::vec3 translation = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+struct NJoint {
+    std::string name;
+    int parent;             // an earlier joint, -1 for a root
+    NJointPose restPose;    // where no track moves it
+    glm::mat4 inverseBind;  // model space to the joint's space in the bind pose
+};
+
+// Joints ordered parents first
+struct NSkeleton {
+    std::vector<NJoint> joints;
+    glm::mat4 rootTransform = glm::mat4(1.0f);  // the roots' parent space to model space
+};
+
+// Keys of one channel, times from 0 to 1 over the clip in ascending order. Interpolated linearly, wrapping around
+// from the last key to the first.
+template <typename T>
+struct NKeys {
+    std::vector<float> times;
+    std::vector<T> values;
+};
+
+struct NJointTrack {
+    int joint;
+    NKeys<glm::vec3> translations;
+    NKeys<glm::quat> rotations;
+    NKeys<glm::vec3> scales;
+};
+
+// Looping clip, joints without a track or a channel keep their rest pose
+struct NAnimationClip {
+    std::string name;
+    std::vector<NJointTrack> tracks;
+};
+
+// Joints moving a vertex, largest weight first. The weights add up to 1, unused influences weigh 0.
+struct NVertexSkin {
+    int joints[kNJointInfluenceCount] = {};
+    float weights[kNJointInfluenceCount] = {1.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// kRgba32F texture contents, 4 floats per texel, rows top to bottom
+struct NAnimationTexture {
+    int width = 0;
+    int height = 0;
+    std::vector<float> texels;
+};
+
+// Pose of every joint at phase (0 to 1) of the clip
+std::vector<NJointPose> nSampleClip(const NSkeleton& skeleton, const NAnimationClip& clip, float phase);
+// Skinning matrix of every joint in the given poses, from model space in the bind pose to model space
+std::vector<glm::mat4> nSkinningMatrices(const NSkeleton& skeleton, const std::vector<NJointPose>& poses);
+
+// Row clip * kNAnimationFrameCount + frame holds the skinning matrices at phase frame / kNAnimationFrameCount, joint
+// j in texels 3j to 3j + 2 as the rows of its 3x4 affine matrix. clips are in NAnimation order.
+NAnimationTexture nBakeAnimations(const NSkeleton& skeleton, const std::vector<NAnimationClip>& clips);
+// Two texels per vertex from texel 2 * vertex on, kNSkinTextureWidth texels per row: the joints, then the weights
+NAnimationTexture nBakeSkins(const std::vector<NVertexSkin>& skins);
+// Bounds of the skinned positions over every baked frame of the clips
+void nAnimatedBounds(const NSkeleton& skeleton, const std::vector<NAnimationClip>& clips,
+                     const std::vector<glm::vec3>& positions, const std::vector<NVertexSkin>& skins,
+                     glm::vec3& boundsMin, glm::vec3& boundsMax);
@@ -0,0 +1,332 @@
+#include "nbcn.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "ngllog.h"
+
+constexpr int kTexelCount = 16;
+constexpr int kPowerIterationCount = 8;
+// Interpolation weights of BC7's 4-bit indices, out of 64
+constexpr int kBc7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+template <int N>
+static void fitEndpoints(const float points[kTexelCount][N], float start[N], float end[N]);
+static uint16_t packRgb565(const float color[3]);
+static void unpackRgb565(uint16_t packed, int color[3]);
+static void encodeColorBlock(const unsigned char texels[64], unsigned char block[8]);
+static void encodeChannelBlock(const unsigned char texels[64], int channel, unsigned char block[8]);
+static void putBits(unsigned char* block, int& position, uint32_t value, int count);
+
+void nEncodeBc1(const unsigned char texels[64], unsigned char block[8]) {
+    encodeColorBlock(texels, block);
+}
+
+void nEncodeBc3(const unsigned char texels[64], unsigned char block[16]) {
+    encodeChannelBlock(texels, 3, block);
+    encodeColorBlock(texels, block + 8);
+}
+
+void nEncodeBc5(const unsigned char texels[64], unsigned char block[16]) {
+    encodeChannelBlock(texels, 0, block);
+    encodeChannelBlock(texels, 1, block + 8);
+}
+
+void nEncodeBc7(const unsigned char texels[64], unsigned char block[16]) {
+    // Mode 6: a single subset, 7-bit RGBA endpoints with a p-bit each, 4-bit indices
+    float points[kTexelCount][4];
+    for (int i = 0; i < kTexelCount; i++) {
+        for (int c = 0; c < 4; c++) {
+            points[i][c] = texels[i * 4 + c];
+        }
+    }
+    float endpoints[2][4];
+    fitEndpoints<4>(points, endpoints[0], endpoints[1]);
+
+    // The p-bit is the lowest bit of all four channels, pick the one closer to the endpoint
+    int quantized[2][4];
+    int pBits[2];
+    for (int e = 0; e < 2; e++) {
+        float bestError = INFINITY;
+        for (int p = 0; p < 2; p++) {
+            int candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                candidate[c] = std::clamp(static_cast<int>(std::lround((endpoints[e][c] - p) / 2.0f)), 0, 127);
+                float difference = static_cast<float>((candidate[c] << 1) | p) - endpoints[e][c];
+                error += difference * difference;
+            }
+            if (error < bestError) {
+                bestError = error;
+                pBits[e] = p;
+                std::copy(candidate, candidate + 4, quantized[e]);
+            }
+        }
+    }
+
+    int palette[16][4];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 4; c++) {
+            int v0 = (quantized[0][c] << 1) | pBits[0];
+            int v1 = (quantized[1][c] << 1) | pBits[1];
+            palette[i][c] = ((64 - kBc7Weights[i]) * v0 + kBc7Weights[i] * v1 + 32) >> 6;
+        }
+    }
+    int indices[kTexelCount];
+    for (int i = 0; i < kTexelCount; i++) {
+        int bestError = INT32_MAX;
+        for (int j = 0; j < 16; j++) {
+            int error = 0;
+            for (int c = 0; c < 4; c++) {
+                int difference = palette[j][c] - texels[i * 4 + c];
+                error += difference * difference;
+            }
+            if (error < bestError) {
+                bestError = error;
+                indices[i] = j;
+            }
+        }
+    }
+    // The first index is stored without its top bit, which must be 0
+    if (indices[0] >= 8) {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(pBits[0], pBits[1]);
+        for (int& index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    memset(block, 0, 16);
+    int position = 0;
+    putBits(block, position, 1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        putBits(block, position, quantized[0][c], 7);
+        putBits(block, position, quantized[1][c], 7);
+    }
+    putBits(block, position, pBits[0], 1);
+    putBits(block, position, pBits[1], 1);
+    putBits(block, position, indices[0], 3);
+    for (int i = 1; i < kTexelCount; i++) {
+        putBits(block, position, indices[i], 4);
+    }
+}
+
+std::vector<unsigned char> nEncodeBlocks(NTextureFormat format, const unsigned char* pixels, int width, int height) {
+    std::vector<unsigned char> result(nTextureLevelSize(format, width, height));
+    size_t blockSize = nTextureLevelSize(format, 4, 4);
+    unsigned char* block = result.data();
+    for (int blockY = 0; blockY < height; blockY += 4) {
+        for (int blockX = 0; blockX < width; blockX += 4) {
+            unsigned char texels[64];
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    size_t pixel = static_cast<size_t>(std::min(blockY + y, height - 1)) * width +
+                                   std::min(blockX + x, width - 1);
+                    memcpy(texels + (y * 4 + x) * 4, pixels + pixel * 4, 4);
+                }
+            }
+            switch (format) {
+                case NTextureFormat::kBc1:
+                    nEncodeBc1(texels, block);
+                    break;
+                case NTextureFormat::kBc3:
+                    nEncodeBc3(texels, block);
+                    break;
+                case NTextureFormat::kBc5:
+                    nEncodeBc5(texels, block);
+                    break;
+                case NTextureFormat::kBc7:
+                    nEncodeBc7(texels, block);
+                    break;
+                default:
+                    NGL_ABORT("Format %d is not block compressed", static_cast<int>(format));
+            }
+            block += blockSize;
+        }
+    }
+    return result;
+}
+
+template <int N>
+void fitEndpoints(const float points[kTexelCount][N], float start[N], float end[N]) {
+    float mean[N] = {};
+    for (int i = 0; i < kTexelCount; i++) {
+        for (int c = 0; c < N; c++) {
+            mean[c] += points[i][c] / kTexelCount;
+        }
+    }
+    float covariance[N][N] = {};
+    for (int i = 0; i < kTexelCount; i++) {
+        for (int a = 0; a < N; a++) {
+            for (int b = 0; b < N; b++) {
+                covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // Principal axis by power iteration, starting from the diagonal of the bounding box
+    float axis[N];
+    for (int c = 0; c < N; c++) {
+        float low = INFINITY;
+        float high = -INFINITY;
+        for (int i = 0; i < kTexelCount; i++) {
+            low = std::min(low, points[i][c]);
+            high = std::max(high, points[i][c]);
+        }
+        axis[c] = high - low;
+    }
+    for (int iteration = 0; iteration < kPowerIterationCount; iteration++) {
+        float next[N] = {};
+        float length = 0.0f;
+        for (int a = 0; a < N; a++) {
+            for (int b = 0; b < N; b++) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length = std::max(length, std::abs(next[a]));
+        }
+        if (length == 0.0f) {
+            break;
+        }
+        for (int c = 0; c < N; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float lengthSquared = 0.0f;
+    for (int c = 0; c < N; c++) {
+        lengthSquared += axis[c] * axis[c];
+    }
+    float low = 0.0f;
+    float high = 0.0f;
+    if (lengthSquared > 0.0f) {
+        for (int i = 0; i < kTexelCount; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < N; c++) {
+                t += (points[i][c] - mean[c]) * axis[c];
+            }
+            t /= lengthSquared;
+            low = std::min(low, t);
+            high = std::max(high, t);
+        }
+    }
+    for (int c = 0; c < N; c++) {
+        start[c] = std::clamp(mean[c] + low * axis[c], 0.0f, 255.0f);
+        end[c] = std::clamp(mean[c] + high * axis[c], 0.0f, 255.0f);
+    }
+}
+
+uint16_t packRgb565(const float color[3]) {
+    int r = static_cast<int>(std::lround(color[0] * 31.0f / 255.0f));
+    int g = static_cast<int>(std::lround(color[1] * 63.0f / 255.0f));
+    int b = static_cast<int>(std::lround(color[2] * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpackRgb565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void encodeColorBlock(const unsigned char texels[64], unsigned char block[8]) {
+    // Always the four color mode, the only one BC3 has
+    float points[kTexelCount][3];
+    for (int i = 0; i < kTexelCount; i++) {
+        for (int c = 0; c < 3; c++) {
+            points[i][c] = texels[i * 4 + c];
+        }
+    }
+    float start[3];
+    float end[3];
+    fitEndpoints<3>(points, start, end);
+    uint16_t color0 = packRgb565(end);
+    uint16_t color1 = packRgb565(start);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < kTexelCount; i++) {
+            int bestError = INT32_MAX;
+            uint32_t bestIndex = 0;
+            for (uint32_t j = 0; j < 4; j++) {
+                int error = 0;
+                for (int c = 0; c < 3; c++) {
+                    int difference = palette[j][c] - texels[i * 4 + c];
+                    error += difference * difference;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    bestIndex = j;
+                }
+            }
+            indices |= bestIndex << (2 * i);
+        }
+    }
+
+    block[0] = static_cast<unsigned char>(color0 & 0xFF);
+    block[1] = static_cast<unsigned char>(color0 >> 8);
+    block[2] = static_cast<unsigned char>(color1 & 0xFF);
+    block[3] = static_cast<unsigned char>(color1 >> 8);
+    for (int i = 0; i < 4; i++) {
+        block[4 + i] = static_cast<unsigned char>(indices >> (8 * i));
+    }
+}
+
+void encodeChannelBlock(const unsigned char texels[64], int channel, unsigned char block[8]) {
+    // The eight value mode, from the largest value down to the smallest
+    int low = 255;
+    int high = 0;
+    for (int i = 0; i < kTexelCount; i++) {
+        low = std::min(low, static_cast<int>(texels[i * 4 + channel]));
+        high = std::max(high, static_cast<int>(texels[i * 4 + channel]));
+    }
+    int palette[8] = {high, low};
+    for (int i = 2; i < 8; i++) {
+        palette[i] = ((8 - i) * high + (i - 1) * low + 3) / 7;
+    }
+
+    uint64_t indices = 0;
+    if (high != low) {
+        for (int i = 0; i < kTexelCount; i++) {
+            int bestError = INT32_MAX;
+            uint64_t bestIndex = 0;
+            for (uint64_t j = 0; j < 8; j++) {
+                int error = std::abs(palette[j] - texels[i * 4 + channel]);
+                if (error < bestError) {
+                    bestError = error;
+                    bestIndex = j;
+                }
+            }
+            indices |= bestIndex << (3 * i);
+        }
+    }
+
+    block[0] = static_cast<unsigned char>(high);
+    block[1] = static_cast<unsigned char>(low);
+    for (int i = 0; i < 6; i++) {
+        block[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+    }
+}
+
+void putBits(unsigned char* block, int& position, uint32_t value, int count) {
+    // Least significant bit first
+    for (int i = 0; i < count; i++, position++) {
+        if ((value >> i) & 1) {
+            block[position / 8] |= static_cast<unsigned char>(1 << (position % 8));
+        }
+    }
+}
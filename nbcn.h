@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+#include "nrender.h"
+
+// BCn block compression for nwar-texc. A block is 4x4 texels of 8-bit RGBA, rows top to bottom. The endpoints of a
+// block are fit along the principal axis of its texels, which is fast and does well on the mostly smooth textures
+// nwar has. There is no search over modes or partitions like production encoders do, BC7 blocks are always mode 6.
+
+void nEncodeBc1(const unsigned char texels[64], unsigned char block[8]);   // color, alpha is ignored
+void nEncodeBc3(const unsigned char texels[64], unsigned char block[16]);  // color and alpha
+void nEncodeBc5(const unsigned char texels[64], unsigned char block[16]);  // red and green
+void nEncodeBc7(const unsigned char texels[64], unsigned char block[16]);  // color and alpha
+
+// Blocks of a whole level, left to right and top to bottom. Blocks past the right or bottom edge repeat the last
+// column or row.
+std::vector<unsigned char> nEncodeBlocks(NTextureFormat format, const unsigned char* pixels, int width, int height);
@@ -0,0 +1,128 @@
+#include "nbench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#include "ngllog.h"
+
+NBenchResult nBenchRun(const std::string& name, int sampleCount, const std::function<void()>& fn) {
+    return nBenchRun(name, sampleCount, [] {}, fn);
+}
+
+NBenchResult nBenchRun(const std::string& name, int sampleCount, const std::function<void()>& setup,
+                       const std::function<void()>& fn) {
+    using Clock = std::chrono::steady_clock;
+    NBenchResult result;
+    result.name = name;
+    setup();
+    fn();
+    for (int i = 0; i < sampleCount; i++) {
+        setup();
+        Clock::time_point startTime = Clock::now();
+        fn();
+        result.samples.push_back(std::chrono::duration<double>(Clock::now() - startTime).count());
+    }
+    NGL_LOGI("%s: median %0.3fms over %d samples", name.c_str(), nMedian(result.samples) * 1000.0, sampleCount);
+    return result;
+}
+
+bool nBenchWriteResults(const std::string& path, const std::vector<NBenchResult>& results) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+        return false;
+    }
+    file.precision(9);
+    for (const NBenchResult& result : results) {
+        file << result.name;
+        for (double sample : result.samples) {
+            file << ' ' << sample;
+        }
+        file << '\n';
+    }
+    NGL_LOGI("Results written to %s", path.c_str());
+    return file.good();
+}
+
+bool nBenchReadResults(const std::string& path, std::vector<NBenchResult>& results) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    results.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        NBenchResult result;
+        if (!(stream >> result.name)) {
+            continue;
+        }
+        double sample;
+        while (stream >> sample) {
+            result.samples.push_back(sample);
+        }
+        results.push_back(std::move(result));
+    }
+    return true;
+}
+
+double nMannWhitneyP(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.empty() || b.empty()) {
+        return 1.0;
+    }
+
+    // Ranks over both samples, ties get the average of their ranks
+    std::vector<std::pair<double, bool>> values;  // value, is from a
+    for (double value : a) {
+        values.push_back({value, true});
+    }
+    for (double value : b) {
+        values.push_back({value, false});
+    }
+    std::sort(values.begin(), values.end());
+    const double n = static_cast<double>(values.size());
+    double rankSumA = 0;
+    double tieTerm = 0;
+    for (size_t i = 0; i < values.size();) {
+        size_t j = i;
+        while (j < values.size() && values[j].first == values[i].first) {
+            j++;
+        }
+        double rank = (i + 1 + j) * 0.5;
+        for (size_t k = i; k < j; k++) {
+            if (values[k].second) {
+                rankSumA += rank;
+            }
+        }
+        double tieCount = static_cast<double>(j - i);
+        tieTerm += tieCount * tieCount * tieCount - tieCount;
+        i = j;
+    }
+
+    const double nA = static_cast<double>(a.size());
+    const double nB = static_cast<double>(b.size());
+    double u = rankSumA - nA * (nA + 1.0) * 0.5;
+    double mean = nA * nB * 0.5;
+    double variance = nA * nB / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+    if (variance <= 0) {
+        return 1.0;
+    }
+    // With continuity correction
+    double z = std::max(std::abs(u - mean) - 0.5, 0.0) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+double nMedian(const std::vector<double>& values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::vector<double> sortedValues = values;
+    std::sort(sortedValues.begin(), sortedValues.end());
+    size_t middle = sortedValues.size() / 2;
+    return sortedValues.size() % 2 == 1 ? sortedValues[middle]
+                                        : (sortedValues[middle - 1] + sortedValues[middle]) * 0.5;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Perf regression harness: repeated timings of each metric, stored in a results file and compared with a baseline
+// by the Mann-Whitney U test, which makes no assumption on how timings are distributed.
+
+// Repeated timings of one metric, in seconds
+struct NBenchResult {
+    std::string name;
+    std::vector<double> samples;
+};
+
+// Times sampleCount calls of fn, after a warmup call
+NBenchResult nBenchRun(const std::string& name, int sampleCount, const std::function<void()>& fn);
+// Same, with setup called before every call of fn and not timed, e.g. to restore the state fn changes
+NBenchResult nBenchRun(const std::string& name, int sampleCount, const std::function<void()>& setup,
+                       const std::function<void()>& fn);
+
+// Results file: a line per metric, its name then its samples. Return false if the file cannot be written or read.
+bool nBenchWriteResults(const std::string& path, const std::vector<NBenchResult>& results);
+bool nBenchReadResults(const std::string& path, std::vector<NBenchResult>& results);
+
+// Two-sided p-value of the Mann-Whitney U test that a and b come from the same distribution. Normal approximation
+// with tie correction, fine from about 10 samples each.
+double nMannWhitneyP(const std::vector<double>& a, const std::vector<double>& b);
+double nMedian(const std::vector<double>& values);
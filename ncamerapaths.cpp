@@ -0,0 +1,87 @@
+#include "ncamerapaths.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/ext.hpp>
+
+#include "nglarmy.h"
+
+using glm::vec2;
+using glm::vec3;
+
+constexpr double kKeyInterval = 0.25;  // seconds, for the paths following the army
+constexpr float kOverviewRadius = 7.0f;
+constexpr float kOverviewHeight = 6.0f;
+constexpr double kOverviewPeriod = 60.0;
+constexpr double kFlybyDuration = 40.0;
+constexpr float kFlybyHeight = 0.4f;  // above the highest ground under the camera
+constexpr int kFlybyLookAhead = 3;    // rows
+constexpr double kCloseupDuration = 20.0;
+constexpr float kCloseupRadius = 0.5f;
+constexpr float kCloseupHeight = 0.15f;
+constexpr float kLowAngleRadius = 5.0f;
+constexpr float kLowAngleHeight = 0.35f;
+constexpr double kLowAnglePeriod = 60.0;
+constexpr int kOrbitKeyCount = 64;
+
+static void addOrbit(NCameraPath& path, float radius, float height, double period, const vec3& target);
+static int middleUnitOfRow(int row);
+static float groundHeight(const NglTerrainGeometry& terrainGeometry, const vec2& xz, float radius);
+
+bool nCreateCameraPath(const std::string& name, const NglTerrainGeometry& terrainGeometry, NCameraPath& path) {
+    path = NCameraPath();
+    if (name == "overview") {
+        addOrbit(path, kOverviewRadius, kOverviewHeight, kOverviewPeriod, vec3(0.0f));
+    } else if (name == "flyby") {
+        // Rows are numbered from the head of the army
+        const int rowCount = kUnitCount.y * kRegimentCount;
+        const int keyCount = static_cast<int>(kFlybyDuration / kKeyInterval);
+        for (int i = 0; i <= keyCount; i++) {
+            double time = i * kKeyInterval;
+            float row = (rowCount - 1) * (1.0f - static_cast<float>(i) / keyCount);
+            int unit = middleUnitOfRow(static_cast<int>(row));
+            vec2 xz = nglUnitCenter(unit, static_cast<float>(time));
+            vec2 targetXz = nglUnitCenter(middleUnitOfRow(std::max(static_cast<int>(row) - kFlybyLookAhead, 0)),
+                                          static_cast<float>(time));
+            vec3 position(xz.x, groundHeight(terrainGeometry, xz, nglUnitRadius()) + kFlybyHeight, xz.y);
+            vec3 target(targetXz.x, groundHeight(terrainGeometry, targetXz, 0.0f), targetXz.y);
+            path.addKey(time, position, target);
+        }
+    } else if (name == "closeup") {
+        const int keyCount = static_cast<int>(kCloseupDuration / kKeyInterval);
+        for (int i = 0; i <= keyCount; i++) {
+            double time = i * kKeyInterval;
+            vec2 center = nglUnitCenter(middleUnitOfRow(0), static_cast<float>(time));
+            float angle = static_cast<float>(i) / keyCount * glm::pi<float>();
+            vec2 xz = center + kCloseupRadius * vec2(std::cos(angle), std::sin(angle));
+            float ground = groundHeight(terrainGeometry, center, kCloseupRadius);
+            path.addKey(time, vec3(xz.x, ground + kCloseupHeight, xz.y), vec3(center.x, ground, center.y));
+        }
+    } else if (name == "lowangle") {
+        addOrbit(path, kLowAngleRadius, kLowAngleHeight, kLowAnglePeriod, vec3(0.0f, kLowAngleHeight * 0.5f, 0.0f));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void addOrbit(NCameraPath& path, float radius, float height, double period, const vec3& target) {
+    for (int i = 0; i <= kOrbitKeyCount; i++) {
+        float angle = static_cast<float>(i) / kOrbitKeyCount * glm::two_pi<float>();
+        vec3 position(radius * std::cos(angle), height, radius * std::sin(angle));
+        path.addKey(period * i / kOrbitKeyCount, position, target);
+    }
+}
+
+int middleUnitOfRow(int row) {
+    // Units are numbered by regiment, then row, then column
+    const int regimentUnitCount = kUnitCount.x * kUnitCount.y;
+    return row / kUnitCount.y * regimentUnitCount + row % kUnitCount.y * kUnitCount.x + kUnitCount.x / 2;
+}
+
+float groundHeight(const NglTerrainGeometry& terrainGeometry, const vec2& xz, float radius) {
+    float minY, maxY;
+    terrainGeometry.heightRange(xz - vec2(radius), xz + vec2(radius), minY, maxY);
+    return maxY;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "NCameraPath.h"
+#include "NglTerrainGeometry.h"
+
+// Canonical camera paths for benchmark runs. The paths following the army expect the frame time to be the path time,
+// as in playback.
+//   overview  high orbit with the whole battlefield in view
+//   flyby     low flight over the army, from its rear to its head
+//   closeup   slow circle around the leading unit, a few soldiers fill the screen
+//   lowangle  orbit just above the hills, where they hide the most soldiers
+// Returns false if name is none of these.
+bool nCreateCameraPath(const std::string& name, const NglTerrainGeometry& terrainGeometry, NCameraPath& path);
@@ -1,8 +1,29 @@
 #include "nfile.h"
 
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <memory>
+#include <utility>
 
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "NAssetArchive.h"
 #include "nglassert.h"
+#include "ngllog.h"
+
+static bool mapLooseFile(const std::string& path, NFileAccess access, const char*& data, size_t& size);
+
+static std::unique_ptr<NAssetArchive> gArchive;
 
 std::vector<char> nReadFile(const std::string& path) {
     std::ifstream file(path, std::ios::ate | std::ios::binary);
@@ -13,3 +34,149 @@ std::vector<char> nReadFile(const std::string& path) {
     file.read(result.data(), size);
     return result;
 }
+
+NMappedFile::NMappedFile(NMappedFile&& other) noexcept
+    : mData(std::exchange(other.mData, nullptr)),
+      mSize(std::exchange(other.mSize, 0)),
+      mIsMapping(std::exchange(other.mIsMapping, false)),
+      mBuffer(std::move(other.mBuffer)) {}
+
+NMappedFile& NMappedFile::operator=(NMappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        mData = std::exchange(other.mData, nullptr);
+        mSize = std::exchange(other.mSize, 0);
+        mIsMapping = std::exchange(other.mIsMapping, false);
+        mBuffer = std::move(other.mBuffer);
+    }
+    return *this;
+}
+
+NMappedFile::~NMappedFile() {
+    unmap();
+}
+
+const char* NMappedFile::data() const {
+    return mData;
+}
+
+size_t NMappedFile::size() const {
+    return mSize;
+}
+
+void NMappedFile::unmap() {
+    if (mIsMapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+#else
+        munmap(const_cast<char*>(mData), mSize);
+#endif
+    }
+    mData = nullptr;
+    mSize = 0;
+    mIsMapping = false;
+    mBuffer = std::vector<char>();
+}
+
+NMappedFile nMapFile(const std::string& path, NFileAccess access) {
+    NMappedFile file;
+    if (!nTryMapFile(path, access, file)) {
+        NGL_ABORT("Cannot open %s", path.c_str());
+    }
+    return file;
+}
+
+bool nTryMapFile(const std::string& path, NFileAccess access, NMappedFile& file) {
+    file.unmap();
+    const NArchiveEntry* entry = gArchive ? gArchive->find(path) : nullptr;
+    if (entry == nullptr) {
+        if (!mapLooseFile(path, access, file.mData, file.mSize)) {
+            return false;
+        }
+        file.mIsMapping = file.mData != nullptr;
+        return true;
+    }
+
+    if (entry->compression == NArchiveCompression::kNone) {
+        file.mData = entry->size > 0 ? gArchive->data(*entry) : nullptr;
+        file.mSize = entry->size;
+        return true;
+    }
+    if (!gArchive->decompress(*entry, file.mBuffer)) {
+        NGL_ABORT("Cannot read %s from the asset archive", path.c_str());
+    }
+    file.mData = file.mBuffer.empty() ? nullptr : file.mBuffer.data();
+    file.mSize = file.mBuffer.size();
+    return true;
+}
+
+bool nMountArchive(const std::string& path) {
+    NGL_ASSERT(!gArchive);
+    auto archive = std::make_unique<NAssetArchive>();
+    if (!archive->open(path)) {
+        return false;
+    }
+    gArchive = std::move(archive);
+    return true;
+}
+
+#ifdef _WIN32
+
+bool mapLooseFile(const std::string& path, NFileAccess access, const char*& data, size_t& size) {
+    DWORD flags = access == NFileAccess::kSequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    NGL_VERIFY(GetFileSizeEx(file, &fileSize));
+
+    // Empty files cannot be mapped
+    data = nullptr;
+    size = 0;
+    if (fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        NGL_VERIFY(mapping != nullptr);
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        NGL_VERIFY(view != nullptr);
+        // The view keeps the file open
+        CloseHandle(mapping);
+        data = static_cast<const char*>(view);
+        size = static_cast<size_t>(fileSize.QuadPart);
+        if (access == NFileAccess::kWillNeed) {
+            WIN32_MEMORY_RANGE_ENTRY range = {view, size};
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+    }
+    CloseHandle(file);
+    return true;
+}
+
+#else
+
+bool mapLooseFile(const std::string& path, NFileAccess access, const char*& data, size_t& size) {
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status;
+    NGL_VERIFY(fstat(file, &status) == 0);
+
+    // Empty files cannot be mapped
+    data = nullptr;
+    size = 0;
+    if (status.st_size > 0) {
+        size = static_cast<size_t>(status.st_size);
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view == MAP_FAILED) {
+            NGL_ABORT("Cannot map %s: %s", path.c_str(), strerror(errno));
+        }
+        madvise(view, size, access == NFileAccess::kSequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+        data = static_cast<const char*>(view);
+    }
+    // The mapping keeps the file open
+    close(file);
+    return true;
+}
+
+#endif
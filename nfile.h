@@ -1,6 +1,49 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
 std::vector<char> nReadFile(const std::string& path);
+
+// How a mapped file is going to be read, a hint for the kernel's read-ahead
+enum class NFileAccess {
+    kSequential,  // once from start to end, e.g. decoding an image
+    kWillNeed,    // all of it soon, starts reading it in the background
+};
+
+// Read-only contents of a whole file, mapped into memory and unmapped when destroyed. Pages are read from the page
+// cache when first touched, nothing is copied. Files served by the mounted archive are a view into it, or a
+// decompressed copy for compressed entries.
+class NMappedFile {
+public:
+    NMappedFile() = default;
+    NMappedFile(const NMappedFile&) = delete;
+    NMappedFile& operator=(const NMappedFile&) = delete;
+    NMappedFile(NMappedFile&& other) noexcept;
+    NMappedFile& operator=(NMappedFile&& other) noexcept;
+    ~NMappedFile();
+
+    // Aligned to at least 16 bytes, nullptr if the file is empty
+    const char* data() const;
+    size_t size() const;
+
+private:
+    friend bool nTryMapFile(const std::string& path, NFileAccess access, NMappedFile& file);
+
+    void unmap();
+
+    const char* mData = nullptr;
+    size_t mSize = 0;
+    bool mIsMapping = false;    // else a view into the archive or into mBuffer
+    std::vector<char> mBuffer;  // decompressed archive entry
+};
+
+// Aborts if the file cannot be opened, like nReadFile()
+NMappedFile nMapFile(const std::string& path, NFileAccess access);
+// Returns false if the file cannot be opened
+bool nTryMapFile(const std::string& path, NFileAccess access, NMappedFile& file);
+
+// Serves nMapFile() from an asset archive (see NAssetArchive.h) for the files it has, from loose files for the others.
+// Call before loading anything, the archive stays mounted until exit. Returns false if there is no such archive.
+bool nMountArchive(const std::string& path);
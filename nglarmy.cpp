@@ -0,0 +1,427 @@
+#include "nglarmy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "NBattle.h"
+#include "nglassert.h"
+
+using glm::vec2;
+
+// The army marches along its route, regiment after regiment, and loops. The route is a cubic Bezier through kPath
+// until nglRouteArmy() finds one over the terrain.
+constexpr vec2 kPath[] = {kArmyStart, vec2(3.0f, -4.0f), vec2(-2.0f, 2.0f), kArmyDestination};
+constexpr int kPathSampleCount = 256;
+// Routes are resampled this far apart, after averaging this many points on either side to round their turns
+constexpr float kRouteSpacing = 0.05f;
+constexpr int kRouteSmoothing = 4;
+constexpr int kMaxRouteStepCount = 10000;
+constexpr vec2 kInUnitDistance = vec2(0.05f, 0.05f);
+constexpr vec2 kUnitPadding = vec2(0.12f, 0.12f);
+constexpr float kRegimentPadding = 0.2f;
+constexpr float kTwoStepPeriod = 1.0f;
+constexpr float kSwayPeriodsPerLoop = 50.0f;
+constexpr float kPi = 3.14159265f;
+// Soldiers sway around their place in the unit, and the rows of a unit follow the curve of the path, a guess at how far
+// that bends them
+constexpr float kRandomOffset = 1.0f / 300.0f;
+constexpr float kPathCurveSlack = 0.05f;
+
+// Evenly spaced points along the route, their directions along it, kRouteSpacing or slightly less apart
+struct ArmyRoute {
+    std::vector<vec2> points;
+    std::vector<vec2> directions;
+    float spacing;
+    float length;
+};
+
+// Derived from the constants above and the route
+struct ArmyMotion {
+    float len;
+    vec2 unitDistance;
+    float regimentDistance;
+    vec2 regimentSize;
+    float tSpeed;
+    float period;
+    float time0;
+};
+
+static ArmyRoute routeThrough(const std::vector<vec2>& points);
+static std::vector<vec2> pathPoints();
+static ArmyMotion motionAlong(const ArmyRoute& route);
+static float pathParameter(const ArmyMotion& motion, int unitIndex, float inUnitJ, float time);
+static float ortOffset(const ArmyMotion& motion, int unitIndex, float inUnitI);
+static vec2 interpolateAlongPath(float t, vec2& dxy);
+static float fract(float value);
+static bool crossCircle(vec2 origin, vec2 direction, vec2 center, float radius, float& enter, float& exit);
+static bool crossSlab(float origin, float direction, float bottom, float top, float& enter, float& exit);
+
+static ArmyRoute gRoute = routeThrough(pathPoints());
+static ArmyMotion gMotion = motionAlong(gRoute);
+
+void nglRouteArmy(NFlowFieldCache& flowFields) {
+    // Down the flow field from the start, straight on in the destination's cell where the field is flat
+    const NFlowField& field = flowFields.field(kArmyDestination);
+    std::vector<vec2> points = {kArmyStart};
+    while (glm::length(kArmyDestination - points.back()) > kRouteSpacing) {
+        if (points.size() == kMaxRouteStepCount) {
+            NGL_LOGE("No route to the destination after %d steps, the army keeps its path", kMaxRouteStepCount);
+            return;
+        }
+        vec2 direction = field.direction(points.back());
+        if (direction.x == 0.0f && direction.y == 0.0f) {
+            direction = glm::normalize(kArmyDestination - points.back());
+        }
+        points.push_back(points.back() + direction * kRouteSpacing);
+    }
+    points.push_back(kArmyDestination);
+    gRoute = routeThrough(points);
+    gMotion = motionAlong(gRoute);
+    NGL_LOGI("Army route: %0.2f long, %0.2f as the crow flies", gRoute.length,
+             glm::length(kArmyDestination - kArmyStart));
+}
+
+void nglUpdateInstances(float time, const NglTerrainGeometry& terrainGeometry, uint32_t animation,
+                        std::vector<NInstance>& instances) {
+    const ArmyMotion& motion = gMotion;
+    const float effectiveTime = motion.time0 + time;
+    const float swayPhase = fract(effectiveTime / (motion.period / kSwayPeriodsPerLoop));
+    instances.resize(kArmyInstanceCount);
+    for (int unit = 0; unit < kArmyUnitCount; unit++) {
+        // A row of a unit shares its point on the path
+        for (int inUnitJ = 0; inUnitJ < kUnitSize.y; inUnitJ++) {
+            vec2 dxz;
+            vec2 rowXz = interpolateAlongPath(pathParameter(motion, unit, static_cast<float>(inUnitJ), time), dxz);
+            vec2 pathDir = glm::normalize(dxz);
+            vec2 ortDir = vec2(pathDir.y, -pathDir.x);
+            for (int inUnitI = 0; inUnitI < kUnitSize.x; inUnitI++) {
+                int instanceIndex = unit * kUnitInstanceCount + inUnitJ * kUnitSize.x + inUnitI;
+                uint32_t randomNumber = static_cast<uint32_t>(instanceIndex) * 1103515245u + 12345u;
+
+                vec2 randomPhase = vec2(randomNumber & 1023, (randomNumber >> 10) & 1023) / 1024.0f;
+                vec2 effectivePhase = (vec2(swayPhase) + randomPhase) * (2.0f * kPi);
+                vec2 xz = rowXz + ortDir * ortOffset(motion, unit, static_cast<float>(inUnitI)) +
+                          glm::sin(effectivePhase) * kRandomOffset;
+
+                float randomStepPhase = ((randomNumber >> 5) & 1023) / 1024.0f;
+                float randomStepOffset = std::sin(randomStepPhase * 2.0f * kPi) * 0.25f;
+                float twoStepT = fract(effectiveTime / kTwoStepPeriod + randomStepOffset);
+                float stepT = fract(twoStepT * 2.0f);
+                float y = terrainGeometry.height(xz.x, xz.y) + std::sin(stepT * kPi) * kStepHeight;
+
+                NInstance& instance = instances[instanceIndex];
+                instance.position = glm::vec3(xz.x, y, xz.y);
+                instance.heightScale = (randomNumber & 63) / 63.0f * kMaxHeightScale;
+                instance.heading = pathDir;
+                instance.phase = twoStepT;
+                instance.animation = animation;
+            }
+        }
+    }
+}
+
+void nglSeparateSoldiers(const NglTerrainGeometry& terrainGeometry, NSpatialGrid& grid,
+                         std::vector<vec2>& groundPositions, std::vector<NInstance>& instances) {
+    groundPositions.resize(instances.size());
+    for (size_t i = 0; i < instances.size(); i++) {
+        groundPositions[i] = vec2(instances[i].position.x, instances[i].position.z);
+    }
+    grid.rebuild(groundPositions);
+
+    // Every push is computed from the positions before any soldier moved, so the order soldiers are visited in does
+    // not matter
+    std::vector<uint32_t> neighbors;
+    for (size_t i = 0; i < instances.size(); i++) {
+        const vec2 position = groundPositions[i];
+        neighbors.clear();
+        grid.queryRadius(position, kSeparationRadius, neighbors);
+        vec2 push(0.0f);
+        for (uint32_t neighbor : neighbors) {
+            if (neighbor == i) {
+                continue;
+            }
+            vec2 offset = position - groundPositions[neighbor];
+            float distance = glm::length(offset);
+            // Soldiers in the same place part along x
+            vec2 direction = distance > 0.0f ? offset / distance : vec2(neighbor > i ? -1.0f : 1.0f, 0.0f);
+            push += direction * ((kSeparationRadius - distance) * 0.5f);
+        }
+        if (push.x == 0.0f && push.y == 0.0f) {
+            continue;
+        }
+        // Keeps the lift of the step
+        NInstance& instance = instances[i];
+        float lift = instance.position.y - terrainGeometry.height(position.x, position.y);
+        vec2 moved = position + push;
+        instance.position = glm::vec3(moved.x, terrainGeometry.height(moved.x, moved.y) + lift, moved.y);
+    }
+}
+
+void nglInterpolateInstances(const std::vector<NInstance>& previous, const std::vector<NInstance>& current, float alpha,
+                             std::vector<NInstance>& instances) {
+    NGL_ASSERT(previous.size() == current.size());
+    instances.resize(current.size());
+    for (size_t i = 0; i < current.size(); i++) {
+        const NInstance& before = previous[i];
+        const NInstance& after = current[i];
+        NInstance& instance = instances[i];
+        instance.position = glm::mix(before.position, after.position, alpha);
+        instance.heightScale = after.heightScale;
+        // Soldiers turn little in a tick, renormalizing is enough
+        vec2 heading = glm::mix(before.heading, after.heading, alpha);
+        float headingLength = glm::length(heading);
+        instance.heading = headingLength > 0.0f ? heading / headingLength : after.heading;
+        // The shorter way around, phases wrap from 1 to 0
+        float phaseDelta = fract(after.phase - before.phase + 0.5f) - 0.5f;
+        instance.phase = fract(before.phase + phaseDelta * alpha);
+        instance.animation = after.animation;
+    }
+}
+
+uint32_t nglPickSoldier(const std::vector<NInstance>& instances, const std::vector<NArmyUnit>& units,
+                        float soldierRadius, float soldierHeight, const glm::vec3& origin, const glm::vec3& direction,
+                        float maxDistance, float& distance) {
+    const vec2 groundOrigin(origin.x, origin.z);
+    const vec2 groundDirection(direction.x, direction.z);
+    std::vector<std::pair<float, uint32_t>> crossedUnits;  // distance the ray enters them, unit
+    for (uint32_t i = 0; i < units.size(); i++) {
+        const NArmyUnit& unit = units[i];
+        float enter, exit;
+        if (crossCircle(groundOrigin, groundDirection, unit.center, unit.radius + soldierRadius, enter, exit) &&
+            crossSlab(origin.y, direction.y, unit.minHeight, unit.maxHeight + soldierHeight, enter, exit) &&
+            exit >= 0.0f && enter <= maxDistance) {
+            crossedUnits.emplace_back(enter, i);
+        }
+    }
+    std::sort(crossedUnits.begin(), crossedUnits.end());
+
+    uint32_t nearest = kNInvalidIndex;
+    distance = maxDistance;
+    for (const auto& [unitEnter, unitIndex] : crossedUnits) {
+        if (unitEnter >= distance) {
+            break;
+        }
+        const NArmyUnit& unit = units[unitIndex];
+        for (uint32_t i = unit.firstInstance; i < unit.firstInstance + unit.instanceCount; i++) {
+            const glm::vec3& feet = instances[i].position;
+            float enter, exit;
+            if (crossCircle(groundOrigin, groundDirection, vec2(feet.x, feet.z), soldierRadius, enter, exit) &&
+                crossSlab(origin.y, direction.y, feet.y, feet.y + soldierHeight, enter, exit) &&
+                exit >= 0.0f && enter < distance) {
+                nearest = i;
+                distance = std::max(enter, 0.0f);
+            }
+        }
+    }
+    return nearest;
+}
+
+void nglMarchingUnits(NArmySnapshot& snapshot) {
+    std::vector<NArmyUnit>& units = snapshot.units;
+    units.resize(kArmyUnitCount);
+    for (int i = 0; i < kArmyUnitCount; i++) {
+        NArmyUnit& unit = units[i];
+        unit = {static_cast<uint32_t>(i * kUnitInstanceCount), kUnitInstanceCount, vec2(0.0f), 0.0f,
+                std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+        // Around the soldiers at both ticks, and so wherever they are rendered between them, separated or not
+        vec2 minXz(std::numeric_limits<float>::infinity());
+        vec2 maxXz(-std::numeric_limits<float>::infinity());
+        for (uint32_t k = unit.firstInstance; k < unit.firstInstance + unit.instanceCount; k++) {
+            const glm::vec3& position = snapshot.instances[k].position;
+            const glm::vec3& previousPosition = snapshot.previousInstances[k].position;
+            vec2 xz(position.x, position.z);
+            vec2 previousXz(previousPosition.x, previousPosition.z);
+            minXz = glm::min(minXz, glm::min(xz, previousXz));
+            maxXz = glm::max(maxXz, glm::max(xz, previousXz));
+            unit.minHeight = std::min({unit.minHeight, position.y, previousPosition.y});
+            unit.maxHeight = std::max({unit.maxHeight, position.y, previousPosition.y});
+        }
+        unit.center = (minXz + maxXz) * 0.5f;
+        float radiusSquared = 0.0f;
+        for (uint32_t k = unit.firstInstance; k < unit.firstInstance + unit.instanceCount; k++) {
+            const glm::vec3& position = snapshot.instances[k].position;
+            const glm::vec3& previousPosition = snapshot.previousInstances[k].position;
+            vec2 offset = vec2(position.x, position.z) - unit.center;
+            vec2 previousOffset = vec2(previousPosition.x, previousPosition.z) - unit.center;
+            radiusSquared =
+                    std::max({radiusSquared, glm::dot(offset, offset), glm::dot(previousOffset, previousOffset)});
+        }
+        unit.radius = std::sqrt(radiusSquared);
+    }
+}
+
+void nglDeployArmies(const NglTerrainGeometry& terrainGeometry, NBattle& battle) {
+    // When the gap between the halves of the army is halfway along the route
+    const ArmyMotion& motion = gMotion;
+    const int frontRegimentCount = kRegimentCount / 2;
+    float gapOffset = frontRegimentCount * motion.regimentDistance - kRegimentPadding * 0.5f;
+    float time = (0.5f + gapOffset / motion.len) / motion.tSpeed - motion.time0;
+    std::vector<NInstance> instances;
+    nglUpdateInstances(time, terrainGeometry, static_cast<uint32_t>(NAnimation::kWalk), instances);
+
+    const int frontInstanceCount = frontRegimentCount * kUnitCount.x * kUnitCount.y * kUnitInstanceCount;
+    for (int i = frontInstanceCount; i < kArmyInstanceCount; i++) {
+        battle.addSoldier(0, static_cast<uint32_t>(i / kUnitInstanceCount), instances[i]);
+    }
+    for (int i = 0; i < frontInstanceCount; i++) {
+        NInstance instance = instances[i];
+        instance.heading = -instance.heading;
+        battle.addSoldier(1, static_cast<uint32_t>(i / kUnitInstanceCount), instance);
+    }
+}
+
+vec2 nglUnitCenter(int unitIndex, float time) {
+    const ArmyMotion& motion = gMotion;
+    // Between the middle two rows and columns of soldiers
+    vec2 inUnitCenter = vec2(kUnitSize - 1) * 0.5f;
+    vec2 dxz;
+    vec2 xz = interpolateAlongPath(pathParameter(motion, unitIndex, inUnitCenter.y, time), dxz);
+    vec2 pathDir = glm::normalize(dxz);
+    vec2 ortDir = vec2(pathDir.y, -pathDir.x);
+    return xz + ortDir * ortOffset(motion, unitIndex, inUnitCenter.x);
+}
+
+float nglUnitRadius() {
+    vec2 halfSize = vec2(kUnitSize - 1) * kInUnitDistance * 0.5f;
+    return glm::length(halfSize) + kRandomOffset * std::sqrt(2.0f) + kPathCurveSlack;
+}
+
+ArmyRoute routeThrough(const std::vector<vec2>& points) {
+    NGL_ASSERT(points.size() >= 2);
+    // Turns rounded with a moving average, the ends stay in place
+    const int pointCount = static_cast<int>(points.size());
+    std::vector<vec2> smoothPoints(points.size());
+    for (int i = 0; i < pointCount; i++) {
+        int radius = std::min({kRouteSmoothing, i, pointCount - 1 - i});
+        vec2 sum(0.0f);
+        for (int k = i - radius; k <= i + radius; k++) {
+            sum += points[k];
+        }
+        smoothPoints[i] = sum / static_cast<float>(2 * radius + 1);
+    }
+
+    std::vector<float> distances(smoothPoints.size(), 0.0f);
+    for (size_t i = 1; i < smoothPoints.size(); i++) {
+        distances[i] = distances[i - 1] + glm::length(smoothPoints[i] - smoothPoints[i - 1]);
+    }
+    ArmyRoute route;
+    route.length = distances.back();
+    int segmentCount = std::max(static_cast<int>(std::ceil(route.length / kRouteSpacing)), 1);
+    route.spacing = route.length / segmentCount;
+    size_t segment = 0;
+    for (int i = 0; i <= segmentCount; i++) {
+        float distance = std::min(i * route.spacing, route.length);
+        while (segment + 2 < distances.size() && distances[segment + 1] < distance) {
+            segment++;
+        }
+        float segmentLength = distances[segment + 1] - distances[segment];
+        float t = segmentLength > 0.0f ? (distance - distances[segment]) / segmentLength : 0.0f;
+        route.points.push_back(glm::mix(smoothPoints[segment], smoothPoints[segment + 1], t));
+    }
+    // Central differences, one sided at the ends
+    for (int i = 0; i <= segmentCount; i++) {
+        vec2 delta = route.points[std::min(i + 1, segmentCount)] - route.points[std::max(i - 1, 0)];
+        route.directions.push_back(glm::normalize(delta));
+    }
+    return route;
+}
+
+std::vector<vec2> pathPoints() {
+    std::vector<vec2> points;
+    for (int i = 0; i <= kPathSampleCount; i++) {
+        float t = static_cast<float>(i) / kPathSampleCount;
+        float it = 1.0f - t;
+        points.push_back(it * it * it * kPath[0] + 3.0f * it * it * t * kPath[1] + 3.0f * it * t * t * kPath[2] +
+                         t * t * t * kPath[3]);
+    }
+    return points;
+}
+
+ArmyMotion motionAlong(const ArmyRoute& route) {
+    ArmyMotion result;
+    result.len = route.length;
+    result.unitDistance = vec2(kUnitSize) * kInUnitDistance + kUnitPadding;
+    result.regimentDistance = kUnitCount.y * result.unitDistance.y + kRegimentPadding;
+    result.regimentSize = vec2(kUnitCount) * result.unitDistance - kUnitPadding;
+    float armyLength = result.regimentDistance * kRegimentCount;
+    float speed = result.regimentDistance / 90.0f;
+    result.tSpeed = speed / result.len;
+    result.period = (1.0f + armyLength / result.len) / result.tSpeed;
+    result.time0 = 0.2f * result.period;
+    return result;
+}
+
+// Position along the path of a row of soldiers, inUnitJ is the row in the unit
+float pathParameter(const ArmyMotion& motion, int unitIndex, float inUnitJ, float time) {
+    const int regimentUnitCount = kUnitCount.x * kUnitCount.y;
+    int regimentIndex = unitIndex / regimentUnitCount;
+    int unitJ = unitIndex % regimentUnitCount / kUnitCount.x;
+    float tOffset = regimentIndex * motion.regimentDistance + unitJ * motion.unitDistance.y +
+                    inUnitJ * kInUnitDistance.y;
+    return -tOffset / motion.len + motion.tSpeed * std::fmod(motion.time0 + time, motion.period);
+}
+
+// Distance across the path from its center line, inUnitI is the column in the unit
+float ortOffset(const ArmyMotion& motion, int unitIndex, float inUnitI) {
+    int unitI = unitIndex % (kUnitCount.x * kUnitCount.y) % kUnitCount.x;
+    return unitI * motion.unitDistance.x + inUnitI * kInUnitDistance.x - motion.regimentSize.x / 2.0f;
+}
+
+// Point t of the way along the route, and the direction there. Straight on before the start and after the end.
+vec2 interpolateAlongPath(float t, vec2& dxy) {
+    const int lastPoint = static_cast<int>(gRoute.points.size()) - 1;
+    float position = t * gRoute.length / gRoute.spacing;
+    int segment = std::clamp(static_cast<int>(std::floor(position)), 0, lastPoint - 1);
+    if (position <= 0.0f || position >= lastPoint) {
+        int end = position <= 0.0f ? 0 : lastPoint;
+        dxy = gRoute.directions[end];
+        return gRoute.points[end] + dxy * ((position - end) * gRoute.spacing);
+    }
+    float segmentT = position - segment;
+    dxy = glm::mix(gRoute.directions[segment], gRoute.directions[segment + 1], segmentT);
+    return glm::mix(gRoute.points[segment], gRoute.points[segment + 1], segmentT);
+}
+
+// Like GLSL's, also for negative values
+float fract(float value) {
+    return value - std::floor(value);
+}
+
+// Where the ray origin + t direction on the ground is within radius of center, from t = enter to exit. A ray that does
+// not move on the ground is within it for every t or none.
+bool crossCircle(vec2 origin, vec2 direction, vec2 center, float radius, float& enter, float& exit) {
+    const vec2 offset = origin - center;
+    const float c = glm::dot(offset, offset) - radius * radius;
+    const float a = glm::dot(direction, direction);
+    if (a == 0.0f) {
+        enter = -std::numeric_limits<float>::infinity();
+        exit = std::numeric_limits<float>::infinity();
+        return c <= 0.0f;
+    }
+    const float b = glm::dot(offset, direction);
+    const float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) {
+        return false;
+    }
+    const float root = std::sqrt(discriminant);
+    enter = (-b - root) / a;
+    exit = (-b + root) / a;
+    return true;
+}
+
+// Narrows [enter, exit] of the ray origin + t direction, along the height, to where it is from bottom to top. False if
+// it is empty.
+bool crossSlab(float origin, float direction, float bottom, float top, float& enter, float& exit) {
+    if (direction != 0.0f) {
+        float bottomT = (bottom - origin) / direction;
+        float topT = (top - origin) / direction;
+        enter = std::max(enter, std::min(bottomT, topT));
+        exit = std::min(exit, std::max(bottomT, topT));
+    } else if (origin < bottom || origin > top) {
+        return false;
+    }
+    return enter <= exit;
+}
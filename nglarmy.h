@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NFlowField.h"
+#include "NSpatialGrid.h"
+#include "NglTerrainGeometry.h"
+#include "nrender.h"
+
+// Army layout and motion. The vertex shaders only read the NInstance records computed here.
+constexpr glm::ivec2 kUnitSize = glm::ivec2(12, 12);
+constexpr glm::ivec2 kUnitCount = glm::ivec2(3, 5);
+constexpr int kRegimentCount = 4;
+constexpr int kUnitInstanceCount = kUnitSize.x * kUnitSize.y;
+constexpr int kArmyUnitCount = kUnitCount.x * kUnitCount.y * kRegimentCount;
+constexpr int kArmyInstanceCount = kUnitInstanceCount * kArmyUnitCount;
+static_assert(static_cast<uint32_t>(kArmyInstanceCount) <= kNMaxInstanceCount, "The army must fit the instances");
+// Soldiers are stretched by up to kMaxHeightScale and lifted by up to kStepHeight when they step
+constexpr float kMaxHeightScale = 63.0f / 448.0f;
+constexpr float kStepHeight = 0.003f;
+// The army marches from kArmyStart to kArmyDestination and loops, on a route found through a flow field of this
+// resolution
+constexpr glm::vec2 kArmyStart = glm::vec2(6.0f, -3.0f);
+constexpr glm::vec2 kArmyDestination = glm::vec2(-6.0f, 3.0f);
+constexpr int kArmyFlowFieldResolution = 256;
+// Ground distance soldiers keep between each other, a little more than the soldier model is wide
+constexpr float kSeparationRadius = 0.04f;
+
+class NBattle;
+
+// Soldiers of a unit are consecutive instances
+struct NArmyUnit {
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+    glm::vec2 center;  // on the ground (x, z)
+    float radius;      // ground distance from center within which its soldiers are, not counting their own size
+    float minHeight;   // of its soldiers' feet
+    float maxHeight;
+};
+
+// Soldiers at a simulation tick, as rendered
+struct NArmySnapshot {
+    std::vector<NInstance> previousInstances;  // the same soldiers at the tick before, the same tick at the first
+    std::vector<NInstance> instances;
+    std::vector<NArmyUnit> units;
+};
+
+// Routes the army down the flow field to kArmyDestination, the quickest way over the terrain. Until then, it marches
+// along a fixed curve. Call before anything asks where the army is.
+void nglRouteArmy(NFlowFieldCache& flowFields);
+// Places every soldier at the given frame time, on the terrain, playing animation (NInstance::animation) in step with
+// their walk. Soldiers are numbered in instance order, the first kUnitInstanceCount records are unit 0 and so on.
+void nglUpdateInstances(float time, const NglTerrainGeometry& terrainGeometry, uint32_t animation,
+                        std::vector<NInstance>& instances);
+// Pushes apart the soldiers closer than kSeparationRadius, each by half of its overlap with every neighbor, and keeps
+// them on the terrain. grid is rebuilt from groundPositions, which are set to the soldiers' ground positions (x, z).
+void nglSeparateSoldiers(const NglTerrainGeometry& terrainGeometry, NSpatialGrid& grid,
+                         std::vector<glm::vec2>& groundPositions, std::vector<NInstance>& instances);
+// Soldiers between their placements at two simulation ticks, previous at alpha 0 and current at 1
+void nglInterpolateInstances(const std::vector<NInstance>& previous, const std::vector<NInstance>& current, float alpha,
+                             std::vector<NInstance>& instances);
+// Soldier that the ray from origin along direction, unit length, meets first within maxDistance, kNInvalidIndex for
+// none, and the distance to it. Soldiers are upright cylinders of soldierRadius and soldierHeight on their feet. Units
+// bound their soldiers, upright cylinders fit around them at both ticks: only the units the ray crosses are searched,
+// nearest first, and none past the nearest soldier found.
+uint32_t nglPickSoldier(const std::vector<NInstance>& instances, const std::vector<NArmyUnit>& units,
+                        float soldierRadius, float soldierHeight, const glm::vec3& origin, const glm::vec3& direction,
+                        float maxDistance, float& distance);
+// Units of the marching army into snapshot, fit around its instances and previousInstances. Unit i is made of soldier
+// instances i * kUnitInstanceCount and following.
+void nglMarchingUnits(NArmySnapshot& snapshot);
+// Splits the army for a battle where the middle of its route is, the front half turned around to face the rear half.
+// The rear half is side 0, marching on.
+void nglDeployArmies(const NglTerrainGeometry& terrainGeometry, NBattle& battle);
+// Ground position (x, z) of the center of a unit at the given frame time, unit i is made of soldier instances
+// i * kUnitInstanceCount and following.
+glm::vec2 nglUnitCenter(int unitIndex, float time);
+// Rough ground distance from nglUnitCenter() within which a unit's soldiers are placed, not counting their own size,
+// nor how far separation pushes them. Snapshot units are fit around their soldiers instead.
+float nglUnitRadius();
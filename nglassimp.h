@@ -12,3 +12,12 @@ inline glm::vec3 ai2glm(const aiVector3D& aiVector) {
 inline glm::vec2 ai2glmvec2(const aiVector3D& aiVector) {
     return glm::vec2(aiVector.x, aiVector.y);
 }
+
+inline glm::quat ai2glm(const aiQuaternion& aiRotation) {
+    return glm::quat(aiRotation.w, aiRotation.x, aiRotation.y, aiRotation.z);
+}
+
+inline glm::mat4 ai2glm(const aiMatrix4x4& aiMatrix) {
+    // Row-major
+    return glm::transpose(glm::make_mat4(&aiMatrix.a1));
+}
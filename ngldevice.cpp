@@ -0,0 +1,778 @@
+#include "ngldevice.h"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "NglBuffer.h"
+#include "NglFramebuffer.h"
+#include "NglProgram.h"
+#include "NglTexture.h"
+#include "NglUploadRing.h"
+#include "NglVertex.h"
+#include "NglVertexArray.h"
+#include "nglassert.h"
+#include "ngldbg.h"
+#include "nglerr.h"
+#include "nglfrag.h"
+#include "nglgeom.h"
+#include "nglgl.h"
+#include "ngllog.h"
+#include "nglvert.h"
+#include "nprofile.h"
+
+// EXT_texture_compression_s3tc, which the glad loader was not generated with. BC5 and BC7 are core.
+constexpr GLenum kGlCompressedRgbS3tcDxt1 = 0x83F0;
+constexpr GLenum kGlCompressedRgbaS3tcDxt5 = 0x83F3;
+// Per frame, for the frame uniform, the instances and per-draw data
+constexpr size_t kUploadRingFrameSize = 1024 * 1024;
+static_assert(kNMaxInstanceCount * sizeof(NInstance) <= kUploadRingFrameSize / 2, "Instances must fit the ring");
+
+static void setCapability(GLenum capability, bool enabled);
+static bool hasExtension(const char* name);
+static GLenum toGlInternalFormat(NTextureFormat format);
+static int bytesPerPixel(NTextureFormat format);
+static GLuint globalTextureUnit(uint32_t slot);
+static bool isPositionOnly(NShader shader);
+static GLenum toGlCompareFunc(NCompareOp compareOp);
+
+class NglRenderDevice : public NRenderDevice {
+public:
+    NglRenderDevice(bool isHeadless);
+    ~NglRenderDevice() override;
+
+    const char* name() const override;
+    GLFWwindow* window() const override;
+    glm::ivec2 backbufferSize() const override;
+
+    NBufferHandle createBuffer(NBufferUsage usage, const void* data, size_t size) override;
+    NTextureHandle createTexture(const NTextureDesc& desc) override;
+    bool isTextureFormatSupported(NTextureFormat format) const override;
+    NPipelineHandle createPipeline(const NPipelineDesc& desc) override;
+
+    NMemoryRequirements getRenderTargetMemoryRequirements(const NRenderTargetDesc& desc) override;
+    void allocateTransientMemory(const NMemoryRequirements& requirements) override;
+    NTextureHandle createTransientRenderTarget(const NRenderTargetDesc& desc, uint64_t offset) override;
+    NTextureHandle createRenderTarget(const NRenderTargetDesc& desc) override;
+    void destroyTexture(NTextureHandle texture) override;
+
+    void setGlobalTexture(uint32_t slot, NTextureHandle texture) override;
+
+    bool beginFrame(const NFrameUniform& frameUniform) override;
+    void uploadInstances(const std::vector<NInstance>& instances) override;
+    void executePass(const NPassDesc& pass, const NPassTargets& targets, const std::vector<NBarrier>& barriers,
+                     const NCommandList& commandList) override;
+    void executeBarriers(const std::vector<NBarrier>& barriers) override;
+    void endFrame() override;
+
+    double frameWaitTime() const override;
+    const std::vector<NPassStats>& passStats() const override;
+
+    void waitIdle() override;
+
+private:
+    // Timestamps are read back kQueryLatency frames later, when they are available without stalling. The upload ring
+    // already keeps the CPU from getting further ahead than that.
+    static constexpr uint32_t kQueryLatency = NglUploadRing::kFrameCount;
+
+    // A pass or a scope of its command list
+    struct TimedRange {
+        const char* name;
+        bool isScope;
+        double pixelCount;  // of the pass's targets
+    };
+
+    struct FrameQueries {
+        std::vector<GLuint> queries;          // a begin and an end timestamp per range
+        std::vector<GLuint> fragmentQueries;  // fragment shader invocations per range, passes only
+        std::vector<TimedRange> ranges;
+        double submitTime = 0;  // of the first range
+    };
+
+    struct Pipeline {
+        NglProgram program;
+        NPipelineDesc desc;
+    };
+
+    void applyPipeline(const Pipeline& pipeline) const;
+    size_t beginTimedRange(FrameQueries& frameQueries, const TimedRange& range);
+    void endTimedRange(const FrameQueries& frameQueries, size_t rangeIndex);
+    void readPassStats(FrameQueries& frameQueries);
+    NTextureHandle addTexture(std::unique_ptr<NglTexture> texture);
+    GLuint textureName(NTextureHandle texture) const;
+    const NglFramebuffer& getFramebuffer(NTextureHandle color, NTextureHandle depth);
+    void destroyFramebuffers(NTextureHandle texture);
+
+    const bool mIsHeadless;
+    GLFWwindow* mWindow = nullptr;
+    bool mIsS3tcSupported = false;  // kBc1 and kBc3
+    size_t mUniformBufferAlignment = NglUploadRing::kMaxAlignment;
+    size_t mStorageBufferAlignment = NglUploadRing::kMaxAlignment;
+
+    // GL objects need a current context, so they are created after the window
+    std::unique_ptr<NglVertexArray> mVao;
+    std::unique_ptr<NglVertexArray> mPositionVao;
+    std::unique_ptr<NglUploadRing> mUploadRing;
+    std::vector<std::unique_ptr<NglBuffer>> mBuffers;
+    std::vector<std::unique_ptr<NglTexture>> mTextures;
+    std::vector<Pipeline> mPipelines;
+
+    // The frame is rendered offscreen, the default framebuffer has no depth and is only blitted to in endFrame().
+    // This keeps the backbuffer a texture like any other render target.
+    std::unique_ptr<NglTexture> mBackbuffer;
+    glm::ivec2 mBackbufferSize = glm::ivec2(0, 0);
+    // Keyed by color and depth texture handle
+    std::map<std::pair<uint32_t, uint32_t>, std::unique_ptr<NglFramebuffer>> mFramebuffers;
+
+    std::array<FrameQueries, kQueryLatency> mFrameQueries;
+    uint32_t mQueryFrame = 0;
+    std::vector<NPassStats> mPassStats;
+
+    double mFrameWaitTime = 0;
+};
+
+std::unique_ptr<NRenderDevice> nglCreateRenderDevice(bool isHeadless) {
+    return std::make_unique<NglRenderDevice>(isHeadless);
+}
+
+NglRenderDevice::NglRenderDevice(bool isHeadless) : mIsHeadless(isHeadless) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_DEPTH_BITS, 0);
+    if (mIsHeadless) {
+        // The null platform has no native contexts. EGL gives a surfaceless context where the driver supports it
+        // (Mesa, NVIDIA), the window's framebuffer is never drawn to since the frame is rendered offscreen anyway.
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+    nglPrepareDebugIfNecessary();
+
+    mWindow = glfwCreateWindow(1920, 1080, "N War (OpenGL)", nullptr, nullptr);
+    if (!mWindow) {
+        NGL_LOGE("glfwCreateWindow() failed");
+        glfwTerminate();
+        abort();
+    }
+
+    glfwMakeContextCurrent(mWindow);
+    gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+    if (!mIsHeadless) {
+        glfwSwapInterval(1);
+    }
+
+    nglEnableDebugIfNecessary();
+    mIsS3tcSupported = hasExtension("GL_EXT_texture_compression_s3tc");
+
+    glCullFace(GL_BACK);
+    NGL_CHECK_ERRORS;
+
+    // A single VAO with the NglVertex layout, draws only swap the buffers bound to it
+    mVao = std::make_unique<NglVertexArray>();
+    glVertexArrayAttribFormat(*mVao, 0 /*position*/, 3, GL_FLOAT, GL_FALSE, offsetof(NglVertex, position));
+    NGL_CHECK_ERRORS;
+    glVertexArrayAttribFormat(*mVao, 1 /*normal*/, 3, GL_FLOAT, GL_FALSE, offsetof(NglVertex, normal));
+    NGL_CHECK_ERRORS;
+    glVertexArrayAttribFormat(*mVao, 2 /*uv*/, 2, GL_FLOAT, GL_FALSE, offsetof(NglVertex, uv));
+    NGL_CHECK_ERRORS;
+    for (GLuint attribute = 0; attribute < 3; attribute++) {
+        glVertexArrayAttribBinding(*mVao, attribute, 0);
+        NGL_CHECK_ERRORS;
+        glEnableVertexArrayAttrib(*mVao, attribute);
+        NGL_CHECK_ERRORS;
+    }
+
+    // Positions only, for the depth-only shaders
+    mPositionVao = std::make_unique<NglVertexArray>();
+    glVertexArrayAttribFormat(*mPositionVao, 0 /*position*/, 3, GL_FLOAT, GL_FALSE, 0);
+    NGL_CHECK_ERRORS;
+    glVertexArrayAttribBinding(*mPositionVao, 0, 0);
+    NGL_CHECK_ERRORS;
+    glEnableVertexArrayAttrib(*mPositionVao, 0);
+    NGL_CHECK_ERRORS;
+
+    // FrameUniform is bound to the current frame's copy in the upload ring by beginFrame()
+    GLint uniformBufferAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignment);
+    NGL_CHECK_ERRORS;
+    mUniformBufferAlignment = static_cast<size_t>(uniformBufferAlignment);
+    GLint storageBufferAlignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageBufferAlignment);
+    NGL_CHECK_ERRORS;
+    mStorageBufferAlignment = static_cast<size_t>(storageBufferAlignment);
+    mUploadRing = std::make_unique<NglUploadRing>(kUploadRingFrameSize);
+}
+
+NglRenderDevice::~NglRenderDevice() {
+    for (FrameQueries& frameQueries : mFrameQueries) {
+        if (!frameQueries.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(frameQueries.queries.size()), frameQueries.queries.data());
+            NGL_CHECK_ERRORS;
+            glDeleteQueries(static_cast<GLsizei>(frameQueries.fragmentQueries.size()),
+                            frameQueries.fragmentQueries.data());
+            NGL_CHECK_ERRORS;
+        }
+    }
+    mFramebuffers.clear();
+    mBackbuffer.reset();
+    mPipelines.clear();
+    mTextures.clear();
+    mBuffers.clear();
+    mUploadRing.reset();
+    mPositionVao.reset();
+    mVao.reset();
+    glfwDestroyWindow(mWindow);
+}
+
+const char* NglRenderDevice::name() const {
+    return "OpenGL";
+}
+
+GLFWwindow* NglRenderDevice::window() const {
+    return mWindow;
+}
+
+glm::ivec2 NglRenderDevice::backbufferSize() const {
+    return mBackbufferSize;
+}
+
+NBufferHandle NglRenderDevice::createBuffer(NBufferUsage /*usage*/, const void* data, size_t size) {
+    auto buffer = std::make_unique<NglBuffer>();
+    glNamedBufferStorage(*buffer, size, data, 0);
+    NGL_CHECK_ERRORS;
+    mBuffers.push_back(std::move(buffer));
+    return {static_cast<uint32_t>(mBuffers.size() - 1)};
+}
+
+NTextureHandle NglRenderDevice::createTexture(const NTextureDesc& desc) {
+    NGL_ASSERT(desc.levelCount == 1 || nIsBlockCompressed(desc.format));
+    NGL_ASSERT(!desc.generatesLevels || (desc.format == NTextureFormat::kRgba8 && desc.levelCount == 1));
+    auto texture = std::make_unique<NglTexture>();
+    switch (desc.format) {
+        case NTextureFormat::kRgba8:
+            texture->load(GL_RGBA8, desc.width, desc.height,
+                          desc.generatesLevels ? nFullLevelCount(desc.width, desc.height) : 1, GL_RGBA,
+                          GL_UNSIGNED_BYTE, desc.pixels, desc.label);
+            break;
+        case NTextureFormat::kR32F:
+            texture->load(GL_R32F, desc.width, desc.height, 1, GL_RED, GL_FLOAT, desc.pixels, desc.label);
+            break;
+        case NTextureFormat::kRgba32F:
+            texture->load(GL_RGBA32F, desc.width, desc.height, 1, GL_RGBA, GL_FLOAT, desc.pixels, desc.label);
+            break;
+        case NTextureFormat::kDepth:
+            NGL_ABORT("Depth texture %s can only be a render target", desc.label);
+        case NTextureFormat::kBc1:
+        case NTextureFormat::kBc3:
+        case NTextureFormat::kBc5:
+        case NTextureFormat::kBc7:
+            NGL_ASSERT(isTextureFormatSupported(desc.format));
+            texture->loadBlocks(toGlInternalFormat(desc.format),
+                                static_cast<int>(nTextureLevelSize(desc.format, 4, 4)), desc.width, desc.height,
+                                desc.levelCount, desc.pixels, desc.label);
+            break;
+    }
+    return addTexture(std::move(texture));
+}
+
+bool NglRenderDevice::isTextureFormatSupported(NTextureFormat format) const {
+    switch (format) {
+        case NTextureFormat::kRgba8:
+        case NTextureFormat::kR32F:
+        case NTextureFormat::kRgba32F:
+        case NTextureFormat::kBc5:
+        case NTextureFormat::kBc7:
+            return true;
+        case NTextureFormat::kDepth:
+            return false;
+        case NTextureFormat::kBc1:
+        case NTextureFormat::kBc3:
+            return mIsS3tcSupported;
+    }
+    return false;
+}
+
+NPipelineHandle NglRenderDevice::createPipeline(const NPipelineDesc& desc) {
+    NglProgram::Builder builder;
+    switch (desc.shader) {
+        case NShader::kScene:
+            builder.setVertexShader(gVertexShaderSrc)
+                    .setGeometryShader(gGeometryShaderSrc)
+                    .setFragmentShader(gFragmentShaderSrc);
+            break;
+        case NShader::kShadow:
+            // The geometry shader only feeds the wireframe overlay
+            builder.addDefine("SHADOW_PASS").setVertexShader(gVertexShaderSrc).setFragmentShader(gFragmentShaderSrc);
+            break;
+        case NShader::kDepth:
+            builder.addDefine("DEPTH_PASS").setVertexShader(gVertexShaderSrc).setFragmentShader(gFragmentShaderSrc);
+            break;
+    }
+    NglProgram program = builder.build();
+    mPipelines.push_back({std::move(program), desc});
+    return {static_cast<uint32_t>(mPipelines.size() - 1)};
+}
+
+NMemoryRequirements NglRenderDevice::getRenderTargetMemoryRequirements(const NRenderTargetDesc& desc) {
+    // GL allocates texture memory itself, the numbers only feed the frame graph's memory report
+    NMemoryRequirements requirements;
+    requirements.size = static_cast<uint64_t>(desc.width) * desc.height * bytesPerPixel(desc.format);
+    requirements.alignment = 256;
+    return requirements;
+}
+
+void NglRenderDevice::allocateTransientMemory(const NMemoryRequirements& /*requirements*/) {}
+
+NTextureHandle NglRenderDevice::createTransientRenderTarget(const NRenderTargetDesc& desc, uint64_t /*offset*/) {
+    // No way to place a texture in memory in GL, transient targets get storage of their own
+    return createRenderTarget(desc);
+}
+
+NTextureHandle NglRenderDevice::createRenderTarget(const NRenderTargetDesc& desc) {
+    auto texture = std::make_unique<NglTexture>();
+    texture->allocate(toGlInternalFormat(desc.format), desc.width, desc.height, desc.label);
+    return addTexture(std::move(texture));
+}
+
+void NglRenderDevice::destroyTexture(NTextureHandle texture) {
+    destroyFramebuffers(texture);
+    mTextures[texture.index].reset();
+}
+
+void NglRenderDevice::setGlobalTexture(uint32_t slot, NTextureHandle texture) {
+    mTextures[texture.index]->bind(globalTextureUnit(slot));
+}
+
+bool NglRenderDevice::beginFrame(const NFrameUniform& frameUniform) {
+    int width, height;
+    glfwGetFramebufferSize(mWindow, &width, &height);
+    if (width == 0 || height == 0) {
+        // Minimized
+        return false;
+    }
+    if (glm::ivec2(width, height) != mBackbufferSize) {
+        destroyFramebuffers(kNBackbuffer);
+        mBackbuffer = std::make_unique<NglTexture>();
+        mBackbuffer->allocate(GL_RGBA8, width, height, "Backbuffer");
+        mBackbufferSize = glm::ivec2(width, height);
+    }
+
+    // Also what throttles the CPU when headless, with no swap to do it
+    mFrameWaitTime = mUploadRing->beginFrame();
+
+    NglUploadAllocation uniform = mUploadRing->allocate(sizeof(NFrameUniform), mUniformBufferAlignment);
+    memcpy(uniform.data, &frameUniform, sizeof(NFrameUniform));
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0 /*FrameUniform*/, *mUploadRing, uniform.offset, sizeof(NFrameUniform));
+    NGL_CHECK_ERRORS;
+
+    FrameQueries& frameQueries = mFrameQueries[mQueryFrame];
+    if (!frameQueries.ranges.empty()) {
+        readPassStats(frameQueries);
+        frameQueries.ranges.clear();
+    }
+
+    return true;
+}
+
+void NglRenderDevice::uploadInstances(const std::vector<NInstance>& instances) {
+    NGL_ASSERT(!instances.empty() && instances.size() <= kNMaxInstanceCount);
+    size_t size = instances.size() * sizeof(NInstance);
+    NglUploadAllocation allocation = mUploadRing->allocate(size, mStorageBufferAlignment);
+    memcpy(allocation.data, instances.data(), size);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1 /*Instances*/, *mUploadRing, allocation.offset,
+                      static_cast<GLsizeiptr>(size));
+    NGL_CHECK_ERRORS;
+}
+
+void NglRenderDevice::executePass(const NPassDesc& pass, const NPassTargets& targets,
+                                  const std::vector<NBarrier>& /*barriers*/, const NCommandList& commandList) {
+    // GL tracks hazards itself, the barriers only matter to explicit APIs
+    FrameQueries& frameQueries = mFrameQueries[mQueryFrame];
+    size_t passRange =
+            beginTimedRange(frameQueries, {pass.name, false, static_cast<double>(targets.size.x) * targets.size.y});
+
+    const NglFramebuffer& framebuffer = getFramebuffer(targets.color, targets.depth);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    NGL_CHECK_ERRORS;
+    glViewport(0, 0, targets.size.x, targets.size.y);
+    NGL_CHECK_ERRORS;
+
+    GLenum discarded[2];
+    GLsizei discardedCount = 0;
+    if (targets.color.isValid()) {
+        if (targets.colorLoadOp == NLoadOp::kClear) {
+            glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, &pass.clearColor.r);
+            NGL_CHECK_ERRORS;
+        } else if (targets.colorLoadOp == NLoadOp::kDontCare) {
+            discarded[discardedCount++] = GL_COLOR_ATTACHMENT0;
+        }
+    }
+    if (targets.depth.isValid()) {
+        if (targets.depthLoadOp == NLoadOp::kClear) {
+            // Clears honor the depth mask
+            glDepthMask(GL_TRUE);
+            NGL_CHECK_ERRORS;
+            glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &pass.clearDepth);
+            NGL_CHECK_ERRORS;
+        } else if (targets.depthLoadOp == NLoadOp::kDontCare) {
+            discarded[discardedCount++] = GL_DEPTH_ATTACHMENT;
+        }
+    }
+    if (discardedCount > 0) {
+        glInvalidateNamedFramebufferData(framebuffer, discardedCount, discarded);
+        NGL_CHECK_ERRORS;
+    }
+
+    // Only state that differs from the previous draw is sent to the driver
+    NPipelineHandle boundPipeline;
+    const NglVertexArray* boundVao = nullptr;
+    NBufferHandle boundVertexBuffer;
+    NBufferHandle boundIndexBuffer;
+    NTextureHandle boundTexture;
+    uint32_t boundCascade = UINT32_MAX;
+    // Scopes begin before their first draw and end after their last one
+    const std::vector<NDraw>& draws = commandList.draws();
+    const std::vector<NCommandScope>& scopes = commandList.scopes();
+    size_t scopeIndex = 0;
+    size_t scopeRange = 0;
+    bool isInScope = false;
+    auto updateScopes = [&](uint32_t drawIndex) {
+        while (scopeIndex < scopes.size()) {
+            const NCommandScope& scope = scopes[scopeIndex];
+            if (isInScope) {
+                if (scope.endDraw != drawIndex) {
+                    return;
+                }
+                endTimedRange(frameQueries, scopeRange);
+                isInScope = false;
+                scopeIndex++;
+            } else {
+                if (scope.firstDraw != drawIndex) {
+                    return;
+                }
+                scopeRange = beginTimedRange(frameQueries, {scope.name, true, 0.0});
+                isInScope = true;
+            }
+        }
+    };
+    for (uint32_t drawIndex = 0; drawIndex < draws.size(); drawIndex++) {
+        updateScopes(drawIndex);
+        const NDraw& draw = draws[drawIndex];
+        const Pipeline& pipeline = mPipelines[draw.pipeline.index];
+        bool isPositionStream = isPositionOnly(pipeline.desc.shader);
+        if (draw.pipeline != boundPipeline) {
+            applyPipeline(pipeline);
+            boundPipeline = draw.pipeline;
+            boundCascade = UINT32_MAX;
+
+            const NglVertexArray* vao = isPositionStream ? mPositionVao.get() : mVao.get();
+            if (vao != boundVao) {
+                glBindVertexArray(*vao);
+                NGL_CHECK_ERRORS;
+                boundVao = vao;
+                boundVertexBuffer = NBufferHandle();
+                boundIndexBuffer = NBufferHandle();
+            }
+        }
+        if (pipeline.desc.shader == NShader::kShadow && draw.cascade != boundCascade) {
+            glUniform1i(0 /*cascade_index*/, static_cast<GLint>(draw.cascade));
+            NGL_CHECK_ERRORS;
+            boundCascade = draw.cascade;
+        }
+        if (draw.vertexBuffer != boundVertexBuffer) {
+            GLsizei stride = isPositionStream ? sizeof(glm::vec3) : sizeof(NglVertex);
+            glVertexArrayVertexBuffer(*boundVao, 0, *mBuffers[draw.vertexBuffer.index], 0, stride);
+            NGL_CHECK_ERRORS;
+            boundVertexBuffer = draw.vertexBuffer;
+        }
+        if (draw.indexBuffer != boundIndexBuffer) {
+            glVertexArrayElementBuffer(*boundVao, *mBuffers[draw.indexBuffer.index]);
+            NGL_CHECK_ERRORS;
+            boundIndexBuffer = draw.indexBuffer;
+        }
+        if (draw.texture.isValid() && draw.texture != boundTexture) {
+            mTextures[draw.texture.index]->bind(1);
+            boundTexture = draw.texture;
+        }
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, draw.indexCount, GL_UNSIGNED_INT, nullptr,
+                                            draw.instanceCount, draw.firstInstance);
+        NGL_CHECK_ERRORS;
+    }
+    updateScopes(static_cast<uint32_t>(draws.size()));
+
+    discardedCount = 0;
+    if (targets.color.isValid() && !targets.storeColor) {
+        discarded[discardedCount++] = GL_COLOR_ATTACHMENT0;
+    }
+    if (targets.depth.isValid() && !targets.storeDepth) {
+        discarded[discardedCount++] = GL_DEPTH_ATTACHMENT;
+    }
+    if (discardedCount > 0) {
+        glInvalidateNamedFramebufferData(framebuffer, discardedCount, discarded);
+        NGL_CHECK_ERRORS;
+    }
+
+    endTimedRange(frameQueries, passRange);
+}
+
+void NglRenderDevice::executeBarriers(const std::vector<NBarrier>& /*barriers*/) {}
+
+void NglRenderDevice::endFrame() {
+    mUploadRing->endFrame();
+    if (mIsHeadless) {
+        // Nothing to show, the frame stays in the offscreen backbuffer
+        glFlush();
+        NGL_CHECK_ERRORS;
+        mQueryFrame = (mQueryFrame + 1) % kQueryLatency;
+        return;
+    }
+
+    const NglFramebuffer& framebuffer = getFramebuffer(kNBackbuffer, NTextureHandle());
+    glBlitNamedFramebuffer(framebuffer, 0, 0, 0, mBackbufferSize.x, mBackbufferSize.y, 0, 0, mBackbufferSize.x,
+                           mBackbufferSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    NGL_CHECK_ERRORS;
+
+    {
+        NGL_PROFILE_SCOPE("Present");
+        double waitStartTime = glfwGetTime();
+        glfwSwapBuffers(mWindow);
+        mFrameWaitTime += glfwGetTime() - waitStartTime;
+    }
+
+    mQueryFrame = (mQueryFrame + 1) % kQueryLatency;
+}
+
+double NglRenderDevice::frameWaitTime() const {
+    return mFrameWaitTime;
+}
+
+const std::vector<NPassStats>& NglRenderDevice::passStats() const {
+    return mPassStats;
+}
+
+void NglRenderDevice::waitIdle() {
+    glFinish();
+    NGL_CHECK_ERRORS;
+}
+
+void NglRenderDevice::applyPipeline(const Pipeline& pipeline) const {
+    pipeline.program.use();
+    setCapability(GL_DEPTH_TEST, pipeline.desc.depthTest);
+    glDepthMask(pipeline.desc.depthWrite ? GL_TRUE : GL_FALSE);
+    NGL_CHECK_ERRORS;
+    glDepthFunc(toGlCompareFunc(pipeline.desc.depthCompareOp));
+    NGL_CHECK_ERRORS;
+    setCapability(GL_CULL_FACE, pipeline.desc.cullBackFaces);
+    bool hasDepthBias = pipeline.desc.depthBiasConstant != 0.0f || pipeline.desc.depthBiasSlope != 0.0f;
+    setCapability(GL_POLYGON_OFFSET_FILL, hasDepthBias);
+    if (hasDepthBias) {
+        glPolygonOffset(pipeline.desc.depthBiasSlope, pipeline.desc.depthBiasConstant);
+        NGL_CHECK_ERRORS;
+    }
+}
+
+size_t NglRenderDevice::beginTimedRange(FrameQueries& frameQueries, const TimedRange& range) {
+    size_t rangeIndex = frameQueries.ranges.size();
+    if (rangeIndex * 2 == frameQueries.queries.size()) {
+        frameQueries.queries.resize(rangeIndex * 2 + 2);
+        glCreateQueries(GL_TIMESTAMP, 2, &frameQueries.queries[rangeIndex * 2]);
+        NGL_CHECK_ERRORS;
+        frameQueries.fragmentQueries.resize(rangeIndex + 1);
+        glCreateQueries(GL_FRAGMENT_SHADER_INVOCATIONS, 1, &frameQueries.fragmentQueries[rangeIndex]);
+        NGL_CHECK_ERRORS;
+    }
+    if (rangeIndex == 0) {
+        frameQueries.submitTime = glfwGetTime();
+    }
+    frameQueries.ranges.push_back(range);
+
+    glQueryCounter(frameQueries.queries[rangeIndex * 2], GL_TIMESTAMP);
+    NGL_CHECK_ERRORS;
+    // Queries of the same target do not nest, scopes are inside their pass
+    if (!range.isScope) {
+        glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, frameQueries.fragmentQueries[rangeIndex]);
+        NGL_CHECK_ERRORS;
+    }
+    return rangeIndex;
+}
+
+void NglRenderDevice::endTimedRange(const FrameQueries& frameQueries, size_t rangeIndex) {
+    if (!frameQueries.ranges[rangeIndex].isScope) {
+        glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+        NGL_CHECK_ERRORS;
+    }
+    glQueryCounter(frameQueries.queries[rangeIndex * 2 + 1], GL_TIMESTAMP);
+    NGL_CHECK_ERRORS;
+}
+
+void NglRenderDevice::readPassStats(FrameQueries& frameQueries) {
+    // The last timestamp of the frame is the last to become available
+    GLuint lastQuery = frameQueries.queries[frameQueries.ranges.size() * 2 - 1];
+    GLint isAvailable = GL_FALSE;
+    glGetQueryObjectiv(lastQuery, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+    NGL_CHECK_ERRORS;
+    if (!isAvailable) {
+        return;
+    }
+
+    mPassStats.clear();
+    GLuint64 frameBegin = 0;
+    for (size_t i = 0; i < frameQueries.ranges.size(); i++) {
+        const TimedRange& range = frameQueries.ranges[i];
+        GLuint64 begin, end;
+        glGetQueryObjectui64v(frameQueries.queries[i * 2], GL_QUERY_RESULT, &begin);
+        NGL_CHECK_ERRORS;
+        glGetQueryObjectui64v(frameQueries.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        NGL_CHECK_ERRORS;
+        if (i == 0) {
+            frameBegin = begin;
+        }
+        double overdraw = -1.0;
+        if (!range.isScope) {
+            GLuint64 fragmentCount;
+            glGetQueryObjectui64v(frameQueries.fragmentQueries[i], GL_QUERY_RESULT, &fragmentCount);
+            NGL_CHECK_ERRORS;
+            overdraw = static_cast<double>(fragmentCount) / range.pixelCount;
+        }
+        double startTime = frameQueries.submitTime + static_cast<double>(begin - frameBegin) * 1e-9;
+        mPassStats.push_back({range.name, range.isScope, startTime, static_cast<double>(end - begin) * 1e-9, overdraw});
+    }
+}
+
+NTextureHandle NglRenderDevice::addTexture(std::unique_ptr<NglTexture> texture) {
+    for (size_t i = 0; i < mTextures.size(); i++) {
+        if (!mTextures[i]) {
+            mTextures[i] = std::move(texture);
+            return {static_cast<uint32_t>(i)};
+        }
+    }
+    mTextures.push_back(std::move(texture));
+    return {static_cast<uint32_t>(mTextures.size() - 1)};
+}
+
+GLuint NglRenderDevice::textureName(NTextureHandle texture) const {
+    return texture == kNBackbuffer ? *mBackbuffer : *mTextures[texture.index];
+}
+
+const NglFramebuffer& NglRenderDevice::getFramebuffer(NTextureHandle color, NTextureHandle depth) {
+    std::unique_ptr<NglFramebuffer>& framebuffer = mFramebuffers[{color.index, depth.index}];
+    if (framebuffer) {
+        return *framebuffer;
+    }
+
+    framebuffer = std::make_unique<NglFramebuffer>();
+    if (color.isValid()) {
+        glNamedFramebufferTexture(*framebuffer, GL_COLOR_ATTACHMENT0, textureName(color), 0);
+        NGL_CHECK_ERRORS;
+    } else {
+        glNamedFramebufferDrawBuffer(*framebuffer, GL_NONE);
+        NGL_CHECK_ERRORS;
+    }
+    if (depth.isValid()) {
+        glNamedFramebufferTexture(*framebuffer, GL_DEPTH_ATTACHMENT, textureName(depth), 0);
+        NGL_CHECK_ERRORS;
+    }
+    GLenum status = glCheckNamedFramebufferStatus(*framebuffer, GL_FRAMEBUFFER);
+    NGL_CHECK_ERRORS;
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        NGL_ABORT("Framebuffer incomplete: 0x%x", status);
+    }
+    return *framebuffer;
+}
+
+void NglRenderDevice::destroyFramebuffers(NTextureHandle texture) {
+    for (auto it = mFramebuffers.begin(); it != mFramebuffers.end();) {
+        if (it->first.first == texture.index || it->first.second == texture.index) {
+            it = mFramebuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void setCapability(GLenum capability, bool enabled) {
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+    NGL_CHECK_ERRORS;
+}
+
+bool hasExtension(const char* name) {
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    NGL_CHECK_ERRORS;
+    for (GLint i = 0; i < extensionCount; i++) {
+        const GLubyte* extension = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+        NGL_CHECK_ERRORS;
+        if (strcmp(reinterpret_cast<const char*>(extension), name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+GLenum toGlInternalFormat(NTextureFormat format) {
+    // Color is not sRGB in this backend, see kRgba8 in createTexture()
+    switch (format) {
+        case NTextureFormat::kRgba8:
+            return GL_RGBA8;
+        case NTextureFormat::kR32F:
+            return GL_R32F;
+        case NTextureFormat::kRgba32F:
+            return GL_RGBA32F;
+        case NTextureFormat::kDepth:
+            return GL_DEPTH_COMPONENT32F;
+        case NTextureFormat::kBc1:
+            return kGlCompressedRgbS3tcDxt1;
+        case NTextureFormat::kBc3:
+            return kGlCompressedRgbaS3tcDxt5;
+        case NTextureFormat::kBc5:
+            return GL_COMPRESSED_RG_RGTC2;
+        case NTextureFormat::kBc7:
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    NGL_ABORT("Unknown texture format %d", static_cast<int>(format));
+}
+
+int bytesPerPixel(NTextureFormat format) {
+    switch (format) {
+        case NTextureFormat::kRgba8:
+        case NTextureFormat::kR32F:
+        case NTextureFormat::kDepth:
+            return 4;
+        case NTextureFormat::kRgba32F:
+            return 16;
+        case NTextureFormat::kBc1:
+        case NTextureFormat::kBc3:
+        case NTextureFormat::kBc5:
+        case NTextureFormat::kBc7:
+            NGL_ABORT("Block compressed format %d cannot be a render target", static_cast<int>(format));
+    }
+    NGL_ABORT("Unknown texture format %d", static_cast<int>(format));
+}
+
+GLuint globalTextureUnit(uint32_t slot) {
+    // Unit 1 is the per-draw material texture, see executePass()
+    NGL_ASSERT(slot >= kNShadowCascadeSlot && slot < kNGlobalTextureCount);
+    return 2 + (slot - kNShadowCascadeSlot);
+}
+
+bool isPositionOnly(NShader shader) {
+    return shader != NShader::kScene;
+}
+
+GLenum toGlCompareFunc(NCompareOp compareOp) {
+    switch (compareOp) {
+        case NCompareOp::kLess:
+            return GL_LESS;
+        case NCompareOp::kEqual:
+            return GL_EQUAL;
+    }
+    NGL_ABORT("Unknown compare op %d", static_cast<int>(compareOp));
+}
@@ -3,10 +3,16 @@
 static const char* gFragmentShaderSrc = R"(
 #version 460 core
 
+#if defined(SHADOW_PASS) || defined(DEPTH_PASS)
+void main() {
+}
+#else
 in GS_OUT {
     vec2 uv;
     vec3 color_factor;
     vec3 color_offset;
+    vec3 world_position;
+    float view_depth;
     vec3 barycoords;
 } fs_in;
 
@@ -15,15 +21,58 @@ layout (location = 0) out vec4 out_color;
 layout (std140, binding = 0) uniform FrameUniform {
     mat4 model_view_matrix;
     mat4 projection_matrix;
+    mat4 shadow_matrices[4];
+    vec4 cascade_splits;
+    vec4 light_vector;
     float time;
     int is_wireframe_enabled;
 } frame;
 
 layout (binding = 1) uniform sampler2D colorTexture;
+layout (binding = 2) uniform sampler2D shadow_maps[4];
+
+const vec3 ambient_factor = vec3(0.4);
+const int soldier_cascade_count = 3;
+const int terrain_cascade = 3;
+
+// Fraction of the 2x2 texels around uv that are farther from the light than depth
+float sample_shadow_map(int cascade, vec2 uv, float depth) {
+    // Sampler arrays may only be indexed with dynamically uniform values, the cascade varies per fragment
+    vec4 depths;
+    switch (cascade) {
+        case 0: depths = textureGather(shadow_maps[0], uv); break;
+        case 1: depths = textureGather(shadow_maps[1], uv); break;
+        case 2: depths = textureGather(shadow_maps[2], uv); break;
+        default: depths = textureGather(shadow_maps[3], uv); break;
+    }
+    return dot(step(vec4(depth), depths), vec4(0.25));
+}
+
+float cascade_shadow(int cascade) {
+    vec3 coords = (frame.shadow_matrices[cascade] * vec4(fs_in.world_position, 1)).xyz * 0.5 + 0.5;
+    if (any(lessThan(coords, vec3(0))) || any(greaterThan(coords, vec3(1)))) {
+        return 1;
+    }
+    return sample_shadow_map(cascade, coords.xy, coords.z);
+}
+
+// Soldier cascades hold soldiers only, the terrain cascade holds the terrain only
+float shadow() {
+    float result = cascade_shadow(terrain_cascade);
+    for (int i = 0; i < soldier_cascade_count; i++) {
+        if (fs_in.view_depth < frame.cascade_splits[i]) {
+            result = min(result, cascade_shadow(i));
+            break;
+        }
+    }
+    return result;
+}
 
 void main() {
+    float shadow_factor = shadow();
     vec4 color = texture(colorTexture, fs_in.uv);
-    color = color * vec4(fs_in.color_factor, 1) + vec4(fs_in.color_offset, 1);
+    color = color * vec4(ambient_factor + fs_in.color_factor * shadow_factor, 1) +
+            vec4(fs_in.color_offset * shadow_factor, 1);
     if (frame.is_wireframe_enabled != 0) {
         vec3 edge_factor = smoothstep(vec3(0.0), fwidth(fs_in.barycoords), fs_in.barycoords);
         float min_edge_factor = min(min(edge_factor.x, edge_factor.y), edge_factor.z);
@@ -32,4 +81,5 @@ void main() {
         out_color = color;
     }
 }
+#endif
 )";
@@ -6,16 +6,22 @@ static const char* gGeometryShaderSrc = R"(
 layout (triangles) in;
 layout (triangle_strip, max_vertices = 3) out;
 
+invariant gl_Position;
+
 in VS_OUT {
     vec2 uv;
     vec3 color_factor;
     vec3 color_offset;
+    vec3 world_position;
+    float view_depth;
 } gs_in[];
 
 out GS_OUT {
     vec2 uv;
     vec3 color_factor;
     vec3 color_offset;
+    vec3 world_position;
+    float view_depth;
     vec3 barycoords;
 } gs_out;
 
@@ -31,6 +37,8 @@ void main() {
         gs_out.uv = gs_in[i].uv;
         gs_out.color_factor = gs_in[i].color_factor;
         gs_out.color_offset = gs_in[i].color_offset;
+        gs_out.world_position = gs_in[i].world_position;
+        gs_out.view_depth = gs_in[i].view_depth;
         gs_out.barycoords = reference_barycoords[i];
         EmitVertex();
     }
@@ -1,3 +0,0 @@
-#pragma once
-
-int nglMain();
@@ -0,0 +1,35 @@
+#include "nimage.h"
+
+#include <stb_image.h>
+
+#include "nfile.h"
+#include "nglassert.h"
+#include "ngllog.h"
+
+static NImage toImage(stbi_uc* pixels, int width, int height, const char* label);
+
+NImage nLoadImage(const char* path) {
+    NMappedFile file = nMapFile(path, NFileAccess::kSequential);
+    return nDecodeImage(file.data(), static_cast<uint32_t>(file.size()), path);
+}
+
+NImage nDecodeImage(const void* data, uint32_t length, const char* label) {
+    int width;
+    int height;
+    stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(data), length, &width, &height, nullptr,
+                                            STBI_rgb_alpha);
+    return toImage(pixels, width, height, label);
+}
+
+NImage toImage(stbi_uc* pixels, int width, int height, const char* label) {
+    if (!pixels) {
+        NGL_ABORT("Failed to decode image %s: %s", label, stbi_failure_reason());
+    }
+    NImage result;
+    result.width = width;
+    result.height = height;
+    result.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    NGL_LOGI("Image %s decoded, width: %d, height: %d", label, width, height);
+    return result;
+}
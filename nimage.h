@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Decoded 8-bit RGBA image
+struct NImage {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+NImage nLoadImage(const char* path);
+NImage nDecodeImage(const void* data, uint32_t length, const char* label);
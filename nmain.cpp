@@ -0,0 +1,448 @@
+#include "nmain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/ext.hpp>
+#include <glm/glm.hpp>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include "NArmyLayer.h"
+#include "NAssetService.h"
+#include "NBenchmark.h"
+#include "NCamera.h"
+#include "NCameraPath.h"
+#include "NFlowField.h"
+#include "NFrameGraph.h"
+#include "NFrameStats.h"
+#include "NHeightField.h"
+#include "NOcclusionCuller.h"
+#include "NRenderDevice.h"
+#include "NShadowCascades.h"
+#include "NSimulationClock.h"
+#include "NTerrainLayer.h"
+#include "NglSoundGenerator.h"
+#include "NglTerrainGeometry.h"
+#include "ncamerapaths.h"
+#include "nfile.h"
+#include "nglarmy.h"
+#include "ngldevice.h"
+#include "ngllog.h"
+#include "nprofile.h"
+#include "nvkdevice.h"
+
+using glm::vec3;
+
+constexpr float kFieldOfView = 45.0f;
+constexpr float kNearPlane = 0.1f;
+constexpr float kFarPlane = 1000.0f;
+const vec3 kLightVector = glm::normalize(vec3(-1100.0f, 1200.0f, 1000.0f));  // towards the light
+// Frames rendered before a benchmark starts measuring, while pipelines and render targets get created
+constexpr int kBenchmarkWarmupFrameCount = 30;
+constexpr double kPlaybackTimestep = 1.0 / 60.0;
+// Simulation ticks a frame catches up on at most, after a stall
+constexpr int kMaxTicksPerFrame = 8;
+const char* const kCameraRecordingPath = "camera-path.ncam";
+// Main thread time per frame for creating the GPU resources of streamed assets
+constexpr double kAssetUploadBudget = 0.002;
+constexpr double kProfileOverlayInterval = 0.5;
+const char* const kProfilePath = "profile.json";
+
+static NCamera gCamera(vec3(0.0f, 1.6f, 1.6f), vec3(0.0f, 0.6f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+static bool gIsWireFrameEnabled = false;
+static bool gIsDepthPrepassEnabled = false;
+static bool gIsOcclusionCullingEnabled = true;
+static bool gIsLowAngleFlyoverEnabled = false;
+static bool gIsProfileOverlayEnabled = false;
+static bool gIsProfileExportRequested = false;
+static bool gIsCameraRecordingToggled = false;
+static bool gIsPickRequested = false;
+
+static void setInputCallbacks(GLFWwindow* window);
+static void pick(GLFWwindow* window, const NFrameUniform& frameUniform, const NHeightField& heightField,
+                 const NArmyLayer& armyLayer);
+static void doMain(NRenderDevice& device, const NMainOptions& options);
+
+int nMain(const NMainOptions& options) {
+    if (!nMountArchive(options.archivePath)) {
+        NGL_LOGI("No asset archive %s, loading loose files", options.archivePath.c_str());
+    }
+
+    glfwSetErrorCallback(
+            [](int error, const char* description) { NGL_LOGE("GLFW error: %s (%d)", description, error); });
+
+    if (options.isHeadless) {
+#ifdef GLFW_PLATFORM_NULL
+        // No display needed, windows exist but are never shown
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+        NGL_ABORT("Headless mode needs GLFW %s or later", "3.4");
+#endif
+    }
+    if (!glfwInit()) {
+        NGL_LOGE("glfwInit() failed");
+        abort();
+    }
+
+    {
+        std::unique_ptr<NRenderDevice> device = options.backend == NBackend::kOpenGL
+                                                        ? nglCreateRenderDevice(options.isHeadless)
+                                                        : nvkCreateRenderDevice(options.isHeadless);
+        setInputCallbacks(device->window());
+
+        // Build machines have no sound either
+        std::unique_ptr<NglSoundGenerator> soundGenerator;
+        if (!options.isHeadless) {
+            soundGenerator = std::make_unique<NglSoundGenerator>();
+        }
+
+        doMain(*device, options);
+
+        device->waitIdle();
+    }
+
+    glfwTerminate();
+
+    return 0;
+}
+
+void doMain(NRenderDevice& device, const NMainOptions& options) {
+    nProfileSetThreadName("Main");
+    NPipelineHandle scenePipeline = device.createPipeline(NPipelineDesc{});
+
+    // With the depth prepass, the scene pipeline shades only the fragments that ended up visible
+    NPipelineDesc depthPipelineDesc;
+    depthPipelineDesc.shader = NShader::kDepth;
+    depthPipelineDesc.hasColorTarget = false;
+    NPipelineHandle depthPipeline = device.createPipeline(depthPipelineDesc);
+    NPipelineDesc equalPipelineDesc;
+    equalPipelineDesc.depthWrite = false;
+    equalPipelineDesc.depthCompareOp = NCompareOp::kEqual;
+    NPipelineHandle equalPipeline = device.createPipeline(equalPipelineDesc);
+
+    // Layers. Their textures and models stream in while the first frames render with placeholders, the terrain
+    // geometry is needed right away by the army's route, the camera paths and the culler.
+    NAssetService assetService(device, options.hasMipmaps);
+    // The army and the camera's motion are simulated at a fixed tick rate, rendered between ticks. The army is
+    // simulated a tick ahead on its own thread, overlapping the frames that render it.
+    NSimulationClock simulationClock(options.tickRate, kMaxTicksPerFrame);
+    NglTerrainGeometry terrainGeometry;
+    NFlowFieldCache flowFields(terrainGeometry, kArmyFlowFieldResolution);
+    nglRouteArmy(flowFields);
+    NTerrainLayer terrainLayer(device, assetService, terrainGeometry);
+    NArmyLayer armyLayer(device, assetService, terrainGeometry, options.isAnimated, options.isBattle,
+                         simulationClock.tickDuration());
+    NOcclusionCuller occlusionCuller(terrainGeometry);
+    // Picking meets the terrain where it is drawn, on the same vertices
+    NHeightField heightField(terrainGeometry, terrainGeometry.width());
+
+    // Shadows, the bias keeps surfaces from shadowing themselves
+    NPipelineDesc shadowPipelineDesc;
+    shadowPipelineDesc.shader = NShader::kShadow;
+    shadowPipelineDesc.hasColorTarget = false;
+    shadowPipelineDesc.cullBackFaces = false;
+    shadowPipelineDesc.depthBiasConstant = 4.0f;
+    shadowPipelineDesc.depthBiasSlope = 2.0f;
+    NShadowCascades shadowCascades(device, terrainGeometry, device.createPipeline(shadowPipelineDesc));
+
+    // Frame graph. The main pass comes in two variants, with and without a depth prepass, only one is enabled.
+    // Soldiers are in front of the terrain, drawing them first lets early depth testing reject terrain fragments.
+    NFrameGraph frameGraph;
+    NGraphResource backbuffer = frameGraph.backbuffer();
+    NGraphResource sceneDepth = frameGraph.createTexture("SceneDepth", {NTextureFormat::kDepth});
+    std::vector<NPassAccess> shadowReads = shadowCascades.addPasses(frameGraph, terrainLayer, armyLayer);
+
+    NPassDesc depthPrepass;
+    depthPrepass.name = "Depth prepass";
+    NGraphPass depthPrepassPass = frameGraph.addPass(depthPrepass, {{sceneDepth, NResourceState::kDepthAttachment}},
+                                                     [&](NCommandList& commandList) {
+                                                         armyLayer.recordDepth(commandList, depthPipeline);
+                                                         terrainLayer.recordDepth(commandList, depthPipeline);
+                                                     });
+
+    std::vector<NPassAccess> mainAccesses = shadowReads;
+    mainAccesses.push_back({backbuffer, NResourceState::kColorAttachment});
+    mainAccesses.push_back({sceneDepth, NResourceState::kDepthAttachment});
+    NPassDesc mainPass;
+    mainPass.name = "Main";
+    mainPass.clearColor = glm::vec4(0.4f, 0.6f, 1.0f, 1.0f);
+    NGraphPass mainPassPass = frameGraph.addPass(mainPass, mainAccesses, [&](NCommandList& commandList) {
+        armyLayer.record(commandList, scenePipeline);
+        terrainLayer.record(commandList, scenePipeline);
+    });
+
+    std::vector<NPassAccess> equalAccesses = shadowReads;
+    equalAccesses.push_back({backbuffer, NResourceState::kColorAttachment});
+    equalAccesses.push_back({sceneDepth, NResourceState::kDepthRead});
+    NPassDesc equalPass = mainPass;
+    equalPass.name = "Main after prepass";
+    NGraphPass equalPassPass = frameGraph.addPass(equalPass, equalAccesses, [&](NCommandList& commandList) {
+        armyLayer.record(commandList, equalPipeline);
+        terrainLayer.record(commandList, equalPipeline);
+    });
+
+    NFrameStats frameStats(device.name());
+    NFrameUniform frameUniform;
+
+    // Playback drives the camera and the frame time at a fixed timestep, so every run renders the same frames.
+    // Benchmark runs stay on the first frame of the path until they start measuring. The simulation clock advances
+    // by the same timestep, as fast as frames render rather than in real time.
+    NCameraPath lowAngleFlyoverPath;
+    nCreateCameraPath("lowangle", terrainGeometry, lowAngleFlyoverPath);
+    const bool isBenchmark = options.benchmarkFrameCount > 0;
+    const std::string playbackPathName = options.cameraPath.empty() && isBenchmark ? "lowangle" : options.cameraPath;
+    NCameraPath playbackPath;
+    if (!playbackPathName.empty() && !nCreateCameraPath(playbackPathName, terrainGeometry, playbackPath) &&
+        !playbackPath.load(playbackPathName)) {
+        NGL_ABORT("Unknown camera path %s", playbackPathName.c_str());
+    }
+    const bool isPlayback = !playbackPath.isEmpty();
+    if (isPlayback && playbackPath.duration() <= 0) {
+        NGL_ABORT("Camera path %s is too short", playbackPathName.c_str());
+    }
+    NBenchmark benchmark(device.name());
+    int frameIndex = 0;
+    // Benchmarks measure the complete scene only
+    if (isBenchmark) {
+        assetService.finish();
+    }
+    const double startTime = glfwGetTime();
+    bool isStreaming = assetService.pendingCount() > 0;
+
+    NCameraPath recordedPath;
+    bool isRecording = false;
+    double recordingStartTime = 0;
+
+    GLFWwindow* window = device.window();
+    // No text rendering here, the window title is the overlay
+    const std::string windowTitle = std::string("N War (") + device.name() + ")";
+    double profileOverlayTime = -kProfileOverlayInterval;
+    bool isProfileOverlayShown = false;
+    double previousTime = startTime;
+    while (!glfwWindowShouldClose(window)) {
+        double time = glfwGetTime();
+        const bool isMeasured = isBenchmark && frameIndex >= kBenchmarkWarmupFrameCount;
+        // Playback loops the path
+        double pathTime = time;
+        double elapsedTime = time - previousTime;
+        previousTime = time;
+        if (isPlayback) {
+            int playbackFrame = std::max(frameIndex - (isBenchmark ? kBenchmarkWarmupFrameCount : 0), 0);
+            pathTime = std::fmod(playbackFrame * kPlaybackTimestep, playbackPath.duration());
+            elapsedTime = playbackFrame > 0 ? kPlaybackTimestep : 0.0;
+        }
+        if (gIsCameraRecordingToggled) {
+            gIsCameraRecordingToggled = false;
+            if (isRecording) {
+                recordedPath.save(kCameraRecordingPath);
+            } else {
+                recordedPath = NCameraPath();
+                recordingStartTime = time;
+            }
+            isRecording = !isRecording;
+            NGL_LOGI("Camera recording %s", isRecording ? "started" : "stopped");
+        }
+        {
+            NGL_PROFILE_SCOPE("Frame");
+            assetService.update(kAssetUploadBudget);
+            if (isStreaming && assetService.pendingCount() == 0) {
+                isStreaming = false;
+                NGL_LOGI("Assets streamed in %0.3fs after the first frame", time - startTime);
+            }
+
+            simulationClock.advance(elapsedTime);
+            double tickTime;
+            while (simulationClock.nextTick(tickTime)) {
+                gCamera.onTick(static_cast<float>(simulationClock.tickDuration()));
+            }
+            armyLayer.simulateTo(simulationClock.tick());
+            gCamera.interpolate(simulationClock.alpha());
+            if (isPlayback || gIsLowAngleFlyoverEnabled) {
+                const NCameraPath& path = isPlayback ? playbackPath : lowAngleFlyoverPath;
+                vec3 position, target;
+                path.sample(isPlayback ? pathTime : std::fmod(time, path.duration()), position, target);
+                gCamera.setLookAt(position, target);
+            }
+            if (isRecording) {
+                recordedPath.addKey(time - recordingStartTime, gCamera.getPosition(), gCamera.getTarget());
+            }
+
+            glfwPollEvents();
+
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            float aspect = height > 0 ? width / static_cast<float>(height) : 1.0f;
+
+            {
+                NGL_PROFILE_SCOPE("Uniform update");
+                frameUniform.model_view_matrix = gCamera.getModelViewMatrix();
+                frameUniform.projection_matrix = glm::perspective(kFieldOfView, aspect, kNearPlane, kFarPlane);
+                frameUniform.light_vector = glm::vec4(kLightVector, 0.0f);
+                frameUniform.time = static_cast<float>(simulationClock.renderTime());
+                frameUniform.is_wireframe_enabled = gIsWireFrameEnabled ? 1 : 0;
+                shadowCascades.update(frameGraph, frameUniform.model_view_matrix, frameUniform.projection_matrix,
+                                      kLightVector, frameUniform);
+            }
+            {
+                NGL_PROFILE_SCOPE("Occlusion culling");
+                if (gIsOcclusionCullingEnabled) {
+                    occlusionCuller.update(frameUniform.model_view_matrix, frameUniform.projection_matrix);
+                    armyLayer.update(simulationClock.alpha(), gCamera.getPosition(), &occlusionCuller);
+                    frameStats.onOcclusionCulling(armyLayer.occludedUnitCount(), armyLayer.unitCount());
+                } else {
+                    armyLayer.update(simulationClock.alpha(), gCamera.getPosition(), nullptr);
+                }
+            }
+            armyLayer.updateShadowCasters(frameUniform);
+            if (gIsPickRequested) {
+                gIsPickRequested = false;
+                pick(window, frameUniform, heightField, armyLayer);
+            }
+
+            frameGraph.setPassEnabled(depthPrepassPass, gIsDepthPrepassEnabled);
+            frameGraph.setPassEnabled(equalPassPass, gIsDepthPrepassEnabled);
+            frameGraph.setPassEnabled(mainPassPass, !gIsDepthPrepassEnabled);
+
+            if (device.beginFrame(frameUniform)) {
+                // Nothing draws soldiers when a battle left none
+                if (!armyLayer.instances().empty()) {
+                    device.uploadInstances(armyLayer.instances());
+                }
+                {
+                    NGL_PROFILE_SCOPE("Frame graph");
+                    frameGraph.execute(device);
+                }
+                device.endFrame();
+                shadowCascades.onFrameRendered();
+            }
+        }
+
+        double cpuFrameTime = glfwGetTime() - time - device.frameWaitTime();
+        frameStats.onFrame(time, cpuFrameTime);
+        frameStats.onPassStats(device.passStats());
+        if (isMeasured) {
+            benchmark.onFrame(time, cpuFrameTime);
+        }
+        benchmark.onPassStats(device.passStats());
+        frameIndex++;
+        if (isBenchmark && benchmark.frameCount() == options.benchmarkFrameCount) {
+            benchmark.writeJson(options.benchmarkPath);
+            if (options.onBenchmarkFinished) {
+                options.onBenchmarkFinished(benchmark);
+            }
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+
+        nProfileOnPassStats(device.passStats());
+        nProfileEndFrame();
+        if (gIsProfileExportRequested) {
+            gIsProfileExportRequested = false;
+            nProfileWriteChromeTrace(kProfilePath);
+        }
+        if (gIsProfileOverlayEnabled && time - profileOverlayTime >= kProfileOverlayInterval) {
+            profileOverlayTime = time;
+            glfwSetWindowTitle(window, nProfileSummary().c_str());
+            isProfileOverlayShown = true;
+        } else if (!gIsProfileOverlayEnabled && isProfileOverlayShown) {
+            glfwSetWindowTitle(window, windowTitle.c_str());
+            isProfileOverlayShown = false;
+        }
+    }
+}
+
+void setInputCallbacks(GLFWwindow* window) {
+    glfwSetKeyCallback(window, [](auto window, int key, int scancode, int action, int mods) {
+        if (key == GLFW_KEY_ESCAPE && action != GLFW_RELEASE) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            return;
+        }
+        if (key == GLFW_KEY_SPACE && action != GLFW_RELEASE) {
+            gIsWireFrameEnabled = !gIsWireFrameEnabled;
+            return;
+        }
+        if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+            gIsDepthPrepassEnabled = !gIsDepthPrepassEnabled;
+            NGL_LOGI("Depth prepass %s", gIsDepthPrepassEnabled ? "enabled" : "disabled");
+            return;
+        }
+        if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+            gIsOcclusionCullingEnabled = !gIsOcclusionCullingEnabled;
+            NGL_LOGI("Occlusion culling %s", gIsOcclusionCullingEnabled ? "enabled" : "disabled");
+            return;
+        }
+        if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+            gIsLowAngleFlyoverEnabled = !gIsLowAngleFlyoverEnabled;
+            NGL_LOGI("Low angle flyover %s", gIsLowAngleFlyoverEnabled ? "enabled" : "disabled");
+            return;
+        }
+        if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+            gIsProfileOverlayEnabled = !gIsProfileOverlayEnabled;
+            return;
+        }
+        if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+            gIsProfileExportRequested = true;
+            return;
+        }
+        if (key == GLFW_KEY_R && action == GLFW_PRESS) {
+            gIsCameraRecordingToggled = true;
+            return;
+        }
+        if (gCamera.onKeyEvent(key, scancode, action, mods)) {
+            return;
+        }
+    });
+
+    glfwSetMouseButtonCallback(window, [](auto window, int button, int action, int mods) {
+        if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
+            gIsPickRequested = true;
+            return;
+        }
+        if (gCamera.onMouseButtonEvent(window, button, action, mods)) {
+            return;
+        }
+    });
+
+    glfwSetCursorPosCallback(window, [](auto window, double x, double y) {
+        if (gCamera.onMouseMotionEvent(window, x, y)) {
+            return;
+        }
+    });
+}
+
+// Logs the soldier under the cursor, or the point of the terrain. All on the CPU against what the frame renders, the
+// GPU is not waited for.
+void pick(GLFWwindow* window, const NFrameUniform& frameUniform, const NHeightField& heightField,
+          const NArmyLayer& armyLayer) {
+    NGL_PROFILE_SCOPE("Picking");
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    if (width == 0 || height == 0) {
+        return;
+    }
+    // From the camera through the cursor's point on the far plane, in normalized device coordinates
+    const float ndcX = static_cast<float>(x / width) * 2.0f - 1.0f;
+    const float ndcY = 1.0f - static_cast<float>(y / height) * 2.0f;
+    glm::vec4 farPoint = glm::inverse(frameUniform.projection_matrix * frameUniform.model_view_matrix) *
+                         glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    const vec3 origin = gCamera.getPosition();
+    const vec3 direction = glm::normalize(vec3(farPoint) / farPoint.w - origin);
+
+    vec3 groundPoint;
+    const bool isGroundHit = heightField.intersectRay(origin, direction, kFarPlane, groundPoint);
+    float distance;
+    uint32_t soldier = armyLayer.pickSoldier(origin, direction,
+                                             isGroundHit ? glm::distance(origin, groundPoint) : kFarPlane, distance);
+    if (soldier != kNInvalidIndex) {
+        const vec3& position = armyLayer.instances()[soldier].position;
+        NGL_LOGI("Picked soldier %u at (%0.3f, %0.3f, %0.3f)", soldier, position.x, position.y, position.z);
+    } else if (isGroundHit) {
+        NGL_LOGI("Picked the terrain at (%0.3f, %0.3f, %0.3f)", groundPoint.x, groundPoint.y, groundPoint.z);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+class NBenchmark;
+
+enum class NBackend {
+    kOpenGL,
+    kVulkan,
+};
+
+struct NMainOptions {
+    NBackend backend = NBackend::kVulkan;
+    // Renders offscreen with no display: GLFW's null platform (GLFW 3.4) with an EGL context for OpenGL, no surface
+    // and no swapchain for Vulkan. Headless runs are benchmark runs.
+    bool isHeadless = false;
+    // Plays the camera path back for this many frames, writes the results to benchmarkPath and exits. 0 for an
+    // interactive run.
+    int benchmarkFrameCount = 0;
+    std::string benchmarkPath = "benchmark.json";
+    // Called at the end of a benchmark run, after the results are written, e.g. by the perf regression suite
+    std::function<void(const NBenchmark&)> onBenchmarkFinished;
+    // Played back at a fixed timestep: a canonical path (ncamerapaths.h) or a file recorded with the R key. Benchmark
+    // runs default to lowangle.
+    std::string cameraPath;
+    // Asset archive written by nwar-pack, files it does not have are loaded from the working directory. Loose files
+    // only if it is missing.
+    std::string archivePath = "nwar.pak";
+    // Textures with full mip chains, sampled trilinear and anisotropic. Off to compare the cost of sampling the
+    // largest level only.
+    bool hasMipmaps = true;
+    // Soldiers skinned with the animations baked into textures (see nanim.h). Off to compare with the static mesh.
+    bool isAnimated = true;
+    // The army split in two sides that fight each other (see NBattle), rather than marching
+    bool isBattle = false;
+    // Simulation ticks per second, independent of the frame rate (see NSimulationClock)
+    double tickRate = 60.0;
+};
+
+int nMain(const NMainOptions& options);
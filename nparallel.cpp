@@ -0,0 +1,107 @@
+#include "nparallel.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "nglassert.h"
+#include "nprofile.h"
+
+// A loop of nRunPartsOnPool(), on the stack of the thread that called it
+struct NPartLoop {
+    NPartFunction function;
+    const void* context;
+    int partCount;
+    int nextPart;   // to start
+    int doneCount;  // parts run
+};
+
+// Loops come and go and parts are taken under the mutex, the parts run outside of it
+struct NPartPool {
+    std::mutex mutex;
+    std::condition_variable condition;  // a loop was added or is done, or the pool stops
+    std::vector<NPartLoop*> loops;      // with parts left to start, oldest first
+    std::vector<std::thread> threads;
+    bool isStopping = false;
+
+    NPartPool();
+    NPartPool(const NPartPool&) = delete;
+    NPartPool& operator=(const NPartPool&) = delete;
+    NPartPool(NPartPool&&) = delete;
+    NPartPool& operator=(NPartPool&&) = delete;
+    ~NPartPool();
+};
+
+static NPartPool& partPool();
+static void runPoolThread(NPartPool& pool);
+static void runPart(NPartPool& pool, NPartLoop& loop, std::unique_lock<std::mutex>& lock);
+
+void nRunPartsOnPool(int partCount, NPartFunction function, const void* context) {
+    NGL_ASSERT(partCount > 0);
+    NPartPool& pool = partPool();
+    NPartLoop loop = {function, context, partCount, 0, 0};
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.loops.push_back(&loop);
+    pool.condition.notify_all();
+    while (loop.doneCount < partCount) {
+        if (loop.nextPart < partCount) {
+            runPart(pool, loop, lock);
+        } else if (!pool.loops.empty()) {
+            runPart(pool, *pool.loops.front(), lock);
+        } else {
+            pool.condition.wait(lock);
+        }
+    }
+}
+
+NPartPool::NPartPool() {
+    const unsigned threadCount = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    for (unsigned i = 0; i < threadCount; i++) {
+        threads.emplace_back(runPoolThread, std::ref(*this));
+    }
+}
+
+NPartPool::~NPartPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    condition.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Started by the first call, stopped at exit
+NPartPool& partPool() {
+    static NPartPool pool;
+    return pool;
+}
+
+void runPoolThread(NPartPool& pool) {
+    nProfileSetThreadName("Parts");
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    for (;;) {
+        pool.condition.wait(lock, [&] { return pool.isStopping || !pool.loops.empty(); });
+        if (pool.isStopping) {
+            return;
+        }
+        runPart(pool, *pool.loops.front(), lock);
+    }
+}
+
+// Takes the next part of loop and runs it with the mutex unlocked. The loop leaves the pool's list once all of its
+// parts are started, and its caller is woken once they are done.
+void runPart(NPartPool& pool, NPartLoop& loop, std::unique_lock<std::mutex>& lock) {
+    const int part = loop.nextPart++;
+    if (loop.nextPart == loop.partCount) {
+        pool.loops.erase(std::find(pool.loops.begin(), pool.loops.end(), &loop));
+    }
+    lock.unlock();
+    loop.function(loop.context, part);
+    lock.lock();
+    if (++loop.doneCount == loop.partCount) {
+        pool.condition.notify_all();
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+// Data parallel loops on a pool of threads, one per core besides the calling thread, started by the first loop split
+// in parts and kept until exit. Loops are split only when each part has enough work to pay for waking a thread.
+
+// Parts to split count items into, at least minCountPerPart items each and at most one part per core
+inline int nPartCount(size_t count, size_t minCountPerPart) {
+    size_t coreCount = std::max(std::thread::hardware_concurrency(), 1u);
+    return static_cast<int>(std::clamp<size_t>(count / minCountPerPart, 1, coreCount));
+}
+
+// Items [first, second) of part out of partCount about equal parts of count items
+inline std::pair<size_t, size_t> nPartRange(size_t count, int part, int partCount) {
+    return {count * part / partCount, count * (part + 1) / partCount};
+}
+
+using NPartFunction = void (*)(const void* context, int part);
+
+// Calls function(context, part) for every part from 0 to partCount - 1 on the pool's threads and on the calling
+// thread, and waits for all of them. Use nRunParts().
+void nRunPartsOnPool(int partCount, NPartFunction function, const void* context);
+
+// Calls function(part) for every part from 0 to partCount - 1 and waits for all of them. The calling thread takes the
+// first parts. While it waits for the pool to finish the others, it runs parts of any other loop, so a part may split
+// into parts in turn, e.g. to run loops at once that each use only a few threads.
+template <typename Function>
+void nRunParts(int partCount, const Function& function) {
+    if (partCount == 1) {
+        function(0);
+        return;
+    }
+    nRunPartsOnPool(
+            partCount, [](const void* context, int part) { (*static_cast<const Function*>(context))(part); },
+            &function);
+}
@@ -0,0 +1,207 @@
+#include "nprofile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include "nglassert.h"
+
+constexpr double kEventLifetime = 10.0;  // seconds
+constexpr double kSummaryWindow = 1.0;   // seconds
+constexpr int kSummaryDepth = 1;         // scopes nested deeper are left out of the summary
+
+struct NProfileEvent {
+    const char* name;
+    double startTime;
+    double endTime;  // negative while the scope is open
+    int depth;
+};
+
+// Events of one thread. The thread appends to them, the main thread reads and trims them.
+struct NProfileThread {
+    std::mutex mutex;
+    const char* name = nullptr;
+    int id = 0;
+    std::deque<NProfileEvent> events;  // in start order
+    size_t trimmedCount = 0;           // events dropped from the front so far
+    std::vector<size_t> openEvents;    // absolute indices, counting the trimmed events
+};
+
+static NProfileThread& currentThread();
+static NProfileThread& gpuThread();
+static void writeEscaped(FILE* file, const char* text);
+
+static std::mutex gThreadsMutex;
+static std::vector<std::unique_ptr<NProfileThread>> gThreads;
+static thread_local NProfileThread* tThread = nullptr;
+static std::deque<double> gFrameEndTimes;
+static double gLastGpuFrameStartTime = -1.0;
+
+void nProfileSetThreadName(const char* name) {
+    NProfileThread& thread = currentThread();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    thread.name = name;
+}
+
+void nProfileBeginScope(const char* name) {
+    NProfileThread& thread = currentThread();
+    double time = glfwGetTime();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    thread.openEvents.push_back(thread.trimmedCount + thread.events.size());
+    thread.events.push_back({name, time, -1.0, static_cast<int>(thread.openEvents.size()) - 1});
+}
+
+void nProfileEndScope() {
+    NProfileThread& thread = currentThread();
+    double time = glfwGetTime();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    NGL_ASSERT(!thread.openEvents.empty());
+    thread.events[thread.openEvents.back() - thread.trimmedCount].endTime = time;
+    thread.openEvents.pop_back();
+}
+
+void nProfileOnPassStats(const std::vector<NPassStats>& passStats) {
+    // Devices keep reporting the latest frame they have results for until a newer one is available
+    if (passStats.empty() || passStats.front().startTime <= gLastGpuFrameStartTime) {
+        return;
+    }
+    gLastGpuFrameStartTime = passStats.front().startTime;
+
+    NProfileThread& thread = gpuThread();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    for (const NPassStats& stats : passStats) {
+        thread.events.push_back({stats.name, stats.startTime, stats.startTime + stats.gpuTime, stats.isScope ? 1 : 0});
+    }
+}
+
+void nProfileEndFrame() {
+    double time = glfwGetTime();
+    gFrameEndTimes.push_back(time);
+    while (gFrameEndTimes.front() < time - kSummaryWindow) {
+        gFrameEndTimes.pop_front();
+    }
+
+    std::lock_guard<std::mutex> threadsLock(gThreadsMutex);
+    for (std::unique_ptr<NProfileThread>& thread : gThreads) {
+        std::lock_guard<std::mutex> lock(thread->mutex);
+        // Stops at the oldest open scope, its nested scopes are kept with it
+        while (!thread->events.empty() && thread->events.front().endTime >= 0 &&
+               thread->events.front().endTime < time - kEventLifetime) {
+            thread->events.pop_front();
+            thread->trimmedCount++;
+        }
+    }
+}
+
+std::string nProfileSummary() {
+    double time = glfwGetTime();
+    double frameCount = static_cast<double>(std::max<size_t>(gFrameEndTimes.size(), 1));
+
+    std::string summary;
+    std::lock_guard<std::mutex> threadsLock(gThreadsMutex);
+    for (std::unique_ptr<NProfileThread>& thread : gThreads) {
+        std::lock_guard<std::mutex> lock(thread->mutex);
+        // Time per name, in the order names were first seen
+        std::vector<std::pair<std::string, double>> times;
+        for (const NProfileEvent& event : thread->events) {
+            if (event.endTime < time - kSummaryWindow || event.depth > kSummaryDepth) {
+                continue;
+            }
+            auto it = std::find_if(times.begin(), times.end(),
+                                   [&](const auto& entry) { return entry.first == event.name; });
+            if (it == times.end()) {
+                it = times.insert(times.end(), {event.name, 0.0});
+            }
+            it->second += event.endTime - event.startTime;
+        }
+        if (times.empty()) {
+            continue;
+        }
+
+        char text[128];
+        snprintf(text, sizeof(text), "%s%s:", summary.empty() ? "" : " | ", thread->name ? thread->name : "Thread");
+        summary += text;
+        for (const auto& [name, totalTime] : times) {
+            snprintf(text, sizeof(text), " %s %0.2fms", name.c_str(), totalTime / frameCount * 1000.0);
+            summary += text;
+        }
+    }
+    return summary;
+}
+
+bool nProfileWriteChromeTrace(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+        return false;
+    }
+
+    // Times in microseconds, a single process with a track per thread
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool isFirst = true;
+    std::lock_guard<std::mutex> threadsLock(gThreadsMutex);
+    for (std::unique_ptr<NProfileThread>& thread : gThreads) {
+        std::lock_guard<std::mutex> lock(thread->mutex);
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                isFirst ? "" : ",\n", thread->id);
+        if (thread->name != nullptr) {
+            writeEscaped(file, thread->name);
+        } else {
+            fprintf(file, "Thread %d", thread->id);
+        }
+        fprintf(file, "\"}}");
+        isFirst = false;
+
+        for (const NProfileEvent& event : thread->events) {
+            if (event.endTime < 0) {
+                continue;
+            }
+            fprintf(file, ",\n{\"name\":\"");
+            writeEscaped(file, event.name);
+            fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%0.3f,\"dur\":%0.3f}", thread->id,
+                    event.startTime * 1e6, (event.endTime - event.startTime) * 1e6);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    bool isWritten = ferror(file) == 0;
+    fclose(file);
+    NGL_LOGI("Profile written to %s", path.c_str());
+    return isWritten;
+}
+
+NProfileThread& currentThread() {
+    if (tThread == nullptr) {
+        std::lock_guard<std::mutex> lock(gThreadsMutex);
+        gThreads.push_back(std::make_unique<NProfileThread>());
+        tThread = gThreads.back().get();
+        tThread->id = static_cast<int>(gThreads.size());
+    }
+    return *tThread;
+}
+
+NProfileThread& gpuThread() {
+    // Not a real thread, a track of its own in the trace
+    static NProfileThread* thread = [] {
+        std::lock_guard<std::mutex> lock(gThreadsMutex);
+        gThreads.push_back(std::make_unique<NProfileThread>());
+        gThreads.back()->name = "GPU";
+        gThreads.back()->id = static_cast<int>(gThreads.size());
+        return gThreads.back().get();
+    }();
+    return *thread;
+}
+
+void writeEscaped(FILE* file, const char* text) {
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "nrender.h"
+
+// Frame profiler. CPU work is measured with scope markers on any thread, GPU work comes from the timestamp queries
+// of the render device (NPassStats). Events of the last few seconds are kept, for a summary shown in the window title
+// and for export to the Chrome trace format (chrome://tracing, ui.perfetto.dev).
+//
+// Build with NGL_PROFILE_ENABLED=0 to compile the markers out.
+
+#ifndef NGL_PROFILE_ENABLED
+#define NGL_PROFILE_ENABLED 1
+#endif
+
+#if NGL_PROFILE_ENABLED
+#define NGL_PROFILE_CONCAT_(a, b) a##b
+#define NGL_PROFILE_CONCAT(a, b) NGL_PROFILE_CONCAT_(a, b)
+// Measures the enclosing scope, name must outlive the profiler, e.g. a string literal
+#define NGL_PROFILE_SCOPE(name) NProfileScope NGL_PROFILE_CONCAT(nglProfileScope, __LINE__)(name)
+#else
+#define NGL_PROFILE_SCOPE(name) \
+    do {                        \
+    } while (false)
+#endif
+
+// Names the calling thread in the trace, name must outlive the profiler
+void nProfileSetThreadName(const char* name);
+void nProfileBeginScope(const char* name);
+void nProfileEndScope();
+
+// Call once per frame on the main thread with NRenderDevice::passStats()
+void nProfileOnPassStats(const std::vector<NPassStats>& passStats);
+// Call once per frame on the main thread, drops old events
+void nProfileEndFrame();
+
+// Average time per frame of the top-level CPU scopes of each thread and of the GPU passes, over the last second
+std::string nProfileSummary();
+// Writes the kept events as Chrome trace JSON. Returns false if the file cannot be written.
+bool nProfileWriteChromeTrace(const std::string& path);
+
+class NProfileScope {
+public:
+    NProfileScope(const char* name) {
+        nProfileBeginScope(name);
+    }
+    NProfileScope(const NProfileScope&) = delete;
+    NProfileScope& operator=(const NProfileScope&) = delete;
+    NProfileScope(NProfileScope&&) = delete;
+    NProfileScope& operator=(NProfileScope&&) = delete;
+    ~NProfileScope() {
+        nProfileEndScope();
+    }
+};
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Soldier cascades fit to the camera frustum, followed by one cascade covering the whole terrain
+constexpr int kNSoldierCascadeCount = 3;
+constexpr int kNShadowCascadeCount = kNSoldierCascadeCount + 1;
+
+// Per-frame uniform block (std140). Must match FrameUniform in nglvert.h, nglfrag.h, vertex.glsl and fragment.glsl.
+struct NFrameUniform {
+    glm::mat4 model_view_matrix;
+    glm::mat4 projection_matrix;
+    glm::mat4 shadow_matrices[kNShadowCascadeCount];  // world to light clip space
+    glm::vec4 cascade_splits;                         // view-space far distance of each soldier cascade
+    glm::vec4 light_vector;                           // towards the light, w unused
+    float time;
+    int32_t is_wireframe_enabled;
+};
+
+// Looping clips baked into a model's animation texture, kNAnimationFrameCount rows each in this order, see nanim.h
+enum class NAnimation : uint32_t {
+    kWalk,  // two steps
+    kIdle,
+    kAttack,
+    kCount,
+};
+constexpr uint32_t kNAnimationFrameCount = 32;
+// NInstance::animation of a soldier drawn as the static mesh, with a whole-body swing for a walk
+constexpr uint32_t kNStaticPose = UINT32_MAX;
+
+// Placement of a soldier, std430 like the vertex shaders' Instance. Instance 0 is the terrain and has no record,
+// instance i reads record i - 1.
+struct NInstance {
+    glm::vec3 position;  // of the feet
+    float heightScale;   // the soldier is stretched vertically by 1 + heightScale
+    glm::vec2 heading;   // ground direction (x, z) the soldier faces, unit length
+    float phase;         // of the animation, from 0 to 1
+    uint32_t animation;  // NAnimation or kNStaticPose
+};
+static_assert(sizeof(NInstance) == 32, "NInstance must match the vertex shaders");
+
+constexpr uint32_t kNMaxInstanceCount = 16384;
+
+constexpr uint32_t kNInvalidIndex = UINT32_MAX;
+
+// Index into one of the resource tables of an NRenderDevice. The tag only keeps the handle kinds apart.
+template <typename Tag>
+struct NHandle {
+    uint32_t index = kNInvalidIndex;
+
+    bool isValid() const {
+        return index != kNInvalidIndex;
+    }
+    bool operator==(NHandle other) const {
+        return index == other.index;
+    }
+    bool operator!=(NHandle other) const {
+        return index != other.index;
+    }
+};
+
+using NBufferHandle = NHandle<struct NBufferTag>;
+using NTextureHandle = NHandle<struct NTextureTag>;
+using NPipelineHandle = NHandle<struct NPipelineTag>;
+
+// Stands for the image presented this frame wherever a texture handle is expected
+constexpr NTextureHandle kNBackbuffer = {kNInvalidIndex - 1};
+
+// Slots of the textures visible to every draw, see NRenderDevice::setGlobalTexture()
+constexpr uint32_t kNShadowCascadeSlot = 0;  // one slot per cascade
+constexpr uint32_t kNAnimationSlot = kNShadowCascadeSlot + kNShadowCascadeCount;  // of the soldier, kRgba32F
+constexpr uint32_t kNSkinSlot = kNAnimationSlot + 1;                              // of the soldier, kRgba32F
+constexpr uint32_t kNGlobalTextureCount = kNSkinSlot + 1;
+
+enum class NBufferUsage {
+    kVertex,  // NglVertex
+    kIndex,   // uint32_t
+};
+
+enum class NTextureFormat {
+    kRgba8,  // 8-bit color
+    kR32F,   // terrain heights, a backend may store them with less precision
+    kDepth,  // depth attachment, 32-bit float where supported
+    // Block compressed, 4x4 texels per block, sampled like kRgba8. See ntexfile.h.
+    kBc1,  // color without alpha, 8 bytes per block
+    kBc3,  // color and alpha, 16 bytes per block
+    kBc5,  // two channels, e.g. normals, 16 bytes per block
+    kBc7,  // color and alpha, 16 bytes per block, the best quality
+    // 32-bit float RGBA, data fetched by the shaders without filtering such as baked animations
+    kRgba32F,
+};
+
+inline bool nIsBlockCompressed(NTextureFormat format) {
+    return format == NTextureFormat::kBc1 || format == NTextureFormat::kBc3 || format == NTextureFormat::kBc5 ||
+           format == NTextureFormat::kBc7;
+}
+
+// Bytes of one level, in whole blocks for block compressed formats
+inline size_t nTextureLevelSize(NTextureFormat format, int width, int height) {
+    size_t blockCount = static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4);
+    switch (format) {
+        case NTextureFormat::kBc1:
+            return blockCount * 8;
+        case NTextureFormat::kBc3:
+        case NTextureFormat::kBc5:
+        case NTextureFormat::kBc7:
+            return blockCount * 16;
+        case NTextureFormat::kRgba32F:
+            return static_cast<size_t>(width) * height * 16;
+        default:
+            return static_cast<size_t>(width) * height * 4;
+    }
+}
+
+// Levels of a full mip chain, down to 1x1
+inline int nFullLevelCount(int width, int height) {
+    int levelCount = 1;
+    while ((std::max(width, height) >> levelCount) > 0) {
+        levelCount++;
+    }
+    return levelCount;
+}
+
+// Textures with more than one level are sampled trilinear and anisotropic
+struct NTextureDesc {
+    NTextureFormat format;
+    int width;
+    int height;
+    const void* pixels;  // tightly packed rows, then the smaller levels if any, each half the size of the previous one
+    const char* label;
+    int levelCount = 1;            // in pixels
+    bool generatesLevels = false;  // kRgba8, the device generates a full chain from the single level in pixels
+};
+
+struct NRenderTargetDesc {
+    NTextureFormat format;
+    int width;
+    int height;
+    const char* label;
+};
+
+struct NMemoryRequirements {
+    uint64_t size = 0;
+    uint64_t alignment = 1;
+    uint32_t typeBits = ~0u;  // backend specific compatibility mask, targets sharing memory must have a common bit
+};
+
+// How a texture is used by a pass. Backends derive layouts, pipeline stages and access masks from it.
+enum class NResourceState {
+    kUndefined,  // contents may be discarded
+    kTransferDst,
+    kShaderRead,  // sampled in the vertex or fragment shader
+    kColorAttachment,
+    kDepthAttachment,  // depth test and write
+    kDepthRead,        // depth test only
+    kPresent,
+};
+
+struct NBarrier {
+    NTextureHandle texture;
+    NResourceState before;
+    NResourceState after;
+};
+
+// Shader program of a pipeline. Each backend maps it to its own sources. kScene reads NglVertex vertices, the
+// depth-only shaders read tightly packed glm::vec3 positions.
+enum class NShader {
+    kScene,   // nglvert.h + nglgeom.h + nglfrag.h, vertex.glsl + fragment.glsl
+    kShadow,  // the same sources built with SHADOW_PASS, depth only
+    kDepth,   // the same sources built with DEPTH_PASS, depth only, for the depth prepass
+};
+
+enum class NCompareOp {
+    kLess,
+    kEqual,  // after a depth prepass, only the visible fragments are shaded
+};
+
+struct NPipelineDesc {
+    NShader shader = NShader::kScene;
+    bool hasColorTarget = true;  // backbuffer format
+    bool hasDepthTarget = true;  // kDepth
+    bool depthTest = true;
+    bool depthWrite = true;
+    NCompareOp depthCompareOp = NCompareOp::kLess;
+    bool cullBackFaces = true;
+    // In units of the smallest resolvable depth difference, and per unit of depth slope
+    float depthBiasConstant = 0.0f;
+    float depthBiasSlope = 0.0f;
+};
+
+enum class NLoadOp {
+    kLoad,  // keep the contents, becomes kDontCare when there is nothing to keep
+    kClear,
+    kDontCare,
+};
+
+struct NPassDesc {
+    const char* name;
+    NLoadOp colorLoadOp = NLoadOp::kClear;
+    NLoadOp depthLoadOp = NLoadOp::kClear;
+    glm::vec4 clearColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float clearDepth = 1.0f;
+};
+
+// Attachments of a pass as resolved by NFrameGraph
+struct NPassTargets {
+    NTextureHandle color;  // kNBackbuffer or a render target, invalid if the pass has no color attachment
+    NTextureHandle depth;
+    NLoadOp colorLoadOp = NLoadOp::kDontCare;
+    NLoadOp depthLoadOp = NLoadOp::kDontCare;
+    bool storeColor = true;  // false if nothing reads the attachment after the pass
+    bool storeDepth = true;
+    bool isDepthReadOnly = false;
+    glm::ivec2 size = glm::ivec2(0, 0);
+};
+
+// Indexed, instanced draw, see NShader for the vertex format. Besides the global textures the shaders see the draw's
+// material texture. The shaders treat base instance 0 as terrain and instances from 1 on as soldiers.
+struct NDraw {
+    NPipelineHandle pipeline;
+    NBufferHandle vertexBuffer;
+    NBufferHandle indexBuffer;
+    NTextureHandle texture;
+    uint32_t indexCount = 0;
+    uint32_t instanceCount = 1;
+    uint32_t firstInstance = 0;
+    uint32_t cascade = 0;  // shadow cascade rendered by kShadow pipelines
+};
+
+// Draws [firstDraw, endDraw) of a command list
+struct NCommandScope {
+    const char* name;
+    uint32_t firstDraw;
+    uint32_t endDraw;
+};
+
+// GPU cost of one pass, or of a scope of its command list, measured with timestamp and pipeline statistics queries.
+// A pass is followed by the scopes of its command list.
+struct NPassStats {
+    const char* name;  // NPassDesc::name or NCommandScope::name
+    bool isScope;
+    // Start on the CPU clock (glfwGetTime). The GPU clock is not calibrated against it: the first pass of a frame
+    // is placed where the frame was submitted, the rest keep their GPU offsets to it.
+    double startTime;
+    double gpuTime;
+    // Debug counter for overdraw: fragment shader invocations per pixel of the pass's targets, -1 if the device
+    // cannot count them
+    double overdraw;
+};
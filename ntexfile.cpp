@@ -0,0 +1,101 @@
+#include "ntexfile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "ngllog.h"
+
+static_assert(sizeof(NTextureFileHeader) == 24, "NTextureFileHeader is part of the file format");
+static_assert(sizeof(NTextureFileLevel) == 16, "NTextureFileLevel is part of the file format");
+
+bool nParseTextureFile(const char* data, size_t size, const char* label, NTextureFile& file) {
+    NTextureFileHeader header{};
+    bool isValid = size >= sizeof(header);
+    if (isValid) {
+        memcpy(&header, data, sizeof(header));
+        isValid = memcmp(header.magic, kNTextureFileMagic, sizeof(kNTextureFileMagic)) == 0 &&
+                  header.version == kNTextureFileVersion &&
+                  nIsBlockCompressed(static_cast<NTextureFormat>(header.format)) && header.width > 0 &&
+                  header.height > 0 && header.width <= INT32_MAX && header.height <= INT32_MAX &&
+                  header.levelCount > 0 && header.levelCount <= 32 &&
+                  (std::max(header.width, header.height) >> (header.levelCount - 1)) > 0 &&
+                  header.levelCount <= (size - sizeof(header)) / sizeof(NTextureFileLevel);
+    }
+    // The levels must follow each other, with the sizes their format and dimensions give
+    NTextureFormat format = static_cast<NTextureFormat>(header.format);
+    uint64_t levelsOffset = 0;
+    uint64_t expectedOffset = 0;
+    for (uint32_t i = 0; isValid && i < header.levelCount; i++) {
+        NTextureFileLevel level;
+        memcpy(&level, data + sizeof(header) + i * sizeof(level), sizeof(level));
+        int levelWidth = std::max(static_cast<int>(header.width >> i), 1);
+        int levelHeight = std::max(static_cast<int>(header.height >> i), 1);
+        if (i == 0) {
+            levelsOffset = level.offset;
+            expectedOffset = level.offset;
+        }
+        isValid = level.offset == expectedOffset && level.offset <= size && level.size <= size - level.offset &&
+                  level.size == nTextureLevelSize(format, levelWidth, levelHeight);
+        expectedOffset = level.offset + level.size;
+    }
+    if (!isValid) {
+        NGL_LOGE("%s is not a texture file", label);
+        return false;
+    }
+
+    file.format = format;
+    file.width = static_cast<int>(header.width);
+    file.height = static_cast<int>(header.height);
+    file.levelCount = static_cast<int>(header.levelCount);
+    file.levels = data + levelsOffset;
+    file.size = static_cast<size_t>(expectedOffset - levelsOffset);
+    return true;
+}
+
+bool nWriteTextureFile(const std::string& path, NTextureFormat format, int width, int height,
+                       const std::vector<std::vector<unsigned char>>& levels) {
+    NTextureFileHeader header{};
+    memcpy(header.magic, kNTextureFileMagic, sizeof(kNTextureFileMagic));
+    header.version = kNTextureFileVersion;
+    header.format = static_cast<uint32_t>(format);
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.levelCount = static_cast<uint32_t>(levels.size());
+
+    uint64_t indexEnd = sizeof(header) + levels.size() * sizeof(NTextureFileLevel);
+    uint64_t offset = (indexEnd + kNTextureFileAlignment - 1) / kNTextureFileAlignment * kNTextureFileAlignment;
+    std::vector<NTextureFileLevel> index;
+    for (const std::vector<unsigned char>& level : levels) {
+        index.push_back({offset, level.size()});
+        offset += level.size();
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+        return false;
+    }
+    static const char kZeros[kNTextureFileAlignment] = {};
+    size_t paddingSize = static_cast<size_t>(index.empty() ? 0 : index[0].offset - indexEnd);
+    bool isWritten = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                     fwrite(index.data(), sizeof(NTextureFileLevel), index.size(), file) == index.size() &&
+                     (paddingSize == 0 || fwrite(kZeros, paddingSize, 1, file) == 1);
+    for (const std::vector<unsigned char>& level : levels) {
+        isWritten = isWritten && fwrite(level.data(), level.size(), 1, file) == 1;
+    }
+    isWritten = fclose(file) == 0 && isWritten;
+    if (!isWritten) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+    }
+    return isWritten;
+}
+
+std::string nTextureFilePath(const std::string& path) {
+    size_t separator = path.find_last_of("/\\");
+    size_t extension = path.find_last_of('.');
+    if (extension == std::string::npos || (separator != std::string::npos && extension < separator)) {
+        return path + ".ntex";
+    }
+    return path.substr(0, extension) + ".ntex";
+}
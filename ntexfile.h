@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nrender.h"
+
+// Texture file written by nwar-texc: block compressed levels, ready to be uploaded as they are. Laid out after KTX2,
+// without what nwar has no use for (array layers, cube faces, supercompression, the data format descriptor).
+// Little-endian:
+//
+//   NTextureFileHeader
+//   NTextureFileLevel[levelCount]  largest level first
+//   level data                     from a multiple of kNTextureFileAlignment, the levels one after the other
+//
+// NAssetService loads name.ntex in place of the name.png or name.glb texture it was made from, see
+// nTextureFilePath().
+
+constexpr char kNTextureFileMagic[4] = {'N', 'T', 'E', 'X'};
+constexpr uint32_t kNTextureFileVersion = 1;
+constexpr uint64_t kNTextureFileAlignment = 16;
+
+struct NTextureFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;  // NTextureFormat, block compressed
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+};
+
+struct NTextureFileLevel {
+    uint64_t offset;  // from the start of the file
+    uint64_t size;
+};
+
+// A texture file's contents, pointing into the file's data
+struct NTextureFile {
+    NTextureFormat format = NTextureFormat::kBc7;
+    int width = 0;
+    int height = 0;
+    int levelCount = 0;
+    const char* levels = nullptr;  // all of them, as NTextureDesc::pixels
+    size_t size = 0;               // of all levels
+};
+
+// Returns false, and logs why, if data is not a texture file this build can read
+bool nParseTextureFile(const char* data, size_t size, const char* label, NTextureFile& file);
+// levels are largest first, each half the size of the previous one. Returns false if the file cannot be written.
+bool nWriteTextureFile(const std::string& path, NTextureFormat format, int width, int height,
+                       const std::vector<std::vector<unsigned char>>& levels);
+
+// The texture file standing in for an image or a model's texture, the path with a .ntex extension
+std::string nTextureFilePath(const std::string& path);
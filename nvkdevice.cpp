@@ -0,0 +1,1895 @@
+#include "nvkdevice.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+//
+#include "nvkvk.h"
+//
+
+#include "NglVertex.h"
+#include "NvkBuffer.h"
+#include "NvkContext.h"
+#include "NvkTexture.h"
+#include "nfile.h"
+#include "nglassert.h"
+#include "ngllog.h"
+#include "nprofile.h"
+#include "nvkdbg.h"
+#include "nvkerr.h"
+#include "nvkstate.h"
+#include "nvkutil.h"
+
+constexpr uint32_t kWidth = 1920;
+constexpr uint32_t kHeight = 1080;
+const std::vector<const char*> kDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+constexpr int kMaxFramesInFlight = 2;
+constexpr uint32_t kMaxTextureCount = 32;  // one material descriptor set each
+constexpr uint32_t kMaxTimedRangeCount = 32;  // passes and scopes per frame, those beyond are not timed
+constexpr uint32_t kUntimedRange = UINT32_MAX;
+
+// Maps OpenGL clip space (y up, z in [-1, 1]) to Vulkan clip space (y down, z in [0, 1])
+const glm::mat4 kVulkanClip = glm::mat4(1.0f, 0.0f, 0.0f, 0.0f,   //
+                                        0.0f, -1.0f, 0.0f, 0.0f,  //
+                                        0.0f, 0.0f, 0.5f, 0.0f,   //
+                                        0.0f, 0.0f, 0.5f, 1.0f);
+
+class NvkRenderDevice : public NRenderDevice {
+public:
+    NvkRenderDevice(bool isHeadless) : mIsHeadless(isHeadless) {
+        initWindow();
+        initVulkan();
+    }
+
+    ~NvkRenderDevice() override {
+        terminate();
+    }
+
+    const char* name() const override {
+        return "Vulkan";
+    }
+
+    GLFWwindow* window() const override {
+        return mWindow;
+    }
+
+    glm::ivec2 backbufferSize() const override {
+        return glm::ivec2(mSwapchainExtent.width, mSwapchainExtent.height);
+    }
+
+    NBufferHandle createBuffer(NBufferUsage usage, const void* data, size_t size) override {
+        VkBufferUsageFlags usageFlags =
+                usage == NBufferUsage::kVertex ? VK_BUFFER_USAGE_VERTEX_BUFFER_BIT : VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        mBuffers.push_back(std::make_unique<NvkBuffer>(*mContext, data, size, usageFlags));
+        return {static_cast<uint32_t>(mBuffers.size() - 1)};
+    }
+
+    NTextureHandle createTexture(const NTextureDesc& desc) override {
+        uint32_t width = static_cast<uint32_t>(desc.width);
+        uint32_t height = static_cast<uint32_t>(desc.height);
+        std::unique_ptr<NvkTexture> texture;
+        uint32_t levelCount = static_cast<uint32_t>(desc.levelCount);
+        NGL_ASSERT(!desc.generatesLevels || (desc.format == NTextureFormat::kRgba8 && levelCount == 1));
+        // Levels are blitted, without linear blits the texture keeps its single level
+        bool generatesLevels = desc.generatesLevels && isLinearBlitSupported(toVkTextureFormat(desc.format));
+        switch (desc.format) {
+            case NTextureFormat::kRgba8:
+            case NTextureFormat::kRgba32F:
+            case NTextureFormat::kBc1:
+            case NTextureFormat::kBc3:
+            case NTextureFormat::kBc5:
+            case NTextureFormat::kBc7: {
+                NGL_ASSERT(isTextureFormatSupported(desc.format));
+                VkFormat format = toVkTextureFormat(desc.format);
+                VkDeviceSize size = 0;
+                for (uint32_t level = 0; level < levelCount; level++) {
+                    size += nvkImageLevelSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+                }
+                uint32_t imageLevelCount =
+                        generatesLevels ? static_cast<uint32_t>(nFullLevelCount(desc.width, desc.height)) : levelCount;
+                texture = std::make_unique<NvkTexture>(*mContext, desc.pixels, size, width, height, imageLevelCount,
+                                                       generatesLevels, format, desc.label);
+                break;
+            }
+            case NTextureFormat::kR32F: {
+                // Half floats: R32_SFLOAT is not guaranteed to support linear filtering
+                NGL_ASSERT(levelCount == 1);
+                const float* values = static_cast<const float*>(desc.pixels);
+                std::vector<uint16_t> halfValues(size_t{width} * height);
+                for (size_t i = 0; i < halfValues.size(); i++) {
+                    halfValues[i] = glm::packHalf1x16(values[i]);
+                }
+                texture = std::make_unique<NvkTexture>(*mContext, halfValues.data(),
+                                                       halfValues.size() * sizeof(uint16_t), width, height, 1, false,
+                                                       toVkTextureFormat(desc.format), desc.label);
+                break;
+            }
+            case NTextureFormat::kDepth:
+                NGL_ABORT("Depth texture %s can only be a render target", desc.label);
+        }
+        return addTexture(std::move(texture));
+    }
+
+    bool isTextureFormatSupported(NTextureFormat format) const override {
+        switch (format) {
+            case NTextureFormat::kRgba8:
+            case NTextureFormat::kR32F:
+            case NTextureFormat::kRgba32F:
+                return true;
+            case NTextureFormat::kDepth:
+                return false;
+            case NTextureFormat::kBc1:
+            case NTextureFormat::kBc3:
+            case NTextureFormat::kBc5:
+            case NTextureFormat::kBc7: {
+                if (!mIsTextureCompressionBcEnabled) {
+                    return false;
+                }
+                VkFormatProperties properties;
+                vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, toVkTextureFormat(format), &properties);
+                VkFormatFeatureFlags features =
+                        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+                return (properties.optimalTilingFeatures & features) == features;
+            }
+        }
+        return false;
+    }
+
+    bool isLinearBlitSupported(VkFormat format) const {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, format, &properties);
+        VkFormatFeatureFlags features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        return (properties.optimalTilingFeatures & features) == features;
+    }
+
+    NPipelineHandle createPipeline(const NPipelineDesc& desc) override {
+        mPipelines.push_back(createGraphicsPipeline(desc));
+        return {static_cast<uint32_t>(mPipelines.size() - 1)};
+    }
+
+    NMemoryRequirements getRenderTargetMemoryRequirements(const NRenderTargetDesc& desc) override {
+        VkFormat format = toVkFormat(desc.format);
+        VkImage image = mContext->createImage(static_cast<uint32_t>(desc.width), static_cast<uint32_t>(desc.height), 1,
+                                              format, VK_IMAGE_TILING_OPTIMAL, renderTargetUsage(format));
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(mDevice, image, &memoryRequirements);
+        vkDestroyImage(mDevice, image, nullptr);
+
+        NMemoryRequirements requirements;
+        requirements.size = memoryRequirements.size;
+        requirements.alignment = memoryRequirements.alignment;
+        requirements.typeBits = memoryRequirements.memoryTypeBits;
+        return requirements;
+    }
+
+    void allocateTransientMemory(const NMemoryRequirements& requirements) override {
+        if (mTransientMemory != VK_NULL_HANDLE) {
+            vkFreeMemory(mDevice, mTransientMemory, nullptr);
+            mTransientMemory = VK_NULL_HANDLE;
+        }
+        if (requirements.size == 0) {
+            return;
+        }
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex =
+                mContext->findMemoryType(requirements.typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        NVK_CHECK(vkAllocateMemory(mDevice, &allocInfo, nullptr, &mTransientMemory));
+        NGL_LOGI("mTransientMemory: %p, size: %llu", reinterpret_cast<void*>(mTransientMemory),
+                 static_cast<unsigned long long>(requirements.size));
+    }
+
+    NTextureHandle createTransientRenderTarget(const NRenderTargetDesc& desc, uint64_t offset) override {
+        NGL_ASSERT(mTransientMemory != VK_NULL_HANDLE);
+        VkFormat format = toVkFormat(desc.format);
+        return addTexture(std::make_unique<NvkTexture>(
+                *mContext, static_cast<uint32_t>(desc.width), static_cast<uint32_t>(desc.height), format,
+                renderTargetUsage(format), mTransientMemory, offset, desc.label));
+    }
+
+    NTextureHandle createRenderTarget(const NRenderTargetDesc& desc) override {
+        VkFormat format = toVkFormat(desc.format);
+        auto texture = std::make_unique<NvkTexture>(*mContext, static_cast<uint32_t>(desc.width),
+                                                    static_cast<uint32_t>(desc.height), format,
+                                                    renderTargetUsage(format), VK_NULL_HANDLE, 0, desc.label);
+        mContext->transitionImageLayout(texture->image(), format, NResourceState::kUndefined,
+                                        NResourceState::kShaderRead);
+        return addTexture(std::move(texture));
+    }
+
+    void destroyTexture(NTextureHandle texture) override {
+        // The caller guarantees the GPU is done with the texture
+        destroyFramebuffers(mTextures[texture.index]->view());
+        mTextures[texture.index].reset();
+        mFreeTextureSlots.push_back(texture.index);
+    }
+
+    void setGlobalTexture(uint32_t slot, NTextureHandle texture) override {
+        // The frame descriptor sets may still be in use by frames in flight
+        NVK_CHECK(vkDeviceWaitIdle(mDevice));
+
+        // Binding 2 holds the array of shadow cascades, bindings 3 and 4 the animation and skin textures. Those are
+        // fetched texel by texel, the shadow sampler does no harm.
+        NGL_ASSERT(slot >= kNShadowCascadeSlot && slot < kNGlobalTextureCount);
+        bool isShadowCascade = slot < kNShadowCascadeSlot + kNShadowCascadeCount;
+        uint32_t binding = isShadowCascade ? 2 : 3 + (slot - kNAnimationSlot);
+        uint32_t arrayElement = isShadowCascade ? slot - kNShadowCascadeSlot : 0;
+        for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+            writeImageDescriptor(mDescriptorSets[i], binding, arrayElement, mTextures[texture.index]->view(),
+                                 mShadowSampler);
+        }
+        mGlobalTextures[slot] = texture;
+    }
+
+    bool beginFrame(const NFrameUniform& frameUniform) override {
+        for (NTextureHandle globalTexture : mGlobalTextures) {
+            NGL_ASSERT(globalTexture.isValid());
+        }
+        mFrameWaitTime = 0;
+
+        double waitStartTime = glfwGetTime();
+        NVK_CHECK(vkWaitForFences(mDevice, 1, &mInFlightFences[mCurrentFrame], VK_TRUE, UINT64_MAX));
+        mFrameWaitTime += glfwGetTime() - waitStartTime;
+        if (!mTimedRanges[mCurrentFrame].empty()) {
+            // The fence guarantees the results are available
+            readPassStats();
+            mTimedRanges[mCurrentFrame].clear();
+        }
+
+        if (!mIsHeadless) {
+            waitStartTime = glfwGetTime();
+            VkResult result = vkAcquireNextImageKHR(mDevice, mSwapchain, UINT64_MAX,
+                                                    mImageAvailableSemaphores[mCurrentFrame], VK_NULL_HANDLE,
+                                                    &mImageIndex);
+            mFrameWaitTime += glfwGetTime() - waitStartTime;
+            if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+                recreateSwapchain();
+                return false;
+            } else {
+                NGL_VERIFY(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR);
+            }
+        }
+
+        NVK_CHECK(vkResetFences(mDevice, 1, &mInFlightFences[mCurrentFrame]));
+
+        NVK_CHECK(vkResetCommandBuffer(mCommandBuffers[mCurrentFrame], 0));
+
+        VkCommandBufferBeginInfo bufferBeginInfo{};
+        bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        bufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        bufferBeginInfo.pInheritanceInfo = nullptr;  // Optional
+        NVK_CHECK(vkBeginCommandBuffer(mCommandBuffers[mCurrentFrame], &bufferBeginInfo));
+        if (mTimestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(mCommandBuffers[mCurrentFrame], mTimestampQueryPool,
+                                mCurrentFrame * kMaxTimedRangeCount * 2, kMaxTimedRangeCount * 2);
+        }
+        if (mFragmentQueryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(mCommandBuffers[mCurrentFrame], mFragmentQueryPool,
+                                mCurrentFrame * kMaxTimedRangeCount, kMaxTimedRangeCount);
+        }
+
+        NFrameUniform vulkanFrameUniform = frameUniform;
+        vulkanFrameUniform.projection_matrix = kVulkanClip * frameUniform.projection_matrix;
+        for (glm::mat4& shadowMatrix : vulkanFrameUniform.shadow_matrices) {
+            shadowMatrix = kVulkanClip * shadowMatrix;
+        }
+        memcpy(mUniformBufferMappedAddresses[mCurrentFrame], &vulkanFrameUniform, sizeof(vulkanFrameUniform));
+
+        return true;
+    }
+
+    void uploadInstances(const std::vector<NInstance>& instances) override {
+        NGL_ASSERT(instances.size() <= kNMaxInstanceCount);
+        // The fence waited for in beginFrame() guarantees the GPU is done with this frame's buffer
+        memcpy(mInstanceBufferMappedAddresses[mCurrentFrame], instances.data(), instances.size() * sizeof(NInstance));
+    }
+
+    void executePass(const NPassDesc& pass, const NPassTargets& targets, const std::vector<NBarrier>& barriers,
+                     const NCommandList& commandList) override {
+        VkCommandBuffer commandBuffer = mCommandBuffers[mCurrentFrame];
+        uint32_t passRange =
+                beginTimedRange({pass.name, false, static_cast<double>(targets.size.x) * targets.size.y});
+        executeBarriers(barriers);
+        bool isFragmentCounted = passRange != kUntimedRange && mFragmentQueryPool != VK_NULL_HANDLE;
+        uint32_t fragmentQuery = mCurrentFrame * kMaxTimedRangeCount + passRange;
+        if (isFragmentCounted) {
+            vkCmdBeginQuery(commandBuffer, mFragmentQueryPool, fragmentQuery, 0);
+        }
+
+        RenderPassKey renderPassKey;
+        std::vector<VkImageView> attachments;
+        std::vector<VkClearValue> clearValues;  // The order must match the order of attachments.
+        if (targets.color.isValid()) {
+            renderPassKey.colorFormat = textureFormat(targets.color);
+            renderPassKey.colorLoadOp = targets.colorLoadOp;
+            renderPassKey.storeColor = targets.storeColor;
+            attachments.push_back(textureView(targets.color));
+            VkClearValue clearValue{};
+            clearValue.color = {{pass.clearColor.r, pass.clearColor.g, pass.clearColor.b, pass.clearColor.a}};
+            clearValues.push_back(clearValue);
+        }
+        if (targets.depth.isValid()) {
+            renderPassKey.depthFormat = textureFormat(targets.depth);
+            renderPassKey.depthLoadOp = targets.depthLoadOp;
+            renderPassKey.storeDepth = targets.storeDepth;
+            renderPassKey.isDepthReadOnly = targets.isDepthReadOnly;
+            attachments.push_back(textureView(targets.depth));
+            VkClearValue clearValue{};
+            clearValue.depthStencil = {pass.clearDepth, 0};
+            clearValues.push_back(clearValue);
+        }
+        VkExtent2D extent = {static_cast<uint32_t>(targets.size.x), static_cast<uint32_t>(targets.size.y)};
+
+        VkRenderPassBeginInfo renderPassBeginInfo{};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = getRenderPass(renderPassKey);
+        renderPassBeginInfo.framebuffer = getFramebuffer(renderPassKey, attachments, extent);
+        renderPassBeginInfo.renderArea.offset = {0, 0};
+        renderPassBeginInfo.renderArea.extent = extent;
+        renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassBeginInfo.pClearValues = clearValues.data();
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = extent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0 /*frame*/, 1,
+                                &mDescriptorSets[mCurrentFrame], 0, nullptr);
+
+        // Only state that differs from the previous draw is recorded
+        NPipelineHandle boundPipeline;
+        NBufferHandle boundVertexBuffer;
+        NBufferHandle boundIndexBuffer;
+        NTextureHandle boundTexture;
+        uint32_t boundCascade = UINT32_MAX;
+        // Scopes begin before their first draw and end after their last one
+        const std::vector<NDraw>& draws = commandList.draws();
+        const std::vector<NCommandScope>& scopes = commandList.scopes();
+        size_t scopeIndex = 0;
+        uint32_t scopeRange = kUntimedRange;
+        bool isInScope = false;
+        auto updateScopes = [&](uint32_t drawIndex) {
+            while (scopeIndex < scopes.size()) {
+                const NCommandScope& scope = scopes[scopeIndex];
+                if (isInScope) {
+                    if (scope.endDraw != drawIndex) {
+                        return;
+                    }
+                    endTimedRange(scopeRange);
+                    isInScope = false;
+                    scopeIndex++;
+                } else {
+                    if (scope.firstDraw != drawIndex) {
+                        return;
+                    }
+                    scopeRange = beginTimedRange({scope.name, true, 0.0});
+                    isInScope = true;
+                }
+            }
+        };
+        for (uint32_t drawIndex = 0; drawIndex < draws.size(); drawIndex++) {
+            updateScopes(drawIndex);
+            const NDraw& draw = draws[drawIndex];
+            if (draw.pipeline != boundPipeline) {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelines[draw.pipeline.index]);
+                boundPipeline = draw.pipeline;
+            }
+            if (draw.cascade != boundCascade) {
+                // Part of the pipeline layout, pipelines other than kShadow ignore it
+                vkCmdPushConstants(commandBuffer, mPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                                   sizeof(draw.cascade), &draw.cascade);
+                boundCascade = draw.cascade;
+            }
+            if (draw.vertexBuffer != boundVertexBuffer) {
+                VkBuffer vertexBuffer = *mBuffers[draw.vertexBuffer.index];
+                VkDeviceSize offset = 0;
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+                boundVertexBuffer = draw.vertexBuffer;
+            }
+            if (draw.indexBuffer != boundIndexBuffer) {
+                vkCmdBindIndexBuffer(commandBuffer, *mBuffers[draw.indexBuffer.index], 0, VK_INDEX_TYPE_UINT32);
+                boundIndexBuffer = draw.indexBuffer;
+            }
+            if (draw.texture.isValid() && draw.texture != boundTexture) {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout,
+                                        1 /*material*/, 1, &mTextureDescriptorSets[draw.texture.index], 0, nullptr);
+                boundTexture = draw.texture;
+            }
+            vkCmdDrawIndexed(commandBuffer, draw.indexCount, draw.instanceCount, 0, 0, draw.firstInstance);
+        }
+        updateScopes(static_cast<uint32_t>(draws.size()));
+
+        vkCmdEndRenderPass(commandBuffer);
+        if (isFragmentCounted) {
+            vkCmdEndQuery(commandBuffer, mFragmentQueryPool, fragmentQuery);
+        }
+        endTimedRange(passRange);
+    }
+
+    void executeBarriers(const std::vector<NBarrier>& barriers) override {
+        if (barriers.empty()) {
+            return;
+        }
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        VkPipelineStageFlags srcStage = 0;
+        VkPipelineStageFlags dstStage = 0;
+        for (const NBarrier& barrier : barriers) {
+            NResourceState after = barrier.after;
+            if (mIsHeadless && after == NResourceState::kPresent) {
+                // The present layout needs VK_KHR_swapchain, the offscreen backbuffer stays a color attachment
+                after = NResourceState::kColorAttachment;
+            }
+            imageBarriers.push_back(nvkImageBarrier(textureImage(barrier.texture), textureFormat(barrier.texture),
+                                                    barrier.before, after));
+            srcStage |= nvkResourceState(barrier.before).stage;
+            dstStage |= nvkResourceState(after).stage;
+        }
+        vkCmdPipelineBarrier(mCommandBuffers[mCurrentFrame], srcStage, dstStage, 0, 0, nullptr, 0, nullptr,
+                             static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    void endFrame() override {
+        NVK_CHECK(vkEndCommandBuffer(mCommandBuffers[mCurrentFrame]));
+
+        VkSemaphore waitSemaphores[] = {mImageAvailableSemaphores[mCurrentFrame]};
+        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        VkSemaphore signalSemaphores[] = {mRenderFinishedSemaphores[mCurrentFrame]};
+
+        // Headless, no image is acquired or presented and the in-flight fence alone paces the frames
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = mIsHeadless ? 0 : 1;
+        submitInfo.pWaitSemaphores = waitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &mCommandBuffers[mCurrentFrame];
+        submitInfo.signalSemaphoreCount = mIsHeadless ? 0 : 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+        mSubmitTimes[mCurrentFrame] = glfwGetTime();
+        NVK_CHECK(vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mInFlightFences[mCurrentFrame]));
+        if (mIsHeadless) {
+            mCurrentFrame = (mCurrentFrame + 1) % kMaxFramesInFlight;
+            return;
+        }
+
+        VkSwapchainKHR swapChains[] = {mSwapchain};
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = signalSemaphores;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
+        presentInfo.pImageIndices = &mImageIndex;
+        presentInfo.pResults = nullptr;  // Optional
+        VkResult result;
+        {
+            NGL_PROFILE_SCOPE("Present");
+            double waitStartTime = glfwGetTime();
+            result = vkQueuePresentKHR(mPresentQueue, &presentInfo);
+            mFrameWaitTime += glfwGetTime() - waitStartTime;
+        }
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || mFramebufferResized) {
+            NGL_LOGI("Resize or swapchain incompatibility detected, recreating swapchain");
+            mFramebufferResized = false;
+            recreateSwapchain();
+        } else {
+            NGL_VERIFY(result == VK_SUCCESS);
+        }
+
+        mCurrentFrame = (mCurrentFrame + 1) % kMaxFramesInFlight;
+    }
+
+    double frameWaitTime() const override {
+        return mFrameWaitTime;
+    }
+
+    const std::vector<NPassStats>& passStats() const override {
+        return mPassStats;
+    }
+
+    void waitIdle() override {
+        NVK_CHECK(vkDeviceWaitIdle(mDevice));
+    }
+private:
+    // A pass or a scope of its command list
+    struct TimedRange {
+        const char* name;
+        bool isScope;
+        double pixelCount;  // of the pass's targets
+    };
+
+    void initWindow() {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+        if (!mIsHeadless) {
+            GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+
+            const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+            glfwWindowHint(GLFW_RED_BITS, mode->redBits);
+            glfwWindowHint(GLFW_GREEN_BITS, mode->greenBits);
+            glfwWindowHint(GLFW_BLUE_BITS, mode->blueBits);
+            glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+
+            mWindow = glfwCreateWindow(mode->width, mode->height, "N War (Vulkan)", monitor, nullptr);
+        } else {
+            mWindow = glfwCreateWindow(kWidth, kHeight, "N War (Vulkan)", nullptr, nullptr);
+        }
+
+        if (!mWindow) {
+            NGL_LOGE("glfwCreateWindow() failed");
+            abort();
+        }
+
+        glfwSetWindowUserPointer(mWindow, this);
+
+        glfwSetFramebufferSizeCallback(mWindow, [](GLFWwindow* window, int /*width*/, int /*height*/) {
+            thiz(window)->mFramebufferResized = true;
+        });
+    }
+
+    static NvkRenderDevice* thiz(GLFWwindow* window) {
+        return reinterpret_cast<NvkRenderDevice*>(glfwGetWindowUserPointer(window));
+    }
+
+    void initVulkan() {
+        createInstance();
+        nvkInitDebugIfNecessary(mInstance);
+        if (!mIsHeadless) {
+            createSurface();
+        }
+        nvkDumpPhysicalDevices(mInstance);
+        choosePhysicalDevice();
+        nvkDumpQueueFamilies(mPhysicalDevice);
+        createDevice();
+        createCommandPool();
+        mContext = std::make_unique<NvkContext>(mPhysicalDevice, mDevice, mGraphicsQueue, mCommandPool);
+        createSwapchain();
+        createSwapchainImageViews();
+        mDepthFormat = findDepthFormat();
+        NGL_LOGI("mDepthFormat: %s", nvkFormatToString(mDepthFormat));
+        createDescriptorSetLayouts();
+        createPipelineLayout();
+        nvkDumpPhysicalDeviceMemoryProperties(mPhysicalDevice);
+        createTextureSamplers();
+        createUniformBuffers();
+        createDescriptorPool();
+        createDescriptorSets();
+        createCommandBuffers();
+        createSyncObjects();
+        createTimestampQueryPool();
+    }
+
+    void createInstance() {
+        NGL_LOGI("Available instance extensions:");
+        uint32_t extensionCount;
+        NVK_CHECK(vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr));
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+        for (VkExtensionProperties extension : extensions) {
+            NGL_LOGI("  %s %u", extension.extensionName, extension.specVersion);
+        }
+
+        NGL_LOGI("Available instance layers:");
+        uint32_t layerCount;
+        NVK_CHECK(vkEnumerateInstanceLayerProperties(&layerCount, nullptr));
+        std::vector<VkLayerProperties> layers(layerCount);
+        vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+        for (VkLayerProperties layer : layers) {
+            NGL_LOGI("  %s %u %u %s", layer.layerName, layer.specVersion, layer.implementationVersion,
+                     layer.description);
+        }
+
+        VkApplicationInfo appInfo{};
+        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.pApplicationName = "N War (VK)";
+        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.pEngineName = "No Engine";
+        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.apiVersion = VK_API_VERSION_1_0;
+
+        // Headless, nothing is presented and the surface extensions are not needed
+        std::vector<const char*> requiredExtensions;
+        if (!mIsHeadless) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            if (!mWindow) {
+                NGL_LOGE("glfwGetRequiredInstanceExtensions() failed");
+                abort();
+            }
+            NGL_LOGI("Instance extensions required by GLFW:");
+            for (uint32_t i = 0; i < glfwExtensionCount; i++) {
+                NGL_LOGI("  %s", glfwExtensions[i]);
+            }
+            requiredExtensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
+        nvkAppendDebugExtensionsIfNecessary(requiredExtensions);
+        NGL_LOGI("Required instance extensions:");
+        for (const char* requiredExtension : requiredExtensions) {
+            NGL_LOGI("  %s", requiredExtension);
+        }
+
+        std::vector<const char*> requiredLayers;
+        nvkAppendDebugLayersIfNecessary(requiredLayers);
+        NGL_LOGI("Required instance layers:");
+        for (const char* requiredLayer : requiredLayers) {
+            NGL_LOGI("  %s", requiredLayer);
+        }
+
+        VkDebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo{};
+
+        VkInstanceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &appInfo;
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(requiredExtensions.size());
+        createInfo.ppEnabledExtensionNames = requiredExtensions.data();
+        createInfo.enabledLayerCount = static_cast<uint32_t>(requiredLayers.size());
+        createInfo.ppEnabledLayerNames = requiredLayers.data();
+        createInfo.pNext = nvkPopulateDebugMessengerCreateInfoIfNecessary(&debugMessengerCreateInfo);
+
+        NVK_CHECK(vkCreateInstance(&createInfo, nullptr, &mInstance));
+        NGL_LOGI("mInstance: %p", reinterpret_cast<void*>(mInstance));
+    }
+
+    void createSurface() {
+        NVK_CHECK(glfwCreateWindowSurface(mInstance, mWindow, nullptr, &mSurface));
+        NGL_LOGI("mSurface: %p", reinterpret_cast<void*>(mSurface));
+    }
+
+    void choosePhysicalDevice() {
+        uint32_t deviceCount = 0;
+        NVK_CHECK(vkEnumeratePhysicalDevices(mInstance, &deviceCount, nullptr));
+        if (deviceCount == 0) {
+            NGL_ABORT("Found no Vulkan devices");
+        }
+        std::vector<VkPhysicalDevice> devices(deviceCount);
+        vkEnumeratePhysicalDevices(mInstance, &deviceCount, devices.data());
+
+        for (const auto& device : devices) {
+            if (isDeviceSuitable(device)) {
+                mPhysicalDevice = device;
+                break;
+            }
+        }
+
+        if (mPhysicalDevice == VK_NULL_HANDLE) {
+            NGL_ABORT("Found no suitable Vulkan device");
+        }
+
+        NGL_LOGI("Chosen physical device: %p", reinterpret_cast<void*>(mPhysicalDevice));
+    }
+
+    bool isDeviceSuitable(VkPhysicalDevice device) {
+        QueueFamilyIndices queueFamilyIndices = findQueueFamilies(device);
+
+        if (!queueFamilyIndices.isComplete()) {
+            return false;
+        }
+
+        if (!checkDeviceExtensionsSupport(device)) {
+            return false;
+        }
+
+        if (!mIsHeadless) {
+            SwapchainSupportDetails swapchainSupport = querySwapchainSupport(device);
+            if (swapchainSupport.formats.empty() || swapchainSupport.presentModes.empty()) {
+                return false;
+            }
+        }
+
+        VkPhysicalDeviceFeatures physicalDeviceFeatures;
+        vkGetPhysicalDeviceFeatures(device, &physicalDeviceFeatures);
+        if (!physicalDeviceFeatures.samplerAnisotropy) {
+            return false;
+        }
+
+        return true;
+    }
+
+    struct QueueFamilyIndices {
+        std::optional<uint32_t> graphicsFamily;
+        std::optional<uint32_t> presentFamily;
+
+        bool isComplete() {
+            return graphicsFamily.has_value() && presentFamily.has_value();
+        }
+    };
+
+    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) {
+        QueueFamilyIndices result;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+        for (uint32_t i = 0; i < queueFamilyCount; i++) {
+            if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+                result.graphicsFamily = i;
+            }
+            VkBool32 presentSupport = false;
+            if (mIsHeadless) {
+                // Nothing is presented, the graphics queue stands in for the present queue
+                presentSupport = result.graphicsFamily == i;
+            } else {
+                NVK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, mSurface, &presentSupport));
+            }
+            if (presentSupport) {
+                result.presentFamily = i;
+            }
+            if (result.isComplete()) {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    bool checkDeviceExtensionsSupport(VkPhysicalDevice device) {
+        uint32_t extensionCount;
+        NVK_CHECK(vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr));
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        NVK_CHECK(vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data()));
+
+        const std::vector<const char*>& deviceExtensions = requiredDeviceExtensions();
+        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+
+        for (const auto& extension : extensions) {
+            requiredExtensions.erase(extension.extensionName);
+        }
+        return requiredExtensions.empty();
+    }
+
+    const std::vector<const char*>& requiredDeviceExtensions() const {
+        static const std::vector<const char*> kNoExtensions;
+        return mIsHeadless ? kNoExtensions : kDeviceExtensions;
+    }
+
+    void createDevice() {
+        QueueFamilyIndices indices = findQueueFamilies(mPhysicalDevice);
+
+        NGL_ASSERT(indices.graphicsFamily.has_value());
+        NGL_ASSERT(indices.presentFamily.has_value());
+
+        NGL_LOGI("graphicsFamily queue index: %u", indices.graphicsFamily.value());
+        NGL_LOGI("presentFamily queue index:  %u", indices.presentFamily.value());
+
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+
+        float queuePriority = 1.0f;
+        for (uint32_t queueFamily : uniqueQueueFamilies) {
+            VkDeviceQueueCreateInfo queueCreateInfo{};
+            queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueCreateInfo.queueFamilyIndex = queueFamily;
+            queueCreateInfo.queueCount = 1;
+            queueCreateInfo.pQueuePriorities = &queuePriority;
+            queueCreateInfos.push_back(queueCreateInfo);
+        }
+
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+        VkPhysicalDeviceFeatures deviceFeatures{};
+        deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // Optional, only feeds the overdraw counter
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+        mIsPipelineStatisticsQueryEnabled = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        // Optional, assets fall back to uncompressed textures without it
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+        mIsTextureCompressionBcEnabled = supportedFeatures.textureCompressionBC == VK_TRUE;
+
+        std::vector<const char*> requiredLayers;
+        nvkAppendDebugLayersIfNecessary(requiredLayers);
+
+        VkDeviceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+        createInfo.pQueueCreateInfos = queueCreateInfos.data();
+        createInfo.enabledLayerCount = static_cast<uint32_t>(requiredLayers.size());
+        createInfo.ppEnabledLayerNames = requiredLayers.data();
+        const std::vector<const char*>& deviceExtensions = requiredDeviceExtensions();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.pEnabledFeatures = &deviceFeatures;
+        NVK_CHECK(vkCreateDevice(mPhysicalDevice, &createInfo, nullptr, &mDevice));
+        NGL_LOGI("mDevice: %p", reinterpret_cast<void*>(mDevice));
+
+        vkGetDeviceQueue(mDevice, indices.graphicsFamily.value(), 0, &mGraphicsQueue);
+        vkGetDeviceQueue(mDevice, indices.presentFamily.value(), 0, &mPresentQueue);
+        NGL_LOGI("mGraphicsQueue: %p", reinterpret_cast<void*>(mGraphicsQueue));
+        NGL_LOGI("mPresentQueue:  %p", reinterpret_cast<void*>(mPresentQueue));
+    }
+
+    void createSwapchain() {
+        if (mIsHeadless) {
+            // A single offscreen image stands in for the swapchain images
+            mSwapchainFormat = VK_FORMAT_B8G8R8A8_SRGB;
+            mSwapchainExtent = {kWidth, kHeight};
+            mOffscreenBackbuffer = std::make_unique<NvkTexture>(
+                    *mContext, kWidth, kHeight, mSwapchainFormat,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_NULL_HANDLE, 0,
+                    "Backbuffer");
+            mSwapchainImages = {mOffscreenBackbuffer->image()};
+            NGL_LOGI("Headless, mSwapchainExtent: %u x %u", mSwapchainExtent.width, mSwapchainExtent.height);
+            return;
+        }
+
+        SwapchainSupportDetails swapchainSupport = querySwapchainSupport(mPhysicalDevice);
+        VkSurfaceFormatKHR surfaceFormat = chooseSurfaceFormat(swapchainSupport.formats);
+        VkPresentModeKHR presentMode = choosePresentMode(swapchainSupport.presentModes);
+        VkExtent2D extent = chooseExtent(swapchainSupport.capabilities);
+        uint32_t imageCount = swapchainSupport.capabilities.minImageCount + 1;
+        if (swapchainSupport.capabilities.maxImageCount > 0) {
+            imageCount = std::min(imageCount, swapchainSupport.capabilities.maxImageCount);
+        }
+
+        VkSwapchainCreateInfoKHR createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        createInfo.surface = mSurface;
+        createInfo.minImageCount = imageCount;
+        createInfo.imageFormat = surfaceFormat.format;
+        createInfo.imageColorSpace = surfaceFormat.colorSpace;
+        createInfo.imageExtent = extent;
+        createInfo.imageArrayLayers = 1;
+        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+        QueueFamilyIndices indices = findQueueFamilies(mPhysicalDevice);
+        uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+
+        if (indices.graphicsFamily != indices.presentFamily) {
+            createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = 2;
+            createInfo.pQueueFamilyIndices = queueFamilyIndices;
+        } else {
+            createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+
+        createInfo.preTransform = swapchainSupport.capabilities.currentTransform;
+        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        createInfo.presentMode = presentMode;
+        createInfo.clipped = VK_TRUE;
+        createInfo.oldSwapchain = VK_NULL_HANDLE;
+
+        NVK_CHECK(vkCreateSwapchainKHR(mDevice, &createInfo, nullptr, &mSwapchain));
+        NGL_LOGI("mSwapchain: %p", reinterpret_cast<void*>(mSwapchain));
+
+        NVK_CHECK(vkGetSwapchainImagesKHR(mDevice, mSwapchain, &imageCount, nullptr));
+        mSwapchainImages.resize(imageCount);
+        NVK_CHECK(vkGetSwapchainImagesKHR(mDevice, mSwapchain, &imageCount, mSwapchainImages.data()));
+        NGL_LOGI("mSwapchainImages:");
+        for (VkImage image : mSwapchainImages) {
+            NGL_LOGI("  %p", reinterpret_cast<void*>(image));
+        }
+
+        mSwapchainFormat = surfaceFormat.format;
+        NGL_LOGI("mSwapchainFormat: %s", nvkFormatToString(mSwapchainFormat));
+
+        mSwapchainExtent = extent;
+        NGL_LOGI("mSwapchainExtent: %u x %u", mSwapchainExtent.width, mSwapchainExtent.height);
+    }
+
+    struct SwapchainSupportDetails {
+        VkSurfaceCapabilitiesKHR capabilities;
+        std::vector<VkSurfaceFormatKHR> formats;
+        std::vector<VkPresentModeKHR> presentModes;
+    };
+
+    SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device) {
+        SwapchainSupportDetails details;
+
+        NVK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, mSurface, &details.capabilities));
+
+        uint32_t formatCount;
+        NVK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(device, mSurface, &formatCount, nullptr));
+        if (formatCount != 0) {
+            details.formats.resize(formatCount);
+            NVK_CHECK(vkGetPhysicalDeviceSurfaceFormatsKHR(device, mSurface, &formatCount, details.formats.data()));
+        }
+
+        uint32_t presentModeCount;
+        NVK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(device, mSurface, &presentModeCount, nullptr));
+        if (presentModeCount != 0) {
+            details.presentModes.resize(presentModeCount);
+            NVK_CHECK(vkGetPhysicalDeviceSurfacePresentModesKHR(device, mSurface, &presentModeCount,
+                                                                details.presentModes.data()));
+        }
+
+        NGL_LOGI("Swapchain support details for device %p surface %p:", reinterpret_cast<void*>(device),
+                 reinterpret_cast<void*>(mSurface));
+        NGL_LOGI("  Capabilities:");
+        nvkDumpSurfaceCapabilities(details.capabilities, "    ");
+        NGL_LOGI("  Formats:");
+        nvkDumpSurfaceFormats(details.formats, "    ");
+        NGL_LOGI("  Present modes:");
+        nvkDumpPresentModes(details.presentModes, "    ");
+
+        return details;
+    }
+
+    VkSurfaceFormatKHR chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
+        for (const auto& availableFormat : availableFormats) {
+            if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
+                availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+                return availableFormat;
+            }
+        }
+        return availableFormats[0];
+    }
+
+    VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& /*availablePresentModes*/) {
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+    VkExtent2D chooseExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
+        if (capabilities.currentExtent.width != (std::numeric_limits<uint32_t>::max)()) {
+            return capabilities.currentExtent;
+        } else {
+            int width, height;
+            glfwGetFramebufferSize(mWindow, &width, &height);
+            VkExtent2D actualExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+            actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width,
+                                            capabilities.maxImageExtent.width);
+            actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height,
+                                             capabilities.maxImageExtent.height);
+            return actualExtent;
+        }
+    }
+
+    void recreateSwapchain() {
+        int width = 0;
+        int height = 0;
+        glfwGetFramebufferSize(mWindow, &width, &height);
+        while (width == 0 || height == 0) {
+            NGL_LOGI("width: %d, height: %d", width, height);
+            glfwGetFramebufferSize(mWindow, &width, &height);
+            glfwWaitEvents();
+        }
+
+        vkDeviceWaitIdle(mDevice);
+
+        cleanupSwapchain();
+
+        createSwapchain();
+        createSwapchainImageViews();
+    }
+
+    void createSwapchainImageViews() {
+        NGL_LOGI("mSwapchainImageViews:");
+        mSwapchainImageViews.resize(mSwapchainImages.size());
+        for (size_t i = 0; i < mSwapchainImages.size(); i++) {
+            mSwapchainImageViews[i] =
+                    mContext->createImageView(mSwapchainImages[i], mSwapchainFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+        }
+    }
+
+    // Attachments stay in the layout of their NResourceState for the whole pass, transitions are barriers recorded by
+    // executeBarriers(). Render passes differing only in load/store ops are compatible, pipelines are created against
+    // the variant with don't care ops.
+    struct RenderPassKey {
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+        NLoadOp colorLoadOp = NLoadOp::kDontCare;
+        NLoadOp depthLoadOp = NLoadOp::kDontCare;
+        bool storeColor = false;
+        bool storeDepth = false;
+        bool isDepthReadOnly = false;
+
+        bool operator<(const RenderPassKey& other) const {
+            return std::tie(colorFormat, depthFormat, colorLoadOp, depthLoadOp, storeColor, storeDepth,
+                            isDepthReadOnly) < std::tie(other.colorFormat, other.depthFormat, other.colorLoadOp,
+                                                        other.depthLoadOp, other.storeColor, other.storeDepth,
+                                                        other.isDepthReadOnly);
+        }
+    };
+
+    VkRenderPass getRenderPass(const RenderPassKey& key) {
+        VkRenderPass& renderPass = mRenderPasses[key];
+        if (renderPass == VK_NULL_HANDLE) {
+            renderPass = createRenderPass(key);
+        }
+        return renderPass;
+    }
+
+    VkRenderPass createRenderPass(const RenderPassKey& key) {
+        std::vector<VkAttachmentDescription> attachments;
+
+        VkAttachmentReference colorAttachmentRef{};
+        if (key.colorFormat != VK_FORMAT_UNDEFINED) {
+            VkAttachmentDescription colorAttachment{};
+            colorAttachment.format = key.colorFormat;
+            colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp = toVkLoadOp(key.colorLoadOp);
+            colorAttachment.storeOp = key.storeColor ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            colorAttachmentRef.attachment = static_cast<uint32_t>(attachments.size());
+            colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachments.push_back(colorAttachment);
+        }
+
+        VkAttachmentReference depthAttachmentRef{};
+        if (key.depthFormat != VK_FORMAT_UNDEFINED) {
+            VkImageLayout depthLayout = key.isDepthReadOnly ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                                                            : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentDescription depthAttachment{};
+            depthAttachment.format = key.depthFormat;
+            depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            depthAttachment.loadOp = toVkLoadOp(key.depthLoadOp);
+            depthAttachment.storeOp = key.storeDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.initialLayout = depthLayout;
+            depthAttachment.finalLayout = depthLayout;
+
+            depthAttachmentRef.attachment = static_cast<uint32_t>(attachments.size());
+            depthAttachmentRef.layout = depthLayout;
+            attachments.push_back(depthAttachment);
+        }
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        if (key.colorFormat != VK_FORMAT_UNDEFINED) {
+            subpass.colorAttachmentCount = 1;
+            subpass.pColorAttachments = &colorAttachmentRef;
+        }
+        if (key.depthFormat != VK_FORMAT_UNDEFINED) {
+            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+        }
+
+        VkRenderPassCreateInfo renderPassCreateInfo{};
+        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassCreateInfo.pAttachments = attachments.data();
+        renderPassCreateInfo.subpassCount = 1;
+        renderPassCreateInfo.pSubpasses = &subpass;
+
+        VkRenderPass renderPass;
+        NVK_CHECK(vkCreateRenderPass(mDevice, &renderPassCreateInfo, nullptr, &renderPass));
+        NGL_LOGI("renderPass: %p", reinterpret_cast<void*>(renderPass));
+        return renderPass;
+    }
+
+    // Keyed by attachment views, so the backbuffer has one framebuffer per swapchain image
+    VkFramebuffer getFramebuffer(const RenderPassKey& key, const std::vector<VkImageView>& attachments,
+                                 VkExtent2D extent) {
+        auto views = std::make_pair(attachments.size() > 0 ? attachments[0] : VK_NULL_HANDLE,
+                                    attachments.size() > 1 ? attachments[1] : VK_NULL_HANDLE);
+        VkFramebuffer& framebuffer = mFramebuffers[views];
+        if (framebuffer != VK_NULL_HANDLE) {
+            return framebuffer;
+        }
+
+        RenderPassKey compatibleKey;
+        compatibleKey.colorFormat = key.colorFormat;
+        compatibleKey.depthFormat = key.depthFormat;
+
+        VkFramebufferCreateInfo framebufferCreateInfo{};
+        framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferCreateInfo.renderPass = getRenderPass(compatibleKey);
+        framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferCreateInfo.pAttachments = attachments.data();
+        framebufferCreateInfo.width = extent.width;
+        framebufferCreateInfo.height = extent.height;
+        framebufferCreateInfo.layers = 1;
+        NVK_CHECK(vkCreateFramebuffer(mDevice, &framebufferCreateInfo, nullptr, &framebuffer));
+        NGL_LOGI("framebuffer: %p", reinterpret_cast<void*>(framebuffer));
+        return framebuffer;
+    }
+
+    // Pass VK_NULL_HANDLE to destroy all of them
+    void destroyFramebuffers(VkImageView view) {
+        for (auto it = mFramebuffers.begin(); it != mFramebuffers.end();) {
+            if (view == VK_NULL_HANDLE || it->first.first == view || it->first.second == view) {
+                vkDestroyFramebuffer(mDevice, it->second, nullptr);
+                it = mFramebuffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    NTextureHandle addTexture(std::unique_ptr<NvkTexture> texture) {
+        if (!mFreeTextureSlots.empty()) {
+            uint32_t index = mFreeTextureSlots.back();
+            mFreeTextureSlots.pop_back();
+            writeImageDescriptor(mTextureDescriptorSets[index], 0, 0, texture->view(), mTextureSampler);
+            mTextures[index] = std::move(texture);
+            return {index};
+        }
+        NGL_VERIFY(mTextures.size() < kMaxTextureCount);
+        mTextureDescriptorSets.push_back(mContext->allocateImageDescriptorSet(
+                mDescriptorPool, mMaterialDescriptorSetLayout, texture->view(), mTextureSampler));
+        mTextures.push_back(std::move(texture));
+        return {static_cast<uint32_t>(mTextures.size() - 1)};
+    }
+
+    void writeImageDescriptor(VkDescriptorSet descriptorSet, uint32_t binding, uint32_t arrayElement, VkImageView view,
+                              VkSampler sampler) {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = view;
+        imageInfo.sampler = sampler;
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = descriptorSet;
+        descriptorWrite.dstBinding = binding;
+        descriptorWrite.dstArrayElement = arrayElement;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+    }
+
+    VkImage textureImage(NTextureHandle texture) const {
+        return texture == kNBackbuffer ? mSwapchainImages[mImageIndex] : mTextures[texture.index]->image();
+    }
+
+    VkImageView textureView(NTextureHandle texture) const {
+        return texture == kNBackbuffer ? mSwapchainImageViews[mImageIndex] : mTextures[texture.index]->view();
+    }
+
+    VkFormat textureFormat(NTextureHandle texture) const {
+        return texture == kNBackbuffer ? mSwapchainFormat : mTextures[texture.index]->format();
+    }
+
+    VkFormat toVkFormat(NTextureFormat format) const {
+        switch (format) {
+            case NTextureFormat::kRgba8:
+                // Same as the backbuffer, so the scene pipelines can render to either
+                return mSwapchainFormat;
+            case NTextureFormat::kR32F:
+                return VK_FORMAT_R32_SFLOAT;
+            case NTextureFormat::kRgba32F:
+                return VK_FORMAT_R32G32B32A32_SFLOAT;
+            case NTextureFormat::kDepth:
+                return mDepthFormat;
+            case NTextureFormat::kBc1:
+            case NTextureFormat::kBc3:
+            case NTextureFormat::kBc5:
+            case NTextureFormat::kBc7:
+                NGL_ABORT("Block compressed format %d cannot be a render target", static_cast<int>(format));
+        }
+        NGL_ABORT("Unknown texture format %d", static_cast<int>(format));
+    }
+
+    // Color textures are sRGB, like the swapchain
+    static VkFormat toVkTextureFormat(NTextureFormat format) {
+        switch (format) {
+            case NTextureFormat::kRgba8:
+                return VK_FORMAT_R8G8B8A8_SRGB;
+            case NTextureFormat::kBc1:
+                return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            case NTextureFormat::kBc3:
+                return VK_FORMAT_BC3_SRGB_BLOCK;
+            case NTextureFormat::kBc5:
+                return VK_FORMAT_BC5_UNORM_BLOCK;
+            case NTextureFormat::kBc7:
+                return VK_FORMAT_BC7_SRGB_BLOCK;
+            case NTextureFormat::kR32F:
+                return VK_FORMAT_R16_SFLOAT;  // see createTexture()
+            case NTextureFormat::kRgba32F:
+                return VK_FORMAT_R32G32B32A32_SFLOAT;
+            case NTextureFormat::kDepth:
+                break;
+        }
+        NGL_ABORT("Unexpected texture format %d", static_cast<int>(format));
+    }
+
+    static VkImageUsageFlags renderTargetUsage(VkFormat format) {
+        return (nvkIsDepthFormat(format) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                         : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) |
+               VK_IMAGE_USAGE_SAMPLED_BIT;
+    }
+
+    static VkAttachmentLoadOp toVkLoadOp(NLoadOp loadOp) {
+        switch (loadOp) {
+            case NLoadOp::kLoad:
+                return VK_ATTACHMENT_LOAD_OP_LOAD;
+            case NLoadOp::kClear:
+                return VK_ATTACHMENT_LOAD_OP_CLEAR;
+            case NLoadOp::kDontCare:
+                return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        }
+        NGL_ABORT("Unknown load op %d", static_cast<int>(loadOp));
+    }
+
+    static VkCompareOp toVkCompareOp(NCompareOp compareOp) {
+        switch (compareOp) {
+            case NCompareOp::kLess:
+                return VK_COMPARE_OP_LESS;
+            case NCompareOp::kEqual:
+                return VK_COMPARE_OP_EQUAL;
+        }
+        NGL_ABORT("Unknown compare op %d", static_cast<int>(compareOp));
+    }
+
+    void createDescriptorSetLayouts() {
+        // Set 0: per frame
+        VkDescriptorSetLayoutBinding uboLayoutBinding{};
+        uboLayoutBinding.binding = 0;
+        uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uboLayoutBinding.descriptorCount = 1;
+        uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        uboLayoutBinding.pImmutableSamplers = nullptr;  // Optional
+
+        VkDescriptorSetLayoutBinding instancesLayoutBinding{};
+        instancesLayoutBinding.binding = 1;
+        instancesLayoutBinding.descriptorCount = 1;
+        instancesLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        instancesLayoutBinding.pImmutableSamplers = nullptr;
+        instancesLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        VkDescriptorSetLayoutBinding shadowsLayoutBinding{};
+        shadowsLayoutBinding.binding = 2;
+        shadowsLayoutBinding.descriptorCount = kNShadowCascadeCount;
+        shadowsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        shadowsLayoutBinding.pImmutableSamplers = nullptr;
+        shadowsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        // Bindings 3 and 4: the soldier's animation and skin textures
+        VkDescriptorSetLayoutBinding animationLayoutBinding{};
+        animationLayoutBinding.binding = 3;
+        animationLayoutBinding.descriptorCount = 1;
+        animationLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        animationLayoutBinding.pImmutableSamplers = nullptr;
+        animationLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        VkDescriptorSetLayoutBinding skinLayoutBinding = animationLayoutBinding;
+        skinLayoutBinding.binding = 4;
+
+        std::array<VkDescriptorSetLayoutBinding, 5> bindings = {uboLayoutBinding, instancesLayoutBinding,
+                                                                shadowsLayoutBinding, animationLayoutBinding,
+                                                                skinLayoutBinding};
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        NVK_CHECK(vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mDescriptorSetLayout));
+        NGL_LOGI("mDescriptorSetLayout: %p", reinterpret_cast<void*>(mDescriptorSetLayout));
+
+        // Set 1: per layer material
+        VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+        samplerLayoutBinding.binding = 0;
+        samplerLayoutBinding.descriptorCount = 1;
+        samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        samplerLayoutBinding.pImmutableSamplers = nullptr;
+        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutCreateInfo materialLayoutInfo{};
+        materialLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        materialLayoutInfo.bindingCount = 1;
+        materialLayoutInfo.pBindings = &samplerLayoutBinding;
+        NVK_CHECK(vkCreateDescriptorSetLayout(mDevice, &materialLayoutInfo, nullptr, &mMaterialDescriptorSetLayout));
+        NGL_LOGI("mMaterialDescriptorSetLayout: %p", reinterpret_cast<void*>(mMaterialDescriptorSetLayout));
+    }
+
+    void createPipelineLayout() {
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        std::array<VkDescriptorSetLayout, 2> setLayouts = {mDescriptorSetLayout, mMaterialDescriptorSetLayout};
+        pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+        // The cascade rendered by the shadow pipeline
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(uint32_t);
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+        NVK_CHECK(vkCreatePipelineLayout(mDevice, &pipelineLayoutCreateInfo, nullptr, &mPipelineLayout));
+        NGL_LOGI("mPipelineLayout: %p", reinterpret_cast<void*>(mPipelineLayout));
+    }
+
+    VkPipeline createGraphicsPipeline(const NPipelineDesc& desc) {
+        RenderPassKey compatibleKey;
+        compatibleKey.colorFormat = desc.hasColorTarget ? mSwapchainFormat : VK_FORMAT_UNDEFINED;
+        compatibleKey.depthFormat = desc.hasDepthTarget ? mDepthFormat : VK_FORMAT_UNDEFINED;
+
+        // The shadow and depth prepass pipelines only write depth, they read positions only and have no fragment stage
+        bool isDepthOnly = desc.shader != NShader::kScene;
+        const char* vertShaderPath = desc.shader == NShader::kShadow  ? "out/shadow_vertex.spv"
+                                     : desc.shader == NShader::kDepth ? "out/depth_vertex.spv"
+                                                                      : "out/vertex.spv";
+        NMappedFile vertShaderCode = nMapFile(vertShaderPath, NFileAccess::kSequential);
+        NGL_LOGI("vertShaderCode.size: %zu", vertShaderCode.size());
+        VkShaderModule vertShaderModule = mContext->createShaderModule(vertShaderCode.data(), vertShaderCode.size());
+        NGL_LOGI("vertShaderModule: %p", reinterpret_cast<void*>(vertShaderModule));
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+        if (!isDepthOnly) {
+            NMappedFile fragShaderCode = nMapFile("out/fragment.spv", NFileAccess::kSequential);
+            NGL_LOGI("fragShaderCode.size: %zu", fragShaderCode.size());
+            fragShaderModule = mContext->createShaderModule(fragShaderCode.data(), fragShaderCode.size());
+            NGL_LOGI("fragShaderModule: %p", reinterpret_cast<void*>(fragShaderModule));
+        }
+
+        VkPipelineShaderStageCreateInfo vertShaderStageCreateInfo{};
+        vertShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vertShaderStageCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+        vertShaderStageCreateInfo.module = vertShaderModule;
+        vertShaderStageCreateInfo.pName = "main";
+
+        VkPipelineShaderStageCreateInfo fragShaderStageCreateInfo{};
+        fragShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fragShaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        fragShaderStageCreateInfo.module = fragShaderModule;
+        fragShaderStageCreateInfo.pName = "main";
+
+        VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageCreateInfo, fragShaderStageCreateInfo};
+
+        std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+        VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo{};
+        dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+        dynamicStateCreateInfo.pDynamicStates = dynamicStates.data();
+
+        VkPipelineViewportStateCreateInfo viewportStateCreateInfo{};
+        viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportStateCreateInfo.viewportCount = 1;
+        viewportStateCreateInfo.scissorCount = 1;
+
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = isDepthOnly ? sizeof(glm::vec3) : sizeof(NglVertex);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(NglVertex, position);
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[1].offset = offsetof(NglVertex, normal);
+        attributeDescriptions[2].binding = 0;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[2].offset = offsetof(NglVertex, uv);
+
+        VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo{};
+        vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
+        vertexInputStateCreateInfo.pVertexBindingDescriptions = &bindingDescription;
+        vertexInputStateCreateInfo.vertexAttributeDescriptionCount =
+                isDepthOnly ? 1 : static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputStateCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo{};
+        inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(mSwapchainExtent.width);
+        viewport.height = static_cast<float>(mSwapchainExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = mSwapchainExtent;
+
+        VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo{};
+        rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizationStateCreateInfo.depthClampEnable = VK_FALSE;
+        rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;
+        rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizationStateCreateInfo.lineWidth = 1.0f;
+        rasterizationStateCreateInfo.cullMode = desc.cullBackFaces ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+        // Counter-clockwise like OpenGL: kVulkanClip flips y together with the winding
+        rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        rasterizationStateCreateInfo.depthBiasEnable =
+                desc.depthBiasConstant != 0.0f || desc.depthBiasSlope != 0.0f ? VK_TRUE : VK_FALSE;
+        rasterizationStateCreateInfo.depthBiasConstantFactor = desc.depthBiasConstant;
+        rasterizationStateCreateInfo.depthBiasClamp = 0.0f;  // Optional
+        rasterizationStateCreateInfo.depthBiasSlopeFactor = desc.depthBiasSlope;
+
+        VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo{};
+        multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampleStateCreateInfo.sampleShadingEnable = VK_FALSE;
+        multisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        multisampleStateCreateInfo.minSampleShading = 1.0f;           // Optional
+        multisampleStateCreateInfo.pSampleMask = nullptr;             // Optional
+        multisampleStateCreateInfo.alphaToCoverageEnable = VK_FALSE;  // Optional
+        multisampleStateCreateInfo.alphaToOneEnable = VK_FALSE;       // Optional
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachmentState{};
+        colorBlendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                                   VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachmentState.blendEnable = VK_FALSE;
+        colorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;   // Optional
+        colorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;  // Optional
+        colorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;              // Optional
+        colorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;   // Optional
+        colorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;  // Optional
+        colorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;              // Optional
+
+        VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo{};
+        colorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlendStateCreateInfo.logicOpEnable = VK_FALSE;
+        colorBlendStateCreateInfo.logicOp = VK_LOGIC_OP_COPY;  // Optional
+        colorBlendStateCreateInfo.attachmentCount = desc.hasColorTarget ? 1 : 0;
+        colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
+        colorBlendStateCreateInfo.blendConstants[0] = 0.0f;  // Optional
+        colorBlendStateCreateInfo.blendConstants[1] = 0.0f;  // Optional
+        colorBlendStateCreateInfo.blendConstants[2] = 0.0f;  // Optional
+        colorBlendStateCreateInfo.blendConstants[3] = 0.0f;  // Optional
+
+        VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo{};
+        depthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencilStateCreateInfo.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+        depthStencilStateCreateInfo.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+        depthStencilStateCreateInfo.depthCompareOp = toVkCompareOp(desc.depthCompareOp);
+        depthStencilStateCreateInfo.depthBoundsTestEnable = VK_FALSE;
+        depthStencilStateCreateInfo.minDepthBounds = 0.0f;  // Optional
+        depthStencilStateCreateInfo.maxDepthBounds = 1.0f;  // Optional
+        depthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
+        depthStencilStateCreateInfo.front = {};  // Optional
+        depthStencilStateCreateInfo.back = {};   // Optional
+
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stageCount = isDepthOnly ? 1 : 2;
+        pipelineCreateInfo.pStages = shaderStages;
+        pipelineCreateInfo.pVertexInputState = &vertexInputStateCreateInfo;
+        pipelineCreateInfo.pInputAssemblyState = &inputAssemblyStateCreateInfo;
+        pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+        pipelineCreateInfo.pRasterizationState = &rasterizationStateCreateInfo;
+        pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
+        pipelineCreateInfo.pDepthStencilState = &depthStencilStateCreateInfo;
+        pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
+        pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
+        pipelineCreateInfo.layout = mPipelineLayout;
+        pipelineCreateInfo.renderPass = getRenderPass(compatibleKey);
+        pipelineCreateInfo.subpass = 0;
+        pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;  // Optional
+        pipelineCreateInfo.basePipelineIndex = -1;               // Optional
+
+        VkPipeline pipeline;
+        NVK_CHECK(vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline));
+        NGL_LOGI("pipeline: %p", reinterpret_cast<void*>(pipeline));
+
+        if (fragShaderModule != VK_NULL_HANDLE) {
+            vkDestroyShaderModule(mDevice, fragShaderModule, nullptr);
+        }
+        vkDestroyShaderModule(mDevice, vertShaderModule, nullptr);
+
+        return pipeline;
+    }
+
+    void createCommandPool() {
+        QueueFamilyIndices queueFamilyIndices = findQueueFamilies(mPhysicalDevice);
+
+        VkCommandPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolCreateInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+        NVK_CHECK(vkCreateCommandPool(mDevice, &poolCreateInfo, nullptr, &mCommandPool));
+        NGL_LOGI("mCommandPool: %p", reinterpret_cast<void*>(mCommandPool));
+    }
+
+    VkFormat findDepthFormat() {
+        return findSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+                                   VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    }
+
+    VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
+                                 VkFormatFeatureFlags features) {
+        for (VkFormat format : candidates) {
+            VkFormatProperties props;
+            vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, format, &props);
+
+            if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
+                return format;
+            } else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
+                return format;
+            }
+        }
+        NGL_ABORT("Error finding format");
+    }
+
+    void createTextureSamplers() {
+        VkPhysicalDeviceProperties physicalDeviceProperties{};
+        vkGetPhysicalDeviceProperties(mPhysicalDevice, &physicalDeviceProperties);
+
+        VkSamplerCreateInfo samplerCreateInfo{};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+        samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.anisotropyEnable = VK_TRUE;
+        samplerCreateInfo.maxAnisotropy = physicalDeviceProperties.limits.maxSamplerAnisotropy;
+        samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerCreateInfo.compareEnable = VK_FALSE;
+        samplerCreateInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerCreateInfo.mipLodBias = 0.0f;
+        samplerCreateInfo.minLod = 0.0f;
+        samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+        NVK_CHECK(vkCreateSampler(mDevice, &samplerCreateInfo, nullptr, &mTextureSampler));
+
+        // Shadow maps are compared texel by texel with textureGather(), no wrapping across the edges
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.anisotropyEnable = VK_FALSE;
+        samplerCreateInfo.maxAnisotropy = 1.0f;
+        samplerCreateInfo.maxLod = 0.0f;
+        samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        NVK_CHECK(vkCreateSampler(mDevice, &samplerCreateInfo, nullptr, &mShadowSampler));
+    }
+
+    void createUniformBuffers() {
+        VkDeviceSize bufferSize = sizeof(NFrameUniform);
+
+        mUniformBuffers.resize(kMaxFramesInFlight);
+        mUniformBufferMemories.resize(kMaxFramesInFlight);
+        mUniformBufferMappedAddresses.resize(kMaxFramesInFlight);
+
+        for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+            NGL_LOGI("Creating uniform buffer %zu...", i);
+            mContext->createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                   mUniformBuffers[i], mUniformBufferMemories[i]);
+            vkMapMemory(mDevice, mUniformBufferMemories[i], 0, bufferSize, 0, &mUniformBufferMappedAddresses[i]);
+        }
+
+        // NInstance records, written by the CPU every frame like the uniforms
+        VkDeviceSize instanceBufferSize = kNMaxInstanceCount * sizeof(NInstance);
+        mInstanceBuffers.resize(kMaxFramesInFlight);
+        mInstanceBufferMemories.resize(kMaxFramesInFlight);
+        mInstanceBufferMappedAddresses.resize(kMaxFramesInFlight);
+        for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+            mContext->createBuffer(instanceBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                   mInstanceBuffers[i], mInstanceBufferMemories[i]);
+            vkMapMemory(mDevice, mInstanceBufferMemories[i], 0, instanceBufferSize, 0,
+                        &mInstanceBufferMappedAddresses[i]);
+        }
+    }
+
+    void createDescriptorPool() {
+        std::array<VkDescriptorPoolSize, 3> poolSizes{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSizes[0].descriptorCount = kMaxFramesInFlight;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[1].descriptorCount = kMaxFramesInFlight;
+        poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[2].descriptorCount = kMaxFramesInFlight * kNGlobalTextureCount + kMaxTextureCount;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = kMaxFramesInFlight + kMaxTextureCount;
+        NVK_CHECK(vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mDescriptorPool));
+        NGL_LOGI("mDescriptorPool: %p", reinterpret_cast<void*>(mDescriptorPool));
+    }
+
+    void createDescriptorSets() {
+        mDescriptorSets.resize(kMaxFramesInFlight);
+
+        std::vector<VkDescriptorSetLayout> layouts(kMaxFramesInFlight, mDescriptorSetLayout);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = mDescriptorPool;
+        allocInfo.descriptorSetCount = kMaxFramesInFlight;
+        allocInfo.pSetLayouts = layouts.data();
+
+        NVK_CHECK(vkAllocateDescriptorSets(mDevice, &allocInfo, mDescriptorSets.data()));
+
+        for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+            VkDescriptorBufferInfo bufferInfo{};
+            bufferInfo.buffer = mUniformBuffers[i];
+            bufferInfo.offset = 0;
+            bufferInfo.range = sizeof(NFrameUniform);
+
+            VkWriteDescriptorSet descriptorWrite{};
+            descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrite.dstSet = mDescriptorSets[i];
+            descriptorWrite.dstBinding = 0;
+            descriptorWrite.dstArrayElement = 0;
+            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptorWrite.descriptorCount = 1;
+            descriptorWrite.pBufferInfo = &bufferInfo;
+
+            vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+
+            VkDescriptorBufferInfo instanceBufferInfo{};
+            instanceBufferInfo.buffer = mInstanceBuffers[i];
+            instanceBufferInfo.offset = 0;
+            instanceBufferInfo.range = VK_WHOLE_SIZE;
+            descriptorWrite.dstBinding = 1;
+            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrite.pBufferInfo = &instanceBufferInfo;
+            vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+        }
+        // Bindings 2 to 4 are written by setGlobalTexture()
+    }
+
+    void createCommandBuffers() {
+        mCommandBuffers.resize(kMaxFramesInFlight);
+
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = mCommandPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = static_cast<uint32_t>(mCommandBuffers.size());
+
+        NVK_CHECK(vkAllocateCommandBuffers(mDevice, &allocateInfo, mCommandBuffers.data()));
+        for (size_t i = 0; i < mCommandBuffers.size(); i++) {
+            NGL_LOGI("mCommandBuffers[%zd]: %p", i, reinterpret_cast<void*>(mCommandBuffers[i]));
+        }
+    }
+
+    void createSyncObjects() {
+        mImageAvailableSemaphores.resize(kMaxFramesInFlight);
+        mRenderFinishedSemaphores.resize(kMaxFramesInFlight);
+        mInFlightFences.resize(kMaxFramesInFlight);
+
+        VkSemaphoreCreateInfo semaphoreCreateInfo{};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkFenceCreateInfo fenceCreateInfo{};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+            NVK_CHECK(vkCreateSemaphore(mDevice, &semaphoreCreateInfo, nullptr, &mImageAvailableSemaphores[i]));
+            NGL_LOGI("mImageAvailableSemaphores[%zd]: %p", i, reinterpret_cast<void*>(mImageAvailableSemaphores[i]));
+
+            NVK_CHECK(vkCreateSemaphore(mDevice, &semaphoreCreateInfo, nullptr, &mRenderFinishedSemaphores[i]));
+            NGL_LOGI("mRenderFinishedSemaphores[%zd]: %p", i, reinterpret_cast<void*>(mRenderFinishedSemaphores[i]));
+
+            NVK_CHECK(vkCreateFence(mDevice, &fenceCreateInfo, nullptr, &mInFlightFences[i]));
+            NGL_LOGI("mInFlightFences[%zd]:           %p", i, reinterpret_cast<void*>(mInFlightFences[i]));
+        }
+    }
+
+    void createTimestampQueryPool() {
+        VkPhysicalDeviceProperties physicalDeviceProperties{};
+        vkGetPhysicalDeviceProperties(mPhysicalDevice, &physicalDeviceProperties);
+        if (!physicalDeviceProperties.limits.timestampComputeAndGraphics) {
+            NGL_LOGI("Timestamps not supported, %s", "passes will not be timed");
+            return;
+        }
+        mTimestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
+
+        // A begin and an end timestamp per timed range, kMaxTimedRangeCount ranges per frame in flight
+        VkQueryPoolCreateInfo queryPoolCreateInfo{};
+        queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount = kMaxFramesInFlight * kMaxTimedRangeCount * 2;
+        NVK_CHECK(vkCreateQueryPool(mDevice, &queryPoolCreateInfo, nullptr, &mTimestampQueryPool));
+        NGL_LOGI("mTimestampQueryPool: %p", reinterpret_cast<void*>(mTimestampQueryPool));
+
+        // Debug counter for overdraw, indexed like the timed ranges but used by passes only
+        if (!mIsPipelineStatisticsQueryEnabled) {
+            NGL_LOGI("Pipeline statistics not supported, %s", "overdraw will not be measured");
+            return;
+        }
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        queryPoolCreateInfo.queryCount = kMaxFramesInFlight * kMaxTimedRangeCount;
+        queryPoolCreateInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+        NVK_CHECK(vkCreateQueryPool(mDevice, &queryPoolCreateInfo, nullptr, &mFragmentQueryPool));
+        NGL_LOGI("mFragmentQueryPool: %p", reinterpret_cast<void*>(mFragmentQueryPool));
+    }
+
+    // Returns kUntimedRange if the range cannot be timed
+    uint32_t beginTimedRange(const TimedRange& range) {
+        std::vector<TimedRange>& timedRanges = mTimedRanges[mCurrentFrame];
+        if (mTimestampQueryPool == VK_NULL_HANDLE || timedRanges.size() == kMaxTimedRangeCount) {
+            return kUntimedRange;
+        }
+        uint32_t rangeIndex = static_cast<uint32_t>(timedRanges.size());
+        timedRanges.push_back(range);
+        vkCmdWriteTimestamp(mCommandBuffers[mCurrentFrame], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mTimestampQueryPool,
+                            (mCurrentFrame * kMaxTimedRangeCount + rangeIndex) * 2);
+        return rangeIndex;
+    }
+
+    void endTimedRange(uint32_t rangeIndex) {
+        if (rangeIndex == kUntimedRange) {
+            return;
+        }
+        vkCmdWriteTimestamp(mCommandBuffers[mCurrentFrame], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mTimestampQueryPool,
+                            (mCurrentFrame * kMaxTimedRangeCount + rangeIndex) * 2 + 1);
+    }
+
+    void readPassStats() {
+        const std::vector<TimedRange>& timedRanges = mTimedRanges[mCurrentFrame];
+        uint32_t firstQuery = mCurrentFrame * kMaxTimedRangeCount;
+        std::vector<uint64_t> timestamps(timedRanges.size() * 2);
+        NVK_CHECK(vkGetQueryPoolResults(mDevice, mTimestampQueryPool, firstQuery * 2,
+                                        static_cast<uint32_t>(timestamps.size()), timestamps.size() * sizeof(uint64_t),
+                                        timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT));
+
+        mPassStats.clear();
+        for (size_t i = 0; i < timedRanges.size(); i++) {
+            const TimedRange& range = timedRanges[i];
+            double ticks = static_cast<double>(timestamps[i * 2 + 1] - timestamps[i * 2]);
+            double startTicks = static_cast<double>(timestamps[i * 2] - timestamps[0]);
+            // Scopes have no fragment query, reading one that was never begun would not complete
+            double overdraw = -1.0;
+            if (!range.isScope && mFragmentQueryPool != VK_NULL_HANDLE) {
+                uint64_t fragmentCount;
+                NVK_CHECK(vkGetQueryPoolResults(mDevice, mFragmentQueryPool, firstQuery + static_cast<uint32_t>(i), 1,
+                                                sizeof(fragmentCount), &fragmentCount, sizeof(fragmentCount),
+                                                VK_QUERY_RESULT_64_BIT));
+                overdraw = static_cast<double>(fragmentCount) / range.pixelCount;
+            }
+            double startTime = mSubmitTimes[mCurrentFrame] + startTicks * mTimestampPeriod * 1e-9;
+            mPassStats.push_back({range.name, range.isScope, startTime, ticks * mTimestampPeriod * 1e-9, overdraw});
+        }
+    }
+
+    void terminate() {
+        NVK_CHECK(vkDeviceWaitIdle(mDevice));
+        cleanupSwapchain();
+        if (mFragmentQueryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(mDevice, mFragmentQueryPool, nullptr);
+        }
+        if (mTimestampQueryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(mDevice, mTimestampQueryPool, nullptr);
+        }
+        for (auto& [key, renderPass] : mRenderPasses) {
+            vkDestroyRenderPass(mDevice, renderPass, nullptr);
+        }
+        for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+            vkDestroyFence(mDevice, mInFlightFences[i], nullptr);
+            vkDestroySemaphore(mDevice, mRenderFinishedSemaphores[i], nullptr);
+            vkDestroySemaphore(mDevice, mImageAvailableSemaphores[i], nullptr);
+        }
+        for (VkPipeline pipeline : mPipelines) {
+            vkDestroyPipeline(mDevice, pipeline, nullptr);
+        }
+        mTextures.clear();
+        if (mTransientMemory != VK_NULL_HANDLE) {
+            vkFreeMemory(mDevice, mTransientMemory, nullptr);
+        }
+        mBuffers.clear();
+        vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+        for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+            vkDestroyBuffer(mDevice, mUniformBuffers[i], nullptr);
+            vkFreeMemory(mDevice, mUniformBufferMemories[i], nullptr);
+            vkDestroyBuffer(mDevice, mInstanceBuffers[i], nullptr);
+            vkFreeMemory(mDevice, mInstanceBufferMemories[i], nullptr);
+        }
+        vkDestroySampler(mDevice, mShadowSampler, nullptr);
+        vkDestroySampler(mDevice, mTextureSampler, nullptr);
+        mContext.reset();
+        vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+        vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(mDevice, mMaterialDescriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(mDevice, mDescriptorSetLayout, nullptr);
+        vkDestroyDevice(mDevice, nullptr);
+        if (mSurface != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+        }
+        nvkTerminateDebugIfNecessary(mInstance);
+        vkDestroyInstance(mInstance, nullptr);
+        glfwDestroyWindow(mWindow);
+    }
+
+    void cleanupSwapchain() {
+        destroyFramebuffers(VK_NULL_HANDLE);
+        for (auto imageView : mSwapchainImageViews) {
+            vkDestroyImageView(mDevice, imageView, nullptr);
+        }
+        if (mSwapchain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(mDevice, mSwapchain, nullptr);
+        }
+        mOffscreenBackbuffer.reset();
+    }
+
+    const bool mIsHeadless;
+    GLFWwindow* mWindow = nullptr;
+    VkInstance mInstance = VK_NULL_HANDLE;
+    VkSurfaceKHR mSurface = VK_NULL_HANDLE;
+    VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+    VkDevice mDevice = VK_NULL_HANDLE;
+    VkQueue mGraphicsQueue = VK_NULL_HANDLE;
+    VkQueue mPresentQueue = VK_NULL_HANDLE;
+    VkSwapchainKHR mSwapchain = VK_NULL_HANDLE;
+    std::vector<VkImage> mSwapchainImages;
+    VkFormat mSwapchainFormat;
+    VkExtent2D mSwapchainExtent;
+    std::vector<VkImageView> mSwapchainImageViews;
+    std::unique_ptr<NvkTexture> mOffscreenBackbuffer;  // headless only
+    VkFormat mDepthFormat;
+    std::map<RenderPassKey, VkRenderPass> mRenderPasses;
+    std::map<std::pair<VkImageView, VkImageView>, VkFramebuffer> mFramebuffers;
+    VkDescriptorSetLayout mDescriptorSetLayout;
+    VkDescriptorSetLayout mMaterialDescriptorSetLayout;
+    VkPipelineLayout mPipelineLayout;
+    VkCommandPool mCommandPool;
+    VkSampler mTextureSampler;
+    VkSampler mShadowSampler;
+    std::vector<VkBuffer> mUniformBuffers;
+    std::vector<VkDeviceMemory> mUniformBufferMemories;
+    std::vector<void*> mUniformBufferMappedAddresses;
+    std::vector<VkBuffer> mInstanceBuffers;
+    std::vector<VkDeviceMemory> mInstanceBufferMemories;
+    std::vector<void*> mInstanceBufferMappedAddresses;
+    VkDescriptorPool mDescriptorPool;
+    std::vector<VkDescriptorSet> mDescriptorSets;
+    std::vector<VkCommandBuffer> mCommandBuffers;
+    std::vector<VkSemaphore> mImageAvailableSemaphores;
+    std::vector<VkSemaphore> mRenderFinishedSemaphores;
+    std::vector<VkFence> mInFlightFences;
+    uint32_t mCurrentFrame = 0;
+    uint32_t mImageIndex = 0;
+
+    bool mFramebufferResized = false;
+
+    std::unique_ptr<NvkContext> mContext;
+
+    // Resource tables indexed by handle. Every texture gets a material descriptor set (set 1), slots of destroyed
+    // textures are reused along with their set.
+    std::vector<std::unique_ptr<NvkBuffer>> mBuffers;
+    std::vector<std::unique_ptr<NvkTexture>> mTextures;
+    std::vector<VkDescriptorSet> mTextureDescriptorSets;
+    std::vector<uint32_t> mFreeTextureSlots;
+    VkDeviceMemory mTransientMemory = VK_NULL_HANDLE;  // render graph targets
+    std::vector<VkPipeline> mPipelines;
+    std::array<NTextureHandle, kNGlobalTextureCount> mGlobalTextures;
+
+    // VK_NULL_HANDLE if the queue cannot write timestamps
+    VkQueryPool mTimestampQueryPool = VK_NULL_HANDLE;
+    float mTimestampPeriod = 0.0f;  // nanoseconds per tick
+    // VK_NULL_HANDLE if timestamps or pipeline statistics are not supported
+    VkQueryPool mFragmentQueryPool = VK_NULL_HANDLE;
+    bool mIsPipelineStatisticsQueryEnabled = false;
+    bool mIsTextureCompressionBcEnabled = false;
+    std::array<std::vector<TimedRange>, kMaxFramesInFlight> mTimedRanges;
+    std::array<double, kMaxFramesInFlight> mSubmitTimes = {};
+    std::vector<NPassStats> mPassStats;
+
+    double mFrameWaitTime = 0;
+};
+
+std::unique_ptr<NRenderDevice> nvkCreateRenderDevice(bool isHeadless) {
+    return std::make_unique<NvkRenderDevice>(isHeadless);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <memory>
+
+#include "NRenderDevice.h"
+
+// Creates the Vulkan device and its window. glfwInit() must have been called, on the null platform when headless.
+std::unique_ptr<NRenderDevice> nvkCreateRenderDevice(bool isHeadless);
@@ -0,0 +1,94 @@
+#include "nvkstate.h"
+
+#include "ngllog.h"
+
+NvkResourceState nvkResourceState(NResourceState state) {
+    switch (state) {
+        case NResourceState::kUndefined:
+            // Waits for everything, e.g. earlier users of aliased memory or the previous frame in flight
+            return {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0};
+        case NResourceState::kTransferDst:
+            return {VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT};
+        case NResourceState::kShaderRead:
+            // Vertex shaders may sample textures too
+            return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT};
+        case NResourceState::kColorAttachment:
+            return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT};
+        case NResourceState::kDepthAttachment:
+            return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+        case NResourceState::kDepthRead:
+            return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT};
+        case NResourceState::kPresent:
+            return {VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0};
+    }
+    NGL_ABORT("Unknown resource state %d", static_cast<int>(state));
+}
+
+bool nvkIsDepthFormat(VkFormat format) {
+    return format == VK_FORMAT_D32_SFLOAT || nvkHasStencilComponent(format);
+}
+
+bool nvkHasStencilComponent(VkFormat format) {
+    return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+}
+
+VkImageAspectFlags nvkImageAspects(VkFormat format) {
+    if (!nvkIsDepthFormat(format)) {
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+    VkImageAspectFlags aspects = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (nvkHasStencilComponent(format)) {
+        aspects |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    return aspects;
+}
+
+VkDeviceSize nvkImageLevelSize(VkFormat format, uint32_t width, uint32_t height) {
+    VkDeviceSize blockCount = VkDeviceSize{(width + 3) / 4} * ((height + 3) / 4);
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+            return VkDeviceSize{width} * height * 4;
+        case VK_FORMAT_R16_SFLOAT:
+            return VkDeviceSize{width} * height * 2;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return VkDeviceSize{width} * height * 16;
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            return blockCount * 8;
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return blockCount * 16;
+        default:
+            NGL_ABORT("Unexpected texture format %d", static_cast<int>(format));
+    }
+}
+
+VkImageMemoryBarrier nvkImageBarrier(VkImage image, VkFormat format, NResourceState before, NResourceState after) {
+    NvkResourceState src = nvkResourceState(before);
+    NvkResourceState dst = nvkResourceState(after);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = src.access;
+    barrier.dstAccessMask = dst.access;
+    barrier.oldLayout = src.layout;
+    barrier.newLayout = dst.layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = nvkImageAspects(format);
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "nrender.h"
+
+// What an NResourceState means to Vulkan
+struct NvkResourceState {
+    VkImageLayout layout;
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+};
+
+NvkResourceState nvkResourceState(NResourceState state);
+
+bool nvkIsDepthFormat(VkFormat format);
+bool nvkHasStencilComponent(VkFormat format);
+// All aspects of the format, for barriers
+VkImageAspectFlags nvkImageAspects(VkFormat format);
+// Bytes of one level of an image of a sampled texture format, in whole blocks for block compressed formats
+VkDeviceSize nvkImageLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+// Barrier covering every level and the single layer of image
+VkImageMemoryBarrier nvkImageBarrier(VkImage image, VkFormat format, NResourceState before, NResourceState after);
@@ -1,13 +1,51 @@
-#include "nglmain.h"
-#include "nvkmain.h"
+#include <cstdlib>
+#include <cstring>
 
-int main() {
-    // TODO: Convert to Vulkan
+#include "ngllog.h"
+#include "nmain.h"
+
+constexpr int kDefaultBenchmarkFrameCount = 1000;
+
+int main(int argc, char* argv[]) {
     // TODO: Gamma correction
-    // TODO: Shadows
     // TODO: Nicer grass rendering, texture
     // TODO: Nicer cloth rendering, texture, roughness, cloth look
     // TODO: Optimize: Simpler or smarter shaders. Example: no wireframe
     // TODO: Optimize: Clipping
-    return nvkMain();
+    NMainOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--gl") == 0) {
+            options.backend = NBackend::kOpenGL;
+        } else if (strcmp(argv[i], "--vk") == 0) {
+            options.backend = NBackend::kVulkan;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            options.isHeadless = true;
+        } else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            options.benchmarkFrameCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--benchmark-output") == 0 && i + 1 < argc) {
+            options.benchmarkPath = argv[++i];
+        } else if (strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc) {
+            options.cameraPath = argv[++i];
+        } else if (strcmp(argv[i], "--archive") == 0 && i + 1 < argc) {
+            options.archivePath = argv[++i];
+        } else if (strcmp(argv[i], "--no-mipmaps") == 0) {
+            options.hasMipmaps = false;
+        } else if (strcmp(argv[i], "--no-animation") == 0) {
+            options.isAnimated = false;
+        } else if (strcmp(argv[i], "--battle") == 0) {
+            options.isBattle = true;
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0) {
+            options.tickRate = atof(argv[++i]);
+        } else {
+            NGL_LOGE("Unknown argument: %s (expected --gl, --vk, --headless, --benchmark <frames>, "
+                     "--benchmark-output <path>, --camera-path <name or path>, --archive <path>, --no-mipmaps, "
+                     "--no-animation, --battle or --tick-rate <ticks per second>)",
+                     argv[i]);
+            return 1;
+        }
+    }
+    if (options.isHeadless && options.benchmarkFrameCount == 0) {
+        options.benchmarkFrameCount = kDefaultBenchmarkFrameCount;
+    }
+    return nMain(options);
 }
@@ -0,0 +1,603 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <glm/ext.hpp>
+#include <glm/glm.hpp>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include "NBattle.h"
+#include "NBenchmark.h"
+#include "NFlowField.h"
+#include "NHeightField.h"
+#include "NOcclusionCuller.h"
+#include "NSpatialGrid.h"
+#include "NglBicubicInterpolation.h"
+#include "NglSoldierGeometry.h"
+#include "NglTerrainGeometry.h"
+#include "nbench.h"
+#include "nfile.h"
+#include "nglarmy.h"
+#include "nglassert.h"
+#include "ngllog.h"
+#include "nimage.h"
+#include "nmain.h"
+#include "ntexfile.h"
+
+// Perf regression suite, run from the directory with the assets like nwar. Each metric is timed repeatedly, the
+// results are written to a results file and compared with the baseline, a results file kept from an earlier run.
+// Exits with 1 when a metric got slower than its baseline by more than the threshold, and significantly so.
+//
+// Rendering options are compared the same way, e.g. what mip chains save in GPU time on the overview camera path,
+// where the terrain is minified the most:
+//
+//   nwar-bench --camera-path overview --baseline mipmaps.txt --update-baseline
+//   nwar-bench --camera-path overview --baseline mipmaps.txt --no-mipmaps
+//
+// or what skinning the soldiers costs against the static mesh, the frame.gpu difference over the 8640 soldiers being
+// the cost per animated instance:
+//
+//   nwar-bench --camera-path lowangle --baseline animation.txt --update-baseline
+//   nwar-bench --camera-path lowangle --baseline animation.txt --no-animation
+//
+// or what the army fighting itself costs in frame time against the march:
+//
+//   nwar-bench --baseline battle.txt --update-baseline
+//   nwar-bench --baseline battle.txt --battle
+
+constexpr int kDefaultSampleCount = 20;
+constexpr int kDefaultFrameCount = 300;
+constexpr double kDefaultThreshold = 5.0;  // percent of the baseline median
+constexpr double kSignificance = 0.01;
+constexpr int kInterpolationCount = 100000;
+constexpr int kArmyStepCount = 600;  // 10 seconds at 60 Hz
+constexpr double kArmyStep = 1.0 / 60.0;
+constexpr int kFlowFieldLookupCount = 100000;
+constexpr int kMaxFlowFieldResolution = 1024;  // without --large-flow-fields, which goes up to 4096
+constexpr int kGridQueryCount = 10000;
+constexpr int kGridNearestCount = 8;
+constexpr float kGridNearestRadius = 1.0f;
+constexpr int kBattleSize = 448;  // soldiers a side of the melee's square, 200k in all
+constexpr float kBattleSpacing = 0.045f;
+constexpr int kBattleMaxWarmupTickCount = 600;  // ticks before the first casualties, 10 seconds at 60 Hz
+constexpr float kBattleGap = 0.5f;               // between the sides as they approach, half of a soldier's sight
+constexpr int kSightLineCount = 100000;
+constexpr int kViewshedObserverCount = 8;
+constexpr float kViewshedRadius = 2.0f;
+constexpr float kEyeHeight = 0.05f;  // of a soldier, and of what it looks at
+constexpr int kPickArmySize = 1008;  // soldiers a side of the square army covering the terrain, 1M in all
+constexpr int kPickCount = 1000;
+constexpr float kPickSoldierRadius = 0.005f;  // fits the army's spacing
+constexpr float kPickSoldierHeight = kEyeHeight;
+constexpr size_t kPageSize = 4096;
+constexpr size_t kMegabyte = 1024 * 1024;
+
+struct NBenchOptions {
+    NBackend backend = NBackend::kVulkan;
+    int sampleCount = kDefaultSampleCount;
+    int frameCount = kDefaultFrameCount;
+    double threshold = kDefaultThreshold;
+    std::string baselinePath = "bench-baseline.txt";
+    std::string resultsPath = "bench-results.txt";
+    bool isBaselineUpdate = false;
+    bool hasLargeFiles = false;       // adds a 1 GB file to the file reading benchmarks
+    bool hasLargeFlowFields = false;  // adds flow fields of 2048 and 4096 cells a side, seconds per sample
+    std::string cameraPath;           // of the frame benchmark, see NMainOptions
+    bool hasMipmaps = true;
+    bool isAnimated = true;
+    bool isBattle = false;
+};
+
+// Keeps the compiler from optimizing away the work being timed
+static volatile float gSink = 0.0f;
+
+static std::vector<NBenchResult> runCpuBenchmarks(const NBenchOptions& options);
+static void runGridBenchmarks(const NBenchOptions& options, const NglTerrainGeometry& terrainGeometry,
+                              std::vector<NBenchResult>& results);
+static void runBattleBenchmarks(const NBenchOptions& options, std::vector<NBenchResult>& results);
+static void runSightBenchmarks(const NBenchOptions& options, const NglTerrainGeometry& terrainGeometry,
+                               std::vector<NBenchResult>& results);
+static void runPickBenchmark(const NBenchOptions& options, const NglTerrainGeometry& terrainGeometry,
+                             std::vector<NBenchResult>& results);
+static void runFileBenchmarks(const NBenchOptions& options, std::vector<NBenchResult>& results);
+static bool writeTestFile(const std::string& path, size_t size);
+static unsigned sumPages(const char* data, size_t size);
+static void runFrameBenchmark(const NBenchOptions& options, std::vector<NBenchResult>& results);
+static bool compareWithBaseline(const NBenchOptions& options, const std::vector<NBenchResult>& results);
+
+int main(int argc, char* argv[]) {
+    NBenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--gl") == 0) {
+            options.backend = NBackend::kOpenGL;
+        } else if (strcmp(argv[i], "--vk") == 0) {
+            options.backend = NBackend::kVulkan;
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            options.sampleCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            options.frameCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc && atof(argv[i + 1]) >= 0) {
+            options.threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            options.baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--results") == 0 && i + 1 < argc) {
+            options.resultsPath = argv[++i];
+        } else if (strcmp(argv[i], "--update-baseline") == 0) {
+            options.isBaselineUpdate = true;
+        } else if (strcmp(argv[i], "--large-files") == 0) {
+            options.hasLargeFiles = true;
+        } else if (strcmp(argv[i], "--large-flow-fields") == 0) {
+            options.hasLargeFlowFields = true;
+        } else if (strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc) {
+            options.cameraPath = argv[++i];
+        } else if (strcmp(argv[i], "--no-mipmaps") == 0) {
+            options.hasMipmaps = false;
+        } else if (strcmp(argv[i], "--no-animation") == 0) {
+            options.isAnimated = false;
+        } else if (strcmp(argv[i], "--battle") == 0) {
+            options.isBattle = true;
+        } else {
+            NGL_LOGE("Unknown argument: %s (expected --gl, --vk, --samples <n>, --frames <n>, --threshold <percent>, "
+                     "--baseline <path>, --results <path>, --update-baseline, --large-files, --large-flow-fields, "
+                     "--camera-path <name or path>, --no-mipmaps, --no-animation or --battle)",
+                     argv[i]);
+            return 1;
+        }
+    }
+
+    std::vector<NBenchResult> results = runCpuBenchmarks(options);
+    runFileBenchmarks(options, results);
+    runFrameBenchmark(options, results);
+
+    if (!nBenchWriteResults(options.resultsPath, results)) {
+        return 1;
+    }
+    if (options.isBaselineUpdate) {
+        return nBenchWriteResults(options.baselinePath, results) ? 0 : 1;
+    }
+    return compareWithBaseline(options, results) ? 0 : 1;
+}
+
+std::vector<NBenchResult> runCpuBenchmarks(const NBenchOptions& options) {
+    // The terrain logs its generation time with glfwGetTime(), no display is needed for that
+#ifdef GLFW_PLATFORM_NULL
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+    if (!glfwInit()) {
+        NGL_LOGE("glfwInit() failed");
+        abort();
+    }
+
+    std::vector<NBenchResult> results;
+    results.push_back(nBenchRun("terrain.generate", options.sampleCount, [] { NglTerrainGeometry terrainGeometry; }));
+
+    results.push_back(nBenchRun("bicubic.interpolate", options.sampleCount, [] {
+        float samples[16];
+        for (int i = 0; i < 16; i++) {
+            samples[i] = static_cast<float>(i % 5) * 0.25f;
+        }
+        NglBicubicInterpolation interpolation(1, 1, samples);
+        float sum = 0.0f;
+        for (int i = 0; i < kInterpolationCount; i++) {
+            sum += interpolation.interpolate((i % 317) / 317.0f, (i % 211) / 211.0f);
+        }
+        gSink = sum;
+    }));
+
+    results.push_back(nBenchRun("mesh.load", options.sampleCount, [] { NglSoldierGeometry soldierGeometry; }));
+
+    // The soldier's texture as NAssetService gets it ready for upload: the embedded image decoded, against the
+    // texture file from nwar-texc read and checked, when there is one
+    NglSoldierGeometry soldierGeometry;
+    const std::vector<unsigned char>& soldierTexture = soldierGeometry.texture();
+    results.push_back(nBenchRun("texture.load.png", options.sampleCount, [&] {
+        NImage image = nDecodeImage(soldierTexture.data(), static_cast<uint32_t>(soldierTexture.size()), "soldier");
+        gSink = static_cast<float>(image.pixels[0]);
+    }));
+    const std::string textureFilePath = nTextureFilePath("soldier.glb");
+    NMappedFile textureFile;
+    if (nTryMapFile(textureFilePath, NFileAccess::kSequential, textureFile)) {
+        results.push_back(nBenchRun("texture.load.ntex", options.sampleCount, [&] {
+            NMappedFile file = nMapFile(textureFilePath, NFileAccess::kSequential);
+            NTextureFile texture;
+            if (nParseTextureFile(file.data(), file.size(), "soldier", texture)) {
+                gSink = static_cast<float>(sumPages(texture.levels, texture.size));
+            }
+        }));
+    }
+
+    results.push_back(nBenchRun("army.step", options.sampleCount, [] {
+        glm::vec2 sum(0.0f);
+        for (int step = 0; step < kArmyStepCount; step++) {
+            for (int unit = 0; unit < kArmyUnitCount; unit++) {
+                sum += nglUnitCenter(unit, static_cast<float>(step * kArmyStep));
+            }
+        }
+        gSink = sum.x + sum.y;
+    }));
+
+    // Every soldier placed on the terrain, once per frame for the vertex shaders
+    NglTerrainGeometry terrainGeometry;
+    std::vector<NInstance> instances;
+    results.push_back(nBenchRun("army.instances", options.sampleCount, [&] {
+        nglUpdateInstances(1.0f, terrainGeometry, static_cast<uint32_t>(NAnimation::kWalk), instances);
+        gSink = instances.back().position.y;
+    }));
+    NSpatialGrid grid(glm::vec2(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z),
+                      glm::vec2(terrainGeometry.boundsMax().x, terrainGeometry.boundsMax().z), kSeparationRadius);
+    std::vector<glm::vec2> groundPositions;
+    results.push_back(nBenchRun("army.separation", options.sampleCount, [&] {
+        nglSeparateSoldiers(terrainGeometry, grid, groundPositions, instances);
+        gSink = instances.back().position.y;
+    }));
+    runGridBenchmarks(options, terrainGeometry, results);
+    runBattleBenchmarks(options, results);
+
+    // Flow fields to the army's destination from the army's resolution up, then the lookups everyone heading there
+    // makes, kFlowFieldLookupCount at a time
+    const int maxResolution = options.hasLargeFlowFields ? 4096 : kMaxFlowFieldResolution;
+    for (int resolution = kArmyFlowFieldResolution; resolution <= maxResolution; resolution *= 2) {
+        results.push_back(nBenchRun("flowfield.build." + std::to_string(resolution), options.sampleCount,
+                                    [&] { NFlowField field(terrainGeometry, resolution, kArmyDestination); }));
+    }
+    NFlowField flowField(terrainGeometry, kArmyFlowFieldResolution, kArmyDestination);
+    results.push_back(nBenchRun("flowfield.lookup", options.sampleCount, [&] {
+        glm::vec2 sum(0.0f);
+        for (int i = 0; i < kFlowFieldLookupCount; i++) {
+            sum += flowField.direction(glm::vec2((i % 317) / 317.0f, (i % 211) / 211.0f) * 12.0f - 6.0f);
+        }
+        gSink = sum.x + sum.y;
+    }));
+    runSightBenchmarks(options, terrainGeometry, results);
+    runPickBenchmark(options, terrainGeometry, results);
+
+    // The occlusion culler rasterizes the terrain on the CPU every frame
+    NOcclusionCuller occlusionCuller(terrainGeometry);
+    glm::mat4 viewMatrix = glm::lookAt(glm::vec3(5.0f, 0.35f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projectionMatrix = glm::perspective(45.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    results.push_back(nBenchRun("occlusion.update", options.sampleCount,
+                                [&] { occlusionCuller.update(viewMatrix, projectionMatrix); }));
+
+    glfwTerminate();
+    return results;
+}
+
+void runGridBenchmarks(const NBenchOptions& options, const NglTerrainGeometry& terrainGeometry,
+                       std::vector<NBenchResult>& results) {
+    // Spatial grid rebuilds and queries over soldiers scattered on the whole terrain, up to a hundred times the army.
+    // The queries are kGridQueryCount at a time, at the separation radius and for the nearest kGridNearestCount.
+    const glm::vec2 boundsMin(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z);
+    const glm::vec2 boundsMax(terrainGeometry.boundsMax().x, terrainGeometry.boundsMax().z);
+    for (size_t count : {size_t(10000), size_t(100000), size_t(1000000)}) {
+        const std::string countName =
+                count >= 1000000 ? std::to_string(count / 1000000) + "M" : std::to_string(count / 1000) + "k";
+        // Same points every run, from a linear congruential generator
+        std::vector<glm::vec2> points(count);
+        uint32_t random = 1;
+        for (glm::vec2& point : points) {
+            random = random * 1664525u + 1013904223u;
+            float x = static_cast<float>(random >> 8) / (1 << 24);
+            random = random * 1664525u + 1013904223u;
+            float z = static_cast<float>(random >> 8) / (1 << 24);
+            point = boundsMin + (boundsMax - boundsMin) * glm::vec2(x, z);
+        }
+
+        NSpatialGrid grid(boundsMin, boundsMax, kSeparationRadius);
+        results.push_back(nBenchRun("grid.rebuild." + countName, options.sampleCount, [&] { grid.rebuild(points); }));
+        std::vector<uint32_t> found;
+        results.push_back(nBenchRun("grid.radius." + countName, options.sampleCount, [&] {
+            size_t foundCount = 0;
+            for (int i = 0; i < kGridQueryCount; i++) {
+                found.clear();
+                grid.queryRadius(points[i], kSeparationRadius, found);
+                foundCount += found.size();
+            }
+            gSink = static_cast<float>(foundCount);
+        }));
+        results.push_back(nBenchRun("grid.nearest." + countName, options.sampleCount, [&] {
+            size_t foundCount = 0;
+            for (int i = 0; i < kGridQueryCount; i++) {
+                grid.queryNearest(points[i], kGridNearestCount, kGridNearestRadius, found);
+                foundCount += found.size();
+            }
+            gSink = static_cast<float>(foundCount);
+        }));
+    }
+}
+
+void runBattleBenchmarks(const NBenchOptions& options, std::vector<NBenchResult>& results) {
+    // Two sides in a checkerboard, every soldier within reach of four enemies, units of kUnitInstanceCount soldiers.
+    // The melee is run until the first casualties fall, after a couple of seconds, and every sample times that same
+    // tick again from a copy of the battle before it, so the culling of the dead is timed along with the fighting.
+    const float extent = kBattleSize * kBattleSpacing * 0.5f;
+    NBattle battle(glm::vec2(-extent), glm::vec2(extent));
+    for (int side = 0; side < 2; side++) {
+        const uint32_t firstUnit = side * kBattleSize * kBattleSize;
+        uint32_t soldierIndex = 0;
+        for (int j = 0; j < kBattleSize; j++) {
+            for (int i = 0; i < kBattleSize; i++) {
+                if ((i + j) % 2 != side) {
+                    continue;
+                }
+                NInstance instance = {};
+                instance.position = glm::vec3((i + 0.5f) * kBattleSpacing - extent, 0.0f,
+                                              (j + 0.5f) * kBattleSpacing - extent);
+                instance.heading = glm::vec2(side == 0 ? 1.0f : -1.0f, 0.0f);
+                battle.addSoldier(side, firstUnit + soldierIndex++ / kUnitInstanceCount, instance);
+            }
+        }
+    }
+    NBattle prepared(glm::vec2(-extent), glm::vec2(extent));
+    for (int i = 0; i < kBattleMaxWarmupTickCount && battle.casualtyCount(0) + battle.casualtyCount(1) == 0; i++) {
+        prepared.copyStateFrom(battle);
+        battle.tick(static_cast<float>(kArmyStep));
+    }
+    NGL_ASSERT(battle.casualtyCount(0) + battle.casualtyCount(1) > 0);
+    NGL_LOGI("battle.tick.200k: %u and %u casualties in the timed tick", static_cast<unsigned>(battle.casualtyCount(0)),
+             static_cast<unsigned>(battle.casualtyCount(1)));
+    results.push_back(nBenchRun("battle.tick.200k", options.sampleCount, [&] { battle.copyStateFrom(prepared); },
+                                [&] { battle.tick(static_cast<float>(kArmyStep)); }));
+    gSink = static_cast<float>(battle.casualtyCount(0));
+
+    // The same number of soldiers in two blocks of kBattleSize files, a side each, facing each other across kBattleGap
+    // in units of kUnitSize soldiers. The front ranks see the enemy and advance, those behind see none and march on.
+    // Every sample times the first tick.
+    const int rankCount = kBattleSize / 2;
+    const float approachExtent = std::max(extent, rankCount * kBattleSpacing + kBattleGap * 0.5f);
+    NBattle approach(glm::vec2(-approachExtent), glm::vec2(approachExtent));
+    uint32_t unit = 0;
+    for (int side = 0; side < 2; side++) {
+        for (int unitJ = 0; unitJ < kBattleSize; unitJ += kUnitSize.y) {
+            for (int unitI = 0; unitI < rankCount; unitI += kUnitSize.x) {
+                for (int j = unitJ; j < std::min(unitJ + kUnitSize.y, kBattleSize); j++) {
+                    for (int i = unitI; i < std::min(unitI + kUnitSize.x, rankCount); i++) {
+                        const float x = kBattleGap * 0.5f + (i + 0.5f) * kBattleSpacing;  // of rank i from the front
+                        NInstance instance = {};
+                        instance.position = glm::vec3(side == 0 ? -x : x, 0.0f, (j + 0.5f) * kBattleSpacing - extent);
+                        instance.heading = glm::vec2(side == 0 ? 1.0f : -1.0f, 0.0f);
+                        approach.addSoldier(side, unit, instance);
+                    }
+                }
+                unit++;
+            }
+        }
+    }
+    NBattle approachStart(glm::vec2(-approachExtent), glm::vec2(approachExtent));
+    approachStart.copyStateFrom(approach);
+    results.push_back(nBenchRun("battle.approach.200k", options.sampleCount,
+                                [&] { approach.copyStateFrom(approachStart); },
+                                [&] { approach.tick(static_cast<float>(kArmyStep)); }));
+}
+
+void runSightBenchmarks(const NBenchOptions& options, const NglTerrainGeometry& terrainGeometry,
+                        std::vector<NBenchResult>& results) {
+    // Sight lines between soldiers scattered on the whole terrain, kSightLineCount at a time, and the viewsheds of
+    // kViewshedObserverCount soldiers at once, on height fields of 1k and 4k vertices a side. Rays per second and the
+    // time per observer are logged from the medians.
+    const glm::vec2 boundsMin(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z);
+    const glm::vec2 boundsMax(terrainGeometry.boundsMax().x, terrainGeometry.boundsMax().z);
+    for (int resolution : {1024, 4096}) {
+        const std::string resolutionName = std::to_string(resolution / 1024) + "k";
+        NHeightField heightField(terrainGeometry, resolution);
+        // Same points every run, from a linear congruential generator
+        uint32_t random = 1;
+        auto randomPosition = [&] {
+            random = random * 1664525u + 1013904223u;
+            float x = static_cast<float>(random >> 8) / (1 << 24);
+            random = random * 1664525u + 1013904223u;
+            float z = static_cast<float>(random >> 8) / (1 << 24);
+            return boundsMin + (boundsMax - boundsMin) * glm::vec2(x, z);
+        };
+        auto eyeAt = [&](const glm::vec2& position) {
+            return glm::vec3(position.x, heightField.height(position) + kEyeHeight, position.y);
+        };
+
+        std::vector<NSightLine> lines(kSightLineCount);
+        for (NSightLine& line : lines) {
+            line.from = eyeAt(randomPosition());
+            line.to = eyeAt(randomPosition());
+        }
+        std::vector<uint8_t> areVisible;
+        results.push_back(nBenchRun("sight.lines." + resolutionName, options.sampleCount, [&] {
+            heightField.testSightLines(lines, areVisible);
+            gSink = static_cast<float>(areVisible[0]);
+        }));
+        NGL_LOGI("sight.lines.%s: %0.2fM rays/s", resolutionName.c_str(),
+                 kSightLineCount / nMedian(results.back().samples) / 1e6);
+
+        std::vector<glm::vec2> observers(kViewshedObserverCount);
+        for (glm::vec2& observer : observers) {
+            observer = randomPosition();
+        }
+        std::vector<NViewshed> viewsheds;
+        results.push_back(nBenchRun("sight.viewshed." + resolutionName, options.sampleCount, [&] {
+            heightField.computeViewsheds(observers, kEyeHeight, kEyeHeight, kViewshedRadius, viewsheds);
+            gSink = static_cast<float>(viewsheds[0].isVisible[0]);
+        }));
+        NGL_LOGI("sight.viewshed.%s: %0.3fms per observer", resolutionName.c_str(),
+                 nMedian(results.back().samples) * 1000.0 / kViewshedObserverCount);
+    }
+}
+
+void runPickBenchmark(const NBenchOptions& options, const NglTerrainGeometry& terrainGeometry,
+                      std::vector<NBenchResult>& results) {
+    // Picks from the start camera of nwar through points of the terrain, kPickCount at a time, with a square army of
+    // units of kUnitSize soldiers covering the terrain. The time per pick is logged from the median.
+    const glm::vec2 boundsMin(terrainGeometry.boundsMin().x, terrainGeometry.boundsMin().z);
+    const glm::vec2 boundsMax(terrainGeometry.boundsMax().x, terrainGeometry.boundsMax().z);
+    const glm::vec2 spacing = (boundsMax - boundsMin) / static_cast<float>(kPickArmySize);
+    const glm::ivec2 unitCount = glm::ivec2(kPickArmySize) / kUnitSize;
+    std::vector<NInstance> instances;
+    std::vector<NArmyUnit> units;
+    instances.reserve(static_cast<size_t>(kPickArmySize) * kPickArmySize);
+    for (int unitJ = 0; unitJ < unitCount.y; unitJ++) {
+        for (int unitI = 0; unitI < unitCount.x; unitI++) {
+            NArmyUnit unit;
+            unit.firstInstance = static_cast<uint32_t>(instances.size());
+            unit.instanceCount = kUnitInstanceCount;
+            unit.center = boundsMin + glm::vec2(unitI, unitJ) * glm::vec2(kUnitSize) * spacing +
+                          glm::vec2(kUnitSize) * spacing * 0.5f;
+            unit.radius = glm::length(glm::vec2(kUnitSize) * spacing * 0.5f);
+            unit.minHeight = terrainGeometry.boundsMax().y;
+            unit.maxHeight = terrainGeometry.boundsMin().y;
+            for (int j = 0; j < kUnitSize.y; j++) {
+                for (int i = 0; i < kUnitSize.x; i++) {
+                    glm::vec2 position = boundsMin + (glm::vec2(unitI * kUnitSize.x + i, unitJ * kUnitSize.y + j) +
+                                                      0.5f) * spacing;
+                    NInstance instance = {};
+                    instance.position = glm::vec3(position.x, terrainGeometry.height(position.x, position.y),
+                                                  position.y);
+                    instance.heading = glm::vec2(1.0f, 0.0f);
+                    instances.push_back(instance);
+                    unit.minHeight = std::min(unit.minHeight, instance.position.y);
+                    unit.maxHeight = std::max(unit.maxHeight, instance.position.y);
+                }
+            }
+            units.push_back(unit);
+        }
+    }
+
+    NHeightField heightField(terrainGeometry, terrainGeometry.width());
+    const glm::vec3 cameraPosition(0.0f, 1.6f, 1.6f);
+    std::vector<glm::vec3> directions(kPickCount);
+    uint32_t random = 1;
+    for (glm::vec3& direction : directions) {
+        random = random * 1664525u + 1013904223u;
+        float x = static_cast<float>(random >> 8) / (1 << 24);
+        random = random * 1664525u + 1013904223u;
+        float z = static_cast<float>(random >> 8) / (1 << 24);
+        glm::vec2 target = boundsMin + (boundsMax - boundsMin) * glm::vec2(x, z);
+        direction = glm::normalize(glm::vec3(target.x, terrainGeometry.height(target.x, target.y), target.y) -
+                                   cameraPosition);
+    }
+    results.push_back(nBenchRun("pick.1M", options.sampleCount, [&] {
+        uint32_t pickedCount = 0;
+        for (const glm::vec3& direction : directions) {
+            glm::vec3 groundPoint;
+            float maxDistance = heightField.intersectRay(cameraPosition, direction, 1000.0f, groundPoint)
+                                        ? glm::length(groundPoint - cameraPosition)
+                                        : 1000.0f;
+            float distance;
+            if (nglPickSoldier(instances, units, kPickSoldierRadius, kPickSoldierHeight, cameraPosition, direction,
+                               maxDistance, distance) != kNInvalidIndex) {
+                pickedCount++;
+            }
+        }
+        gSink = static_cast<float>(pickedCount);
+    }));
+    NGL_LOGI("pick.1M: %0.4fms per pick", nMedian(results.back().samples) * 1000.0 / kPickCount);
+}
+
+void runFileBenchmarks(const NBenchOptions& options, std::vector<NBenchResult>& results) {
+    // nReadFile() against nMapFile(), each followed by a read of every page as a decoder would do. The files were
+    // just written and are in the page cache, this measures the copy and the page faults, not the disk.
+    std::vector<size_t> sizes = {kMegabyte, 100 * kMegabyte};
+    if (options.hasLargeFiles) {
+        sizes.push_back(1024 * kMegabyte);
+    }
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    for (size_t size : sizes) {
+        const std::string sizeName = size >= 1024 * kMegabyte ? std::to_string(size / (1024 * kMegabyte)) + "G"
+                                                              : std::to_string(size / kMegabyte) + "M";
+        const std::string path = (directory / ("nwar-bench-" + sizeName + ".bin")).string();
+        if (!writeTestFile(path, size)) {
+            continue;
+        }
+        results.push_back(nBenchRun("file.read." + sizeName, options.sampleCount, [&] {
+            std::vector<char> data = nReadFile(path);
+            gSink = static_cast<float>(sumPages(data.data(), data.size()));
+        }));
+        results.push_back(nBenchRun("file.map." + sizeName, options.sampleCount, [&] {
+            NMappedFile file = nMapFile(path, NFileAccess::kSequential);
+            gSink = static_cast<float>(sumPages(file.data(), file.size()));
+        }));
+        std::remove(path.c_str());
+    }
+}
+
+bool writeTestFile(const std::string& path, size_t size) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+        return false;
+    }
+    std::vector<char> block(kMegabyte);
+    for (size_t i = 0; i < block.size(); i++) {
+        block[i] = static_cast<char>(i * 31);
+    }
+    bool isWritten = true;
+    for (size_t offset = 0; offset < size && isWritten; offset += block.size()) {
+        isWritten = fwrite(block.data(), 1, std::min(block.size(), size - offset), file) > 0;
+    }
+    isWritten = fclose(file) == 0 && isWritten;
+    if (!isWritten) {
+        NGL_LOGE("Cannot write %s", path.c_str());
+    }
+    return isWritten;
+}
+
+unsigned sumPages(const char* data, size_t size) {
+    unsigned sum = 0;
+    for (size_t offset = 0; offset < size; offset += kPageSize) {
+        sum += static_cast<unsigned char>(data[offset]);
+    }
+    return sum;
+}
+
+void runFrameBenchmark(const NBenchOptions& options, std::vector<NBenchResult>& results) {
+    // A frame is a sample, GPU times come from the device's timestamp queries when it has them
+    NMainOptions mainOptions;
+    mainOptions.backend = options.backend;
+    mainOptions.isHeadless = true;
+    mainOptions.benchmarkFrameCount = options.frameCount;
+    mainOptions.cameraPath = options.cameraPath;
+    mainOptions.hasMipmaps = options.hasMipmaps;
+    mainOptions.isAnimated = options.isAnimated;
+    mainOptions.isBattle = options.isBattle;
+    mainOptions.onBenchmarkFinished = [&](const NBenchmark& benchmark) {
+        results.push_back({"frame.cpu", benchmark.cpuFrameTimes()});
+        if (!benchmark.gpuFrameTimes().empty()) {
+            results.push_back({"frame.gpu", benchmark.gpuFrameTimes()});
+        }
+    };
+    nMain(mainOptions);
+}
+
+bool compareWithBaseline(const NBenchOptions& options, const std::vector<NBenchResult>& results) {
+    std::vector<NBenchResult> baseline;
+    if (!nBenchReadResults(options.baselinePath, baseline)) {
+        NGL_LOGI("No baseline in %s, run with --update-baseline to store one", options.baselinePath.c_str());
+        return true;
+    }
+
+    int regressionCount = 0;
+    for (const NBenchResult& result : results) {
+        auto it = std::find_if(baseline.begin(), baseline.end(),
+                               [&](const NBenchResult& baselineResult) { return baselineResult.name == result.name; });
+        if (it == baseline.end()) {
+            NGL_LOGI("%-20s no baseline", result.name.c_str());
+            continue;
+        }
+        double baselineMedian = nMedian(it->samples);
+        double median = nMedian(result.samples);
+        double change = baselineMedian > 0 ? (median / baselineMedian - 1.0) * 100.0 : 0.0;
+        double p = nMannWhitneyP(it->samples, result.samples);
+        bool isRegression = change > options.threshold && p < kSignificance;
+        if (isRegression) {
+            regressionCount++;
+        }
+        NGL_LOGI("%-20s baseline %9.3fms, now %9.3fms, %+6.1f%%, p %0.4f%s", result.name.c_str(),
+                 baselineMedian * 1000.0, median * 1000.0, change, p, isRegression ? "  REGRESSION" : "");
+    }
+    if (regressionCount > 0) {
+        NGL_LOGE("%d metrics regressed by more than %0.1f%%", regressionCount, options.threshold);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "NAssetArchive.h"
+#include "nfile.h"
+#include "ngllog.h"
+
+#if NGL_ZSTD_ENABLED
+#include <zstd.h>
+#endif
+
+// Packs asset files into an archive that nwar mounts at startup (see NAssetArchive.h), run from the directory with
+// the assets like nwar:
+//
+//   nwar-pack [--zstd] <archive> [<file>...]
+//
+// Without files, packs the ones nwar loads, those missing (e.g. shaders not compiled) are left out. Entries are
+// written in the order given, put them in the order they are loaded for reads to go front to back.
+
+// In load order: the sound, the Vulkan pipelines, the terrain, then the streamed assets, texture files before the
+// images they stand in for (see NAssetService)
+const char* const kDefaultFiles[] = {
+        "sound.mp3",
+        "out/vertex.spv",
+        "out/fragment.spv",
+        "out/shadow_vertex.spv",
+        "out/depth_vertex.spv",
+        "terrain-map.png",
+        "terrain-texture.ntex",
+        "terrain-texture.png",
+        "soldier.ntex",
+        "soldier.glb",
+};
+// Compressed entries are kept only when they are smaller than this fraction of the file
+constexpr double kMinCompressionRatio = 0.9;
+constexpr int kZstdLevel = 19;
+
+struct NPackFile {
+    std::string path;
+    NArchiveEntry entry;
+};
+
+#if NGL_ZSTD_ENABLED
+static bool compress(const NMappedFile& file, std::vector<char>& result);
+#endif
+static bool writePadding(FILE* file, uint64_t size);
+
+int main(int argc, char* argv[]) {
+    bool isCompressed = false;
+    std::string archivePath;
+    std::vector<NPackFile> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--zstd") == 0) {
+            isCompressed = true;
+        } else if (archivePath.empty()) {
+            archivePath = argv[i];
+        } else {
+            files.push_back({argv[i], {}});
+        }
+    }
+    if (archivePath.empty()) {
+        NGL_LOGE("Usage: %s [--zstd] <archive> [<file>...]", argv[0]);
+        return 1;
+    }
+#if !NGL_ZSTD_ENABLED
+    if (isCompressed) {
+        NGL_LOGE("--zstd needs a build with %s", "NGL_ZSTD_ENABLED=1");
+        return 1;
+    }
+#endif
+    if (files.empty()) {
+        for (const char* path : kDefaultFiles) {
+            NMappedFile file;
+            if (nTryMapFile(path, NFileAccess::kSequential, file)) {
+                files.push_back({path, {}});
+            } else {
+                NGL_LOGI("%s not found, left out", path);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        files[i].entry.hash = nArchiveHash(files[i].path);
+        for (size_t j = 0; j < i; j++) {
+            if (files[j].entry.hash == files[i].entry.hash) {
+                NGL_LOGE("%s and %s have the same hash, rename one", files[j].path.c_str(), files[i].path.c_str());
+                return 1;
+            }
+        }
+    }
+
+    FILE* archive = fopen(archivePath.c_str(), "wb");
+    if (archive == nullptr) {
+        NGL_LOGE("Cannot write %s", archivePath.c_str());
+        return 1;
+    }
+
+    // The index goes first but is written last, once the offsets and sizes are known
+    NArchiveHeader header{};
+    memcpy(header.magic, kNArchiveMagic, sizeof(kNArchiveMagic));
+    header.version = kNArchiveVersion;
+    header.entryCount = static_cast<uint32_t>(files.size());
+    uint64_t offset = sizeof(header) + files.size() * sizeof(NArchiveEntry);
+    bool isWritten = writePadding(archive, offset);
+    uint64_t storedSize = 0;
+    uint64_t totalSize = 0;
+    for (NPackFile& packFile : files) {
+        NMappedFile file;
+        if (!nTryMapFile(packFile.path, NFileAccess::kSequential, file)) {
+            NGL_LOGE("Cannot read %s", packFile.path.c_str());
+            fclose(archive);
+            return 1;
+        }
+        std::vector<char> compressed;
+#if NGL_ZSTD_ENABLED
+        bool isEntryCompressed = isCompressed && compress(file, compressed) &&
+                                 compressed.size() < file.size() * kMinCompressionRatio;
+#else
+        bool isEntryCompressed = false;
+#endif
+        const char* data = isEntryCompressed ? compressed.data() : file.data();
+        size_t size = isEntryCompressed ? compressed.size() : file.size();
+
+        uint64_t alignedOffset = (offset + kNArchiveAlignment - 1) / kNArchiveAlignment * kNArchiveAlignment;
+        isWritten = isWritten && writePadding(archive, alignedOffset - offset);
+        isWritten = isWritten && (size == 0 || fwrite(data, size, 1, archive) == 1);
+        packFile.entry.offset = alignedOffset;
+        packFile.entry.size = size;
+        packFile.entry.uncompressedSize = file.size();
+        packFile.entry.compression = isEntryCompressed ? NArchiveCompression::kZstd : NArchiveCompression::kNone;
+        offset = alignedOffset + size;
+        storedSize += size;
+        totalSize += file.size();
+        if (isEntryCompressed) {
+            NGL_LOGI("%-24s %10zu bytes, %zu compressed", packFile.path.c_str(), file.size(), size);
+        } else {
+            NGL_LOGI("%-24s %10zu bytes", packFile.path.c_str(), file.size());
+        }
+    }
+
+    std::vector<NArchiveEntry> entries;
+    for (const NPackFile& packFile : files) {
+        entries.push_back(packFile.entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const NArchiveEntry& a, const NArchiveEntry& b) {
+        return a.hash < b.hash;
+    });
+    isWritten = isWritten && fseek(archive, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, archive) == 1 &&
+                (entries.empty() || fwrite(entries.data(), sizeof(NArchiveEntry), entries.size(), archive) ==
+                                            entries.size());
+    isWritten = fclose(archive) == 0 && isWritten;
+    if (!isWritten) {
+        NGL_LOGE("Cannot write %s", archivePath.c_str());
+        return 1;
+    }
+    NGL_LOGI("%s written, %zu files, %llu bytes stored of %llu", archivePath.c_str(), files.size(),
+             static_cast<unsigned long long>(storedSize), static_cast<unsigned long long>(totalSize));
+    return 0;
+}
+
+#if NGL_ZSTD_ENABLED
+bool compress(const NMappedFile& file, std::vector<char>& result) {
+    result.resize(ZSTD_compressBound(file.size()));
+    size_t size = ZSTD_compress(result.data(), result.size(), file.data(), file.size(), kZstdLevel);
+    if (ZSTD_isError(size)) {
+        NGL_LOGE("Compression failed: %s", ZSTD_getErrorName(size));
+        return false;
+    }
+    result.resize(size);
+    return true;
+}
+#endif
+
+bool writePadding(FILE* file, uint64_t size) {
+    static const char kZeros[kNArchiveAlignment] = {};
+    while (size > 0) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(size, sizeof(kZeros)));
+        if (fwrite(kZeros, count, 1, file) != 1) {
+            return false;
+        }
+        size -= count;
+    }
+    return true;
+}
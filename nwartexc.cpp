@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "NglSoldierGeometry.h"
+#include "nbcn.h"
+#include "nfile.h"
+#include "ngllog.h"
+#include "nimage.h"
+#include "nrender.h"
+#include "ntexfile.h"
+
+// Transcodes textures into block compressed texture files with their mip chains (see ntexfile.h), run from the
+// directory with the assets like nwar:
+//
+//   nwar-texc [--bc1|--bc3|--bc5|--bc7] [<input> [<output>]]
+//
+// The input is a PNG or JPEG image, or a .glb model whose embedded texture is transcoded. The output defaults to
+// the input with a .ntex extension, where NAssetService looks for it. Without input, transcodes the textures nwar
+// loads. Color formats are filtered in linear space, kBc5 holds data such as normals and is filtered as it is.
+
+struct NTranscodeJob {
+    std::string path;
+    NTextureFormat format;
+};
+
+// Opaque terrain in half the space of the soldier, which BC7 keeps sharper up close
+const NTranscodeJob kDefaultJobs[] = {
+        {"terrain-texture.png", NTextureFormat::kBc1},
+        {"soldier.glb", NTextureFormat::kBc7},
+};
+
+static bool transcode(const std::string& inputPath, const std::string& outputPath, NTextureFormat format);
+static NImage loadImage(const std::string& path);
+static NImage downsample(const NImage& image, bool isSrgb);
+static float toLinear(unsigned char value);
+static unsigned char toSrgb(float value);
+static const char* formatName(NTextureFormat format);
+
+int main(int argc, char* argv[]) {
+    NTextureFormat format = NTextureFormat::kBc7;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bc1") == 0) {
+            format = NTextureFormat::kBc1;
+        } else if (strcmp(argv[i], "--bc3") == 0) {
+            format = NTextureFormat::kBc3;
+        } else if (strcmp(argv[i], "--bc5") == 0) {
+            format = NTextureFormat::kBc5;
+        } else if (strcmp(argv[i], "--bc7") == 0) {
+            format = NTextureFormat::kBc7;
+        } else if (argv[i][0] != '-' && paths.size() < 2) {
+            paths.push_back(argv[i]);
+        } else {
+            NGL_LOGE("Usage: %s [--bc1|--bc3|--bc5|--bc7] [<input> [<output>]]", argv[0]);
+            return 1;
+        }
+    }
+
+    if (paths.empty()) {
+        bool isTranscoded = true;
+        for (const NTranscodeJob& job : kDefaultJobs) {
+            isTranscoded = transcode(job.path, nTextureFilePath(job.path), job.format) && isTranscoded;
+        }
+        return isTranscoded ? 0 : 1;
+    }
+    return transcode(paths[0], paths.size() > 1 ? paths[1] : nTextureFilePath(paths[0]), format) ? 0 : 1;
+}
+
+bool transcode(const std::string& inputPath, const std::string& outputPath, NTextureFormat format) {
+    NMappedFile file;
+    if (!nTryMapFile(inputPath, NFileAccess::kSequential, file)) {
+        NGL_LOGE("Cannot read %s", inputPath.c_str());
+        return false;
+    }
+    NImage image = loadImage(inputPath);
+
+    // Down to 1x1, as GL and Vulkan count a full chain
+    bool isSrgb = format != NTextureFormat::kBc5;
+    std::vector<std::vector<unsigned char>> levels;
+    size_t size = 0;
+    for (NImage level = image;; level = downsample(level, isSrgb)) {
+        levels.push_back(nEncodeBlocks(format, level.pixels.data(), level.width, level.height));
+        size += levels.back().size();
+        if (level.width == 1 && level.height == 1) {
+            break;
+        }
+    }
+    if (!nWriteTextureFile(outputPath, format, image.width, image.height, levels)) {
+        return false;
+    }
+
+    // What the texture takes in VRAM against the single RGBA8 level it was before
+    size_t uncompressedSize = nTextureLevelSize(NTextureFormat::kRgba8, image.width, image.height);
+    NGL_LOGI("%s written, %s, width: %d, height: %d, levels: %zu, %zu bytes, %zu as RGBA8 without levels (%0.1f%%)",
+             outputPath.c_str(), formatName(format), image.width, image.height, levels.size(), size,
+             uncompressedSize, 100.0 * size / uncompressedSize);
+    return true;
+}
+
+NImage loadImage(const std::string& path) {
+    size_t extension = path.find_last_of('.');
+    if (extension == std::string::npos || path.compare(extension, std::string::npos, ".glb") != 0) {
+        return nLoadImage(path.c_str());
+    }
+    NMappedFile file = nMapFile(path, NFileAccess::kSequential);
+    NglSoldierGeometry geometry(file.data(), file.size(), path.c_str());
+    const std::vector<unsigned char>& texture = geometry.texture();
+    return nDecodeImage(texture.data(), static_cast<uint32_t>(texture.size()), path.c_str());
+}
+
+NImage downsample(const NImage& image, bool isSrgb) {
+    // 2x2 box filter, odd rows and columns fold into the last texel
+    NImage result;
+    result.width = std::max(image.width / 2, 1);
+    result.height = std::max(image.height / 2, 1);
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+    for (int y = 0; y < result.height; y++) {
+        for (int x = 0; x < result.width; x++) {
+            for (int c = 0; c < 4; c++) {
+                float sum = 0.0f;
+                for (int sy = 0; sy < 2; sy++) {
+                    for (int sx = 0; sx < 2; sx++) {
+                        size_t sourceX = std::min(x * 2 + sx, image.width - 1);
+                        size_t sourceY = std::min(y * 2 + sy, image.height - 1);
+                        unsigned char value = image.pixels[(sourceY * image.width + sourceX) * 4 + c];
+                        // Alpha is linear either way
+                        sum += isSrgb && c < 3 ? toLinear(value) : value / 255.0f;
+                    }
+                }
+                float average = sum / 4.0f;
+                result.pixels[(static_cast<size_t>(y) * result.width + x) * 4 + c] =
+                        isSrgb && c < 3 ? toSrgb(average)
+                                        : static_cast<unsigned char>(std::lround(average * 255.0f));
+            }
+        }
+    }
+    return result;
+}
+
+float toLinear(unsigned char value) {
+    float v = value / 255.0f;
+    return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+unsigned char toSrgb(float value) {
+    float v = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<unsigned char>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+const char* formatName(NTextureFormat format) {
+    switch (format) {
+        case NTextureFormat::kBc1:
+            return "BC1";
+        case NTextureFormat::kBc3:
+            return "BC3";
+        case NTextureFormat::kBc5:
+            return "BC5";
+        case NTextureFormat::kBc7:
+            return "BC7";
+        default:
+            return "?";
+    }
+}
@@ -1,19 +1,161 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model_view;
-    mat4 proj;
-} ubo;
+// Vulkan port of nglvert.h. Instance 0 is the terrain, soldiers are instances 1..N (see NArmyLayer::record).
+// Built again with SHADOW_PASS for the shadow pipeline and with DEPTH_PASS for the depth prepass, both depth only.
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
+layout (std140, set = 0, binding = 0) uniform FrameUniform {
+    mat4 model_view_matrix;
+    mat4 projection_matrix;
+    mat4 shadow_matrices[4];
+    vec4 cascade_splits;
+    vec4 light_vector;
+    float time;
+    int is_wireframe_enabled;
+} frame;
 
-layout(location = 0) out vec3 fragColor;
-layout(location = 1) out vec2 fragTexCoord;
+struct Instance {
+    vec3 position;
+    float height_scale;
+    vec2 heading;
+    float phase;
+    uint animation;
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
+
+// Baked animations of the soldier, see nanim.h: the skinning matrices of every frame of every clip, and the joints and
+// weights of every vertex
+layout (set = 0, binding = 3) uniform sampler2D animation_texture;
+layout (set = 0, binding = 4) uniform sampler2D skin_texture;
+
+const uint static_pose = 0xFFFFFFFFu;
+const int animation_frame_count = 32;
+const int skin_texture_width = 1024;
+
+// The depth-only passes read a stream of positions only
+#if defined(SHADOW_PASS) || defined(DEPTH_PASS)
+#define POSITION_ONLY
+#endif
+
+layout (location = 0) in vec3 in_position;
+#ifndef POSITION_ONLY
+layout (location = 1) in vec3 in_normal;
+layout (location = 2) in vec2 in_uv;
+#endif
+
+// The depth prepass and the color pass after it must produce the same depth for the EQUAL test
+invariant gl_Position;
+
+#ifdef SHADOW_PASS
+layout (push_constant) uniform ShadowConstants {
+    int cascade_index;
+} shadow;
+#elif !defined(DEPTH_PASS)
+layout (location = 0) out VS_OUT {
+    vec2 uv;
+    vec3 color_factor;  // diffuse only, ambient is added after shadowing
+    vec3 color_offset;
+    vec3 world_position;
+    float view_depth;
+} vs_out;
+#endif
+
+const float pi = 3.14159265;
+const float pi_x2 = 2 * pi;
+
+const vec3 specular_factor = vec3(0.1);
+const float specular_power = 48;
+
+// Skinning matrix of a joint in a frame's row of the animation texture, which holds the rows of the 3x4 matrix
+mat4x3 joint_matrix(int joint, int frame_row) {
+    return transpose(mat3x4(
+        texelFetch(animation_texture, ivec2(joint * 3, frame_row), 0),
+        texelFetch(animation_texture, ivec2(joint * 3 + 1, frame_row), 0),
+        texelFetch(animation_texture, ivec2(joint * 3 + 2, frame_row), 0)));
+}
+
+// Blend of the matrices of the joints moving this vertex, at the instance's frame of its clip
+mat4x3 skinning_matrix(Instance instance) {
+    int frame = int(instance.phase * animation_frame_count) % animation_frame_count;
+    int frame_row = int(instance.animation) * animation_frame_count + frame;
+    int skin_texel = gl_VertexIndex * 2;
+    ivec2 skin_coord = ivec2(skin_texel % skin_texture_width, skin_texel / skin_texture_width);
+    vec4 joints = texelFetch(skin_texture, skin_coord, 0);
+    vec4 weights = texelFetch(skin_texture, skin_coord + ivec2(1, 0), 0);
+    mat4x3 skinning = weights.x * joint_matrix(int(joints.x), frame_row);
+    for (int i = 1; i < 4 && weights[i] > 0; i++) {
+        skinning += weights[i] * joint_matrix(int(joints[i]), frame_row);
+    }
+    return skinning;
+}
 
 void main() {
-    gl_Position = ubo.proj * ubo.model_view * vec4(inPosition, 1.0);
-    fragColor = inColor;
-    fragTexCoord = inTexCoord;
+    vec3 position;
+#ifndef POSITION_ONLY
+    vec3 normal = in_normal;
+#endif
+    if (gl_InstanceIndex == 0) {
+        position = in_position;
+    } else {
+        // Placed by the CPU, see nglarmy.h
+        Instance instance = instances[gl_InstanceIndex - 1];
+        vec2 heading = instance.heading;
+        mat3 path_orientation = mat3(
+            heading.y, 0, -heading.x,
+            0, 1, 0,
+            heading.x, 0, heading.y);
+
+        // Posed in model space by the instance's animation, or the static mesh swings as it walks
+        mat4x3 pose;
+        if (instance.animation == static_pose) {
+            float theta = sin(instance.phase * pi_x2) * 0.03;
+            float sin_theta = sin(theta);
+            float cos_theta = cos(theta);
+            mat3 swing_orientation = mat3(
+                cos_theta, sin_theta, 0,
+                -sin_theta, cos_theta, 0,
+                0, 0, 1
+            );
+            pose = mat4x3(swing_orientation);
+        } else {
+            pose = skinning_matrix(instance);
+        }
+
+        vec3 scale = vec3(1, 1 + instance.height_scale, 1);
+
+        position = path_orientation * (scale * (pose * vec4(in_position, 1))) + instance.position;
+#ifndef POSITION_ONLY
+        normal = path_orientation * (mat3(pose) * in_normal);
+#endif
+    }
+
+#ifdef SHADOW_PASS
+    gl_Position = frame.shadow_matrices[shadow.cascade_index] * vec4(position, 1);
+#else
+    vec4 position_in_view = frame.model_view_matrix * vec4(position, 1);
+#ifndef DEPTH_PASS
+    vec3 normal_in_view = mat3(frame.model_view_matrix) * normal;
+    vec3 light_vector_in_view = mat3(frame.model_view_matrix) * frame.light_vector.xyz;
+    vec3 view_vector_in_view = -position_in_view.xyz;
+
+    normal_in_view = normalize(normal_in_view);
+    light_vector_in_view = normalize(light_vector_in_view);
+    view_vector_in_view = normalize(view_vector_in_view);
+
+    vec3 reflection_vector_in_view = reflect(-light_vector_in_view, normal_in_view);
+
+    vec3 diffuse_factor = vec3(max(dot(normal_in_view, light_vector_in_view), 0));
+    vec3 specular = pow(max(dot(reflection_vector_in_view, view_vector_in_view), 0), specular_power) * specular_factor;
+
+    vs_out.uv = in_uv;
+    vs_out.color_factor = diffuse_factor;
+    vs_out.color_offset = specular;
+    vs_out.world_position = position;
+    vs_out.view_depth = -position_in_view.z;
+#endif
+
+    gl_Position = frame.projection_matrix * position_in_view;
+#endif
 }